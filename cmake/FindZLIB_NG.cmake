@@ -0,0 +1,15 @@
+
+find_package(PkgConfig)
+pkg_check_modules(PC_ZLIB_NG zlib-ng)
+
+# Use ZLIB_NG_INCLUDE_DIR and ZLIB_NG_LIBRARIES_DIR from configure_cmake.sh as
+# primary hints and then package config information after that.
+find_path(ZLIB_NG_INCLUDE_DIRS zlib-ng.h
+    HINTS ${ZLIB_NG_INCLUDE_DIR} ${PC_ZLIB_NG_INCLUDEDIR} ${PC_ZLIB_NG_INCLUDE_DIRS})
+find_library(ZLIB_NG_LIBRARIES NAMES z-ng
+    HINTS ${ZLIB_NG_LIBRARIES_DIR} ${PC_ZLIB_NG_LIBDIR} ${PC_ZLIB_NG_LIBRARY_DIRS})
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(ZLIB_NG DEFAULT_MSG ZLIB_NG_LIBRARIES ZLIB_NG_INCLUDE_DIRS)
+
+mark_as_advanced(ZLIB_NG_INCLUDE_DIRS ZLIB_NG_LIBRARIES)
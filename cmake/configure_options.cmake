@@ -14,6 +14,10 @@ endif ( NOT ENABLE_COREFILES )
 set ( _LARGEFILE_SOURCE ${ENABLE_LARGE_PCAP} )
 set ( USE_TSC_CLOCK ${ENABLE_TSC_CLOCK} )
 
+if ( NOT ENABLE_TIME_PROFILER )
+    set ( NO_TIME_PROFILER ON )
+endif ( NOT ENABLE_TIME_PROFILER )
+
 if ( ENABLE_LARGE_PCAP )
     set ( _FILE_OFFSET_BITS 64 )
 endif ( ENABLE_LARGE_PCAP )
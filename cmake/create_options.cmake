@@ -23,6 +23,7 @@ option ( ENABLE_COREFILES "Prevent Snort from generating core files" ON )
 option ( ENABLE_INTEL_SOFT_CPM "Enable Intel Soft CPM support" OFF )
 option ( ENABLE_LARGE_PCAP "Enable support for pcaps larger than 2 GB" OFF )
 option ( ENABLE_TSC_CLOCK "Use timestamp counter register clock (x86 only)" OFF )
+option ( ENABLE_TIME_PROFILER "Compile in module time profiling scopes" ON )
 
 # documentation
 option ( MAKE_HTML_DOC "Create the HTML documentation" ON )
@@ -180,6 +180,10 @@ if (HS_FOUND)
     check_library_exists (${HS_LIBRARIES} hs_scan "" HAVE_HYPERSCAN)
 endif()
 
+if (ZLIB_NG_FOUND)
+    check_library_exists (${ZLIB_NG_LIBRARIES} zng_inflate "" HAVE_ZLIB_NG)
+endif()
+
 if (DEFINED LIBLZMA_LIBRARIES)
     check_library_exists (${LIBLZMA_LIBRARIES} lzma_code "" HAVE_LZMA)
 endif()
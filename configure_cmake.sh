@@ -41,6 +41,7 @@ Optional Features:
     --enable-shell          enable command line shell support
     --enable-large-pcap     enable support for pcaps larger than 2 GB
     --enable-tsc-clock      use timestamp counter register clock (x86 only)
+    --disable-time-profiler compile out module time profiling scopes
     --enable-debug-msgs     enable debug printing options (bugreports and
                             developers only)
     --enable-debug          enable debugging options (bugreports and developers
@@ -85,6 +86,10 @@ Optional Packages:
                             libhs include directory
     --with-hyperscan-libraries=DIR
                             libhs library directory
+    --with-zlib-ng-includes=DIR
+                            zlib-ng include directory
+    --with-zlib-ng-libraries=DIR
+                            zlib-ng library directory
 
 Some influential environment variables:
     SIGNAL_SNORT_RELOAD=<value>
@@ -223,6 +228,9 @@ while [ $# -ne 0 ]; do
         --enable-tsc-clock)
             append_cache_entry ENABLE_TSC_CLOCK         BOOL true
             ;;
+        --disable-time-profiler)
+            append_cache_entry ENABLE_TIME_PROFILER     BOOL false
+            ;;
         --disable-large-pcap)
             append_cache_entry ENABLE_LARGE_PCAP        BOOL false
             ;;
@@ -344,6 +352,12 @@ while [ $# -ne 0 ]; do
         --with-hyperscan-libraries=*)
             append_cache_entry HS_LIBRARIES_DIR PATH $optarg
             ;;
+        --with-zlib-ng-includes=*)
+            append_cache_entry ZLIB_NG_INCLUDE_DIR PATH $optarg
+            ;;
+        --with-zlib-ng-libraries=*)
+            append_cache_entry ZLIB_NG_LIBRARIES_DIR PATH $optarg
+            ;;
         SIGNAL_SNORT_RELOAD=*)
             append_cache_entry SIGNAL_SNORT_RELOAD STRING $optarg
             ;;
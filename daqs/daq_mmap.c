@@ -0,0 +1,810 @@
+/*--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+*/
+/* daq_mmap.c */
+
+/*
+ * read pcap and pcapng files by mapping them into memory.  packets are
+ * passed to the analyzer as pointers into the mapping so there is no copy
+ * per packet.  the mapping is private and writable so that a replace
+ * verdict only costs a copy of the affected page.
+ *
+ * variables:
+ *   speed=<x>  replay at x times the capture rate; 0 (default) is as fast
+ *              as possible
+ */
+
+#include "daq_user.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/unistd.h>
+
+#include <daq_api.h>
+#include <sfbpf.h>
+#include <sfbpf_dlt.h>
+
+#define DAQ_MOD_VERSION 0
+#define DAQ_NAME "mmap"
+#define DAQ_TYPE (DAQ_TYPE_FILE_CAPABLE|DAQ_TYPE_MULTI_INSTANCE)
+#define DEF_SNAPLEN 65535
+
+#define PCAP_MAGIC       0xa1b2c3d4
+#define PCAP_MAGIC_NSEC  0xa1b23c4d
+#define PCAP_HDR_LEN     24
+#define PCAP_REC_LEN     16
+
+#define PCAPNG_SHB       0x0a0d0d0a
+#define PCAPNG_IDB       0x00000001
+#define PCAPNG_PB        0x00000002
+#define PCAPNG_SPB       0x00000003
+#define PCAPNG_EPB       0x00000006
+#define PCAPNG_BOM       0x1a2b3c4d
+#define PCAPNG_TSRESOL   9
+#define PCAPNG_MAX_IFS   32
+
+typedef enum { FMT_PCAP, FMT_PCAPNG } FileFormat;
+
+typedef struct {
+    char* name;
+    int fid;
+
+    const uint8_t* map;
+    size_t size;
+    size_t pos;
+
+    FileFormat fmt;
+    int swap;
+    int stop;
+
+    int dlt;
+    unsigned snaplen;
+
+    /* pcap usec divisor: 1 for usec, 1000 for nsec files */
+    uint32_t ts_div;
+
+    unsigned num_ifs;
+    uint64_t if_tsres[PCAPNG_MAX_IFS];
+    unsigned if_snaplen[PCAPNG_MAX_IFS];
+
+    double speed;
+    struct timeval first_pkt;
+    struct timespec first_wall;
+    int paced;
+
+    struct sfbpf_program fcode;
+    int have_filter;
+
+    char error[DAQ_ERRBUF_SIZE];
+
+    DAQ_State state;
+    DAQ_Stats_t stats;
+} MmapImpl;
+
+//-------------------------------------------------------------------------
+// file format helpers
+//-------------------------------------------------------------------------
+
+static inline uint32_t get32(const MmapImpl* impl, const uint8_t* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return impl->swap ? __builtin_bswap32(v) : v;
+}
+
+static inline uint16_t get16(const MmapImpl* impl, const uint8_t* p)
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return impl->swap ? __builtin_bswap16(v) : v;
+}
+
+static int pcap_open_header(MmapImpl* impl)
+{
+    if ( impl->size < PCAP_HDR_LEN )
+    {
+        DPE(impl->error, "%s: truncated pcap header\n", DAQ_NAME);
+        return -1;
+    }
+    uint32_t magic;
+    memcpy(&magic, impl->map, sizeof(magic));
+
+    if ( magic == PCAP_MAGIC || magic == PCAP_MAGIC_NSEC )
+        impl->swap = 0;
+
+    else if ( __builtin_bswap32(magic) == PCAP_MAGIC ||
+        __builtin_bswap32(magic) == PCAP_MAGIC_NSEC )
+    {
+        impl->swap = 1;
+        magic = __builtin_bswap32(magic);
+    }
+    else
+        return 1;
+
+    impl->fmt = FMT_PCAP;
+    impl->ts_div = (magic == PCAP_MAGIC_NSEC) ? 1000 : 1;
+
+    unsigned snaplen = get32(impl, impl->map + 16);
+
+    if ( snaplen && snaplen < impl->snaplen )
+        impl->snaplen = snaplen;
+
+    impl->dlt = get32(impl, impl->map + 20) & 0x03ffffff;
+    impl->pos = PCAP_HDR_LEN;
+    return 0;
+}
+
+static int pcapng_open_header(MmapImpl* impl)
+{
+    if ( impl->size < 28 )
+        return 1;
+
+    uint32_t type, bom;
+    memcpy(&type, impl->map, sizeof(type));
+    memcpy(&bom, impl->map + 8, sizeof(bom));
+
+    if ( type != PCAPNG_SHB )
+        return 1;
+
+    if ( bom == PCAPNG_BOM )
+        impl->swap = 0;
+
+    else if ( __builtin_bswap32(bom) == PCAPNG_BOM )
+        impl->swap = 1;
+
+    else
+        return 1;
+
+    impl->fmt = FMT_PCAPNG;
+    impl->dlt = -1;
+    impl->pos = 0;
+    return 0;
+}
+
+// timestamp resolution is given as units per second
+static uint64_t pcapng_tsresol(const MmapImpl* impl, const uint8_t* opt, const uint8_t* end)
+{
+    while ( opt + 4 <= end )
+    {
+        uint16_t code = get16(impl, opt);
+        uint16_t len = get16(impl, opt + 2);
+
+        if ( !code )
+            break;
+
+        if ( code == PCAPNG_TSRESOL && len == 1 && opt + 5 <= end )
+        {
+            uint8_t r = opt[4];
+            uint64_t res = 1;
+            unsigned n = r & 0x7f;
+
+            if ( r & 0x80 )
+                return (n < 64) ? ((uint64_t)1 << n) : 1000000;
+
+            while ( n-- && res < 1000000000000000000ULL )
+                res *= 10;
+
+            return res;
+        }
+        opt += 4 + ((len + 3) & ~3);
+    }
+    return 1000000;
+}
+
+static int pcapng_add_interface(MmapImpl* impl, const uint8_t* body, const uint8_t* end)
+{
+    if ( body + 8 > end )
+        return -1;
+
+    int dlt = get16(impl, body);
+
+    if ( impl->dlt < 0 )
+        impl->dlt = dlt;
+
+    else if ( impl->dlt != dlt )
+    {
+        DPE(impl->error, "%s: mixed link types are not supported (%d, %d)\n",
+            DAQ_NAME, impl->dlt, dlt);
+        return -1;
+    }
+
+    if ( impl->num_ifs < PCAPNG_MAX_IFS )
+    {
+        impl->if_snaplen[impl->num_ifs] = get32(impl, body + 4);
+        impl->if_tsres[impl->num_ifs] = pcapng_tsresol(impl, body + 8, end);
+    }
+    impl->num_ifs++;
+    return 0;
+}
+
+static void set_ts(struct timeval* tv, uint64_t ts, uint64_t res)
+{
+    tv->tv_sec = ts / res;
+
+    if ( !(res % 1000000) )
+        tv->tv_usec = (ts % res) / (res / 1000000);
+    else
+        tv->tv_usec = (uint64_t)((double)(ts % res) * 1e6 / res);
+}
+
+// return 1 and set hdr/data for the next packet, 0 at eof, -1 on error
+static int pcap_next(MmapImpl* impl, DAQ_PktHdr_t* hdr, const uint8_t** data)
+{
+    if ( impl->pos + PCAP_REC_LEN > impl->size )
+        return 0;
+
+    const uint8_t* rec = impl->map + impl->pos;
+    uint32_t caplen = get32(impl, rec + 8);
+
+    if ( caplen > impl->size - impl->pos - PCAP_REC_LEN )
+    {
+        // truncated last record is treated like libpcap does
+        return 0;
+    }
+
+    hdr->ts.tv_sec = get32(impl, rec);
+    hdr->ts.tv_usec = get32(impl, rec + 4) / impl->ts_div;
+    hdr->caplen = caplen;
+    hdr->pktlen = get32(impl, rec + 12);
+
+    *data = rec + PCAP_REC_LEN;
+    impl->pos += PCAP_REC_LEN + caplen;
+    return 1;
+}
+
+static int pcapng_next(MmapImpl* impl, DAQ_PktHdr_t* hdr, const uint8_t** data)
+{
+    while ( impl->pos + 12 <= impl->size )
+    {
+        const uint8_t* blk = impl->map + impl->pos;
+        uint32_t type, len;
+
+        memcpy(&type, blk, sizeof(type));
+
+        if ( type == PCAPNG_SHB )
+        {
+            // a new section may switch byte order
+            uint32_t bom;
+            memcpy(&bom, blk + 8, sizeof(bom));
+            impl->swap = (bom != PCAPNG_BOM);
+            impl->num_ifs = 0;
+        }
+        else
+            type = get32(impl, blk);
+
+        len = get32(impl, blk + 4);
+
+        if ( len < 12 || (len & 3) || len > impl->size - impl->pos )
+        {
+            DPE(impl->error, "%s: bad pcapng block length %u at offset %zu\n",
+                DAQ_NAME, len, impl->pos);
+            return -1;
+        }
+
+        const uint8_t* body = blk + 8;
+        const uint8_t* end = blk + len - 4;
+        impl->pos += len;
+
+        if ( type == PCAPNG_IDB )
+        {
+            if ( pcapng_add_interface(impl, body, end) )
+                return -1;
+            continue;
+        }
+
+        if ( type == PCAPNG_EPB || type == PCAPNG_PB )
+        {
+            if ( body + 20 > end )
+                return -1;
+
+            unsigned ifx = (type == PCAPNG_EPB) ? get32(impl, body) : get16(impl, body);
+            uint64_t ts = ((uint64_t)get32(impl, body + 4) << 32) | get32(impl, body + 8);
+            uint32_t caplen = get32(impl, body + 12);
+
+            // compare lengths; a pointer past the block can overflow
+            if ( caplen > (size_t)(end - body - 20) )
+                return -1;
+
+            set_ts(&hdr->ts, ts, ifx < PCAPNG_MAX_IFS ? impl->if_tsres[ifx] : 1000000);
+            hdr->caplen = caplen;
+            hdr->pktlen = get32(impl, body + 16);
+            *data = body + 20;
+            return 1;
+        }
+
+        if ( type == PCAPNG_SPB )
+        {
+            if ( body + 4 > end )
+                return -1;
+
+            uint32_t pktlen = get32(impl, body);
+            uint32_t caplen = end - body - 4;
+
+            if ( caplen > pktlen )
+                caplen = pktlen;
+
+            if ( impl->num_ifs && impl->if_snaplen[0] && caplen > impl->if_snaplen[0] )
+                caplen = impl->if_snaplen[0];
+
+            // simple packet blocks have no timestamp
+            hdr->ts.tv_sec = hdr->ts.tv_usec = 0;
+            hdr->caplen = caplen;
+            hdr->pktlen = pktlen;
+            *data = body + 4;
+            return 1;
+        }
+        // skip name resolution, statistics, custom blocks, etc.
+    }
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+// file functions
+//-------------------------------------------------------------------------
+
+static void mmap_cleanup(MmapImpl* impl)
+{
+    if ( impl->map )
+        munmap((void*)impl->map, impl->size);
+
+    if ( impl->fid >= 0 )
+        close(impl->fid);
+
+    impl->map = NULL;
+    impl->fid = -1;
+}
+
+static int mmap_setup(MmapImpl* impl)
+{
+    struct stat sb;
+
+    if ( !impl->name || !strcmp(impl->name, "-") )
+    {
+        DPE(impl->error, "%s: can't map stdin; use the pcap daq instead\n", DAQ_NAME);
+        return -1;
+    }
+
+    if ( (impl->fid = open(impl->name, O_RDONLY)) < 0 )
+    {
+        DPE(impl->error, "%s: can't open file %s (%s)\n",
+            DAQ_NAME, impl->name, strerror(errno));
+        return -1;
+    }
+
+    if ( fstat(impl->fid, &sb) || !S_ISREG(sb.st_mode) )
+    {
+        DPE(impl->error, "%s: %s is not a regular file\n", DAQ_NAME, impl->name);
+        mmap_cleanup(impl);
+        return -1;
+    }
+
+    impl->size = sb.st_size;
+
+    void* map = mmap(NULL, impl->size, PROT_READ|PROT_WRITE, MAP_PRIVATE, impl->fid, 0);
+
+    if ( map == MAP_FAILED )
+    {
+        DPE(impl->error, "%s: can't map file %s (%s)\n",
+            DAQ_NAME, impl->name, strerror(errno));
+        impl->map = NULL;
+        mmap_cleanup(impl);
+        return -1;
+    }
+    impl->map = (const uint8_t*)map;
+
+    // packets are read once front to back
+    madvise(map, impl->size, MADV_SEQUENTIAL);
+    madvise(map, impl->size, MADV_WILLNEED);
+
+    int rval = pcap_open_header(impl);
+
+    if ( rval > 0 )
+        rval = pcapng_open_header(impl);
+
+    if ( rval )
+    {
+        if ( rval > 0 )
+            DPE(impl->error, "%s: %s is not a pcap or pcapng file\n", DAQ_NAME, impl->name);
+
+        mmap_cleanup(impl);
+        return -1;
+    }
+
+    // pcapng gets the link type from the first interface block
+    if ( impl->fmt == FMT_PCAPNG )
+    {
+        size_t save = impl->pos;
+        DAQ_PktHdr_t hdr;
+        const uint8_t* data;
+
+        if ( pcapng_next(impl, &hdr, &data) < 0 )
+        {
+            mmap_cleanup(impl);
+            return -1;
+        }
+        impl->pos = save;
+        impl->num_ifs = 0;
+
+        if ( impl->dlt < 0 )
+            impl->dlt = DLT_EN10MB;
+    }
+    return 0;
+}
+
+//-------------------------------------------------------------------------
+// daq utilities
+//-------------------------------------------------------------------------
+
+static int get_vars (
+    MmapImpl* impl, const DAQ_Config_t* cfg, char* errBuf, size_t errMax
+) {
+    DAQ_Dict* entry;
+
+    for ( entry = cfg->values; entry; entry = entry->next)
+    {
+        if ( !strcmp(entry->key, "speed") )
+        {
+            char* end = NULL;
+            impl->speed = strtod(entry->value ? entry->value : "", &end);
+
+            if ( !end || *end || impl->speed < 0.0 )
+            {
+                snprintf(errBuf, errMax, "%s: bad speed (%s)", DAQ_NAME,
+                    entry->value ? entry->value : "");
+                return 0;
+            }
+        }
+        else
+        {
+            snprintf(errBuf, errMax, "%s: unknown var (%s)", DAQ_NAME, entry->key);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// sleep until the packet is due at the configured multiple of capture rate
+static void pace(MmapImpl* impl, const struct timeval* ts)
+{
+    if ( !impl->paced )
+    {
+        impl->first_pkt = *ts;
+        clock_gettime(CLOCK_MONOTONIC, &impl->first_wall);
+        impl->paced = 1;
+        return;
+    }
+    double cap = (ts->tv_sec - impl->first_pkt.tv_sec) +
+        (ts->tv_usec - impl->first_pkt.tv_usec) / 1e6;
+
+    if ( cap <= 0.0 )
+        return;
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    double wall = (now.tv_sec - impl->first_wall.tv_sec) +
+        (now.tv_nsec - impl->first_wall.tv_nsec) / 1e9;
+
+    double delay = cap / impl->speed - wall;
+
+    if ( delay > 0.0 )
+    {
+        struct timespec ts_delay;
+        ts_delay.tv_sec = (time_t)delay;
+        ts_delay.tv_nsec = (long)((delay - ts_delay.tv_sec) * 1e9);
+        nanosleep(&ts_delay, NULL);
+    }
+}
+
+static int mmap_daq_process(
+    MmapImpl* impl, DAQ_Analysis_Func_t cb, void* user)
+{
+    DAQ_PktHdr_t hdr;
+    const uint8_t* data = NULL;
+
+    int n = (impl->fmt == FMT_PCAP) ?
+        pcap_next(impl, &hdr, &data) : pcapng_next(impl, &hdr, &data);
+
+    if ( n <= 0 )
+        return n ? DAQ_ERROR : DAQ_READFILE_EOF;
+
+    if ( hdr.caplen > impl->snaplen )
+        hdr.caplen = impl->snaplen;
+
+    hdr.ingress_index = hdr.egress_index = -1;
+    hdr.ingress_group = hdr.egress_group = -1;
+
+    hdr.flags = 0;
+    hdr.address_space_id = 0;
+    hdr.opaque = 0;
+    hdr.priv_ptr = NULL;
+
+    impl->stats.hw_packets_received++;
+
+    if ( impl->have_filter && !sfbpf_filter(impl->fcode.bf_insns, data, hdr.pktlen, hdr.caplen) )
+    {
+        impl->stats.packets_filtered++;
+        return 1;
+    }
+
+    if ( impl->speed > 0.0 )
+        pace(impl, &hdr.ts);
+
+    impl->stats.packets_received++;
+    DAQ_Verdict verdict = cb(user, &hdr, data);
+
+    if ( verdict >= MAX_DAQ_VERDICT )
+        verdict = DAQ_VERDICT_BLOCK;
+
+    impl->stats.verdicts[verdict]++;
+    return 1;
+}
+
+//-------------------------------------------------------------------------
+// daq
+//-------------------------------------------------------------------------
+
+static void mmap_daq_shutdown (void* handle)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+
+    mmap_cleanup(impl);
+
+    if ( impl->have_filter )
+        sfbpf_freecode(&impl->fcode);
+
+    if ( impl->name )
+        free(impl->name);
+
+    free(impl);
+}
+
+//-------------------------------------------------------------------------
+
+static int mmap_daq_initialize (
+    const DAQ_Config_t* cfg, void** handle, char* errBuf, size_t errMax)
+{
+    MmapImpl* impl = calloc(1, sizeof(*impl));
+
+    if ( !impl )
+    {
+        snprintf(errBuf, errMax, "%s: failed to allocate the mmap context", DAQ_NAME);
+        return DAQ_ERROR_NOMEM;
+    }
+
+    impl->fid = -1;
+    impl->snaplen = cfg->snaplen ? cfg->snaplen : DEF_SNAPLEN;
+
+    if ( !get_vars(impl, cfg, errBuf, errMax) )
+    {
+        free(impl);
+        return DAQ_ERROR;
+    }
+
+    if ( cfg->name )
+    {
+        if ( !(impl->name = strdup(cfg->name)) )
+        {
+            snprintf(errBuf, errMax, "%s: failed to allocate the filename", DAQ_NAME);
+            free(impl);
+            return DAQ_ERROR_NOMEM;
+        }
+    }
+
+    // the header is needed now for the datalink type
+    if ( mmap_setup(impl) )
+    {
+        snprintf(errBuf, errMax, "%s", impl->error);
+        mmap_daq_shutdown(impl);
+        return DAQ_ERROR;
+    }
+
+    impl->state = DAQ_STATE_INITIALIZED;
+
+    *handle = impl;
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+
+static int mmap_daq_start (void* handle)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    impl->state = DAQ_STATE_STARTED;
+    return DAQ_SUCCESS;
+}
+
+static int mmap_daq_stop (void* handle)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    mmap_cleanup(impl);
+    impl->state = DAQ_STATE_STOPPED;
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+
+static int mmap_daq_inject (
+    void* handle, const DAQ_PktHdr_t* hdr, const uint8_t* buf, uint32_t len,
+    int rev)
+{
+    (void)handle;
+    (void)hdr;
+    (void)buf;
+    (void)len;
+    (void)rev;
+    return DAQ_ERROR_NOTSUP;
+}
+
+//-------------------------------------------------------------------------
+
+static int mmap_daq_acquire (
+    void* handle, int cnt, DAQ_Analysis_Func_t callback, DAQ_Meta_Func_t meta, void* user)
+{
+    (void)meta;
+
+    MmapImpl* impl = (MmapImpl*)handle;
+    int hit = 0;
+    impl->stop = 0;
+
+    while ( (hit < cnt || cnt <= 0) && !impl->stop )
+    {
+        int status = mmap_daq_process(impl, callback, user);
+
+        if ( status < 0 )
+            return status;
+
+        hit++;
+    }
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+
+static int mmap_daq_breakloop (void* handle)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    impl->stop = 1;
+    return DAQ_SUCCESS;
+}
+
+static DAQ_State mmap_daq_check_status (void* handle)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    return impl->state;
+}
+
+static int mmap_daq_get_stats (void* handle, DAQ_Stats_t* stats)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    *stats = impl->stats;
+    return DAQ_SUCCESS;
+}
+
+static void mmap_daq_reset_stats (void* handle)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    memset(&impl->stats, 0, sizeof(impl->stats));
+}
+
+static int mmap_daq_get_snaplen (void* handle)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    return impl->snaplen;
+}
+
+static uint32_t mmap_daq_get_capabilities (void* handle)
+{
+    (void)handle;
+    return DAQ_CAPA_BLOCK | DAQ_CAPA_REPLACE | DAQ_CAPA_BREAKLOOP | DAQ_CAPA_UNPRIV_START
+        | DAQ_CAPA_BPF;
+}
+
+static int mmap_daq_get_datalink_type(void *handle)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    return impl->dlt;
+}
+
+static const char* mmap_daq_get_errbuf (void* handle)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    return impl->error;
+}
+
+static void mmap_daq_set_errbuf (void* handle, const char* s)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    DPE(impl->error, "%s", s ? s : "");
+}
+
+static int mmap_daq_get_device_index(void* handle, const char* device)
+{
+    (void)handle;
+    (void)device;
+    return DAQ_ERROR_NOTSUP;
+}
+
+static int mmap_daq_set_filter (void* handle, const char* filter)
+{
+    MmapImpl* impl = (MmapImpl*)handle;
+    struct sfbpf_program fcode;
+
+    if ( sfbpf_compile(impl->snaplen, impl->dlt, &fcode, filter, 1, 0) < 0 )
+    {
+        DPE(impl->error, "%s: can't compile bpf filter (%s)\n", DAQ_NAME, filter);
+        return DAQ_ERROR;
+    }
+
+    if ( impl->have_filter )
+        sfbpf_freecode(&impl->fcode);
+
+    impl->fcode = fcode;
+    impl->have_filter = 1;
+    return DAQ_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+
+#ifdef BUILDING_SO
+DAQ_SO_PUBLIC DAQ_Module_t DAQ_MODULE_DATA =
+#else
+DAQ_Module_t mmap_daq_module_data =
+#endif
+{
+    .api_version = DAQ_API_VERSION,
+    .module_version = DAQ_MOD_VERSION,
+    .name = DAQ_NAME,
+    .type = DAQ_TYPE,
+    .initialize = mmap_daq_initialize,
+    .set_filter = mmap_daq_set_filter,
+    .start = mmap_daq_start,
+    .acquire = mmap_daq_acquire,
+    .inject = mmap_daq_inject,
+    .breakloop = mmap_daq_breakloop,
+    .stop = mmap_daq_stop,
+    .shutdown = mmap_daq_shutdown,
+    .check_status = mmap_daq_check_status,
+    .get_stats = mmap_daq_get_stats,
+    .reset_stats = mmap_daq_reset_stats,
+    .get_snaplen = mmap_daq_get_snaplen,
+    .get_capabilities = mmap_daq_get_capabilities,
+    .get_datalink_type = mmap_daq_get_datalink_type,
+    .get_errbuf = mmap_daq_get_errbuf,
+    .set_errbuf = mmap_daq_set_errbuf,
+    .get_device_index = mmap_daq_get_device_index,
+    .modify_flow = NULL,
+    .hup_prep = NULL,
+    .hup_apply = NULL,
+    .hup_post = NULL,
+    .dp_add_dc = NULL
+};
+
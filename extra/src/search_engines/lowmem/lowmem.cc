@@ -127,6 +127,7 @@ static const MpseApi lm_api =
         nullptr
     },
     false,
+    false,
     nullptr,
     nullptr,
     nullptr,
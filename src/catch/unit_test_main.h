@@ -27,22 +27,26 @@
 
 // Unresolved external symbol declarations and references.
 SNORT_CATCH_FORCED_INCLUSION_EXTERN(bitop_test);
+SNORT_CATCH_FORCED_INCLUSION_EXTERN(reputation_parse_test);
 SNORT_CATCH_FORCED_INCLUSION_EXTERN(sfdaq_module_test);
 SNORT_CATCH_FORCED_INCLUSION_EXTERN(sfip_test);
 SNORT_CATCH_FORCED_INCLUSION_EXTERN(sfrf_test);
 SNORT_CATCH_FORCED_INCLUSION_EXTERN(sfrt_test);
 SNORT_CATCH_FORCED_INCLUSION_EXTERN(sfthd_test);
 SNORT_CATCH_FORCED_INCLUSION_EXTERN(stopwatch_test);
+SNORT_CATCH_FORCED_INCLUSION_EXTERN(track_table_test);
 
 bool catch_extern_tests[] =
 {
     SNORT_CATCH_FORCED_INCLUSION_SYMBOL(bitop_test),
+    SNORT_CATCH_FORCED_INCLUSION_SYMBOL(reputation_parse_test),
     SNORT_CATCH_FORCED_INCLUSION_SYMBOL(sfdaq_module_test),
     SNORT_CATCH_FORCED_INCLUSION_SYMBOL(sfip_test),
     SNORT_CATCH_FORCED_INCLUSION_SYMBOL(sfrf_test),
     SNORT_CATCH_FORCED_INCLUSION_SYMBOL(sfrt_test),
     SNORT_CATCH_FORCED_INCLUSION_SYMBOL(sfthd_test),
     SNORT_CATCH_FORCED_INCLUSION_SYMBOL(stopwatch_test),
+    SNORT_CATCH_FORCED_INCLUSION_SYMBOL(track_table_test),
 };
 
 #endif
@@ -49,12 +49,17 @@
 THREAD_LOCAL SimpleStats tcp_connector_stats;
 THREAD_LOCAL ProfileStats tcp_connector_perfstats;
 
+// handles are recycled rather than freed; these bound what is kept around
+#define TCP_POOL_MAX 256
+#define TCP_RECEIVE_BATCH 32
+
 TcpConnectorMsgHandle::TcpConnectorMsgHandle(const uint32_t length)
 {
     DebugMessage(DEBUG_CONNECTORS,"TcpConnectorMsgHandle::TcpConnectorMsgHandle()\n");
 
     connector_msg.length = length;
     connector_msg.data = new uint8_t[length];
+    capacity = length;
 }
 
 TcpConnectorMsgHandle::~TcpConnectorMsgHandle()
@@ -62,6 +67,17 @@ TcpConnectorMsgHandle::~TcpConnectorMsgHandle()
     delete[] connector_msg.data;
 }
 
+void TcpConnectorMsgHandle::resize(const uint32_t length)
+{
+    if ( length > capacity )
+    {
+        delete[] connector_msg.data;
+        connector_msg.data = new uint8_t[length];
+        capacity = length;
+    }
+    connector_msg.length = length;
+}
+
 TcpConnectorCommon::TcpConnectorCommon(TcpConnectorConfig::TcpConnectorConfigSet* conf)
 {
     config_set = (ConnectorConfig::ConfigSet*)conf;
@@ -128,7 +144,7 @@ static ReadDataOutcome read_message_data(int sockfd, uint16_t length, uint8_t *d
 }
 
 
-static TcpConnectorMsgHandle* read_message(int sock_fd)
+TcpConnectorMsgHandle* TcpConnector::read_message()
 {
     TcpConnectorMsgHdr hdr;
     ReadDataOutcome outcome;
@@ -149,7 +165,15 @@ static TcpConnectorMsgHandle* read_message(int sock_fd)
         return nullptr;
     }
 
-    TcpConnectorMsgHandle* handle = new TcpConnectorMsgHandle(hdr.connector_msg_length);
+    TcpConnectorMsgHandle* handle = free_ring->get(nullptr);
+
+    if ( handle )
+        handle->resize(hdr.connector_msg_length);
+    else
+    {
+        handle = new TcpConnectorMsgHandle(hdr.connector_msg_length);
+        handle->received = true;
+    }
 
     if ((outcome = read_message_data(sock_fd, hdr.connector_msg_length, handle->connector_msg.data)) != SUCCESS)
     {
@@ -187,10 +211,27 @@ void TcpConnector::process_receive()
     }
     else if (rval > 0 && pfds[0].revents & POLLIN)
     {
-        TcpConnectorMsgHandle* handle;
-        if ( (handle = read_message(sock_fd)) != nullptr )
+        // drain whatever is already queued on the socket before polling again
+        for ( unsigned i = 0; i < TCP_RECEIVE_BATCH; ++i )
+        {
+            TcpConnectorMsgHandle* handle;
+
+            if ( (handle = read_message()) == nullptr )
+                break;
+
             if ( !receive_ring->put(handle) )
+            {
                 ErrorMessage("TcpC Input Thread: overrun\n");
+                delete handle;
+                break;
+            }
+
+            pfds[0].revents = 0;
+
+            if ( poll(pfds, 1, 0) <= 0 || !(pfds[0].revents & POLLIN) ||
+                (pfds[0].revents & (POLLHUP|POLLERR|POLLNVAL)) )
+                break;
+        }
     }
 }
 
@@ -224,7 +265,15 @@ TcpConnector::TcpConnector(TcpConnectorConfig* tcp_connector_config, int sfd)
     receive_thread = nullptr;
     config = tcp_connector_config;
     receive_ring = new ReceiveRing(50);
+    free_ring = new ReceiveRing(50);
     sock_fd = sfd;
+
+    batch_size = tcp_connector_config->batch_size ? tcp_connector_config->batch_size : 1;
+    tx_pool.reserve(TCP_POOL_MAX);
+    tx_batch.reserve(batch_size);
+    tx_hdrs.resize(batch_size);
+    tx_iov.resize(2 * batch_size);
+
     if ( tcp_connector_config->async_receive )
         start_receive_thread();
 }
@@ -232,15 +281,52 @@ TcpConnector::TcpConnector(TcpConnectorConfig* tcp_connector_config, int sfd)
 TcpConnector::~TcpConnector()
 {
     DebugMessage(DEBUG_CONNECTORS,"TcpConnector::~TcpConnector()\n");
+    flush();
     stop_receive_thread();
+
+    TcpConnectorMsgHandle* handle;
+
+    while ( (handle = receive_ring->get(nullptr)) )
+        delete handle;
+
+    while ( (handle = free_ring->get(nullptr)) )
+        delete handle;
+
+    for ( auto h : tx_pool )
+        delete h;
+
     delete receive_ring;
+    delete free_ring;
     close(sock_fd);
 }
 
+void TcpConnector::release(TcpConnectorMsgHandle* tmsg)
+{
+    if ( tmsg->received )
+    {
+        if ( !free_ring->put(tmsg) )
+            delete tmsg;
+    }
+    else if ( tx_pool.size() < TCP_POOL_MAX )
+        tx_pool.push_back(tmsg);
+
+    else
+        delete tmsg;
+}
+
 ConnectorMsgHandle* TcpConnector::alloc_message(const uint32_t length, const uint8_t** data)
 {
     DebugMessage(DEBUG_CONNECTORS,"TcpConnector::alloc_message()\n");
-    TcpConnectorMsgHandle* msg = new TcpConnectorMsgHandle(length);
+    TcpConnectorMsgHandle* msg;
+
+    if ( !tx_pool.empty() )
+    {
+        msg = tx_pool.back();
+        tx_pool.pop_back();
+        msg->resize(length);
+    }
+    else
+        msg = new TcpConnectorMsgHandle(length);
 
     *data = (uint8_t*)msg->connector_msg.data;
 
@@ -250,10 +336,10 @@ ConnectorMsgHandle* TcpConnector::alloc_message(const uint32_t length, const uin
 void TcpConnector::discard_message(ConnectorMsgHandle* msg)
 {
     DebugMessage(DEBUG_CONNECTORS,"TcpConnector::discard_message()\n");
-    TcpConnectorMsgHandle* tmsg = (TcpConnectorMsgHandle*)msg;
-    delete tmsg;
+    release((TcpConnectorMsgHandle*)msg);
 }
 
+// messages are queued until batch_size is reached or flush() is called
 bool TcpConnector::transmit_message(ConnectorMsgHandle* msg)
 {
     DebugMessage(DEBUG_CONNECTORS,"TcpConnector::transmit_message()\n");
@@ -262,27 +348,59 @@ bool TcpConnector::transmit_message(ConnectorMsgHandle* msg)
     if ( sock_fd < 0 )
     {
         ErrorMessage("TcpConnector: tranmitting to a closed socket\n");
-        delete tmsg;
+        release(tmsg);
         return false;
     }
 
-    TcpConnectorMsgHdr tcpc_hdr(tmsg->connector_msg.length);
+    tx_batch.push_back(tmsg);
+
+    if ( tx_batch.size() < batch_size )
+        return true;
+
+    return flush();
+}
+
+// send each header and message of the batch with a single writev
+bool TcpConnector::flush()
+{
+    if ( tx_batch.empty() )
+        return true;
 
-    if ( send( sock_fd, (const char*)&tcpc_hdr, sizeof(tcpc_hdr), 0 ) != sizeof(tcpc_hdr) )
+    unsigned num = tx_batch.size();
+    ssize_t total = 0;
+
+    for ( unsigned i = 0; i < num; ++i )
     {
-        ErrorMessage("TcpConnector: failed to transmit header\n");
-        delete tmsg;
-        return false;
+        ConnectorMsg& cm = tx_batch[i]->connector_msg;
+        tx_hdrs[i] = TcpConnectorMsgHdr(cm.length);
+
+        tx_iov[2*i].iov_base = &tx_hdrs[i];
+        tx_iov[2*i].iov_len = sizeof(TcpConnectorMsgHdr);
+        tx_iov[2*i+1].iov_base = cm.data;
+        tx_iov[2*i+1].iov_len = cm.length;
+
+        total += sizeof(TcpConnectorMsgHdr) + cm.length;
     }
 
-    if ( send( sock_fd, (const char*)tmsg->connector_msg.data, tmsg->connector_msg.length, 0 ) !=
-        tmsg->connector_msg.length )
+    ssize_t n = -1;
+
+    if ( sock_fd >= 0 )
     {
-        delete tmsg;
-        return false;
+        do
+            n = writev(sock_fd, tx_iov.data(), 2 * num);
+        while ( n < 0 && errno == EINTR );
     }
 
-    delete tmsg;
+    for ( auto h : tx_batch )
+        release(h);
+
+    tx_batch.clear();
+
+    if ( n != total )
+    {
+        ErrorMessage("TcpConnector: failed to transmit %u messages\n", num);
+        return false;
+    }
 
     return true;
 }
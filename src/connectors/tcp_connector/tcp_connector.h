@@ -21,8 +21,11 @@
 #ifndef TCP_CONNECTOR_H
 #define TCP_CONNECTOR_H
 
+#include <sys/uio.h>
+
 #include <fstream>
 #include <thread>
+#include <vector>
 
 #include "tcp_connector_config.h"
 #include "framework/connector.h"
@@ -52,7 +55,13 @@ class TcpConnectorMsgHandle : public ConnectorMsgHandle
 public:
     TcpConnectorMsgHandle(const uint32_t length);
     ~TcpConnectorMsgHandle();
+
+    // reuse the data buffer if it is big enough
+    void resize(const uint32_t length);
+
     ConnectorMsg connector_msg;
+    uint32_t capacity;
+    bool received = false;
 };
 
 class TcpConnectorCommon : public ConnectorCommon
@@ -72,6 +81,7 @@ public:
     ConnectorMsgHandle* alloc_message(const uint32_t, const uint8_t**);
     void discard_message(ConnectorMsgHandle*);
     bool transmit_message(ConnectorMsgHandle*);
+    bool flush();
     ConnectorMsgHandle* receive_message(bool);
 
     ConnectorMsg* get_connector_msg(ConnectorMsgHandle* handle)
@@ -88,7 +98,21 @@ private:
     void start_receive_thread();
     void stop_receive_thread();
     void receive_processing_thread();
+    TcpConnectorMsgHandle* read_message();
+    void release(TcpConnectorMsgHandle*);
+
+    // receive thread -> packet thread
     ReceiveRing* receive_ring;
+
+    // packet thread -> receive thread; recycled receive handles
+    ReceiveRing* free_ring;
+
+    // packet thread only; recycled transmit handles and the pending batch
+    std::vector<TcpConnectorMsgHandle*> tx_pool;
+    std::vector<TcpConnectorMsgHandle*> tx_batch;
+    std::vector<TcpConnectorMsgHdr> tx_hdrs;
+    std::vector<struct iovec> tx_iov;
+    unsigned batch_size;
 };
 
 #endif
@@ -30,12 +30,13 @@ class TcpConnectorConfig : public ConnectorConfig
 public:
     enum Setup { CALL, ANSWER };
     TcpConnectorConfig()
-    { direction = Connector::CONN_DUPLEX; async_receive = true; }
+    { direction = Connector::CONN_DUPLEX; async_receive = true; batch_size = 16; }
 
     uint16_t base_port;
     std::string address;
     Setup setup;
     bool async_receive;
+    unsigned batch_size;
 
     typedef std::vector<TcpConnectorConfig*> TcpConnectorConfigSet;
 };
@@ -36,6 +36,9 @@ static const Parameter tcp_connector_params[] =
     { "setup", Parameter::PT_ENUM, "call | answer", nullptr,
       "stream establishment" },
 
+    { "batch_size", Parameter::PT_INT, "1:64", "16",
+      "maximum number of messages coalesced into one socket write" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -89,6 +92,9 @@ bool TcpConnectorModule::set(const char* fqn, Value& v, SnortConfig*)
     else if ( v.is("base_port") )
         config->base_port = v.get_long();
 
+    else if ( v.is("batch_size") )
+        config->batch_size = v.get_long();
+
     else if ( v.is("setup") )
         switch ( v.get_long() )
         {
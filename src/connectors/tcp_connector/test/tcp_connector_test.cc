@@ -24,6 +24,7 @@
 
 #include <sys/socket.h>
 #include <sys/poll.h>
+#include <sys/uio.h>
 #include <netdb.h>
 
 #include "main/snort_debug.h"
@@ -57,6 +58,7 @@ static bool s_rec_return_zero = false;
 
 static int s_send_ret_header = sizeof(TcpConnectorMsgHdr);
 static int s_send_ret_other = 0;
+static int s_writev_calls = 0;
 
 TcpConnectorConfig connector_config;
 
@@ -82,12 +84,22 @@ void ErrorMessage(const char*, ...) { }
 void LogMessage(const char*, ...) { }
 
 int connect (int, __CONST_SOCKADDR_ARG, socklen_t) { return s_connect_return; }
-ssize_t send (int, const void*, size_t n, int)
+ssize_t writev (int, const struct iovec* iov, int iovcnt)
 {
-    if ( n == sizeof(TcpConnectorMsgHdr) )
-        return s_send_ret_header;
-    else
-        return s_send_ret_other;
+    ssize_t n = 0;
+    s_writev_calls++;
+
+    for ( int i = 0; i < iovcnt; i++ )
+    {
+        ssize_t r = ( iov[i].iov_len == sizeof(TcpConnectorMsgHdr) ) ?
+            s_send_ret_header : s_send_ret_other;
+
+        n += r;
+
+        if ( r != (ssize_t)iov[i].iov_len )
+            break;
+    }
+    return n;
 }
 
 int poll (struct pollfd* fds, nfds_t nfds, int)
@@ -152,6 +164,7 @@ static void set_normal_status()
     s_accept_return = 2;
     s_send_ret_header = sizeof(TcpConnectorMsgHdr);
     s_send_ret_other = 0;
+    s_writev_calls = 0;
     s_connect_return = 1;
     s_send_ret_header = sizeof(TcpConnectorMsgHdr);
     s_send_ret_other = 0;
@@ -376,6 +389,7 @@ TEST_GROUP(tcp_connector_tinit_tterm_thread_call)
         connector_config.base_port = 10000;
         connector_config.setup = TcpConnectorConfig::Setup::CALL;
         connector_config.async_receive = true;
+        connector_config.batch_size = 1;
         CHECK(tcp_connector != nullptr);
         mod = tcp_connector->mod_ctor();
         CHECK(mod != nullptr);
@@ -410,6 +424,7 @@ TEST_GROUP(tcp_connector_tinit_tterm_call)
         connector_config.base_port = 10000;
         connector_config.setup = TcpConnectorConfig::Setup::CALL;
         connector_config.async_receive = false;
+        connector_config.batch_size = 1;
         CHECK(tcp_connector != nullptr);
         mod = tcp_connector->mod_ctor();
         CHECK(mod != nullptr);
@@ -444,6 +459,7 @@ TEST_GROUP(tcp_connector_no_tinit_tterm_call)
         connector_config.base_port = 10000;
         connector_config.setup = TcpConnectorConfig::Setup::CALL;
         connector_config.async_receive = false;
+        connector_config.batch_size = 1;
         CHECK(tcp_connector != nullptr);
         mod = tcp_connector->mod_ctor();
         CHECK(mod != nullptr);
@@ -610,6 +626,56 @@ TEST(tcp_connector_tinit_tterm_call, alloc_transmit_body_fail)
     CHECK(tcpc->transmit_message(handle) == false);
 }
 
+TEST(tcp_connector_tinit_tterm_call, alloc_transmit_reuse)
+{
+    const uint8_t* data = nullptr;
+    TcpConnector* tcpc = (TcpConnector*)connector;
+    set_normal_status();
+
+    TcpConnectorMsgHandle* handle = (TcpConnectorMsgHandle*)(tcpc->alloc_message(40,&data));
+    s_send_ret_other = 40;
+    CHECK(tcpc->transmit_message(handle) == true);
+
+    TcpConnectorMsgHandle* handle2 = (TcpConnectorMsgHandle*)(tcpc->alloc_message(20,&data));
+    CHECK(handle2 == handle);
+    CHECK(handle2->connector_msg.length == 20);
+    CHECK(handle2->connector_msg.data == data);
+    tcpc->discard_message(handle2);
+}
+
+TEST(tcp_connector_tinit_tterm_call, alloc_transmit_batch)
+{
+    const uint8_t* data = nullptr;
+    tcpc_api->tterm(connector);
+    set_normal_status();
+
+    connector_config.batch_size = 3;
+    connector = tcpc_api->tinit(&connector_config);
+    CHECK(connector != nullptr);
+    TcpConnector* tcpc = (TcpConnector*)connector;
+
+    s_send_ret_other = 40;
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        TcpConnectorMsgHandle* handle = (TcpConnectorMsgHandle*)(tcpc->alloc_message(40,&data));
+        CHECK(tcpc->transmit_message(handle) == true);
+    }
+    CHECK(s_writev_calls == 0);
+
+    TcpConnectorMsgHandle* handle = (TcpConnectorMsgHandle*)(tcpc->alloc_message(40,&data));
+    CHECK(tcpc->transmit_message(handle) == true);
+    CHECK(s_writev_calls == 1);
+
+    handle = (TcpConnectorMsgHandle*)(tcpc->alloc_message(40,&data));
+    CHECK(tcpc->transmit_message(handle) == true);
+    CHECK(s_writev_calls == 1);
+    CHECK(tcpc->flush() == true);
+    CHECK(s_writev_calls == 2);
+    CHECK(tcpc->flush() == true);
+    CHECK(s_writev_calls == 2);
+}
+
 TEST(tcp_connector_tinit_tterm_call, alloc_transmit_no_sock)
 {
     const uint8_t* data = nullptr;
@@ -0,0 +1,74 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// decompress_module.cc
+
+#include "decompress_module.h"
+
+#include "profiler/profiler_defs.h"
+
+#define s_name "decompress"
+
+#ifdef HAVE_ZLIB_NG
+#define s_help "inflate statistics (zlib-ng)"
+#else
+#define s_help "inflate statistics (zlib)"
+#endif
+
+static const PegInfo decompress_pegs[] =
+{
+    { "http gzip streams", "gzip http message bodies started" },
+    { "http gzip bytes in", "compressed octets consumed from gzip http message bodies" },
+    { "http gzip bytes out", "octets produced from gzip http message bodies" },
+    { "http deflate streams", "deflate http message bodies started" },
+    { "http deflate bytes in", "compressed octets consumed from deflate http message bodies" },
+    { "http deflate bytes out", "octets produced from deflate http message bodies" },
+    { "swf zlib streams", "zlib compressed swf files started" },
+    { "swf zlib bytes in", "compressed octets consumed from swf files" },
+    { "swf zlib bytes out", "octets produced from swf files" },
+    { "pdf deflate streams", "pdf flate streams started" },
+    { "pdf deflate bytes in", "compressed octets consumed from pdf flate streams" },
+    { "pdf deflate bytes out", "octets produced from pdf flate streams" },
+    { nullptr, nullptr }
+};
+
+static const char* const profile_names[INFLATE_CODEC_MAX] =
+{
+    "inflate_http_gzip", "inflate_http_deflate", "inflate_swf_zlib", "inflate_pdf_deflate"
+};
+
+DecompressModule::DecompressModule() : Module(s_name, s_help)
+{ }
+
+const PegInfo* DecompressModule::get_pegs() const
+{ return decompress_pegs; }
+
+PegCount* DecompressModule::get_counts() const
+{ return (PegCount*)inflate_counts; }
+
+ProfileStats* DecompressModule::get_profile(
+    unsigned index, const char*& name, const char*& parent) const
+{
+    if ( index >= INFLATE_CODEC_MAX )
+        return nullptr;
+
+    name = profile_names[index];
+    parent = nullptr;
+    return &inflate_perf_stats[index];
+}
+
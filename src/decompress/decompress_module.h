@@ -0,0 +1,51 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// decompress_module.h
+
+#ifndef DECOMPRESS_MODULE_H
+#define DECOMPRESS_MODULE_H
+
+#include "decompress/inflate.h"
+#include "framework/module.h"
+#include "main/thread.h"
+
+// the pegs are these three counts for each codec in InflateCodec order
+struct InflateCounts
+{
+    PegCount streams;
+    PegCount bytes_in;
+    PegCount bytes_out;
+};
+
+extern THREAD_LOCAL InflateCounts inflate_counts[INFLATE_CODEC_MAX];
+extern THREAD_LOCAL ProfileStats inflate_perf_stats[INFLATE_CODEC_MAX];
+
+class DecompressModule : public Module
+{
+public:
+    DecompressModule();
+
+    const PegInfo* get_pegs() const override;
+    PegCount* get_counts() const override;
+
+    ProfileStats* get_profile(unsigned, const char*&, const char*&) const override;
+};
+
+#endif
+
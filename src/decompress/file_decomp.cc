@@ -28,7 +28,6 @@
 #include <lzma.h>
 #endif
 
-#include <zlib.h>
 
 #include "main/snort_types.h"
 #include "utils/util.h"
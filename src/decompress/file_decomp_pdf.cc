@@ -27,7 +27,6 @@
 #include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
-#include <zlib.h>
 
 #include "main/thread.h"
 #include "utils/util.h"
@@ -913,19 +912,14 @@ static fd_status_t Init_Stream(fd_session_p_t SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
-        int z_ret;
+        Inflater* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
 
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
+        memset( (char*)z_s, 0, sizeof(Inflater));
 
-        memset( (char*)z_s, 0, sizeof(z_stream));
-
-        z_s->zalloc = (alloc_func)NULL;
-        z_s->zfree = (free_func)NULL;
         SYNC_IN(z_s)
 
-        z_ret = inflateInit2(z_s, 47);
-
-        if ( z_ret != Z_OK )
+        // detect zlib or gzip header
+        if ( !z_s->init(INFLATE_PDF_DEFLATE, 47) )
         {
             File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
             return( File_Decomp_Error );
@@ -955,21 +949,21 @@ static fd_status_t Decomp_Stream(fd_session_p_t SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
-        int z_ret;
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
+        InflateStatus z_ret;
+        Inflater* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
 
         SYNC_IN(z_s)
 
-        z_ret = inflate(z_s, Z_SYNC_FLUSH);
+        z_ret = z_s->inflate();
 
         SYNC_OUT(z_s)
 
-        if ( z_ret == Z_STREAM_END )
+        if ( z_ret == INFLATE_STREAM_END )
         {
             return( File_Decomp_Complete );
         }
 
-        if ( z_ret != Z_OK )
+        if ( z_ret != INFLATE_OK )
         {
             File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
             return( File_Decomp_Error );
@@ -1015,17 +1009,16 @@ fd_status_t File_Decomp_End_PDF(fd_session_p_t SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_DEFLATE:
     {
-        int z_ret;
-        z_stream* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
+        Inflater* z_s = &(StPtr->PDF_Decomp_State.Deflate.StreamDeflate);
 
-        z_ret = inflateEnd(z_s);
-
-        if ( z_ret != Z_OK )
+        if ( !z_s->is_open() )
         {
             File_Decomp_Alert(SessionPtr, FILE_DECOMP_ERR_PDF_DEFL_FAILURE);
             return( File_Decomp_Error );
         }
 
+        z_s->end();
+
         break;
     }
     default:
@@ -23,8 +23,8 @@
 #define FILE_DECOMP_PDF_H
 
 #include <stdint.h>
-#include <zlib.h>
 
+#include "decompress/inflate.h"
 #include "file_decomp.h"
 
 #define ELEM_BUF_LEN        (12)
@@ -65,7 +65,7 @@ struct fd_PDF_Parse_t
 
 struct fd_PDF_Deflate_t
 {
-    z_stream StreamDeflate;
+    Inflater StreamDeflate;
 };
 
 struct fd_PDF_t
@@ -24,7 +24,6 @@
 #include "config.h"
 #endif
 
-#include <zlib.h>
 #include <string.h>
 
 #ifdef HAVE_LZMA
@@ -109,21 +108,21 @@ static fd_status_t Decomp(fd_session_p_t SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_ZLIB:
     {
-        int z_ret;
-        z_stream* z_s = &(SessionPtr->SWF->StreamZLIB);
+        InflateStatus z_ret;
+        Inflater* z_s = &(SessionPtr->SWF->StreamZLIB);
 
         SYNC_IN(z_s)
 
-        z_ret = inflate(z_s, Z_SYNC_FLUSH);
+        z_ret = z_s->inflate();
 
         SYNC_OUT(z_s)
 
-        if ( z_ret == Z_STREAM_END )
+        if ( z_ret == INFLATE_STREAM_END )
         {
             return( File_Decomp_Complete );
         }
 
-        if ( z_ret != Z_OK )
+        if ( z_ret != INFLATE_OK )
         {
             SessionPtr->Error_Event = FILE_DECOMP_ERR_SWF_ZLIB_FAILURE;
             return( File_Decomp_DecompError );
@@ -173,17 +172,16 @@ fd_status_t File_Decomp_End_SWF(fd_session_p_t SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_ZLIB:
     {
-        int z_ret;
-        z_stream* z_s = &(SessionPtr->SWF->StreamZLIB);
+        Inflater* z_s = &(SessionPtr->SWF->StreamZLIB);
 
-        z_ret = inflateEnd(z_s);
-
-        if ( z_ret != Z_OK )
+        if ( !z_s->is_open() )
         {
             SessionPtr->Error_Event = FILE_DECOMP_ERR_SWF_ZLIB_FAILURE;
             return( File_Decomp_DecompError );
         }
 
+        z_s->end();
+
         break;
     }
 #ifdef HAVE_LZMA
@@ -219,23 +217,18 @@ fd_status_t File_Decomp_Init_SWF(fd_session_p_t SessionPtr)
     {
     case FILE_COMPRESSION_TYPE_ZLIB:
     {
-        int z_ret;
-        z_stream* z_s;
+        Inflater* z_s;
 
         SessionPtr->SWF->Header_Len =
             SWF_VER_LEN + SWF_UCL_LEN;
 
         z_s = &(SessionPtr->SWF->StreamZLIB);
 
-        memset( (char*)z_s, 0, sizeof(z_stream));
+        memset( (char*)z_s, 0, sizeof(Inflater));
 
-        z_s->zalloc = (alloc_func)NULL;
-        z_s->zfree = (free_func)NULL;
         SYNC_IN(z_s)
 
-        z_ret = inflateInit(z_s);
-
-        if ( z_ret != Z_OK )
+        if ( !z_s->init(INFLATE_SWF_ZLIB, MAX_WBITS) )
         {
             SessionPtr->Error_Event = FILE_DECOMP_ERR_SWF_ZLIB_FAILURE;
             return( File_Decomp_DecompError );
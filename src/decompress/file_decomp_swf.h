@@ -27,12 +27,12 @@
 #endif
 
 #include <stdint.h>
-#include <zlib.h>
 
 #ifdef HAVE_LZMA
 #include <lzma.h>
 #endif
 
+#include "decompress/inflate.h"
 #include "file_decomp.h"
 
 /* FIXIT-L Other than the API prototypes, the other parts of this header should
@@ -68,7 +68,7 @@ enum fd_SWF_States
 
 struct fd_SWF_t
 {
-    z_stream StreamZLIB;
+    Inflater StreamZLIB;
 #ifdef HAVE_LZMA
     lzma_stream StreamLZMA;
 #endif
@@ -0,0 +1,227 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// inflate.cc
+
+#include "inflate.h"
+
+#include <string.h>
+
+#include "decompress_module.h"
+#include "profiler/profiler_defs.h"
+
+#ifdef UNIT_TEST
+#include "catch/catch.hpp"
+#endif
+
+#ifdef HAVE_ZLIB_NG
+#define INFLATE_INIT2 zng_inflateInit2
+#define INFLATE_RESET zng_inflateReset
+#define INFLATE_RESET2 zng_inflateReset2
+#define INFLATE_END zng_inflateEnd
+#define INFLATE zng_inflate
+#else
+#define INFLATE_INIT2 inflateInit2
+#define INFLATE_RESET inflateReset
+#define INFLATE_RESET2 inflateReset2
+#define INFLATE_END inflateEnd
+#define INFLATE ::inflate
+#endif
+
+THREAD_LOCAL InflateCounts inflate_counts[INFLATE_CODEC_MAX];
+THREAD_LOCAL ProfileStats inflate_perf_stats[INFLATE_CODEC_MAX];
+
+bool Inflater::init(InflateCodec c, int window_bits)
+{
+    memset(&strm, 0, sizeof(strm));
+    codec = c;
+
+    if ( INFLATE_INIT2(&strm, window_bits) != Z_OK )
+        return false;
+
+    open = true;
+    total_in = total_out = 0;
+    inflate_counts[codec].streams++;
+    return true;
+}
+
+bool Inflater::reset()
+{
+    if ( !open )
+        return false;
+
+    total_in = total_out = 0;
+    return INFLATE_RESET(&strm) == Z_OK;
+}
+
+bool Inflater::reset(InflateCodec c, int window_bits)
+{
+    if ( !open )
+        return false;
+
+    codec = c;
+    total_in = total_out = 0;
+    inflate_counts[codec].streams++;
+    return INFLATE_RESET2(&strm, window_bits) == Z_OK;
+}
+
+void Inflater::end()
+{
+    if ( !open )
+        return;
+
+    INFLATE_END(&strm);
+    open = false;
+}
+
+InflateStatus Inflater::inflate()
+{
+    if ( !open )
+        return INFLATE_ERROR;
+
+    Profile profile(inflate_perf_stats[codec]);
+
+    strm.next_in = next_in;
+    strm.avail_in = avail_in;
+    strm.next_out = next_out;
+    strm.avail_out = avail_out;
+
+    int ret = INFLATE(&strm, Z_SYNC_FLUSH);
+
+    const uint32_t used = avail_in - strm.avail_in;
+    const uint32_t made = avail_out - strm.avail_out;
+
+    next_in += used;
+    avail_in -= used;
+    total_in += used;
+
+    next_out += made;
+    avail_out -= made;
+    total_out += made;
+
+    inflate_counts[codec].bytes_in += used;
+    inflate_counts[codec].bytes_out += made;
+
+    switch ( ret )
+    {
+    case Z_OK:
+        return INFLATE_OK;
+
+    case Z_STREAM_END:
+        return INFLATE_STREAM_END;
+
+    case Z_DATA_ERROR:
+        return INFLATE_DATA_ERROR;
+
+    default:
+        break;
+    }
+    return INFLATE_ERROR;
+}
+
+#ifdef UNIT_TEST
+
+#ifdef HAVE_ZLIB_NG
+#define COMPRESS2 zng_compress2
+#define COMPRESS_BOUND zng_compressBound
+typedef size_t CompressLen;
+#else
+#define COMPRESS2 compress2
+#define COMPRESS_BOUND compressBound
+typedef uLongf CompressLen;
+#endif
+
+TEST_CASE("Inflater-closed", "[inflate]")
+{
+    Inflater z;
+    memset(&z, 0, sizeof(z));
+
+    CHECK(!z.is_open());
+    CHECK(z.inflate() == INFLATE_ERROR);
+    CHECK(!z.reset());
+    z.end();
+}
+
+TEST_CASE("Inflater-chunks", "[inflate]")
+{
+    uint8_t plain[4096];
+    for ( unsigned i = 0; i < sizeof(plain); i++ )
+        plain[i] = (uint8_t)("abcdefgh"[i % 8] + i / 512);
+
+    uint8_t comp[8192];
+    CompressLen comp_len = sizeof(comp);
+    REQUIRE(COMPRESS_BOUND(sizeof(plain)) <= sizeof(comp));
+    REQUIRE(COMPRESS2(comp, &comp_len, plain, sizeof(plain), 9) == Z_OK);
+
+    const InflateCounts before = inflate_counts[INFLATE_SWF_ZLIB];
+
+    Inflater z;
+    memset(&z, 0, sizeof(z));
+    REQUIRE(z.init(INFLATE_SWF_ZLIB, MAX_WBITS));
+
+    uint8_t out[sizeof(plain)];
+    z.next_out = out;
+    z.avail_out = sizeof(out);
+
+    // feed the compressed data a few bytes at a time
+    InflateStatus ret = INFLATE_OK;
+    unsigned fed = 0;
+
+    while ( ret == INFLATE_OK && fed < comp_len )
+    {
+        unsigned n = comp_len - fed < 7 ? comp_len - fed : 7;
+        z.next_in = comp + fed;
+        z.avail_in = n;
+        ret = z.inflate();
+        CHECK(z.avail_in == 0);
+        fed += n;
+    }
+    CHECK(ret == INFLATE_STREAM_END);
+    CHECK(z.total_in == comp_len);
+    CHECK(z.total_out == sizeof(plain));
+    CHECK(!memcmp(out, plain, sizeof(plain)));
+
+    const InflateCounts& after = inflate_counts[INFLATE_SWF_ZLIB];
+    CHECK(after.streams == before.streams + 1);
+    CHECK(after.bytes_in == before.bytes_in + comp_len);
+    CHECK(after.bytes_out == before.bytes_out + sizeof(plain));
+
+    // a reset stream decodes the same input again
+    REQUIRE(z.reset());
+    z.next_in = comp;
+    z.avail_in = comp_len;
+    z.next_out = out;
+    z.avail_out = sizeof(out);
+    memset(out, 0, sizeof(out));
+    CHECK(z.inflate() == INFLATE_STREAM_END);
+    CHECK(!memcmp(out, plain, sizeof(plain)));
+
+    // garbage is a data error
+    uint8_t junk[] = { 0x78, 0x9c, 0xff, 0xff, 0xff, 0xff };
+    REQUIRE(z.reset(INFLATE_PDF_DEFLATE, 47));
+    z.next_in = junk;
+    z.avail_in = sizeof(junk);
+    z.next_out = out;
+    z.avail_out = sizeof(out);
+    CHECK(z.inflate() == INFLATE_DATA_ERROR);
+
+    z.end();
+    CHECK(!z.is_open());
+}
+
+#endif
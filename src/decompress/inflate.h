@@ -0,0 +1,102 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// inflate.h
+
+#ifndef INFLATE_H
+#define INFLATE_H
+
+// Inflater is the streaming deflate decoder used by http_inspect and the
+// SWF and PDF file decompressors.  The implementation is chosen at build
+// time: zlib-ng's native API when it is available (HAVE_ZLIB_NG) and zlib
+// otherwise.  Both are driven like zlib's inflate() with Z_SYNC_FLUSH.
+//
+// Inflater is a plain struct so it can live in calloc'd session state.  A
+// zeroed Inflater is closed; init() opens it and end() must close it.
+//
+// Callers point next_in/next_out at their buffers and call inflate(), which
+// advances the pointers and counts just as zlib does.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdint.h>
+
+#ifdef HAVE_ZLIB_NG
+#include <zlib-ng.h>
+typedef zng_stream InflateStream;
+#else
+#include <zlib.h>
+typedef z_stream InflateStream;
+#endif
+
+#include "main/snort_types.h"
+
+// who is decompressing what; stats are kept per codec
+enum InflateCodec
+{
+    INFLATE_HTTP_GZIP,
+    INFLATE_HTTP_DEFLATE,
+    INFLATE_SWF_ZLIB,
+    INFLATE_PDF_DEFLATE,
+    INFLATE_CODEC_MAX
+};
+
+enum InflateStatus
+{
+    INFLATE_OK,           // progress made, more to come
+    INFLATE_STREAM_END,   // end of compressed data
+    INFLATE_DATA_ERROR,   // input is not valid compressed data
+    INFLATE_ERROR         // anything else including no progress possible
+};
+
+// window bits are as for zlib: 8..15 for zlib format, -8..-15 for raw
+// deflate, add 16 for gzip, or add 32 to detect zlib or gzip
+struct SO_PUBLIC Inflater
+{
+    uint8_t* next_in;
+    uint32_t avail_in;
+    uint64_t total_in;
+
+    uint8_t* next_out;
+    uint32_t avail_out;
+    uint64_t total_out;
+
+    bool init(InflateCodec, int window_bits);
+    void end();
+
+    // restart the current stream
+    bool reset();
+
+    // start a new stream reusing the memory init() allocated
+    bool reset(InflateCodec, int window_bits);
+
+    bool is_open() const
+    { return open; }
+
+    InflateStatus inflate();
+
+    // backend state; use the methods above
+    InflateStream strm;
+    uint8_t codec;
+    bool open;
+};
+
+#endif
+
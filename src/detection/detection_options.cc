@@ -50,6 +50,7 @@
 #include "ips_options/ips_pcre.h"
 #include "filters/detection_filter.h"
 #include "latency/packet_latency.h"
+#include "latency/rule_budget.h"
 #include "log/messages.h"
 #include "main/thread_config.h"
 #include "framework/ips_option.h"
@@ -807,12 +808,66 @@ void detection_option_tree_update_otn_stats(SFXHASH* doth)
     }
 }
 
+static void get_otn_stats(detection_option_tree_node_t* node,
+    const node_profile_stats* stats, unsigned instance, otn_stats_func_t fn, void* arg)
+{
+    const dot_node_state_t& ns = node->state[instance];
+    node_profile_stats local_stats;
+
+    local_stats.elapsed = ns.elapsed;
+    local_stats.elapsed_match = ns.elapsed_match;
+    local_stats.elapsed_no_match = ns.elapsed_no_match;
+    local_stats.checks = ns.checks;
+
+    if ( stats )
+    {
+        local_stats.elapsed += stats->elapsed;
+        local_stats.elapsed_match += stats->elapsed_match;
+        local_stats.elapsed_no_match += stats->elapsed_no_match;
+
+        if ( stats->checks > local_stats.checks )
+            local_stats.checks = stats->checks;
+
+        local_stats.latency_timeouts = stats->latency_timeouts;
+        local_stats.latency_suspends = stats->latency_suspends;
+    }
+    else
+    {
+        local_stats.latency_timeouts = ns.latency_timeouts;
+        local_stats.latency_suspends = ns.latency_suspends;
+    }
+
+    if ( node->option_type == RULE_OPTION_TYPE_LEAF_NODE )
+    {
+        OtnState state;
+        state.elapsed = local_stats.elapsed;
+        state.elapsed_match = local_stats.elapsed_match;
+        state.elapsed_no_match = local_stats.elapsed_no_match;
+        state.checks = local_stats.checks;
+        state.latency_timeouts = local_stats.latency_timeouts;
+        state.latency_suspends = local_stats.latency_suspends;
+
+        fn((OptTreeNode*)node->option_data, state, arg);
+    }
+
+    for ( int i=0; i < node->num_children; ++i )
+        get_otn_stats(node->children[i], &local_stats, instance, fn, arg);
+}
+
+void detection_option_node_get_otn_stats(
+    detection_option_tree_node_t* node, unsigned instance, otn_stats_func_t fn, void* arg)
+{
+    if ( node->state[instance].checks )
+        get_otn_stats(node, nullptr, instance, fn, arg);
+}
+
 detection_option_tree_root_t* new_root(OptTreeNode* otn)
 {
     detection_option_tree_root_t* p = (detection_option_tree_root_t*)
         snort_calloc(sizeof(detection_option_tree_root_t));
 
     p->latency_state = new RuleLatencyState[ThreadConfig::get_instance_max()]();
+    p->budget_state = new RuleBudgetState();
     p->otn = otn;
 
     return p;
@@ -829,6 +884,10 @@ void free_detection_option_root(void** existing_tree)
     snort_free(root->children);
 
     delete[] root->latency_state;
+
+    RuleBudget::release(root);
+    delete root->budget_state;
+
     snort_free(root);
     *existing_tree = NULL;
 }
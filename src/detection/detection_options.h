@@ -38,6 +38,7 @@
 #include <sys/time.h>
 #include "detection/rule_option_types.h"
 #include "main/snort_types.h"
+#include "latency/rule_budget_state.h"
 #include "latency/rule_latency_state.h"
 #include "time/clock_defs.h"
 
@@ -100,6 +101,7 @@ struct detection_option_tree_root_t
     int num_children;
     detection_option_tree_node_t** children;
     RuleLatencyState* latency_state;
+    RuleBudgetState* budget_state;
 
     struct OptTreeNode* otn;  // first rule in tree
 };
@@ -128,6 +130,13 @@ void print_option_tree(detection_option_tree_node_t*, int level);
 #endif
 void detection_option_tree_update_otn_stats(SFXHASH*);
 
+// like the above but for one node of the hash, one packet thread, and
+// without updating the otns; the per path stats are passed to the callback
+// for each leaf reached.  packet threads can call this concurrently.
+typedef void (* otn_stats_func_t)(struct OptTreeNode*, const struct OtnState&, void*);
+void detection_option_node_get_otn_stats(
+    detection_option_tree_node_t*, unsigned instance, otn_stats_func_t, void*);
+
 detection_option_tree_root_t* new_root(OptTreeNode*);
 void free_detection_option_root(void** existing_tree);
 
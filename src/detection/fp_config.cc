@@ -33,6 +33,7 @@
 #include "framework/mpse.h"
 #include "managers/mpse_manager.h"
 #include "log/messages.h"
+#include "utils/util.h"
 
 FastPatternConfig::FastPatternConfig()
 {
@@ -45,10 +46,14 @@ FastPatternConfig::FastPatternConfig()
     search_api = MpseManager::get_search_api("ac_bnfa");
     assert(search_api);
     trim = MpseManager::search_engine_trim(search_api);
+    all_hits = MpseManager::search_engine_all_hits(search_api);
 }
 
 FastPatternConfig::~FastPatternConfig()
-{ }
+{
+    if ( corpus )
+        snort_free(corpus);
+}
 
 bool FastPatternConfig::set_detect_search_method(const char* method)
 {
@@ -59,6 +64,7 @@ bool FastPatternConfig::set_detect_search_method(const char* method)
 
     search_api = api;
     trim = MpseManager::search_engine_trim(search_api);
+    all_hits = MpseManager::search_engine_all_hits(search_api);
     return true;
 }
 
@@ -71,6 +77,14 @@ void FastPatternConfig::set_max_pattern_len(unsigned int max_len)
     max_pattern_len = max_len;
 }
 
+void FastPatternConfig::set_corpus(const char* s)
+{
+    if ( corpus )
+        snort_free(corpus);
+
+    corpus = (s and *s) ? snort_strdup(s) : nullptr;
+}
+
 int FastPatternConfig::set_max(int bytes)
 {
     if ( max_pattern_len and (bytes > max_pattern_len) )
@@ -91,6 +91,12 @@ public:
     bool get_split_any_any()
     { return split_any_any; }
 
+    void set_merge_buffers(bool enable)
+    { merge_buffers = enable; }
+
+    bool get_merge_buffers()
+    { return merge_buffers; }
+
     void set_single_rule_group()
     { portlists_flags |= PL_SINGLE_RULE_GROUP; }
 
@@ -127,6 +133,9 @@ public:
     bool get_trim()
     { return trim; }
 
+    bool get_all_hits()
+    { return all_hits; }
+
     void trimmed()
     { num_patterns_trimmed++; }
 
@@ -141,12 +150,20 @@ public:
     int get_max_pattern_len()
     { return max_pattern_len; }
 
+    void set_corpus(const char*);
+
+    const char* get_corpus()
+    { return corpus; }
+
 private:
     const struct MpseApi* search_api;
+    char* corpus;
 
     bool inspect_stream_insert;
     bool trim;
+    bool all_hits;
     bool split_any_any;
+    bool merge_buffers;
     bool debug_print_fast_pattern;
     bool debug;
 
@@ -39,6 +39,11 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "main/snort_config.h"
 #include "hash/sfghash.h"
 #include "ips_options/ips_flow.h"
@@ -61,6 +66,7 @@
 #include "rules.h"
 #include "treenodes.h"
 #include "fp_detect.h"
+#include "fp_quality.h"
 #include "fp_utils.h"
 #include "detection_options.h"
 #include "detection_defines.h"
@@ -69,6 +75,36 @@
 
 static unsigned mpse_count = 0;
 static const char* s_group = "";
+static FpQuality* s_quality = nullptr;
+
+//-------------------------------------------------------------------------
+// mpse sharing
+//
+// groups with the same fast patterns get identical automata and detection
+// option trees so only the first is compiled and the rest share it.  the
+// (otn, pmd) pairs added to an engine fix its patterns so the sorted pairs
+// are the key.  engines are ref counted across configs since groups are
+// deleted individually.
+//-------------------------------------------------------------------------
+
+struct MpseShare
+{
+    struct Pending
+    {
+        std::vector<std::string> recs;
+        uint64_t bytes = 0;
+    };
+
+    std::unordered_map<Mpse*, Pending> pending;
+    std::unordered_map<std::string, Mpse*> compiled;
+
+    unsigned engines = 0;
+    unsigned patterns = 0;
+    uint64_t bytes = 0;
+};
+
+static MpseShare* s_share = nullptr;
+static std::unordered_map<Mpse*, unsigned> s_mpse_refs;
 
 static void fpDeletePMX(void* data);
 
@@ -79,9 +115,12 @@ static void print_nfp_info(const char*, const OptTreeNode*);
 static void print_fp_info(const char*, const OptTreeNode*, const PatternMatchData*,
     const char* pattern, int pattern_length);
 
-static const char* const pm_type_strings[PM_TYPE_MAX] =
+// group summaries count merged engines after the other types
+#define PM_SUM_MAX (PM_TYPE_MAX + 1)
+
+static const char* const pm_type_strings[PM_SUM_MAX] =
 {
-    "packet", "alt", "key", "header", "body", "file"
+    "packet", "alt", "key", "header", "body", "file", "merged"
 };
 
 static int finalize_detection_option_tree(SnortConfig* sc, detection_option_tree_root_t* root)
@@ -344,6 +383,151 @@ static int pmx_create_tree(SnortConfig* sc, void* id, void** existing_tree)
     return otn_create_tree(otn, existing_tree);
 }
 
+// the merged agent keeps a MergedTree in each match state (see fp_create.h)
+static MergedTree::Node& merged_node(void* id, void** state)
+{
+    if ( !*state )
+        *state = new MergedTree;
+
+    MergedTree* mt = (MergedTree*)*state;
+    PMX* pmx = (PMX*)id;
+
+    for ( auto& n : mt->nodes )
+    {
+        if ( n.type == pmx->pmd->pm_type and n.len == pmx->len )
+            return n;
+    }
+    mt->nodes.push_back({ (PmType)pmx->pmd->pm_type, pmx->len, pmx, nullptr, nullptr });
+    return mt->nodes.back();
+}
+
+static int merged_create_tree(SnortConfig* sc, void* id, void** existing_tree)
+{
+    if ( !existing_tree )
+        return -1;
+
+    if ( !id )
+    {
+        if ( !*existing_tree )
+            return -1;
+
+        for ( auto& n : ((MergedTree*)*existing_tree)->nodes )
+        {
+            if ( n.tree and finalize_detection_option_tree(
+                sc, (detection_option_tree_root_t*)n.tree) )
+                return -1;
+        }
+        return 0;
+    }
+    return pmx_create_tree(sc, id, &merged_node(id, existing_tree).tree);
+}
+
+static int merged_neg_list(void* id, void** list)
+{
+    if ( !id or !list )
+        return -1;
+
+    return add_patrn_to_neg_list(id, &merged_node(id, list).list);
+}
+
+static void merged_free(void** state)
+{
+    if ( !state or !*state )
+        return;
+
+    MergedTree* mt = (MergedTree*)*state;
+
+    for ( auto& n : mt->nodes )
+    {
+        free_detection_option_root(&n.tree);
+        neg_list_free(&n.list);
+    }
+    delete mt;
+    *state = nullptr;
+}
+
+static void fp_add_pattern(
+    SnortConfig* sc, Mpse* mpse, const OptTreeNode* otn, const PatternMatchData* pmd,
+    const char* pattern, int pattern_length, PMX* pmx)
+{
+    Mpse::PatternDescriptor desc(pmd->no_case, pmd->negated, pmd->literal, pmd->flags);
+    mpse->add_pattern(sc, (const uint8_t*)pattern, pattern_length, desc, pmx);
+    pmx->len = pattern_length;
+
+    if ( s_share )
+    {
+        std::string rec((const char*)&otn, sizeof(otn));
+        rec.append((const char*)&pmd, sizeof(pmd));
+        MpseShare::Pending& pend = s_share->pending[mpse];
+        pend.recs.push_back(rec);
+        pend.bytes += pattern_length;
+    }
+}
+
+// returns the compiled engine to use instead of this one, if any
+static Mpse* fp_share_mpse(Mpse* mpse)
+{
+    if ( !s_share )
+        return nullptr;
+
+    auto it = s_share->pending.find(mpse);
+
+    if ( it == s_share->pending.end() )
+        return nullptr;
+
+    std::vector<std::string>& recs = it->second.recs;
+    std::sort(recs.begin(), recs.end());
+
+    std::string key;
+
+    for ( auto& r : recs )
+        key += r;
+
+    unsigned count = recs.size();
+    uint64_t bytes = it->second.bytes;
+    s_share->pending.erase(it);
+
+    auto c = s_share->compiled.find(key);
+
+    if ( c == s_share->compiled.end() )
+    {
+        s_share->compiled[key] = mpse;
+        s_mpse_refs[mpse] = 1;
+        return nullptr;
+    }
+
+    s_share->engines++;
+    s_share->patterns += count;
+    s_share->bytes += bytes;
+    s_mpse_refs[c->second]++;
+
+    MpseManager::delete_search_engine(mpse);
+    mpse_count--;
+
+    return c->second;
+}
+
+static void fp_release_mpse(Mpse* mpse)
+{
+    auto it = s_mpse_refs.find(mpse);
+
+    if ( it != s_mpse_refs.end() )
+    {
+        if ( --it->second )
+            return;
+
+        s_mpse_refs.erase(it);
+    }
+    MpseManager::delete_search_engine(mpse);
+}
+
+// file data is not contiguous with the other buffers so is never merged
+static bool fp_is_merged(const PatternMatchData* pmd, FastPatternConfig* fp)
+{ return fp->get_merge_buffers() and pmd->pm_type != PM_TYPE_FILE; }
+
+static Mpse*& fp_get_mpse(PortGroup* pg, const PatternMatchData* pmd, FastPatternConfig* fp)
+{ return fp_is_merged(pmd, fp) ? pg->merged : pg->mpse[pmd->pm_type]; }
+
 static int fpFinishPortGroupRule(
     SnortConfig* sc, PortGroup* pg,
     OptTreeNode* otn, PatternMatchData* pmd, FastPatternConfig* fp)
@@ -354,7 +538,9 @@ static int fpFinishPortGroupRule(
         print_nfp_info(s_group, otn);
         return 0;
     }
-    if ( !pg->mpse[pmd->pm_type] )
+    Mpse*& mpse = fp_get_mpse(pg, pmd, fp);
+
+    if ( !mpse )
     {
         static MpseAgent agent =
         {
@@ -362,10 +548,17 @@ static int fpFinishPortGroupRule(
             fpDeletePMX, free_detection_option_root, neg_list_free
         };
 
-        pg->mpse[pmd->pm_type] = MpseManager::get_search_engine(
-            sc, fp->get_search_api(), true, &agent);
+        static MpseAgent merged_agent =
+        {
+            merged_create_tree, merged_neg_list,
+            fpDeletePMX, merged_free, merged_free
+        };
+
+        mpse = MpseManager::get_search_engine(
+            sc, fp->get_search_api(), true,
+            fp_is_merged(pmd, fp) ? &merged_agent : &agent);
 
-        if ( !pg->mpse[pmd->pm_type] )
+        if ( !mpse )
         {
             ParseError("Failed to create pattern matcher for %d", pmd->pm_type);
             return -1;
@@ -373,7 +566,7 @@ static int fpFinishPortGroupRule(
         mpse_count++;
 
         if ( fp->get_search_opt() )
-            pg->mpse[pmd->pm_type]->set_opt(1);
+            mpse->set_opt(1);
     }
     if (pmd->negated)
         pg->add_nfp_rule(otn);
@@ -394,12 +587,44 @@ static int fpFinishPortGroupRule(
     pmx->rule_node.rnRuleData = otn;
     pmx->pmd = pmd;
 
-    Mpse::PatternDescriptor desc(pmd->no_case, pmd->negated, pmd->literal, pmd->flags);
-    pg->mpse[pmd->pm_type]->add_pattern(sc, (uint8_t*)pattern, pattern_length, desc, pmx);
+    fp_add_pattern(sc, mpse, otn, pmd, pattern, pattern_length, pmx);
+
+    if ( mpse == pg->merged )
+        pg->merged_types |= 1 << pmd->pm_type;
 
     return 0;
 }
 
+// returns true if the mpse has patterns, otherwise it is deleted
+static bool fpFinishMpse(SnortConfig* sc, Mpse*& mpse, FastPatternConfig* fp)
+{
+    if ( !mpse )
+        return false;
+
+    if ( !mpse->get_pattern_count() )
+    {
+        MpseManager::delete_search_engine(mpse);
+        mpse = NULL;
+        return false;
+    }
+
+    if ( Mpse* shared = fp_share_mpse(mpse) )
+    {
+        mpse = shared;
+        return true;
+    }
+
+    if (mpse->prep_patterns(sc) != 0)
+    {
+        FatalError("Failed to compile port group patterns.\n");
+    }
+
+    if (fp->get_debug_mode())
+        mpse->print_info();
+
+    return true;
+}
+
 static int fpFinishPortGroup(
     SnortConfig* sc, PortGroup* pg, FastPatternConfig* fp)
 {
@@ -411,27 +636,13 @@ static int fpFinishPortGroup(
 
     for (i = PM_TYPE_PKT; i < PM_TYPE_MAX; i++)
     {
-        if (pg->mpse[i] != NULL)
-        {
-            if (pg->mpse[i]->get_pattern_count() != 0)
-            {
-                if (pg->mpse[i]->prep_patterns(sc) != 0)
-                {
-                    FatalError("Failed to compile port group patterns.\n");
-                }
-
-                if (fp->get_debug_mode())
-                    pg->mpse[i]->print_info();
-                rules = 1;
-            }
-            else
-            {
-                MpseManager::delete_search_engine(pg->mpse[i]);
-                pg->mpse[i] = NULL;
-            }
-        }
+        if ( fpFinishMpse(sc, pg->mpse[i], fp) )
+            rules = 1;
     }
 
+    if ( fpFinishMpse(sc, pg->merged, fp) )
+        rules = 1;
+
     if ( pg->nfp_head )
     {
         RULE_NODE* ruleNode;
@@ -468,8 +679,7 @@ static void fpAddAlternatePatterns(SnortConfig* sc, PortGroup* pg,
     pmx->rule_node.rnRuleData = otn;
     pmx->pmd = pmd;
 
-    Mpse::PatternDescriptor desc(pmd->no_case, pmd->negated, pmd->literal, pmd->flags);
-    pg->mpse[pmd->pm_type]->add_pattern(sc, (uint8_t*)pmd->pattern_buf, pmd->pattern_size, desc,
+    fp_add_pattern(sc, fp_get_mpse(pg, pmd, fp), otn, pmd, pmd->pattern_buf, pmd->pattern_size,
         pmx);
 }
 
@@ -486,8 +696,11 @@ static int fpAddPortGroupRule(
     if ( !otn->enabled )
         return -1;
 
+    if ( inspects_body(otn) )
+        pg->body_rules = true;
+
     OptFpList* next = nullptr;
-    pmv = get_fp_content(otn, next, srvc);
+    pmv = get_fp_content(otn, next, srvc, s_quality);
 
     if ( !pmv.empty() )
     {
@@ -506,6 +719,8 @@ static int fpAddPortGroupRule(
         {
             if (main_pmd->pattern_size > otn->longestPatternLen)
                 otn->longestPatternLen = main_pmd->pattern_size;
+            if ( s_quality )
+                s_quality->use(main_pmd);
             for (auto p : pmv)
                 fpAddAlternatePatterns(sc, pg, otn, p, fp);
 
@@ -822,6 +1037,9 @@ static void fpPortGroupPrintRuleCount(PortGroup* pg, const char* what)
             LogMessage("\t%s: %d\n", pm_type_strings[type], count);
     }
 
+    if ( pg->merged )
+        LogMessage("\t%s: %d\n", pm_type_strings[PM_TYPE_MAX], pg->merged->get_pattern_count());
+
     if ( pg->nfp_rule_count )
         LogMessage("\tNo content: %u\n", pg->nfp_rule_count);
 }
@@ -841,11 +1059,17 @@ void fpDeletePortGroup(void* data)
     {
         if (pg->mpse[i] != NULL)
         {
-            MpseManager::delete_search_engine(pg->mpse[i]);
+            fp_release_mpse(pg->mpse[i]);
             pg->mpse[i] = NULL;
         }
     }
 
+    if ( pg->merged )
+    {
+        fp_release_mpse(pg->merged);
+        pg->merged = NULL;
+    }
+
     free_detection_option_root(&pg->nfp_tree);
     snort_free(pg);
 }
@@ -1384,7 +1608,7 @@ static void fp_print_service_rules_by_proto(SnortConfig* sc, srmm_table_t* srmm)
         sc->proto_ref->get_name(i));
 }
 
-static void fp_sum_port_groups(PortGroup* pg, unsigned c[PM_TYPE_MAX])
+static void fp_sum_port_groups(PortGroup* pg, unsigned c[PM_SUM_MAX])
 {
     if ( !pg )
         return;
@@ -1392,9 +1616,12 @@ static void fp_sum_port_groups(PortGroup* pg, unsigned c[PM_TYPE_MAX])
     for ( int i = PM_TYPE_PKT; i < PM_TYPE_MAX; ++i )
         if ( pg->mpse[i] and pg->mpse[i]->get_pattern_count() )
             c[i]++;
+
+    if ( pg->merged and pg->merged->get_pattern_count() )
+        c[PM_TYPE_MAX]++;
 }
 
-static void fp_sum_service_groups(SFGHASH* h, unsigned c[PM_TYPE_MAX])
+static void fp_sum_service_groups(SFGHASH* h, unsigned c[PM_SUM_MAX])
 {
     for ( SFGHASH_NODE* node=sfghash_findfirst(h);
         node; node=sfghash_findnext(h) )
@@ -1406,8 +1633,8 @@ static void fp_sum_service_groups(SFGHASH* h, unsigned c[PM_TYPE_MAX])
 
 static void fp_print_service_groups(srmm_table_t* srmm)
 {
-    unsigned to_srv[PM_TYPE_MAX] = { 0 };
-    unsigned to_cli[PM_TYPE_MAX] = { 0 };
+    unsigned to_srv[PM_SUM_MAX] = { 0 };
+    unsigned to_cli[PM_SUM_MAX] = { 0 };
 
     for ( int i = SNORT_PROTO_IP; i < SNORT_PROTO_MAX; ++i )
     {
@@ -1417,7 +1644,7 @@ static void fp_print_service_groups(srmm_table_t* srmm)
 
     bool label = true;
 
-    for ( int i = PM_TYPE_PKT; i < PM_TYPE_MAX; ++i )
+    for ( int i = PM_TYPE_PKT; i < PM_SUM_MAX; ++i )
     {
         if ( !to_srv[i] and !to_cli[i] )
             continue;
@@ -1431,7 +1658,7 @@ static void fp_print_service_groups(srmm_table_t* srmm)
     }
 }
 
-static void fp_sum_port_groups(PortTable* tab, unsigned c[PM_TYPE_MAX])
+static void fp_sum_port_groups(PortTable* tab, unsigned c[PM_SUM_MAX])
 {
     for ( SFGHASH_NODE* node=sfghash_findfirst(tab->pt_mpxo_hash);
         node; node=sfghash_findnext(tab->pt_mpxo_hash) )
@@ -1444,9 +1671,9 @@ static void fp_sum_port_groups(PortTable* tab, unsigned c[PM_TYPE_MAX])
 
 static void fp_print_port_groups(RulePortTables* port_tables)
 {
-    unsigned src[PM_TYPE_MAX] = { 0 };
-    unsigned dst[PM_TYPE_MAX] = { 0 };
-    unsigned any[PM_TYPE_MAX] = { 0 };
+    unsigned src[PM_SUM_MAX] = { 0 };
+    unsigned dst[PM_SUM_MAX] = { 0 };
+    unsigned any[PM_SUM_MAX] = { 0 };
 
     fp_sum_port_groups(port_tables->ip.src, src);
     fp_sum_port_groups(port_tables->ip.dst, dst);
@@ -1466,7 +1693,7 @@ static void fp_print_port_groups(RulePortTables* port_tables)
 
     bool label = true;
 
-    for ( int i = PM_TYPE_PKT; i < PM_TYPE_MAX; ++i )
+    for ( int i = PM_TYPE_PKT; i < PM_SUM_MAX; ++i )
     {
         if ( !src[i] and !dst[i] and !any[i] )
             continue;
@@ -1534,6 +1761,13 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
 
     MpseManager::start_search_engine(fp->get_search_api());
 
+    FpQuality quality;
+    MpseShare share;
+    s_share = &share;
+
+    if ( fp->get_corpus() and quality.load(sc, fp->get_corpus()) )
+        s_quality = &quality;
+
     /* Use PortObjects to create PortGroups */
     if (fp->get_debug_print_rule_group_build_details())
         LogMessage("Creating Port Groups....\n");
@@ -1571,6 +1805,21 @@ int fpCreateFastPacketDetection(SnortConfig* sc)
     fp_print_port_groups(port_tables);
     fp_print_service_groups(sc->spgmmTable);
 
+    if ( share.engines )
+    {
+        LogLabel("fast pattern sharing");
+        LogCount("shared engines", share.engines);
+        LogCount("shared patterns", share.patterns);
+        LogCount("pattern bytes saved", share.bytes);
+    }
+    s_share = nullptr;
+
+    if ( s_quality )
+    {
+        s_quality->print();
+        s_quality = nullptr;
+    }
+
     if ( mpse_count )
     {
         LogLabel("search engine");
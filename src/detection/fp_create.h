@@ -27,6 +27,8 @@
 
 // this is where rule groups are compiled and MPSE are instantiated
 
+#include <vector>
+
 #include "detection/pcrm.h"
 #include "ports/port_group.h"
 #include "target_based/snort_protocols.h"
@@ -37,6 +39,24 @@ struct PMX
 {
     struct PatternMatchData* pmd;
     RULE_NODE rule_node;
+    unsigned len;  // as added to the mpse
+};
+
+// a merged mpse searches several buffer types at once so each match state
+// keeps a rule tree (or negated list) per buffer type and pattern length.
+// a hit ending at offset n applies to a node only if [n - len, n) lies
+// within a buffer of the node's type.
+struct MergedTree
+{
+    struct Node
+    {
+        PmType type;
+        unsigned len;
+        PMX* user;
+        void* tree;
+        void* list;
+    };
+    std::vector<Node> nodes;
 };
 
 /* Used for negative content list */
@@ -55,6 +55,7 @@
 #include "treenodes.h"
 
 #include "latency/packet_latency.h"
+#include "latency/rule_budget.h"
 #include "latency/rule_latency.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
@@ -82,6 +83,13 @@
 #include "stream/stream.h"
 #include "utils/stats.h"
 
+#ifdef UNIT_TEST
+#include "catch/catch.hpp"
+#include <set>
+#include <string>
+#include <vector>
+#endif
+
 THREAD_LOCAL ProfileStats rulePerfStats;
 THREAD_LOCAL ProfileStats ruleRTNEvalPerfStats;
 THREAD_LOCAL ProfileStats ruleOTNEvalPerfStats;
@@ -364,8 +372,9 @@ static int detection_option_tree_evaluate(detection_option_tree_root_t* root,
         return 0;
 
     RuleLatency::Context rule_latency_ctx(root, eval_data->p);
+    RuleBudget::Context rule_budget_ctx(root, eval_data->p);
 
-    if ( RuleLatency::suspended() )
+    if ( RuleLatency::suspended() or RuleBudget::demoted() )
         return 0;
 
     Cursor c(eval_data->p);
@@ -380,6 +389,25 @@ static int detection_option_tree_evaluate(detection_option_tree_root_t* root,
     return rval;
 }
 
+// flag negated fast patterns that were found so they aren't evaluated
+static void mark_negated(NCListNode* ncl, Packet* p)
+{
+    for ( ; ncl != nullptr; ncl = ncl->next )
+    {
+        PMX* neg_pmx = (PMX*)ncl->pmx;
+        assert(neg_pmx->pmd->last_check);
+
+        PmdLastCheck* last_check =
+            neg_pmx->pmd->last_check + get_instance_id();
+
+        last_check->ts.tv_sec = p->pkth->ts.tv_sec;
+        last_check->ts.tv_usec = p->pkth->ts.tv_usec;
+        last_check->packet_number = (rule_eval_pkt_count
+            + (PacketManager::get_rebuilt_packet_count()));
+        last_check->rebuild_flag = (p->packet_flags & PKT_REBUILT_STREAM);
+    }
+}
+
 static int rule_tree_match(
     void* user, void* tree, int index, void* context, void* neg_list)
 {
@@ -388,7 +416,6 @@ static int rule_tree_match(
 
     detection_option_tree_root_t* root = (detection_option_tree_root_t*)tree;
     detection_option_eval_data_t eval_data;
-    NCListNode* ncl;
 
     eval_data.pomd = pomd;
     eval_data.p = pomd->p;
@@ -403,20 +430,7 @@ static int rule_tree_match(
          * may muck with an unintended rule */
 
         /* Set flag for not contents so they aren't evaluated */
-        for (ncl = (NCListNode*)neg_list; ncl != nullptr; ncl = ncl->next)
-        {
-            PMX* neg_pmx = (PMX*)ncl->pmx;
-            assert(neg_pmx->pmd->last_check);
-
-            PmdLastCheck* last_check =
-                neg_pmx->pmd->last_check + get_instance_id();
-
-            last_check->ts.tv_sec = eval_data.p->pkth->ts.tv_sec;
-            last_check->ts.tv_usec = eval_data.p->pkth->ts.tv_usec;
-            last_check->packet_number = (rule_eval_pkt_count
-                + (PacketManager::get_rebuilt_packet_count()));
-            last_check->rebuild_flag = (eval_data.p->packet_flags & PKT_REBUILT_STREAM);
-        }
+        mark_negated((NCListNode*)neg_list, eval_data.p);
 
         int ret = 0;
         {
@@ -891,6 +905,191 @@ static int rule_tree_queue(
             SEARCH_DATA(buf.data, buf.len, cnt) \
     }
 
+// with search_engine.merge_buffers the packet, key, header, body, and alt
+// buffers are searched with the group's merged mpse.  buffers that overlap
+// or abut in memory, such as a header within the packet, are searched once
+// as a span and each hit applies only to buffers containing the pattern.
+// spans require an engine that reports every hit; otherwise a hit outside
+// a header could hide a later hit of the same pattern inside it.
+
+struct MergedBuffer
+{
+    const uint8_t* data;
+    unsigned len;
+    PmType type;
+    PegCount* count;
+};
+
+struct MergedSearch
+{
+    OTNX_MATCH_DATA* omd;
+    const uint8_t* base;
+    const MergedBuffer* bufs;
+    unsigned num;
+};
+
+// the hit ends at end; returns the offset of end in a matching buffer
+static bool merged_hit(
+    const MergedSearch* ms, const MergedTree::Node& n, const uint8_t* end, int& index)
+{
+    for ( unsigned i = 0; i < ms->num; ++i )
+    {
+        const MergedBuffer& b = ms->bufs[i];
+
+        if ( b.type != n.type or end <= b.data )
+            continue;
+
+        unsigned off = end - b.data;
+
+        if ( off >= n.len and off <= b.len )
+        {
+            index = off;
+            return true;
+        }
+    }
+    return false;
+}
+
+static int merged_tree_queue(
+    void*, void* tree, int index, void* context, void* list)
+{
+    MergedSearch* ms = (MergedSearch*)context;
+    const uint8_t* end = ms->base + index;
+    int off;
+
+    if ( list )
+    {
+        for ( auto& n : ((MergedTree*)list)->nodes )
+        {
+            if ( merged_hit(ms, n, end, off) )
+                mark_negated((NCListNode*)n.list, ms->omd->p);
+        }
+    }
+    if ( tree )
+    {
+        for ( auto& n : ((MergedTree*)tree)->nodes )
+        {
+            if ( n.tree and merged_hit(ms, n, end, off) and
+                rule_tree_queue(n.user, n.tree, off, ms->omd, nullptr) )
+                return 1;
+        }
+    }
+    return 0;
+}
+
+static void merged_add(
+    PortGroup* pg, MergedBuffer* bufs, unsigned& num,
+    const uint8_t* data, unsigned len, PmType type, PegCount& count)
+{
+    if ( !len or !(pg->merged_types & (1 << type)) )
+        return;
+
+    // keep the buffers sorted by address
+    unsigned i = num++;
+
+    while ( i > 0 and bufs[i-1].data > data )
+    {
+        bufs[i] = bufs[i-1];
+        --i;
+    }
+    bufs[i] = { data, len, type, &count };
+}
+
+// group the sorted buffers starting at i that overlap or abut into one
+// span ending at hi; returns the index of the first buffer after the span.
+// without spans each buffer is searched alone.
+static unsigned merged_span(
+    const MergedBuffer* bufs, unsigned i, unsigned num, const uint8_t*& hi, bool spans)
+{
+    hi = bufs[i].data + bufs[i].len;
+
+    if ( !spans )
+        return i + 1;
+
+    while ( ++i < num and bufs[i].data <= hi )
+    {
+        if ( bufs[i].data + bufs[i].len > hi )
+            hi = bufs[i].data + bufs[i].len;
+    }
+    return i;
+}
+
+static int merged_search(
+    Mpse* mpse, const MergedBuffer* bufs, unsigned num, OTNX_MATCH_DATA* omd)
+{
+    bool spans = mpse->get_api()->all_hits;
+    unsigned i = 0;
+
+    while ( i < num )
+    {
+        const uint8_t* lo = bufs[i].data;
+        const uint8_t* hi;
+        unsigned j = merged_span(bufs, i, num, hi, spans);
+
+        for ( unsigned k = i; k < j; ++k )
+            (*bufs[k].count)++;
+
+        MergedSearch ms = { omd, lo, bufs + i, j - i };
+        int start_state = 0;
+        pc.merged_searches++;
+
+        omd->data = lo; omd->size = hi - lo;
+        stash.init();
+        mpse->search(lo, hi - lo, merged_tree_queue, &ms, &start_state);
+        stash.process(rule_tree_match, omd);
+
+        if ( PacketLatency::fastpath() )
+            return 1;
+
+        i = j;
+    }
+    return 0;
+}
+
+static int fp_search_merged(
+    PortGroup* port_group, Packet* p, int type, Inspector* gadget, OTNX_MATCH_DATA* omd)
+{
+    MergedBuffer bufs[5];
+    unsigned num = 0;
+
+    bool user_mode = snort_conf->sopgTable->user_mode;
+
+    if ( (!user_mode or type < 2) and p->data and p->dsize )
+    {
+        uint16_t pattern_match_size = p->dsize;
+
+        if ( IsLimitedDetect(p) && (p->alt_dsize < p->dsize) )
+            pattern_match_size = p->alt_dsize;
+
+        if ( pattern_match_size and (port_group->merged_types & (1 << PM_TYPE_PKT)) )
+            p->is_cooked() ?  pc.cooked_searches++ : pc.raw_searches++;
+
+        merged_add(port_group, bufs, num, p->data, pattern_match_size,
+            PM_TYPE_PKT, pc.pkt_searches);
+    }
+
+    if ( (!user_mode or type == 1) and gadget )
+    {
+        InspectionBuffer buf;
+
+        if ( gadget->get_fp_buf(buf.IBT_KEY, p, buf) )
+            merged_add(port_group, bufs, num, buf.data, buf.len, PM_TYPE_KEY, pc.key_searches);
+
+        if ( gadget->get_fp_buf(buf.IBT_HEADER, p, buf) )
+            merged_add(port_group, bufs, num, buf.data, buf.len,
+                PM_TYPE_HEADER, pc.header_searches);
+
+        if ( gadget->get_fp_buf(buf.IBT_BODY, p, buf) )
+            merged_add(port_group, bufs, num, buf.data, buf.len, PM_TYPE_BODY, pc.body_searches);
+
+        // FIXIT-L as with fp_search(), alt uses the packet patterns
+        if ( gadget->get_fp_buf(buf.IBT_ALT, p, buf) )
+            merged_add(port_group, bufs, num, buf.data, buf.len, PM_TYPE_PKT, pc.alt_searches);
+    }
+
+    return merged_search(port_group->merged, bufs, num, omd);
+}
+
 static int fp_search(
     PortGroup* port_group, Packet* p,
     int check_ports, int type, OTNX_MATCH_DATA* omd)
@@ -904,7 +1103,12 @@ static int fp_search(
 
     bool user_mode = snort_conf->sopgTable->user_mode;
 
-    if ( (!user_mode or type < 2) and p->data and p->dsize )
+    if ( port_group->merged )
+    {
+        if ( fp_search_merged(port_group, p, type, gadget, omd) )
+            return 1;
+    }
+    else if ( (!user_mode or type < 2) and p->data and p->dsize )
     {
         // ports search raw packet only
         if ( Mpse* so = port_group->mpse[PM_TYPE_PKT] )
@@ -922,7 +1126,7 @@ static int fp_search(
         }
     }
 
-    if ( (!user_mode or type == 1) and gadget )
+    if ( (!user_mode or type == 1) and gadget and !port_group->merged )
     {
         // service searches PDU buffers and file
         SEARCH_BUFFER(buf.IBT_KEY, PM_TYPE_KEY, pc.key_searches);
@@ -1310,6 +1514,40 @@ int fpEvalPacket(Packet* p)
     return fpFinalSelectEvent(omd, p);
 }
 
+static inline bool body_rules(const PortGroup* pg)
+{ return pg and pg->body_rules; }
+
+// follows the group selection fpEvalPacket() makes for tcp pdus
+bool fpInspectsBody(const Flow* flow, bool c2s)
+{
+    int16_t proto_ordinal = flow->ssn_state.application_protocol;
+    int proto = snort_conf->sopgTable->user_mode ? SNORT_PROTO_USER : SNORT_PROTO_TCP;
+
+    if ( proto_ordinal > 0 )
+    {
+        PortGroup* svc = snort_conf->sopgTable->get_port_group(proto, c2s, proto_ordinal);
+        PortGroup* file = snort_conf->sopgTable->get_port_group(proto, c2s, SNORT_PROTO_FILE);
+
+        if ( body_rules(svc) or body_rules(file) )
+            return true;
+
+        if ( svc )
+            return false;
+    }
+
+    if ( proto == SNORT_PROTO_USER )
+        return false;
+
+    PortGroup* src = nullptr, * dst = nullptr, * any = nullptr;
+    int dp = c2s ? flow->server_port : flow->client_port;
+    int sp = c2s ? flow->client_port : flow->server_port;
+
+    if ( !prmFindRuleGroupTcp(snort_conf->prmTcpRTNX, dp, sp, &src, &dst, &any) )
+        return false;
+
+    return body_rules(src) or body_rules(dst) or body_rules(any);
+}
+
 OptTreeNode* GetOTN(uint32_t gid, uint32_t sid)
 {
     OptTreeNode* otn = OtnLookup(snort_conf->otn_map, gid, sid);
@@ -1327,3 +1565,368 @@ OptTreeNode* GetOTN(uint32_t gid, uint32_t sid)
     return otn;
 }
 
+
+#ifdef UNIT_TEST
+// the merged searches below stand in for the mpse with a naive search
+// that reports the index of each match end like the real engines
+
+static const uint8_t* merged_test_data()
+{
+    static const char* s =
+        "GET / HTTP/1.1\r\nHost: abc\r\nCookie: x\r\n\r\n"
+        "body abc\r\n decoded";
+    return (const uint8_t*)s;
+}
+
+// packet is [0, 40), the header [16, 38) is within it, body [40, 50) abuts
+// the packet, and an alt buffer at [51, 58) is apart from them
+static unsigned merged_test_buffers(MergedBuffer* bufs, PegCount& count)
+{
+    const uint8_t* d = merged_test_data();
+    bufs[0] = { d, 40, PM_TYPE_PKT, &count };
+    bufs[1] = { d + 16, 22, PM_TYPE_HEADER, &count };
+    bufs[2] = { d + 40, 10, PM_TYPE_BODY, &count };
+    return 3;
+}
+
+TEST_CASE("merged_hit", "[fp_detect]")
+{
+    MergedBuffer bufs[4];
+    PegCount count = 0;
+    unsigned num = merged_test_buffers(bufs, count);
+    MergedSearch ms = { nullptr, bufs[0].data, bufs, num };
+
+    MergedTree::Node pkt = { PM_TYPE_PKT, 4, nullptr, nullptr, nullptr };
+    MergedTree::Node hdr = { PM_TYPE_HEADER, 4, nullptr, nullptr, nullptr };
+    MergedTree::Node body = { PM_TYPE_BODY, 4, nullptr, nullptr, nullptr };
+    MergedTree::Node key = { PM_TYPE_KEY, 4, nullptr, nullptr, nullptr };
+    int off = -1;
+
+    SECTION("within buffers")
+    {
+        CHECK(merged_hit(&ms, pkt, ms.base + 20, off));
+        CHECK(off == 20);
+        CHECK(merged_hit(&ms, hdr, ms.base + 20, off));
+        CHECK(off == 4);
+        CHECK(merged_hit(&ms, body, ms.base + 50, off));
+        CHECK(off == 10);
+        CHECK(!merged_hit(&ms, key, ms.base + 20, off));
+    }
+    SECTION("crossing a buffer boundary")
+    {
+        // starts before the header
+        CHECK(!merged_hit(&ms, hdr, ms.base + 18, off));
+        // ends after the header
+        CHECK(!merged_hit(&ms, hdr, ms.base + 39, off));
+        // spans the abutting packet and body
+        CHECK(!merged_hit(&ms, body, ms.base + 42, off));
+        CHECK(!merged_hit(&ms, pkt, ms.base + 42, off));
+        // but the packet still contains it
+        CHECK(merged_hit(&ms, pkt, ms.base + 18, off));
+        CHECK(off == 18);
+    }
+    SECTION("alt buffer is searched as packet")
+    {
+        bufs[num] = { merged_test_data() + 51, 7, PM_TYPE_PKT, &count };
+        MergedSearch as = { nullptr, bufs[num].data, bufs + num, 1 };
+
+        CHECK(merged_hit(&as, pkt, as.base + 7, off));
+        CHECK(off == 7);
+        CHECK(!merged_hit(&as, hdr, as.base + 7, off));
+    }
+}
+
+TEST_CASE("merged_span", "[fp_detect]")
+{
+    MergedBuffer bufs[4];
+    PegCount count = 0;
+    unsigned num = merged_test_buffers(bufs, count);
+    const uint8_t* hi;
+
+    SECTION("overlapping and abutting buffers are one span")
+    {
+        CHECK(merged_span(bufs, 0, num, hi, true) == 3);
+        CHECK(hi == bufs[0].data + 50);
+    }
+    SECTION("a gap starts another span")
+    {
+        bufs[num++] = { merged_test_data() + 51, 7, PM_TYPE_PKT, &count };
+        CHECK(merged_span(bufs, 0, num, hi, true) == 3);
+        CHECK(merged_span(bufs, 3, num, hi, true) == 4);
+        CHECK(hi == bufs[3].data + 7);
+    }
+    SECTION("without spans each buffer is alone")
+    {
+        CHECK(merged_span(bufs, 0, num, hi, false) == 1);
+        CHECK(hi == bufs[0].data + 40);
+        CHECK(merged_span(bufs, 1, num, hi, false) == 2);
+        CHECK(hi == bufs[1].data + 22);
+    }
+}
+
+TEST_CASE("merged negated lists", "[fp_detect]")
+{
+    MergedBuffer bufs[4];
+    PegCount count = 0;
+    unsigned num = merged_test_buffers(bufs, count);
+
+    DAQ_PktHdr_t pkth;
+    memset(&pkth, 0, sizeof(pkth));
+    pkth.ts.tv_sec = 1234;
+
+    Packet p(false);
+    p.pkth = &pkth;
+
+    OTNX_MATCH_DATA omd;
+    memset(&omd, 0, sizeof(omd));
+    omd.p = &p;
+
+    PmdLastCheck hdr_check[1], body_check[1];
+    memset(hdr_check, 0, sizeof(hdr_check));
+    memset(body_check, 0, sizeof(body_check));
+
+    PatternMatchData hdr_pmd, body_pmd;
+    memset(&hdr_pmd, 0, sizeof(hdr_pmd));
+    memset(&body_pmd, 0, sizeof(body_pmd));
+    hdr_pmd.last_check = hdr_check;
+    body_pmd.last_check = body_check;
+
+    PMX hdr_pmx = { &hdr_pmd, { }, 3 }, body_pmx = { &body_pmd, { }, 3 };
+    NCListNode hdr_ncl = { &hdr_pmx, nullptr }, body_ncl = { &body_pmx, nullptr };
+
+    // "abc" is negated in the header and in the body
+    MergedTree list;
+    list.nodes.push_back({ PM_TYPE_HEADER, 3, nullptr, nullptr, &hdr_ncl });
+    list.nodes.push_back({ PM_TYPE_BODY, 3, nullptr, nullptr, &body_ncl });
+
+    MergedSearch ms = { &omd, bufs[0].data, bufs, num };
+    const uint8_t* abc = (const uint8_t*)strstr((const char*)ms.base, "abc");
+
+    stash.init();
+    CHECK(merged_tree_queue(nullptr, nullptr, abc + 3 - ms.base, &ms, &list) == 0);
+    CHECK(hdr_check[0].ts.tv_sec == 1234);
+    CHECK(body_check[0].ts.tv_sec == 0);
+
+    abc = (const uint8_t*)strstr((const char*)ms.base + 40, "abc");
+    pkth.ts.tv_sec = 5678;
+
+    CHECK(merged_tree_queue(nullptr, nullptr, abc + 3 - ms.base, &ms, &list) == 0);
+    CHECK(hdr_check[0].ts.tv_sec == 1234);
+    CHECK(body_check[0].ts.tv_sec == 5678);
+    p.pkth = nullptr;
+}
+
+struct MergedTestPattern
+{
+    const char* s;
+    PmType type;
+    int tree;
+};
+
+typedef std::set<std::pair<void*, int>> MergedTestQueue;
+
+static int merged_test_dequeue(void*, void* tree, int index, void* context, void*)
+{
+    ((MergedTestQueue*)context)->insert({ tree, index });
+    return 0;
+}
+
+static void merged_test_search(
+    const uint8_t* data, unsigned len, const std::vector<std::string>& pats,
+    MpseMatch match, const std::vector<void*>& trees, void* context)
+{
+    for ( unsigned end = 1; end <= len; ++end )
+    {
+        for ( unsigned i = 0; i < pats.size(); ++i )
+        {
+            unsigned n = pats[i].size();
+
+            if ( n <= end and !memcmp(data + end - n, pats[i].c_str(), n) )
+                match(nullptr, trees[i], end, context, nullptr);
+        }
+    }
+}
+
+TEST_CASE("merged search matches per buffer search", "[fp_detect]")
+{
+    const MergedTestPattern pats[] =
+    {
+        { "abc", PM_TYPE_PKT, 0 },
+        { "abc", PM_TYPE_HEADER, 1 },
+        { "abc", PM_TYPE_BODY, 2 },
+        { "GET", PM_TYPE_PKT, 3 },
+        { "GET", PM_TYPE_HEADER, 4 },
+        { "1.1\r\nHost", PM_TYPE_PKT, 5 },
+        { "1.1\r\nHost", PM_TYPE_HEADER, 6 },
+        { "Host", PM_TYPE_HEADER, 7 },
+        { "\r\n\r\nbody", PM_TYPE_BODY, 8 },
+        { "x\r\n", PM_TYPE_HEADER, 9 },
+        { "\r\n\r\n", PM_TYPE_HEADER, 10 },
+    };
+    const unsigned num_pats = sizeof(pats) / sizeof(pats[0]);
+    int tree_ids[num_pats];
+
+    MergedBuffer bufs[4];
+    PegCount count = 0;
+    unsigned num = merged_test_buffers(bufs, count);
+
+    OTNX_MATCH_DATA omd;
+    memset(&omd, 0, sizeof(omd));
+
+    // per buffer: each buffer is searched with the patterns of its type
+    MergedTestQueue expected;
+
+    for ( unsigned b = 0; b < num; ++b )
+    {
+        std::vector<std::string> strs;
+        std::vector<void*> trees;
+
+        for ( unsigned i = 0; i < num_pats; ++i )
+        {
+            if ( pats[i].type != bufs[b].type )
+                continue;
+            strs.push_back(pats[i].s);
+            trees.push_back(tree_ids + pats[i].tree);
+        }
+        stash.init();
+        merged_test_search(bufs[b].data, bufs[b].len, strs, rule_tree_queue, trees, &omd);
+        stash.process(merged_test_dequeue, &expected);
+    }
+
+    // merged: each distinct pattern is in one state with a node per type
+    std::vector<std::string> strs;
+    std::vector<MergedTree> merged;
+
+    for ( unsigned i = 0; i < num_pats; ++i )
+    {
+        unsigned j = 0;
+
+        while ( j < strs.size() and strs[j] != pats[i].s )
+            ++j;
+
+        if ( j == strs.size() )
+        {
+            strs.push_back(pats[i].s);
+            merged.push_back(MergedTree());
+        }
+        MergedTree::Node n =
+            { pats[i].type, (unsigned)strlen(pats[i].s), nullptr, tree_ids + pats[i].tree, nullptr };
+        merged[j].nodes.push_back(n);
+    }
+    std::vector<void*> trees;
+
+    for ( auto& m : merged )
+        trees.push_back(&m);
+
+    MergedTestQueue actual;
+    unsigned i = 0;
+
+    while ( i < num )
+    {
+        const uint8_t* lo = bufs[i].data;
+        const uint8_t* hi;
+        unsigned j = merged_span(bufs, i, num, hi, true);
+        MergedSearch ms = { &omd, lo, bufs + i, j - i };
+
+        stash.init();
+        merged_test_search(lo, hi - lo, strs, merged_tree_queue, trees, &ms);
+        stash.process(merged_test_dequeue, &actual);
+        i = j;
+    }
+
+    CHECK(expected.size() == 7);
+    CHECK(actual == expected);
+}
+
+// the real engines below keep the test's trees, which they don't own
+
+extern const BaseApi* se_ac_bnfa;
+
+static int merged_test_build(SnortConfig*, void* id, void** tree)
+{
+    if ( id )
+        *tree = id;
+    return 0;
+}
+
+static int merged_test_negate(void*, void**)
+{ return 0; }
+
+static void merged_test_free(void*) { }
+static void merged_test_tree_free(void**) { }
+
+static const MpseAgent merged_test_agent =
+{
+    merged_test_build, merged_test_negate,
+    merged_test_free, merged_test_tree_free, merged_test_tree_free
+};
+
+static MergedTestQueue merged_test_run(
+    Mpse* mpse, const MergedBuffer* bufs, unsigned num, bool spans)
+{
+    OTNX_MATCH_DATA omd;
+    memset(&omd, 0, sizeof(omd));
+
+    MergedTestQueue queued;
+    unsigned i = 0;
+
+    while ( i < num )
+    {
+        const uint8_t* lo = bufs[i].data;
+        const uint8_t* hi;
+        unsigned j = merged_span(bufs, i, num, hi, spans);
+        MergedSearch ms = { &omd, lo, bufs + i, j - i };
+        int start_state = 0;
+
+        stash.init();
+        mpse->search(lo, hi - lo, merged_tree_queue, &ms, &start_state);
+        stash.process(merged_test_dequeue, &queued);
+        i = j;
+    }
+    return queued;
+}
+
+TEST_CASE("merged search with ac_bnfa", "[fp_detect]")
+{
+    const MpseApi* api = (const MpseApi*)se_ac_bnfa;
+    REQUIRE(!api->all_hits);
+    api->init();
+
+    Mpse* mpse = api->ctor(nullptr, nullptr, false, &merged_test_agent);
+    mpse->set_api(api);
+
+    // "abc" is a header pattern only
+    int tree_id;
+    MergedTree mt;
+    mt.nodes.push_back({ PM_TYPE_HEADER, 3, nullptr, &tree_id, nullptr });
+
+    Mpse::PatternDescriptor desc;
+    mpse->add_pattern(nullptr, (const uint8_t*)"abc", 3, desc, &mt);
+    mpse->prep_patterns(nullptr);
+
+    // and is in the packet before the header as well as within it
+    const char* s = "abc\r\nGET / HTTP/1.1\r\nHost: abc\r\n\r\n";
+    const uint8_t* d = (const uint8_t*)s;
+    unsigned len = strlen(s);
+    int end = strstr(s + 5, "abc") + 3 - (s + 5);
+
+    MergedBuffer bufs[2];
+    PegCount count = 0;
+    bufs[0] = { d, len, PM_TYPE_PKT, &count };
+    bufs[1] = { d + 5, len - 5, PM_TYPE_HEADER, &count };
+
+    SECTION("each buffer is searched alone")
+    {
+        MergedTestQueue queued = merged_test_run(mpse, bufs, 2, api->all_hits);
+        CHECK(queued.size() == 1);
+        CHECK(queued.count({ &tree_id, end }) == 1);
+    }
+    SECTION("a span misses the repeat")
+    {
+        // bnfa doesn't report the header hit after the packet hit
+        MergedTestQueue queued = merged_test_run(mpse, bufs, 2, true);
+        CHECK(queued.empty());
+    }
+    api->dtor(mpse);
+}
+#endif
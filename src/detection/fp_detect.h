@@ -54,6 +54,11 @@ extern THREAD_LOCAL ProfileStats ruleNFPEvalPerfStats;
 */
 int fpEvalPacket(Packet*);
 
+// true if any rule group that could be searched for this flow and
+// direction has a rule that reads pdu, body, or file data.  lets service
+// inspectors skip work, like decompression, whose output nothing uses.
+bool fpInspectsBody(const Flow*, bool c2s);
+
 struct RuleTreeNode;
 int fpLogEvent(const RuleTreeNode*, const OptTreeNode*, Packet*);
 int fpEvalRTN(RuleTreeNode*, Packet*, int check_ports);
@@ -0,0 +1,271 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// fp_quality.cc
+
+#include "fp_quality.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <pcap.h>
+
+#include <algorithm>
+#include <cctype>
+#include <string.h>
+
+#include "hash/sfghash.h"
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "search_engines/search_tool.h"
+#include "utils/stats.h"
+
+#include "fp_utils.h"
+#include "pattern_match_data.h"
+#include "treenodes.h"
+
+#ifdef UNIT_TEST
+#include "catch/catch.hpp"
+#endif
+
+#define FP_QUALITY_TOP 10
+
+FpQuality::FpQuality()
+{
+    search_tool = nullptr;
+    packets = bytes = 0;
+}
+
+FpQuality::~FpQuality()
+{
+    delete search_tool;
+}
+
+// identical contents in different rules are counted once
+void FpQuality::add(const PatternMatchData* pmd)
+{
+    if ( pmds.find(pmd) != pmds.end() )
+        return;
+
+    std::string key(pmd->no_case ? "i" : "c");
+    key.append(pmd->pattern_buf, pmd->pattern_size);
+
+    auto it = patterns.find(key);
+
+    if ( it == patterns.end() )
+    {
+        unsigned id = candidates.size();
+        candidates.push_back({ std::string(pmd->pattern_buf, pmd->pattern_size), 0, 0, 0 });
+        it = patterns.emplace(key, id).first;
+
+        if ( !search_tool )
+            search_tool = new SearchTool;
+
+        // ids are offset by one so none is null
+        search_tool->add(pmd->pattern_buf, pmd->pattern_size, (void*)(uintptr_t)(id + 1),
+            pmd->no_case);
+    }
+    pmds[pmd] = it->second;
+}
+
+void FpQuality::prep()
+{
+    if ( search_tool )
+        search_tool->prep();
+}
+
+int FpQuality::match(void* id, void*, int, void* data, void*)
+{
+    FpQuality* fq = (FpQuality*)data;
+    Candidate& c = fq->candidates[(uintptr_t)id - 1];
+
+    // count packets, not matches, since that is what queues a rule tree
+    if ( c.last != fq->packets )
+    {
+        c.last = fq->packets;
+        c.hits++;
+    }
+    return 0;
+}
+
+void FpQuality::search(const uint8_t* data, unsigned len)
+{
+    ++packets;
+    bytes += len;
+
+    if ( search_tool )
+        search_tool->find_all((const char*)data, len, match, false, this);
+}
+
+bool FpQuality::load(SnortConfig* sc, const char* corpus)
+{
+    char errbuf[PCAP_ERRBUF_SIZE];
+    pcap_t* pcap = pcap_open_offline(corpus, errbuf);
+
+    if ( !pcap )
+    {
+        ParseError("can't open fast pattern corpus %s: %s", corpus, errbuf);
+        return false;
+    }
+
+    for ( SFGHASH_NODE* node = sfghash_findfirst(sc->otn_map);
+        node; node = sfghash_findnext(sc->otn_map) )
+    {
+        OptTreeNode* otn = (OptTreeNode*)node->data;
+
+        if ( !otn->sigInfo.text_rule or !otn->enabled )
+            continue;
+
+        for ( auto pmd : get_fp_candidates(otn) )
+            add(pmd);
+    }
+    prep();
+
+    struct pcap_pkthdr* hdr;
+    const u_char* data;
+
+    while ( pcap_next_ex(pcap, &hdr, &data) == 1 )
+        search(data, hdr->caplen);
+
+    pcap_close(pcap);
+    return true;
+}
+
+int FpQuality::compare(const PatternMatchData* a, const PatternMatchData* b) const
+{
+    auto ia = pmds.find(a);
+    auto ib = pmds.find(b);
+
+    if ( ia == pmds.end() or ib == pmds.end() )
+        return 0;
+
+    uint64_t ha = candidates[ia->second].hits;
+    uint64_t hb = candidates[ib->second].hits;
+
+    if ( ha < hb )
+        return -1;
+
+    if ( ha > hb )
+        return 1;
+
+    return 0;
+}
+
+void FpQuality::use(const PatternMatchData* pmd)
+{
+    auto it = pmds.find(pmd);
+
+    if ( it != pmds.end() )
+        candidates[it->second].uses++;
+}
+
+uint64_t FpQuality::get_hits(const PatternMatchData* pmd) const
+{
+    auto it = pmds.find(pmd);
+    return it == pmds.end() ? 0 : candidates[it->second].hits;
+}
+
+void FpQuality::print() const
+{
+    std::vector<const Candidate*> used;
+
+    for ( auto& c : candidates )
+        if ( c.uses )
+            used.push_back(&c);
+
+    std::sort(used.begin(), used.end(),
+        [](const Candidate* a, const Candidate* b)
+        { return a->hits > b->hits; });
+
+    LogLabel("fast pattern quality");
+    LogCount("corpus packets", packets);
+    LogCount("corpus bytes", bytes);
+    LogCount("candidates", candidates.size());
+    LogCount("fast patterns", used.size());
+
+    if ( !packets or used.empty() or !used[0]->hits )
+        return;
+
+    // uses counts each rule in each port group that chose the pattern
+    LogLabel("noisiest fast patterns   hits/pkt    uses");
+
+    for ( unsigned i = 0; i < used.size() and i < FP_QUALITY_TOP; ++i )
+    {
+        if ( !used[i]->hits )
+            break;
+
+        std::string txt;
+
+        for ( auto ch : used[i]->pattern )
+            txt += isprint((uint8_t)ch) ? ch : '.';
+
+        LogMessage("%25.25s: %8.4f%8u\n", txt.c_str(),
+            (double)used[i]->hits / packets, used[i]->uses);
+    }
+}
+
+#ifdef UNIT_TEST
+
+static void set_pmd(PatternMatchData& pmd, const char* s)
+{
+    memset(&pmd, 0, sizeof(pmd));
+    pmd.literal = true;
+    pmd.no_case = true;
+    pmd.pattern_buf = s;
+    pmd.pattern_size = strlen(s);
+}
+
+TEST_CASE("fp_quality", "[FastPatternSelect]")
+{
+    PatternMatchData common, rare, dup, other;
+    set_pmd(common, "HTTP/1.");
+    set_pmd(rare, "evil.exe");
+    set_pmd(dup, "http/1.");
+    set_pmd(other, "unknown");
+
+    FpQuality fq;
+    fq.add(&common);
+    fq.add(&rare);
+    fq.add(&dup);
+    fq.prep();
+
+    const char* corpus[] =
+    {
+        "GET / HTTP/1.1\r\nHost: a\r\n\r\n",
+        "HTTP/1.1 200 OK\r\nServer: HTTP/1.0 compatible\r\n\r\n",
+        "GET /evil.exe HTTP/1.1\r\n\r\n",
+        "no match here",
+    };
+
+    for ( auto s : corpus )
+        fq.search((const uint8_t*)s, strlen(s));
+
+    // multiple matches in a packet count once
+    CHECK(fq.get_hits(&common) == 3);
+    CHECK(fq.get_hits(&dup) == 3);
+    CHECK(fq.get_hits(&rare) == 1);
+    CHECK(fq.get_hits(&other) == 0);
+
+    CHECK(fq.compare(&rare, &common) < 0);
+    CHECK(fq.compare(&common, &rare) > 0);
+    CHECK(fq.compare(&common, &dup) == 0);
+    CHECK(fq.compare(&common, &other) == 0);
+}
+
+#endif
@@ -0,0 +1,82 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// fp_quality.h
+
+#ifndef FP_QUALITY_H
+#define FP_QUALITY_H
+
+// FpQuality counts how often the candidate fast patterns of each rule
+// occur in a sample pcap so that fast pattern selection can prefer the
+// candidate that queues the fewest rule tree evaluations.  Whole frames
+// are searched so the counts are a proxy for every buffer type.
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct PatternMatchData;
+struct SnortConfig;
+
+class FpQuality
+{
+public:
+    FpQuality();
+    ~FpQuality();
+
+    // gathers candidates from all enabled text rules and searches the
+    // corpus; returns false if the corpus can't be read
+    bool load(SnortConfig*, const char* corpus);
+
+    void add(const PatternMatchData*);
+    void prep();
+    void search(const uint8_t*, unsigned);
+
+    // < 0 if a is expected to hit less often than b, > 0 if more often,
+    // and 0 if the same or unknown
+    int compare(const PatternMatchData* a, const PatternMatchData* b) const;
+
+    // note the fast pattern chosen for a rule in a port group
+    void use(const PatternMatchData*);
+
+    uint64_t get_hits(const PatternMatchData*) const;
+
+    void print() const;
+
+private:
+    static int match(void* id, void* tree, int index, void* data, void* neg_list);
+
+    struct Candidate
+    {
+        std::string pattern;
+        uint64_t hits;
+        uint64_t last;
+        unsigned uses;
+    };
+
+    std::vector<Candidate> candidates;
+    std::unordered_map<std::string, unsigned> patterns;
+    std::unordered_map<const PatternMatchData*, unsigned> pmds;
+
+    class SearchTool* search_tool;
+    uint64_t packets;
+    uint64_t bytes;
+};
+
+#endif
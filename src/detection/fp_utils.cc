@@ -33,6 +33,7 @@
 #include "ports/port_group.h"
 #include "target_based/snort_protocols.h"
 
+#include "fp_quality.h"
 #include "pattern_match_data.h"
 #include "treenodes.h"
 
@@ -220,7 +221,7 @@ struct FpSelector
     FpSelector()
     { cat = CAT_NONE; pmd = nullptr; size = 0; }
 
-    bool is_better_than(FpSelector&, bool, RuleDirection);
+    bool is_better_than(FpSelector&, bool, RuleDirection, const FpQuality* = nullptr);
 };
 
 FpSelector::FpSelector(CursorActionType c, PatternMatchData* p)
@@ -232,7 +233,8 @@ FpSelector::FpSelector(CursorActionType c, PatternMatchData* p)
     size = flp_trim(pmd->pattern_buf, pmd->pattern_size, nullptr);
 }
 
-bool FpSelector::is_better_than(FpSelector& rhs, bool srvc, RuleDirection dir)
+bool FpSelector::is_better_than(
+    FpSelector& rhs, bool srvc, RuleDirection dir, const FpQuality* quality)
 {
     if ( !pmd_can_be_fp(pmd, cat) )
     {
@@ -280,6 +282,15 @@ bool FpSelector::is_better_than(FpSelector& rhs, bool srvc, RuleDirection dir)
     if ( !pmd->negated && rhs.pmd->negated )
         return true;
 
+    // measured hit rates beat the assumption that longer is rarer
+    if ( quality )
+    {
+        int cmp = quality->compare(pmd, rhs.pmd);
+
+        if ( cmp )
+            return cmp < 0;
+    }
+
     if ( size > rhs.size )
         return true;
 
@@ -290,7 +301,8 @@ bool FpSelector::is_better_than(FpSelector& rhs, bool srvc, RuleDirection dir)
 // public methods
 //--------------------------------------------------------------------------
 
-PatternMatchVector get_fp_content(OptTreeNode* otn, OptFpList*& next, bool srvc)
+PatternMatchVector get_fp_content(
+    OptTreeNode* otn, OptFpList*& next, bool srvc, const FpQuality* quality)
 {
     CursorActionType curr_cat = CAT_SET_RAW;
     FpSelector best;
@@ -326,7 +338,7 @@ PatternMatchVector get_fp_content(OptTreeNode* otn, OptFpList*& next, bool srvc)
 
         FpSelector curr(curr_cat, tmp);
 
-        if ( curr.is_better_than(best, srvc, dir) )
+        if ( curr.is_better_than(best, srvc, dir, quality) )
         {
             best = curr;
             next = ofl->next;
@@ -354,6 +366,66 @@ PatternMatchVector get_fp_content(OptTreeNode* otn, OptFpList*& next, bool srvc)
     return pmds;
 }
 
+// the contents that could be chosen as the rule's fast pattern
+PatternMatchVector get_fp_candidates(OptTreeNode* otn)
+{
+    CursorActionType curr_cat = CAT_SET_RAW;
+    RuleDirection dir = get_dir(otn);
+    PatternMatchVector pmds;
+
+    for (OptFpList* ofl = otn->opt_func; ofl; ofl = ofl->next)
+    {
+        if ( !ofl->ips_opt )
+            continue;
+
+        CursorActionType cat = ofl->ips_opt->get_cursor_type();
+
+        if ( cat > CAT_ADJUST )
+            curr_cat = cat;
+
+        PatternMatchData* pmd = get_pmd(ofl, otn->proto, dir);
+
+        if ( pmd and !pmd->negated and pmd_can_be_fp(pmd, curr_cat) )
+            pmds.push_back(pmd);
+    }
+    return pmds;
+}
+
+// true if the rule may read raw pdu data, the message body, or file data.
+// a service pdu carries the (decompressed) body once headers are done so
+// raw data counts too.  setting a buffer without using it doesn't count.
+bool inspects_body(OptTreeNode* otn)
+{
+    CursorActionType curr_cat = CAT_SET_RAW;
+
+    for (OptFpList* ofl = otn->opt_func; ofl; ofl = ofl->next)
+    {
+        if ( !ofl->ips_opt )
+            continue;
+
+        CursorActionType cat = ofl->ips_opt->get_cursor_type();
+
+        if ( cat > CAT_ADJUST )
+        {
+            curr_cat = cat;
+            continue;
+        }
+
+        switch ( ofl->ips_opt->get_type() )
+        {
+        case RULE_OPTION_TYPE_CONTENT:
+        case RULE_OPTION_TYPE_BUFFER_USE:
+            if ( curr_cat == CAT_SET_RAW or curr_cat == CAT_SET_BODY or curr_cat == CAT_SET_FILE )
+                return true;
+            break;
+
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
 //--------------------------------------------------------------------------
 // unit tests
 //--------------------------------------------------------------------------
@@ -599,5 +671,115 @@ TEST_CASE("fp_pkt_key_srvc_rsp", "[FastPatternSelect]")
     CHECK(s0.is_better_than(s1, true, RULE_FROM_SERVER));
     CHECK(!s1.is_better_than(s0, true, RULE_FROM_SERVER));
 }
+
+TEST_CASE("fp_quality_select", "[FastPatternSelect]")
+{
+    PatternMatchData common;
+    set_pmd(common, 0x0, "longer");
+
+    PatternMatchData rare;
+    set_pmd(rare, 0x0, "short");
+
+    FpQuality fq;
+    fq.add(&common);
+    fq.add(&rare);
+    fq.prep();
+
+    const char* corpus[] = { "longer", "longer", "longer short" };
+
+    for ( auto s : corpus )
+        fq.search((const uint8_t*)s, strlen(s));
+
+    REQUIRE(fq.compare(&rare, &common) < 0);
+
+    SECTION("measured hits beat size")
+    {
+        FpSelector s0(CAT_SET_HEADER, &rare);
+        FpSelector s1(CAT_SET_HEADER, &common);
+
+        CHECK(!s0.is_better_than(s1, false, RULE_WO_DIR));
+        CHECK(s0.is_better_than(s1, false, RULE_WO_DIR, &fq));
+        CHECK(!s1.is_better_than(s0, false, RULE_WO_DIR, &fq));
+    }
+    SECTION("explicit fast_pattern beats measured hits")
+    {
+        common.fp = 1;
+        FpSelector s0(CAT_SET_HEADER, &rare);
+        FpSelector s1(CAT_SET_HEADER, &common);
+
+        CHECK(!s0.is_better_than(s1, false, RULE_WO_DIR, &fq));
+        CHECK(s1.is_better_than(s0, false, RULE_WO_DIR, &fq));
+    }
+    SECTION("raw buffer beats measured hits without service")
+    {
+        FpSelector s0(CAT_SET_HEADER, &rare);
+        FpSelector s1(CAT_SET_RAW, &common);
+
+        CHECK(!s0.is_better_than(s1, false, RULE_WO_DIR, &fq));
+        CHECK(s1.is_better_than(s0, false, RULE_WO_DIR, &fq));
+    }
+    SECTION("non-key buffer beats measured hits from server")
+    {
+        FpSelector s0(CAT_SET_KEY, &rare);
+        FpSelector s1(CAT_SET_HEADER, &common);
+
+        CHECK(!s0.is_better_than(s1, true, RULE_FROM_SERVER, &fq));
+        CHECK(s1.is_better_than(s0, true, RULE_FROM_SERVER, &fq));
+    }
+}
+
+class BodyTestOption : public IpsOption
+{
+public:
+    BodyTestOption(option_type_t t, CursorActionType c = CAT_NONE) :
+        IpsOption("body_test", t) { cat = c; }
+
+    CursorActionType get_cursor_type() const override
+    { return cat; }
+
+private:
+    CursorActionType cat;
+};
+
+static bool body_test(IpsOption* first, IpsOption* second = nullptr)
+{
+    OptFpList ofl[2];
+    memset(ofl, 0, sizeof(ofl));
+    ofl[0].ips_opt = first;
+    ofl[0].next = second ? &ofl[1] : nullptr;
+    ofl[1].ips_opt = second;
+
+    OptTreeNode otn;
+    otn.opt_func = ofl;
+    return inspects_body(&otn);
+}
+
+TEST_CASE("body_raw_content", "[InspectsBody]")
+{
+    BodyTestOption content(RULE_OPTION_TYPE_CONTENT);
+    CHECK(body_test(&content));
+}
+
+TEST_CASE("body_file_data", "[InspectsBody]")
+{
+    BodyTestOption file_data(RULE_OPTION_TYPE_BUFFER_SET, CAT_SET_FILE);
+    BodyTestOption byte_test(RULE_OPTION_TYPE_BUFFER_USE);
+    CHECK(body_test(&file_data, &byte_test));
+    CHECK(!body_test(&file_data));
+}
+
+TEST_CASE("body_key_only", "[InspectsBody]")
+{
+    BodyTestOption uri(RULE_OPTION_TYPE_BUFFER_SET, CAT_SET_KEY);
+    BodyTestOption content(RULE_OPTION_TYPE_CONTENT);
+    CHECK(!body_test(&uri, &content));
+}
+
+TEST_CASE("body_no_payload", "[InspectsBody]")
+{
+    BodyTestOption flow(RULE_OPTION_TYPE_OTHER);
+    BodyTestOption flowbits(RULE_OPTION_TYPE_FLOWBIT);
+    CHECK(!body_test(&flow, &flowbits));
+}
 #endif
 
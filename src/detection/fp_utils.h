@@ -25,6 +25,7 @@
 #include <vector>
 #include "framework/ips_option.h"
 
+class FpQuality;
 struct OptFpList;
 struct OptTreeNode;
 
@@ -35,7 +36,10 @@ void validate_fast_pattern(OptTreeNode*);
 int flp_trim(const char* p, int plen, const char** buff);
 bool set_fp_content(OptTreeNode*);
 
-std::vector <PatternMatchData*> get_fp_content(OptTreeNode*, OptFpList*&, bool srvc);
+std::vector <PatternMatchData*> get_fp_content(
+    OptTreeNode*, OptFpList*&, bool srvc, const FpQuality* = nullptr);
+std::vector <PatternMatchData*> get_fp_candidates(OptTreeNode*);
+bool inspects_body(OptTreeNode*);
 
 #endif
 
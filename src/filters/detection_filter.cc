@@ -29,7 +29,7 @@
 #include "parser/parser.h"
 #include "utils/util.h"
 
-static THREAD_LOCAL SFXHASH* detection_filter_hash = NULL;
+static THREAD_LOCAL TrackTable* detection_filter_hash = NULL;
 
 DetectionFilterConfig* DetectionFilterConfigNew()
 {
@@ -71,7 +71,7 @@ void detection_filter_reset_active()
     if (detection_filter_hash == NULL)
         return;
 
-    sfxhash_make_empty(detection_filter_hash);
+    detection_filter_hash->clear();
 }
 
 void* detection_filter_create(DetectionFilterConfig* df_config, THDX_STRUCT* thdx)
@@ -94,12 +94,7 @@ void detection_filter_init(DetectionFilterConfig* df_config)
         return;
 
     if ( !detection_filter_hash )
-    {
         detection_filter_hash = sfthd_local_new(df_config->memcap);
-
-        if ( !detection_filter_hash )
-            FatalError("can't allocate detection filter cache\n");
-    }
 }
 
 void detection_filter_term()
@@ -107,7 +102,7 @@ void detection_filter_term()
     if ( !detection_filter_hash )
         return;
 
-    sfxhash_delete(detection_filter_hash);
+    delete detection_filter_hash;
     detection_filter_hash = NULL;
 }
 
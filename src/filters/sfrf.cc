@@ -26,6 +26,7 @@
 #include "config.h"
 #endif
 
+#include <limits.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -37,7 +38,8 @@
 #include "utils/util.h"
 #include "utils/sflsq.h"
 #include "hash/sfghash.h"
-#include "hash/sfxhash.h"
+#include "filters/track_table.h"
+#include "main/thread.h"
 #include "sfip/sf_ipvar.h"
 
 // Number of hash rows for gid 1 (rules)
@@ -93,9 +95,16 @@ typedef struct
     /*  time when new action was activated due to rate limit exceeding.
     */
     time_t revertTime;
+
+    /* merging of count with other packet threads.
+    */
+    TrackSync sync;
 } tSFRFTrackingNode;
 
-SFXHASH* rf_hash = NULL;
+/* Each packet thread tracks rates in its own table and merges its counts
+ * with the other threads through the config's share.
+ */
+static THREAD_LOCAL TrackTable* rf_table = NULL;
 
 // private methods ...
 static int _checkThreshold(
@@ -113,7 +122,16 @@ static int _checkSamplingPeriod(
 static tSFRFTrackingNode* _getSFRFTrackingNode(
     const sfip_t*,
     unsigned tid,
-    time_t curTime
+    time_t curTime,
+    tSFRFTrackingNodeKey*,
+    bool* added
+    );
+
+static void _mergeSFRFTrackingNode(
+    tSFRFTrackingNode*,
+    const tSFRFTrackingNodeKey*,
+    int delta,
+    bool added
     );
 
 static void _updateDependentThresholds(
@@ -126,52 +144,21 @@ static void _updateDependentThresholds(
     );
 
 // public methods ...
-/* Create a new threshold global context
- *
- * Create a threshold table, initialize the threshold system, and optionally
- * limit it's memory usage.
- *
- * @param nbytes maximum memory to use for thresholding objects, in bytes.
- * @return  pointer to newly created tSFRFContext
-*/
-#define SFRF_BYTES (sizeof(tSFRFTrackingNodeKey) + sizeof(tSFRFTrackingNode))
-
-static void SFRF_New(unsigned nbytes)
+void SFRF_Delete()
 {
-    int nrows;
-
-    /* Calc max ip nodes for this memory */
-    if ( nbytes < SFRF_BYTES )
-    {
-        nbytes = SFRF_BYTES;
-    }
-    nrows = nbytes / (SFRF_BYTES);
-
-    /* Create global hash table for all of the IP Nodes */
-    rf_hash = sfxhash_new(
-        nrows,  /* try one node per row - for speed */
-        sizeof(tSFRFTrackingNodeKey), /* keys size */
-        sizeof(tSFRFTrackingNode),     /* data size */
-        nbytes,                  /* memcap **/
-        1,         /* ANR flag - true ?- Automatic Node Recovery=ANR */
-        0,         /* ANR callback - none */
-        0,         /* user freemem callback - none */
-        1);       /* Recycle nodes ?*/
+    SFRF_ThreadTerm();
 }
 
-void SFRF_Delete()
+void SFRF_ThreadTerm()
 {
-    if ( !rf_hash )
-        return;
-
-    sfxhash_delete(rf_hash);
-    rf_hash = NULL;
+    delete rf_table;
+    rf_table = NULL;
 }
 
 void SFRF_Flush()
 {
-    if ( rf_hash )
-        sfxhash_make_empty(rf_hash);
+    if ( rf_table )
+        rf_table->clear();
 }
 
 static void SFRF_ConfigNodeFree(void* item)
@@ -227,18 +214,16 @@ int SFRF_ConfigAdd(
 
     PolicyId policy_id = get_network_policy()->policy_id;
 
-    // Auto init - memcap must be set 1st, which is not really a problem
-    if ( rf_hash == NULL )
-    {
-        SFRF_New(rf_config->memcap);
-
-        if ( rf_hash == NULL )
-            return -1;
-    }
-
     if ((rf_config == NULL) || (cfgNode == NULL))
         return -1;
 
+    // Auto init - memcap and sync must be set 1st, which is not really a problem
+    if ( rf_config->share == NULL )
+    {
+        rf_config->share = new TrackShare(sizeof(tSFRFTrackingNodeKey),
+            sizeof(tSFRFTrackingNode), rf_config->memcap, rf_config->sync);
+    }
+
     if ( (cfgNode->sid == 0 ) || (cfgNode->gid == 0) )
         return -1;
 
@@ -369,12 +354,17 @@ static int SFRF_TestObject(
     )
 {
     tSFRFTrackingNode* dynNode;
+    tSFRFTrackingNodeKey key;
+    bool added;
     int retValue = -1;
 
-    dynNode = _getSFRFTrackingNode(ip, cfgNode->tid, curTime);
+    dynNode = _getSFRFTrackingNode(ip, cfgNode->tid, curTime, &key, &added);
 
     if ( dynNode == NULL )
+    {
+        rf_table->release();
         return retValue;
+    }
 
     if ( _checkSamplingPeriod(cfgNode, dynNode, curTime) != 0 )
     {
@@ -384,6 +374,8 @@ static int SFRF_TestObject(
 #endif
     }
 
+    unsigned count = dynNode->count;
+
     switch (op)
     {
     case SFRF_COUNT_INCREMENT:
@@ -409,6 +401,8 @@ static int SFRF_TestObject(
         break;
     }
 
+    _mergeSFRFTrackingNode(dynNode, &key, (int)(dynNode->count - count), added);
+
     retValue = _checkThreshold(cfgNode, dynNode, curTime);
 
     // we drop after the session count has been incremented
@@ -417,7 +411,10 @@ static int SFRF_TestObject(
     // threshold would never be exceeded.
     if ( !cfgNode->seconds && dynNode->count > cfgNode->count )
         if ( cfgNode->newAction == RULE_TYPE__DROP )
+        {
             dynNode->count--;
+            _mergeSFRFTrackingNode(dynNode, &key, -1, false);
+        }
 
 #ifdef SFRF_DEBUG
     printf("--SFRF_DEBUG: %d-%d-%d: %d Packet IP %s, op: %d, count %d, action %d\n",
@@ -426,6 +423,7 @@ static int SFRF_TestObject(
         dynNode->count, retValue);
     fflush(stdout);
 #endif
+    rf_table->release();
     return retValue;
 }
 
@@ -476,6 +474,18 @@ int SFRF_TestThreshold(
     if ( gid >= SFRF_MAX_GENID )
         return status; /* bogus gid */
 
+    if ( !rf_table )
+    {
+        if ( !config->share )
+            return status; /* no rate filters */
+
+        // an exact share keeps all the nodes so the thread's table is empty
+        rf_table = new TrackTable(sizeof(tSFRFTrackingNodeKey), sizeof(tSFRFTrackingNode),
+            config->share->is_exact() ? 0 : config->memcap);
+
+        rf_table->set_share(config->share);
+    }
+
     // Some events (like 'TCP connection closed' raised by preprocessor may
     // not have any configured threshold but may impact thresholds for other
     // events (like 'TCP connection opened'
@@ -787,39 +797,64 @@ static void _updateDependentThresholds(
     }
 }
 
+/* The node may be shared; rf_table->release() must follow.
+ */
 static tSFRFTrackingNode* _getSFRFTrackingNode(
     const sfip_t* ip,
     unsigned tid,
-    time_t curTime
+    time_t curTime,
+    tSFRFTrackingNodeKey* key,
+    bool* added
     )
 {
-    tSFRFTrackingNode* dynNode = NULL;
-    tSFRFTrackingNodeKey key;
-    SFXHASH_NODE* hnode = NULL;
+    tSFRFTrackingNode* dynNode;
 
     /* Setup key */
-    key.ip = *(ip);
-    key.tid = tid;
-    key.policyId = get_network_policy()->policy_id;
+    memset(key, 0, sizeof(*key));
+    key->ip = *(ip);
+    key->tid = tid;
+    key->policyId = get_network_policy()->policy_id;
 
     /*
      * Check for any Permanent sid objects for this gid or add this one ...
      */
-    hnode = sfxhash_get_node(rf_hash, (void*)&key);
-    if ( hnode && hnode->data )
-    {
-        dynNode = (tSFRFTrackingNode*)hnode->data;
+    dynNode = (tSFRFTrackingNode*)rf_table->acquire(key, *added);
 
-        if ( dynNode->filterState == FS_NEW )
-        {
-            // first time initialization
-            dynNode->tstart = curTime;
+    if ( dynNode && dynNode->filterState == FS_NEW )
+    {
+        // first time initialization
+        dynNode->tstart = curTime;
 #ifdef SFRF_OVER_RATE
-            dynNode->tlast = curTime;
+        dynNode->tlast = curTime;
 #endif
-            dynNode->filterState = FS_OFF;
-        }
+        dynNode->filterState = FS_OFF;
     }
     return dynNode;
 }
 
+/* Publish the local change to the count and pick up the changes made by
+ * other packet threads.
+ */
+static void _mergeSFRFTrackingNode(
+    tSFRFTrackingNode* dynNode,
+    const tSFRFTrackingNodeKey* key,
+    int delta,
+    bool added
+    )
+{
+    int64_t remote = rf_table->update(key, dynNode->sync, delta, added);
+
+    if ( !remote )
+        return;
+
+    int64_t count = (int64_t)dynNode->count + remote;
+
+    if ( count < 0 )
+        count = 0;
+
+    else if ( count > UINT_MAX )
+        count = UINT_MAX;
+
+    dynNode->count = (unsigned)count;
+}
+
@@ -28,6 +28,7 @@
 #include "actions/actions.h"
 
 struct sfip_t;
+class TrackShare;
 
 // define to use over rate threshold
 #define SFRF_OVER_RATE
@@ -139,8 +140,15 @@ struct RateFilterConfig
     // count of no revert DOS thresholds
     unsigned noRevertCount;
 
+    // per packet thread or shared if sync is 1
     int memcap;
 
+    // events counted between merges across packet threads
+    unsigned sync;
+
+    // created with the first rate filter
+    TrackShare* share;
+
     int internal_event_mask;
 };
 
@@ -148,6 +156,7 @@ struct RateFilterConfig
  * Prototypes
  */
 void SFRF_Delete();
+void SFRF_ThreadTerm();
 void SFRF_Flush();
 int SFRF_ConfigAdd(struct SnortConfig*, RateFilterConfig*, tSFRFConfigNode*);
 
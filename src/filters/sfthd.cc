@@ -43,7 +43,6 @@
 #include "sfip/sf_ipvar.h"
 #include "utils/sflsq.h"
 #include "hash/sfghash.h"
-#include "hash/sfxhash.h"
 #include "utils/util.h"
 #include "utils/dyn_array.h"
 
@@ -53,29 +52,6 @@
 // This disables adding and testing of Threshold objects
 //#define CRIPPLE
 
-SFXHASH* sfthd_new_hash(unsigned nbytes, size_t key, size_t data)
-{
-    size_t size = key + data;
-    int nrows;
-
-    /* Calc max ip nodes for this memory */
-    if ( nbytes < size )
-    {
-        nbytes = size;
-    }
-    nrows = nbytes / (size);
-
-    return sfxhash_new(
-        nrows,  /* try one node per row - for speed */
-        key,    /* keys size */
-        data,   /* data size */
-        nbytes, /* memcap **/
-        1,      /* ANR flag - true ?- Automatic Node Recovery=ANR */
-        0,      /* ANR callback - none */
-        0,      /* user freemem callback - none */
-        1);     /* Recycle nodes ?*/
-}
-
 /*!
   Create a threshold table, initialize the threshold system,
   and optionally limit it's memory usage.
@@ -87,34 +63,14 @@ SFXHASH* sfthd_new_hash(unsigned nbytes, size_t key, size_t data)
   @retval !0 valid THD_STRUCT
 */
 
-SFXHASH* sfthd_local_new(unsigned bytes)
+TrackTable* sfthd_local_new(unsigned bytes)
 {
-    SFXHASH* local_hash =
-        sfthd_new_hash(bytes,
-        sizeof(THD_IP_NODE_KEY),
-        sizeof(THD_IP_NODE));
-
-#ifdef THD_DEBUG
-    if (local_hash == NULL)
-        printf("Could not allocate the sfxhash table\n");
-#endif
-
-    return local_hash;
+    return new TrackTable(sizeof(THD_IP_NODE_KEY), sizeof(THD_IP_NODE), bytes);
 }
 
-SFXHASH* sfthd_global_new(unsigned bytes)
+TrackTable* sfthd_global_new(unsigned bytes)
 {
-    SFXHASH* global_hash =
-        sfthd_new_hash(bytes,
-        sizeof(THD_IP_GNODE_KEY),
-        sizeof(THD_IP_NODE));
-
-#ifdef THD_DEBUG
-    if (global_hash == NULL)
-        printf("Could not allocate the sfxhash table\n");
-#endif
-
-    return global_hash;
+    return new TrackTable(sizeof(THD_IP_GNODE_KEY), sizeof(THD_IP_NODE), bytes);
 }
 
 THD_STRUCT* sfthd_new(unsigned lbytes, unsigned gbytes)
@@ -125,31 +81,14 @@ THD_STRUCT* sfthd_new(unsigned lbytes, unsigned gbytes)
     thd = (THD_STRUCT*)snort_calloc(sizeof(THD_STRUCT));
 
 #ifndef CRIPPLE
-    /* Create hash table for all of the local IP Nodes */
+    /* Create table for all of the local IP Nodes */
     thd->ip_nodes = sfthd_local_new(lbytes);
-    if ( !thd->ip_nodes )
-    {
-#ifdef THD_DEBUG
-        printf("Could not allocate the sfxhash table\n");
-#endif
-        snort_free(thd);
-        return NULL;
-    }
 
     if ( gbytes == 0 )
         return thd;
 
-    /* Create hash table for all of the global IP Nodes */
+    /* Create table for all of the global IP Nodes */
     thd->ip_gnodes = sfthd_global_new(gbytes);
-    if ( !thd->ip_gnodes )
-    {
-#ifdef THD_DEBUG
-        printf("Could not allocate the sfxhash table\n");
-#endif
-        sfxhash_delete(thd->ip_nodes);
-        snort_free(thd);
-        return NULL;
-    }
 #endif
 
     return thd;
@@ -243,11 +182,8 @@ void sfthd_free(THD_STRUCT* thd)
         return;
 
 #ifndef CRIPPLE
-    if (thd->ip_nodes != NULL)
-        sfxhash_delete(thd->ip_nodes);
-
-    if (thd->ip_gnodes != NULL)
-        sfxhash_delete(thd->ip_gnodes);
+    delete thd->ip_nodes;
+    delete thd->ip_gnodes;
 #endif
 
     snort_free(thd);
@@ -661,7 +597,38 @@ static char* printIP(unsigned u)
 
 #endif
 
-int sfthd_test_rule(SFXHASH* rule_hash, THD_NODE* sfthd_node,
+/*
+ *  Find or add the tracking node for key and count this event including
+ *  any events counted by other packet threads since the last merge.
+ *  The node may be shared; hash->release() must follow.
+ */
+static inline THD_IP_NODE* sfthd_get_ip_node(
+    TrackTable* hash, const void* key, time_t curtime)
+{
+    bool added;
+    THD_IP_NODE* sfthd_ip_node = (THD_IP_NODE*)hash->acquire(key, added);
+
+    if ( !sfthd_ip_node )
+        return NULL;
+
+    if ( added )
+    {
+        sfthd_ip_node->count  = 1;
+        sfthd_ip_node->prev   = 0;
+        sfthd_ip_node->tstart = sfthd_ip_node->tlast = curtime; /* Event time */
+    }
+    else
+        sfthd_ip_node->count++;
+
+    int64_t remote = hash->update(key, sfthd_ip_node->sync, 1, added);
+
+    if ( remote > 0 )
+        sfthd_ip_node->count += remote;
+
+    return sfthd_ip_node;
+}
+
+int sfthd_test_rule(TrackTable* rule_hash, THD_NODE* sfthd_node,
     const sfip_t* sip, const sfip_t* dip, long curtime)
 {
     int status;
@@ -859,15 +826,14 @@ static inline int sfthd_test_non_suppress(
  *
  */
 int sfthd_test_local(
-    SFXHASH* local_hash,
+    TrackTable* local_hash,
     THD_NODE* sfthd_node,
     const sfip_t* sip,
     const sfip_t* dip,
     time_t curtime)
 {
     THD_IP_NODE_KEY key;
-    THD_IP_NODE data,* sfthd_ip_node;
-    int status=0;
+    THD_IP_NODE* sfthd_ip_node;
     const sfip_t* ip;
 
     PolicyId policy_id = get_network_policy()->policy_id;
@@ -914,46 +880,29 @@ int sfthd_test_local(
     */
 
     /* Set up the key */
+    memset(&key, 0, sizeof(key));
     key.policyId = policy_id;
     key.ip = *ip;
     key.thd_id = sfthd_node->thd_id;
 
-    /* Set up a new data element */
-    data.count  = 1;
-    data.prev   = 0;
-    data.tstart = data.tlast = curtime; /* Event time */
-
     /*
      * Check for any Permanent sig_id objects for this gen_id  or add this one ...
      */
-    status = sfxhash_add(local_hash, (void*)&key, &data);
-    if (status == SFXHASH_INTABLE)
-    {
-        /* Already in the table */
-        sfthd_ip_node = (THD_IP_NODE*)local_hash->cnode->data;
+    sfthd_ip_node = sfthd_get_ip_node(local_hash, &key, curtime);
 
-        /* Increment the event count */
-        sfthd_ip_node->count++;
-    }
-    else if (status != SFXHASH_OK)
-    {
-        /* hash error */
-        return 1; /*  check the next threshold object */
-    }
-    else
-    {
-        /* Was not in the table - it was added - work with our copy of the data */
-        sfthd_ip_node = &data;
-    }
+    /* no memory, check the next threshold object */
+    int status = sfthd_ip_node ?
+        sfthd_test_non_suppress(sfthd_node, sfthd_ip_node, curtime) : 1;
 
-    return sfthd_test_non_suppress(sfthd_node, sfthd_ip_node, curtime);
+    local_hash->release();
+    return status;
 }
 
 /*
  *   Test a global thresholding object
  */
 static inline int sfthd_test_global(
-    SFXHASH* global_hash,
+    TrackTable* global_hash,
     THD_NODE* sfthd_node,
     unsigned sig_id,     /* from current event */
     const sfip_t* sip,        /* " */
@@ -961,9 +910,7 @@ static inline int sfthd_test_global(
     time_t curtime)
 {
     THD_IP_GNODE_KEY key;
-    THD_IP_NODE data;
     THD_IP_NODE* sfthd_ip_node;
-    int status=0;
     const sfip_t* ip;
 
     PolicyId policy_id = get_network_policy()->policy_id;
@@ -1006,38 +953,21 @@ static inline int sfthd_test_global(
     */
 
     /* Set up the key */
+    memset(&key, 0, sizeof(key));
     key.ip = *ip;
     key.gen_id = sfthd_node->gen_id;
     key.sig_id = sig_id;
     key.policyId = policy_id;
 
-    /* Set up a new data element */
-    data.count  = 1;
-    data.prev  = 0;
-    data.tstart = data.tlast = curtime; /* Event time */
-
     /* Check for any Permanent sig_id objects for this gen_id  or add this one ...  */
-    status = sfxhash_add(global_hash, (void*)&key, &data);
-    if (status == SFXHASH_INTABLE)
-    {
-        /* Already in the table */
-        sfthd_ip_node = (THD_IP_NODE*)global_hash->cnode->data;
+    sfthd_ip_node = sfthd_get_ip_node(global_hash, &key, curtime);
 
-        /* Increment the event count */
-        sfthd_ip_node->count++;
-    }
-    else if (status != SFXHASH_OK)
-    {
-        /* hash error */
-        return 1; /*  check the next threshold object */
-    }
-    else
-    {
-        /* Was not in the table - it was added - work with our copy of the data */
-        sfthd_ip_node = &data;
-    }
+    /* no memory, check the next threshold object */
+    int status = sfthd_ip_node ?
+        sfthd_test_non_suppress(sfthd_node, sfthd_ip_node, curtime) : 1;
 
-    return sfthd_test_non_suppress(sfthd_node, sfthd_ip_node, curtime);
+    global_hash->release();
+    return status;
 }
 
 /*!
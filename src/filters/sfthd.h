@@ -29,7 +29,7 @@
 
 #include "utils/sflsq.h"
 #include "hash/sfghash.h"
-#include "hash/sfxhash.h"
+#include "filters/track_table.h"
 #include "main/policy.h"
 #include "sfip/sfip_t.h"
 
@@ -80,6 +80,7 @@ enum
 
     Dynamic hashed node data - added and deleted during runtime
     These are added during run-time, and recycled if we max out memory usage.
+    sync tracks the merging of count with other packet threads.
 */
 typedef struct
 {
@@ -87,6 +88,7 @@ typedef struct
     unsigned prev;
     time_t tstart;
     time_t tlast;
+    TrackSync sync;
 } THD_IP_NODE;
 
 /*!
@@ -179,12 +181,12 @@ typedef struct
     The main thresholding data structure.
 
     Local and global threshold thd_id's are all unqiue, so we use just one
-    ip_nodes lookup table
+    ip_nodes lookup table.  Each packet thread has its own THD_STRUCT.
  */
 struct THD_STRUCT
 {
-    SFXHASH* ip_nodes;   /* Global hash of active IP's key=THD_IP_NODE_KEY, data=THD_IP_NODE */
-    SFXHASH* ip_gnodes;  /* Global hash of active IP's key=THD_IP_GNODE_KEY, data=THD_IP_GNODE */
+    TrackTable* ip_nodes;   /* Active IP's key=THD_IP_NODE_KEY, data=THD_IP_NODE */
+    TrackTable* ip_gnodes;  /* Active IP's key=THD_IP_GNODE_KEY, data=THD_IP_NODE */
 };
 
 struct ThresholdObjects
@@ -210,13 +212,13 @@ struct ThresholdObjects
 // lbytes = local threshold memcap
 // gbytes = global threshold memcap (0 to disable global)
 THD_STRUCT* sfthd_new(unsigned lbytes, unsigned gbytes);
-SFXHASH* sfthd_local_new(unsigned bytes);
-SFXHASH* sfthd_global_new(unsigned bytes);
+TrackTable* sfthd_local_new(unsigned bytes);
+TrackTable* sfthd_global_new(unsigned bytes);
 void sfthd_free(THD_STRUCT*);
 ThresholdObjects* sfthd_objs_new();
 void sfthd_objs_free(ThresholdObjects*);
 
-int sfthd_test_rule(SFXHASH* rule_hash, THD_NODE* sfthd_node,
+int sfthd_test_rule(TrackTable* rule_hash, THD_NODE* sfthd_node,
     const sfip_t* sip, const sfip_t* dip, long curtime);
 
 void* sfthd_create_rule_threshold(
@@ -254,10 +256,8 @@ int sfthd_test_threshold(
     const sfip_t* dip,
     long curtime);
 
-SFXHASH* sfthd_new_hash(unsigned, size_t, size_t);
-
 int sfthd_test_local(
-    SFXHASH* local_hash,
+    TrackTable* local_hash,
     THD_NODE* sfthd_node,
     const sfip_t* sip,
     const sfip_t* dip,
@@ -87,7 +87,7 @@ typedef struct
 
 static THD_STRUCT* pThd = NULL;
 static ThresholdObjects* pThdObjs = NULL;
-static SFXHASH* dThd = NULL;
+static TrackTable* dThd = NULL;
 
 //---------------------------------------------------------------
 
@@ -804,7 +804,8 @@ static void Term()
             p->rule = nullptr;
         }
     }
-    sfxhash_delete(dThd);
+    delete dThd;
+    dThd = NULL;
 }
 
 static int SetupCheck(int i)
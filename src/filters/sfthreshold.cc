@@ -49,7 +49,7 @@
 #include "parser/parser.h"
 
 /* Data */
-THD_STRUCT* thd_runtime = NULL;
+static THREAD_LOCAL THD_STRUCT* thd_runtime = NULL;
 
 static THREAD_LOCAL int thd_checked = 0; // per packet
 static THREAD_LOCAL int thd_answer = 0;  // per packet
@@ -64,6 +64,7 @@ ThresholdConfig* ThresholdConfigNew()
     /* sfthd_objs_new will handle fatal */
     tc->thd_objs = sfthd_objs_new();
     tc->memcap = 1024 * 1024;
+    tc->sync = 1;
     tc->enabled = 1;
 
     return tc;
@@ -80,6 +81,9 @@ void ThresholdConfigFree(ThresholdConfig* tc)
         tc->thd_objs = NULL;
     }
 
+    delete tc->share;
+    delete tc->gshare;
+
     snort_free(tc);
 }
 
@@ -256,6 +260,11 @@ void print_thresholding(ThresholdConfig*, unsigned)
 { }
 
 void sfthreshold_free()
+{
+    sfthreshold_tterm();
+}
+
+void sfthreshold_tterm()
 {
     if (thd_runtime != NULL)
         sfthd_free(thd_runtime);
@@ -263,6 +272,25 @@ void sfthreshold_free()
     thd_runtime = NULL;
 }
 
+/* Each packet thread tracks events in its own tables; none are needed
+ * until a threshold is created.  An exact share keeps all the nodes so
+ * the thread's tables are left empty. */
+static THD_STRUCT* get_runtime(ThresholdConfig* thd_config)
+{
+    if (thd_runtime == NULL && thd_config->share != NULL)
+    {
+        unsigned memcap = thd_config->share->is_exact() ? 0 : thd_config->memcap;
+
+        thd_runtime = (THD_STRUCT*)snort_calloc(sizeof(THD_STRUCT));
+        thd_runtime->ip_nodes = sfthd_local_new(memcap);
+        thd_runtime->ip_gnodes = sfthd_global_new(memcap);
+
+        thd_runtime->ip_nodes->set_share(thd_config->share);
+        thd_runtime->ip_gnodes->set_share(thd_config->gshare);
+    }
+    return thd_runtime;
+}
+
 /*
 
     Create and Add a Thresholding Event Object
@@ -277,12 +305,13 @@ int sfthreshold_create(
     if (!thd_config->enabled)
         return 0;
 
-    /* Auto init - memcap must be set 1st, which is not really a problem */
-    if (thd_runtime == NULL)
+    /* Auto init - memcap and sync must be set 1st, which is not really a problem */
+    if (thd_config->share == NULL)
     {
-        thd_runtime = sfthd_new(thd_config->memcap, thd_config->memcap);
-        if (thd_runtime == NULL)
-            return -1;
+        thd_config->share = new TrackShare(sizeof(THD_IP_NODE_KEY), sizeof(THD_IP_NODE),
+            thd_config->memcap, thd_config->sync);
+        thd_config->gshare = new TrackShare(sizeof(THD_IP_GNODE_KEY), sizeof(THD_IP_NODE),
+            thd_config->memcap, thd_config->sync);
     }
 
     /* print_thdx( thdx ); */
@@ -324,8 +353,9 @@ int sfthreshold_test(
     if (!thd_checked)
     {
         thd_checked = 1;
-        thd_answer = sfthd_test_threshold(snort_conf->threshold_config->thd_objs,
-            thd_runtime, gen_id, sig_id, sip, dip, curtime);
+        ThresholdConfig* thd_config = snort_conf->threshold_config;
+        thd_answer = sfthd_test_threshold(thd_config->thd_objs,
+            get_runtime(thd_config), gen_id, sig_id, sip, dip, curtime);
     }
 
     return thd_answer;
@@ -348,9 +378,9 @@ void sfthreshold_reset_active()
         return;
 
     if (thd_runtime->ip_nodes != NULL)
-        sfxhash_make_empty(thd_runtime->ip_nodes);
+        thd_runtime->ip_nodes->clear();
 
     if (thd_runtime->ip_gnodes != NULL)
-        sfxhash_make_empty(thd_runtime->ip_gnodes);
+        thd_runtime->ip_gnodes->clear();
 }
 
@@ -23,12 +23,16 @@
 struct sfip_t;
 struct THDX_STRUCT;
 struct ThresholdObjects;
+class TrackShare;
 
 struct ThresholdConfig
 {
-    int memcap;
+    int memcap;    // per packet thread or shared if sync is 1
+    unsigned sync; // events counted between merges across threads
     int enabled;
     ThresholdObjects* thd_objs;
+    TrackShare* share;   // created with the first threshold
+    TrackShare* gshare;
 };
 
 ThresholdConfig* ThresholdConfigNew();
@@ -39,6 +43,7 @@ int sfthreshold_test(unsigned int, unsigned int, const sfip_t*, const sfip_t*, l
 void print_thresholding(ThresholdConfig*, unsigned shutdown);
 void sfthreshold_reset_active();
 void sfthreshold_free();
+void sfthreshold_tterm();
 
 #endif
 
@@ -0,0 +1,226 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// track_table.cc
+
+#include "track_table.h"
+
+#include <string.h>
+
+#include "utils/util.h"
+
+#define MAX_PROBES 8
+
+// each slot is a header, the key, and the data, all 8 byte aligned
+struct TrackSlot
+{
+    uint32_t hash;
+    uint32_t stamp;  // 0 means empty, otherwise time of last use
+};
+
+static inline unsigned align8(unsigned n)
+{ return (n + 7) & ~7u; }
+
+//-------------------------------------------------------------------------
+// table
+//-------------------------------------------------------------------------
+
+TrackTable::TrackTable(unsigned ks, unsigned ds, unsigned memcap)
+{
+    key_size = ks;
+    data_size = ds;
+    stride = sizeof(TrackSlot) + align8(ks) + align8(ds);
+
+    size = 0;
+
+    if ( memcap >= stride )
+    {
+        size = 1;
+
+        while ( (size_t)size * 2 * stride <= memcap )
+            size *= 2;
+    }
+
+    mask = size ? size - 1 : 0;
+    probes = size < MAX_PROBES ? size : MAX_PROBES;
+    table = size ? (uint8_t*)snort_calloc(size, stride) : nullptr;
+
+    count = 0;
+    tick = 0;
+
+    share = nullptr;
+}
+
+TrackTable::~TrackTable()
+{
+    if ( table )
+        snort_free(table);
+}
+
+uint32_t TrackTable::hash(const void* key) const
+{
+    const uint8_t* k = (const uint8_t*)key;
+    uint32_t h = 2166136261u;
+    unsigned i = 0;
+
+    for ( ; i + 4 <= key_size; i += 4 )
+    {
+        uint32_t w;
+        memcpy(&w, k + i, sizeof(w));
+        h = (h ^ w) * 16777619u;
+    }
+    for ( ; i < key_size; i++ )
+        h = (h ^ k[i]) * 16777619u;
+
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return h;
+}
+
+// nothing is ever removed except by clear() so the first empty slot ends
+// the probe sequence
+void* TrackTable::get(const void* key, bool& added)
+{
+    added = false;
+
+    if ( !size )
+        return nullptr;
+
+    if ( !++tick )
+    {
+        // restart the clock without losing the order of use
+        for ( unsigned i = 0; i < size; i++ )
+        {
+            TrackSlot* s = (TrackSlot*)slot(i);
+
+            if ( s->stamp )
+                s->stamp = 1;
+        }
+        tick = 2;
+    }
+
+    const uint32_t h = hash(key);
+    const unsigned koff = sizeof(TrackSlot);
+    const unsigned doff = koff + align8(key_size);
+
+    unsigned i = h & mask;
+    TrackSlot* victim = nullptr;
+
+    for ( unsigned n = 0; n < probes; n++, i = (i + 1) & mask )
+    {
+        TrackSlot* s = (TrackSlot*)slot(i);
+
+        if ( !s->stamp )
+        {
+            victim = s;
+            count++;
+            break;
+        }
+
+        if ( s->hash == h and !memcmp((uint8_t*)s + koff, key, key_size) )
+        {
+            s->stamp = tick;
+            return (uint8_t*)s + doff;
+        }
+
+        if ( !victim or s->stamp < victim->stamp )
+            victim = s;
+    }
+
+    victim->hash = h;
+    victim->stamp = tick;
+    memcpy((uint8_t*)victim + koff, key, key_size);
+
+    uint8_t* data = (uint8_t*)victim + doff;
+    memset(data, 0, data_size);
+
+    added = true;
+    return data;
+}
+
+void TrackTable::clear()
+{
+    if ( table )
+        memset(table, 0, (size_t)size * stride);
+
+    count = 0;
+    tick = 0;
+}
+
+void* TrackTable::acquire(const void* key, bool& added)
+{
+    if ( share and share->is_exact() )
+        return share->acquire(key, added);
+
+    return get(key, added);
+}
+
+void TrackTable::release()
+{
+    if ( share and share->is_exact() )
+        share->release();
+}
+
+int64_t TrackTable::update(const void* key, TrackSync& ts, int delta, bool added)
+{
+    if ( !share or share->get_sync() < 2 )
+        return 0;
+
+    ts.pending += delta;
+
+    if ( !added and ++ts.updates < share->get_sync() )
+        return 0;
+
+    return share->merge(key, ts, added);
+}
+
+//-------------------------------------------------------------------------
+// share
+//-------------------------------------------------------------------------
+
+TrackShare::TrackShare(unsigned key_size, unsigned data_size, unsigned memcap, unsigned s) :
+    table(key_size, s == 1 ? data_size : sizeof(int64_t), s ? memcap : 0)
+{
+    sync = s;
+}
+
+// a thread's first merge for a key can't tell which part of the total is
+// recent so it only picks up changes made after that
+int64_t TrackShare::merge(const void* key, TrackSync& ts, bool first)
+{
+    std::lock_guard<std::mutex> hold(lock);
+
+    bool added;
+    int64_t* total = (int64_t*)table.get(key, added);
+    int64_t remote = 0;
+
+    if ( total )
+    {
+        if ( !first and !added )
+            remote = *total - ts.seen;
+
+        *total += ts.pending;
+        ts.seen = *total;
+    }
+    ts.pending = 0;
+    ts.updates = 0;
+
+    return remote;
+}
+
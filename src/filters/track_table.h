@@ -0,0 +1,146 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// track_table.h
+
+#ifndef TRACK_TABLE_H
+#define TRACK_TABLE_H
+
+// TrackTable is the event tracking store used by the filters.  It is a
+// fixed size open addressing table of fixed size keys and data kept inline
+// so a lookup usually touches a single cache line.  The number of entries
+// is the largest power of 2 that fits in the memcap.  When a key's probe
+// sequence is full the least recently used entry in that sequence is
+// recycled, much like sfxhash ANR.  A table is not thread safe; each
+// packet thread has its own.
+//
+// Counts for the same key on different threads can be shared through a
+// TrackShare.  With a sync of 1 the share is exact: the data for each key
+// is kept only in the shared table and acquire() returns it under the
+// share's lock, so counts and windows are global as if there were one
+// table, at the cost of a lock per event.  With larger sync values each
+// thread keeps its own data and publishes its local count changes every
+// sync updates, picking up the changes made by the other threads since
+// its last merge.  These counts are approximate: the shared total spans
+// all windows, so a thread's first update for a key only establishes its
+// place in the total and doesn't import events other threads counted
+// before that, and windows and other state derived from the counts are
+// kept per thread.  Larger sync values trade accuracy for less contention.
+
+#include <stdint.h>
+#include <mutex>
+
+struct TrackSync
+{
+    int64_t seen;      // shared total as of the last merge
+    int32_t pending;   // local changes not yet merged
+    uint32_t updates;  // local updates since the last merge
+};
+
+class TrackShare;
+
+class TrackTable
+{
+public:
+    TrackTable(unsigned key_size, unsigned data_size, unsigned memcap);
+    ~TrackTable();
+
+    // returns the data for key or null if the table has no room at all.
+    // added is set if the data was just zeroed for a new key.
+    void* get(const void* key, bool& added);
+
+    void clear();
+
+    unsigned get_count() const
+    { return count; }
+
+    unsigned get_size() const
+    { return size; }
+
+    void set_share(TrackShare* ts)
+    { share = ts; }
+
+    TrackShare* get_share() const
+    { return share; }
+
+    // returns the data for key from the share if it is exact and from this
+    // table otherwise, like get().  release() must be called when done with
+    // the data, even if it is null.
+    void* acquire(const void* key, bool& added);
+    void release();
+
+    // record a local change of delta to the count for key and return the
+    // net change made by other threads since the last merge.  the first
+    // update of a new key only establishes its place in the shared total.
+    // this does nothing with an exact share.
+    int64_t update(const void* key, TrackSync&, int delta, bool added);
+
+private:
+    uint8_t* slot(unsigned i) const
+    { return table + (size_t)i * stride; }
+
+    uint32_t hash(const void* key) const;
+
+private:
+    uint8_t* table;
+    unsigned size;
+    unsigned mask;
+    unsigned probes;
+    unsigned count;
+    uint32_t tick;
+
+    unsigned key_size;
+    unsigned data_size;
+    unsigned stride;
+
+    TrackShare* share;
+};
+
+// the shared data for a TrackTable key space.  sync is the number of local
+// updates between merges, 0 disables sharing and 1 makes the share exact,
+// keeping data_size bytes for each key rather than a total count.
+class TrackShare
+{
+public:
+    TrackShare(unsigned key_size, unsigned data_size, unsigned memcap, unsigned sync);
+
+    unsigned get_sync() const
+    { return sync; }
+
+    bool is_exact() const
+    { return sync == 1; }
+
+    int64_t merge(const void* key, TrackSync&, bool first);
+
+    void* acquire(const void* key, bool& added)
+    {
+        lock.lock();
+        return table.get(key, added);
+    }
+
+    void release()
+    { lock.unlock(); }
+
+private:
+    std::mutex lock;
+    TrackTable table;
+    unsigned sync;
+};
+
+#endif
+
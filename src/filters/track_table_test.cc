@@ -0,0 +1,287 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// track_table_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "catch/catch.hpp"
+#include "catch/unit_test.h"
+#include "hash/sfxhash.h"
+
+#include "track_table.h"
+
+//---------------------------------------------------------------
+
+SNORT_CATCH_FORCED_INCLUSION_DEFINITION(track_table_test);
+
+struct TestKey
+{
+    uint32_t id;
+    uint32_t pad;
+    uint64_t other;
+};
+
+struct TestNode
+{
+    unsigned count;
+    TrackSync sync;
+};
+
+static TestKey make_key(unsigned id)
+{
+    TestKey key;
+    key.id = id;
+    key.pad = 0;
+    key.other = (uint64_t)id * 0x9E3779B97F4A7C15ull;
+    return key;
+}
+
+static void count_event(TrackTable& tt, const TestKey& key)
+{
+    bool added;
+    TestNode* node = (TestNode*)tt.acquire(&key, added);
+
+    if ( node )
+    {
+        node->count++;
+        node->count += tt.update(&key, node->sync, 1, added);
+    }
+    tt.release();
+}
+
+static unsigned get_count(TrackTable& tt, unsigned id)
+{
+    TestKey key = make_key(id);
+    bool added;
+    TestNode* node = (TestNode*)tt.acquire(&key, added);
+    unsigned count = (added or !node) ? 0 : node->count;
+    tt.release();
+    return count;
+}
+
+//---------------------------------------------------------------
+
+TEST_CASE("track table basic", "[track_table]")
+{
+    TrackTable tt(sizeof(TestKey), sizeof(TestNode), 1024 * 1024);
+    CHECK(tt.get_size() > 0);
+    CHECK((tt.get_size() & (tt.get_size() - 1)) == 0);
+
+    for ( unsigned n = 0; n < 3; n++ )
+        for ( unsigned i = 0; i < 1000; i++ )
+            count_event(tt, make_key(i));
+
+    CHECK(tt.get_count() == 1000);
+
+    for ( unsigned i = 0; i < 1000; i++ )
+        CHECK(get_count(tt, i) == 3);
+
+    tt.clear();
+    CHECK(tt.get_count() == 0);
+    CHECK(get_count(tt, 0) == 0);
+}
+
+TEST_CASE("track table memcap", "[track_table]")
+{
+    TrackTable none(sizeof(TestKey), sizeof(TestNode), 0);
+    bool added;
+    TestKey key = make_key(1);
+    CHECK(none.get_size() == 0);
+    CHECK(none.get(&key, added) == nullptr);
+
+    // a table of 8 entries recycles the least recently used
+    TrackTable tt(sizeof(TestKey), sizeof(TestNode), 8 * 64);
+    REQUIRE(tt.get_size() == 8);
+
+    for ( unsigned i = 0; i < 8; i++ )
+        count_event(tt, make_key(i));
+
+    CHECK(tt.get_count() == 8);
+    count_event(tt, make_key(0));
+    count_event(tt, make_key(100));
+
+    CHECK(tt.get_count() == 8);
+    CHECK(get_count(tt, 0) == 2);
+    CHECK(get_count(tt, 1) == 0);
+}
+
+TEST_CASE("track table merge", "[track_table]")
+{
+    const unsigned threads = 4;
+    const unsigned events = 10000;
+    const unsigned sync = 16;
+
+    TrackShare share(sizeof(TestKey), sizeof(TestNode), 1024 * 1024, sync);
+    std::vector<std::thread> workers;
+    std::atomic<unsigned> ready(0);
+    unsigned counts[threads];
+
+    CHECK(!share.is_exact());
+
+    for ( unsigned t = 0; t < threads; t++ )
+    {
+        workers.push_back(std::thread([&share, &ready, &counts, t]()
+        {
+            TrackTable tt(sizeof(TestKey), sizeof(TestNode), 1024 * 1024);
+            tt.set_share(&share);
+
+            // a thread only picks up changes made after its first event
+            count_event(tt, make_key(7));
+            ++ready;
+
+            while ( ready < threads )
+                std::this_thread::yield();
+
+            for ( unsigned i = 1; i < events; i++ )
+                count_event(tt, make_key(7));
+
+            counts[t] = get_count(tt, 7);
+        }));
+    }
+
+    for ( auto& w : workers )
+        w.join();
+
+    // each thread counts its own events plus most of the others'
+    unsigned max = 0;
+
+    for ( unsigned t = 0; t < threads; t++ )
+    {
+        CHECK(counts[t] >= events);
+        CHECK(counts[t] <= threads * events);
+
+        if ( counts[t] > max )
+            max = counts[t];
+    }
+    // the last thread to merge has seen all but the unmerged events
+    // and the first events of the others
+    CHECK(max + (threads - 1) * (sync + 1) >= threads * events);
+}
+
+TEST_CASE("track table exact share", "[track_table]")
+{
+    const unsigned threads = 4;
+    const unsigned events = 10000;
+
+    TrackShare share(sizeof(TestKey), sizeof(TestNode), 1024 * 1024, 1);
+    std::vector<std::thread> workers;
+
+    CHECK(share.is_exact());
+
+    for ( unsigned t = 0; t < threads; t++ )
+    {
+        workers.push_back(std::thread([&share]()
+        {
+            // the share keeps every node so the thread needs no room
+            TrackTable tt(sizeof(TestKey), sizeof(TestNode), 0);
+            tt.set_share(&share);
+
+            for ( unsigned i = 0; i < events; i++ )
+                count_event(tt, make_key(7));
+        }));
+    }
+
+    for ( auto& w : workers )
+        w.join();
+
+    // every event from every thread is in the one shared node
+    TrackTable tt(sizeof(TestKey), sizeof(TestNode), 0);
+    tt.set_share(&share);
+
+    CHECK(get_count(tt, 7) == threads * events);
+    CHECK(get_count(tt, 8) == 0);
+}
+
+//---------------------------------------------------------------
+// benchmarks
+
+static double rate(std::chrono::steady_clock::time_point start, unsigned n)
+{
+    auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    return usecs ? (double)n / usecs : 0.0;
+}
+
+TEST_CASE("track table perf", "[.][track_table]")
+{
+    const unsigned keys = 4096;
+    const unsigned lookups = 4000000;
+
+    std::vector<TestKey> ks;
+    for ( unsigned i = 0; i < keys; i++ )
+        ks.push_back(make_key(i * 2654435761u));
+
+    {
+        SFXHASH* xh = sfxhash_new(keys, sizeof(TestKey), sizeof(TestNode),
+            1024 * 1024, 1, 0, 0, 1);
+        TestNode data = { };
+        auto start = std::chrono::steady_clock::now();
+
+        for ( unsigned i = 0; i < lookups; i++ )
+        {
+            const TestKey& key = ks[(i * 7919) % keys];
+            if ( sfxhash_add(xh, (void*)&key, &data) == SFXHASH_INTABLE )
+                ((TestNode*)xh->cnode->data)->count++;
+        }
+        printf("sfxhash: %.1f M events/s\n", rate(start, lookups));
+        sfxhash_delete(xh);
+    }
+    {
+        TrackTable tt(sizeof(TestKey), sizeof(TestNode), 1024 * 1024);
+        auto start = std::chrono::steady_clock::now();
+
+        for ( unsigned i = 0; i < lookups; i++ )
+            count_event(tt, ks[(i * 7919) % keys]);
+
+        printf("track table: %.1f M events/s\n", rate(start, lookups));
+    }
+
+    const unsigned threads = 4;
+
+    for ( unsigned sync : { 0, 1, 16, 256 } )
+    {
+        TrackShare share(sizeof(TestKey), sizeof(TestNode), 1024 * 1024, sync);
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+
+        for ( unsigned t = 0; t < threads; t++ )
+        {
+            workers.push_back(std::thread([&share, &ks, t]()
+            {
+                TrackTable tt(sizeof(TestKey), sizeof(TestNode), 1024 * 1024);
+                tt.set_share(&share);
+
+                for ( unsigned i = 0; i < lookups / threads; i++ )
+                    count_event(tt, ks[(i * 7919 + t) % keys]);
+            }));
+        }
+        for ( auto& w : workers )
+            w.join();
+
+        printf("%u threads, sync %u: %.1f M events/s\n", threads, sync, rate(start, lookups));
+    }
+}
+
@@ -320,6 +320,11 @@ public:  // FIXIT-M privatize if possible
     Inspector* data;
     const char* service;
 
+    // cached by the inspector manager to select the flow's dispatch lists
+    const char* inspection_service;
+    unsigned inspection_gen;
+    unsigned inspection_index;
+
     uint64_t expire_time;
 
     sfip_t client_ip; // FIXIT-L family and bits should be changed to uint16_t
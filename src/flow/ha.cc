@@ -34,7 +34,7 @@
 #include "stream/stream.h"
 #include "time/packet_time.h"
 
-static const uint8_t HA_MESSAGE_VERSION = 3;
+static const uint8_t HA_MESSAGE_VERSION = 4;
 
 // define message size and content constants.
 static const uint8_t KEY_SIZE_IP6 = sizeof(FlowKey);
@@ -43,6 +43,20 @@ static const uint8_t KEY_SIZE_IP4 = sizeof(FlowKey)-24;
 
 static const suseconds_t USEC_PER_SEC = 1000000;
 
+// client segments carrying a delta against the last synced content rather
+// than the full content have this bit set in the client index byte
+static const uint8_t DELTA_SEGMENT = 0x80;
+
+// full client content is sent on every Nth update of a flow so a standby
+// that missed an update converges again
+static const uint8_t FULL_SYNC_PERIOD = 16;
+
+// records are batched until the batch reaches this size, a critical update
+// is queued, the oldest record has waited this long in packet time, or the
+// packet thread goes idle
+static const uint32_t BATCH_SIZE = 1400;
+static const suseconds_t BATCH_USEC = 1000;
+
 enum
 {
     KEY_TYPE_IP6 = 1,
@@ -51,7 +65,7 @@ enum
 
 typedef std::array<FlowHAClient*, MAX_CLIENTS> ClientMap;
 
-THREAD_LOCAL SimpleStats ha_stats;
+THREAD_LOCAL HAStats ha_stats;
 THREAD_LOCAL ProfileStats ha_perf_stats;
 
 static THREAD_LOCAL HighAvailability* ha;
@@ -156,6 +170,60 @@ void FlowHAState::reset()
 {
     state = INITIAL_STATE;
     pending = NONE_PENDING;
+    syncs = 0;
+    sync_batch = 0;
+    sync_images.clear();
+}
+
+uint8_t* FlowHAState::get_sync_image(uint8_t client, uint8_t& length)
+{
+    size_t i = 0;
+
+    while ( i + 2 <= sync_images.size() )
+    {
+        if ( sync_images[i] == client )
+        {
+            length = sync_images[i+1];
+            return sync_images.data() + i + 2;
+        }
+        i += 2 + sync_images[i+1];
+    }
+    return nullptr;
+}
+
+void FlowHAState::set_sync_image(uint8_t client, const uint8_t* data, uint8_t length)
+{
+    uint8_t old_length;
+    uint8_t* old = get_sync_image(client, old_length);
+
+    if ( old && (old_length == length) )
+    {
+        memmove(old, data, length);
+        return;
+    }
+
+    if ( old )
+    {
+        auto start = sync_images.begin() + (old - sync_images.data()) - 2;
+        sync_images.erase(start, start + 2 + old_length);
+    }
+
+    sync_images.push_back(client);
+    sync_images.push_back(length);
+    sync_images.insert(sync_images.end(), data, data + length);
+}
+
+// true on the first update of a flow and every FULL_SYNC_PERIOD after that,
+// or if the batch with the last update, and so the delta base, was dropped
+bool FlowHAState::full_sync_due(uint64_t batch, uint64_t dropped)
+{
+    bool due = (syncs == 0) || (sync_batch <= dropped);
+    sync_batch = batch;
+
+    if ( ++syncs == FULL_SYNC_PERIOD )
+        syncs = 0;
+
+    return due;
 }
 
 FlowHAClient::FlowHAClient(uint8_t length, bool session_client)
@@ -204,6 +272,99 @@ bool FlowHAClient::place(HAMessage* msg, uint8_t* data, uint8_t length)
         return false;
 }
 
+static inline void put_varint(uint8_t*& p, uint32_t v)
+{
+    while ( v >= 0x80 )
+    {
+        *p++ = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+}
+
+static inline bool get_varint(uint8_t*& p, const uint8_t* end, uint32_t& v)
+{
+    v = 0;
+
+    for ( unsigned shift = 0; (p < end) && (shift < 32); shift += 7 )
+    {
+        uint8_t b = *p++;
+        v |= (uint32_t)(b & 0x7f) << shift;
+
+        if ( !(b & 0x80) )
+            return true;
+    }
+    return false;
+}
+
+// Encode cur as a list of { skip, length, bytes } patches against base.
+// Changed runs separated by only a couple of equal bytes are merged since
+// a new patch header would cost more than the bytes skipped.  Returns
+// false if the delta is no smaller than the content itself.  out must
+// have room for 2*len+8 bytes.
+static bool encode_delta(
+    const uint8_t* base, const uint8_t* cur, unsigned len, uint8_t* out, unsigned& out_len)
+{
+    uint8_t* p = out;
+    unsigned last = 0;
+    unsigned i = 0;
+
+    while ( i < len )
+    {
+        if ( base[i] == cur[i] )
+        {
+            i++;
+            continue;
+        }
+
+        unsigned end = i + 1;
+
+        for ( unsigned j = end; j < len; j++ )
+        {
+            if ( base[j] != cur[j] )
+                end = j + 1;
+
+            else if ( j - end >= 2 )
+                break;
+        }
+
+        put_varint(p, i - last);
+        put_varint(p, end - i);
+        memcpy(p, cur + i, end - i);
+        p += end - i;
+
+        if ( (unsigned)(p - out) >= len )
+            return false;
+
+        last = i = end;
+    }
+
+    out_len = p - out;
+    return true;
+}
+
+static bool apply_delta(uint8_t* in, const uint8_t* end, uint8_t* image, unsigned len)
+{
+    unsigned pos = 0;
+
+    while ( in < end )
+    {
+        uint32_t skip, run;
+
+        if ( !get_varint(in, end, skip) || !get_varint(in, end, run) )
+            return false;
+
+        if ( (skip > len - pos) || (run > len - pos - skip) || (run > (unsigned)(end - in)) )
+            return false;
+
+        pos += skip;
+        memcpy(image + pos, in, run);
+        in += run;
+        pos += run;
+    }
+    return true;
+}
+
 // Write the key type, key length, and key into the message.
 // Does not use the message cursor coming in.
 // Leave the message cursor just after the key. Return
@@ -215,7 +376,9 @@ static uint8_t write_flow_key(Flow* flow, HAMessage* msg)
     const FlowKey* key = flow->key;
     assert(key);
 
+#ifdef COMPRESSED_KEY
     if (is_ip6_key(flow->key) )
+#endif
     {
         hdr->key_type = KEY_TYPE_IP6;
         memcpy(msg->cursor, key, KEY_SIZE_IP6);
@@ -281,7 +444,26 @@ static uint8_t read_flow_key(FlowKey* key, HAMessage* msg)
 static inline uint8_t key_size(Flow* flow)
 {
     assert(flow->key);
+#ifdef COMPRESSED_KEY
     return is_ip6_key(flow->key) ? KEY_SIZE_IP6 : KEY_SIZE_IP4;
+#else
+    UNUSED(flow);
+    return KEY_SIZE_IP6;
+#endif
+}
+
+// Total length of the record starting with hdr or 0 if the key type is unknown.
+static inline uint32_t record_length(const HAMessageHeader* hdr)
+{
+    uint32_t length = sizeof(HAMessageHeader) + hdr->total_length;
+
+    if ( hdr->key_type == KEY_TYPE_IP6 )
+        return length + KEY_SIZE_IP6;
+#ifdef COMPRESSED_KEY
+    if ( hdr->key_type == KEY_TYPE_IP4 )
+        return length + KEY_SIZE_IP4;
+#endif
+    return 0;
 }
 
 static uint16_t calculate_msg_header_length(Flow* flow)
@@ -289,7 +471,7 @@ static uint16_t calculate_msg_header_length(Flow* flow)
     return sizeof(HAMessageHeader) + key_size(flow);
 }
 
-// Calculate the UPDATE message content length based on the
+// Calculate the maximum UPDATE message content length based on the
 // set of active clients.  The Session client is always present.
 static uint16_t calculate_update_msg_content_length(Flow* flow)
 {
@@ -321,22 +503,60 @@ static void write_msg_header(Flow* flow, HAEvent event, uint16_t content_length,
     write_flow_key(flow, msg);  // set cursor to just beyond key
 }
 
-static void write_update_msg_client( FlowHAClient* client, Flow* flow, HAMessage* msg)
+// Each client segment is the client index, a varint length, and either
+// the full client content or a delta against the content last synced.
+static void write_update_msg_client(FlowHAClient* client, Flow* flow, HAMessage* msg, bool full)
 {
     assert(client);
     assert(msg);
 
-    client->place(msg,(uint8_t*)&(client->header),(uint8_t)sizeof(client->header));
-    client->produce(flow, msg);
+    uint8_t image[UINT8_MAX];
+    SCMessage image_sc_msg = { };
+    image_sc_msg.content = image;
+    image_sc_msg.content_length = sizeof(image);
+    HAMessage image_msg(&image_sc_msg);
+    image_msg.cursor = image;
+
+    if ( !client->produce(flow, &image_msg) )
+        return;
+
+    const unsigned length = image_msg.cursor - image;
+
+    // the record was sized using the declared client message size
+    if ( length > client->get_message_size() )
+        return;
+
+    uint8_t base_length;
+    uint8_t* base = flow->ha_state->get_sync_image(client->header.client, base_length);
+    uint8_t delta[2*UINT8_MAX + 8];
+    unsigned delta_length;
+
+    if ( !full && base && (base_length == length) &&
+        encode_delta(base, image, length, delta, delta_length) )
+    {
+        *msg->cursor++ = client->header.client | DELTA_SEGMENT;
+        put_varint(msg->cursor, delta_length);
+        memcpy(msg->cursor, delta, delta_length);
+        msg->cursor += delta_length;
+    }
+    else
+    {
+        *msg->cursor++ = client->header.client;
+        put_varint(msg->cursor, length);
+        memcpy(msg->cursor, image, length);
+        msg->cursor += length;
+    }
+
+    flow->ha_state->set_sync_image(client->header.client, image, (uint8_t)length);
 }
 
-static void write_update_msg_content(Flow* flow, HAMessage* msg)
+static void write_update_msg_content(Flow* flow, HAMessage* msg, bool full)
 {
     assert(s_client_map);
 
     for ( int i=0; i<s_handle_counter; i++ )
         if ( (i==SESSION_HA_CLIENT_INDEX) || flow->ha_state->check_pending(1<<(i-1)) )
-            write_update_msg_client((*s_client_map)[i],flow, msg);
+            write_update_msg_client((*s_client_map)[i], flow, msg, full);
 }
 
 static void consume_receive_delete_message(HAMessage* msg)
@@ -355,44 +575,79 @@ static void consume_receive_update_message(HAMessage* msg)
 
     assert(s_client_map);
 
-    // pointer to the last byte in the message
-    uint8_t* content_end = msg->content() + msg->content_length() - 1;
+    const uint8_t* content_end = msg->content() + msg->content_length();
 
-    while( msg->cursor <= content_end )
+    while( msg->cursor < content_end )
     {
-        // do we have sufficient message left to be able to have an HAClientHeader?
-        if ( (int)(content_end - msg->cursor + 1) < (int)sizeof( HAClientHeader ) )
+        const uint8_t index = *msg->cursor & ~DELTA_SEGMENT;
+        const bool is_delta = (*msg->cursor & DELTA_SEGMENT) != 0;
+        uint32_t length;
+
+        msg->cursor++;
+
+        if ( !get_varint(msg->cursor, content_end, length) ||
+            ((uint32_t)(content_end - msg->cursor) < length) )
         {
-            ErrorMessage("Consuming HA Update message - no HAClientHeader\n");
+            ErrorMessage("Consuming HA Update message - message too short\n");
             break;
         }
 
-        HAClientHeader* header = (HAClientHeader*)msg->cursor;
-        msg->cursor += sizeof( HAClientHeader ); // step to the client content
-
-        if ( (header->client >= s_handle_counter) ||
-            ((*s_client_map)[header->client] == nullptr)  )
+        if ( (index >= s_handle_counter) || ((*s_client_map)[index] == nullptr) )
         {
             ErrorMessage("Consuming HA Update message - invalid client index\n");
             break;
         }
 
-        if ( (content_end - msg->cursor + 1) < header->length )
+        uint8_t image[UINT8_MAX];
+        uint8_t* content = msg->cursor;
+        uint8_t content_length = (uint8_t)length;
+
+        if ( is_delta )
+        {
+            uint8_t* base = flow ? flow->ha_state->get_sync_image(index, content_length) : nullptr;
+
+            if ( !base )
+            {
+                ErrorMessage("Consuming HA Update message - delta without prior update\n");
+                break;
+            }
+
+            memcpy(image, base, content_length);
+
+            if ( !apply_delta(msg->cursor, msg->cursor + length, image, content_length) )
+            {
+                ErrorMessage("Consuming HA Update message - invalid delta\n");
+                break;
+            }
+            content = image;
+        }
+        else if ( length > UINT8_MAX )
         {
-            ErrorMessage("Consuming HA Update memssage - message too short\n");
+            ErrorMessage("Consuming HA Update message - client content too long\n");
             break;
         }
 
+        msg->cursor += length;
+
+        SCMessage client_sc_msg = { };
+        client_sc_msg.content = content;
+        client_sc_msg.content_length = content_length;
+        HAMessage client_msg(&client_sc_msg);
+        client_msg.cursor = content;
+
         // If the Flow does not exist in the caches, flow will be nullptr
         // upon entry into this message processing loop.  Since the session
         // client is always the first segment of the message, the consume()
         // invocation for the session client will create the flow.  This
         // flow can in turn be used by subsequent FlowHAClient's.
-        if ( !(*s_client_map)[header->client]->consume(flow,&key,msg) )
+        if ( !(*s_client_map)[index]->consume(flow,&key,&client_msg) )
         {
             ErrorMessage("Consuming HA Update message - error from client consume()\n");
             break;
         }
+
+        if ( flow )
+            flow->ha_state->set_sync_image(index, content, content_length);
     }
 }
 
@@ -401,7 +656,10 @@ static void consume_receive_message(HAMessage* msg)
     HAMessageHeader* hdr = (HAMessageHeader*)msg->content();
 
     if ( hdr->version != HA_MESSAGE_VERSION)
+    {
+        ha_stats.unknown_version++;
         return;
+    }
 
     switch ( hdr->event )
     {
@@ -452,6 +710,8 @@ HighAvailability::HighAvailability(PortBitSet* ports, bool)
     for ( int i=0; i<MAX_CLIENTS; i++ )
         (*s_client_map)[i] = nullptr;
 
+    batch.reserve(BATCH_SIZE);
+
     // Only looking for side channel processing - FIXIT-H
 }
 
@@ -461,6 +721,7 @@ HighAvailability::~HighAvailability()
 
     if ( sc )
     {
+        flush();
         sc->unregister_receive_handler();
     }
 
@@ -477,12 +738,102 @@ void HighAvailability::receive_handler(SCMessage* sc_msg)
     // SC received messages must have reference back to SideChannel object
     assert(sc_msg->sc);
 
-    HAMessage ha_msg(sc_msg);
-    consume_receive_message(&ha_msg);
+    // each message carries one or more flow records back to back
+    uint8_t* record = sc_msg->content;
+    const uint8_t* end = sc_msg->content + sc_msg->content_length;
+
+    while ( (unsigned)(end - record) >= sizeof(HAMessageHeader) )
+    {
+        const HAMessageHeader* hdr = (HAMessageHeader*)record;
+
+        // the record length can't be trusted so the rest is discarded
+        if ( hdr->version != HA_MESSAGE_VERSION )
+        {
+            ha_stats.unknown_version++;
+            break;
+        }
+
+        const uint32_t length = record_length(hdr);
+
+        if ( !length || (length > (uint32_t)(end - record)) )
+        {
+            ErrorMessage("Consuming HA message - truncated record\n");
+            break;
+        }
+
+        SCMessage record_sc_msg = *sc_msg;
+        record_sc_msg.content = record;
+        record_sc_msg.content_length = length;
+
+        HAMessage ha_msg(&record_sc_msg);
+        consume_receive_message(&ha_msg);
+        record += length;
+    }
 
     sc_msg->sc->discard_message(sc_msg);
 }
 
+// Return space for a record of at most length bytes at the end of the
+// batch, transmitting the batch first if the record would overflow it.
+uint8_t* HighAvailability::reserve(uint32_t length)
+{
+    if ( !batch.empty() && (batch.size() + length > BATCH_SIZE) )
+        flush();
+
+    if ( batch.empty() )
+        packet_gettimeofday(&batch_start);
+
+    size_t offset = batch.size();
+    batch.resize(offset + length);
+    return batch.data() + offset;
+}
+
+// Trim the last reserved record to what was actually written.
+void HighAvailability::commit(const uint8_t* end)
+{
+    batch.resize(end - batch.data());
+}
+
+bool HighAvailability::batch_expired()
+{
+    if ( batch.empty() )
+        return false;
+
+    struct timeval now;
+    packet_gettimeofday(&now);
+
+    int64_t age = (int64_t)(now.tv_sec - batch_start.tv_sec) * USEC_PER_SEC +
+        (now.tv_usec - batch_start.tv_usec);
+
+    return age >= BATCH_USEC;
+}
+
+void HighAvailability::flush()
+{
+    if ( !sc )
+        return;
+
+    if ( !batch.empty() )
+    {
+        SCMessage* sc_msg = sc->alloc_transmit_message((uint32_t)batch.size());
+
+        if ( sc_msg )
+            memcpy(sc_msg->content, batch.data(), batch.size());
+
+        // the flows in a dropped batch send full content next time since
+        // the standby never saw the images their deltas would be against
+        if ( !sc_msg || !sc->transmit_message(sc_msg) )
+        {
+            last_dropped = batch_seq;
+            ha_stats.dropped_batches++;
+        }
+        batch_seq++;
+        batch.clear();
+    }
+
+    sc->flush();
+}
+
 void HighAvailability::process_update(Flow* flow, const DAQ_PktHdr_t* pkthdr)
 {
     DebugMessage(DEBUG_HA,"HighAvailability::process_update()\n");
@@ -496,26 +847,39 @@ void HighAvailability::process_update(Flow* flow, const DAQ_PktHdr_t* pkthdr)
     assert(s_client_map);
     assert((*s_client_map)[0]);
 
+    // Updates pending only from the optional clients are coalesced
+    // until the sync interval has elapsed.
     if ( !(*s_client_map)[0]->is_update_required(flow) &&
         ( !flow->ha_state->check_pending(ALL_CLIENTS) ||
-            flow->ha_state->check_any(FlowHAState::NEW) ) )
+            flow->ha_state->check_any(FlowHAState::NEW) ||
+            !( flow->ha_state->sync_interval_elapsed() ||
+                flow->ha_state->check_any(FlowHAState::CRITICAL) ) ) )
         return;
 
-    const uint16_t header_len = calculate_msg_header_length(flow);
-    const uint16_t content_len = calculate_update_msg_content_length(flow);
+    const bool critical = flow->ha_state->check_any(FlowHAState::CRITICAL);
+    const uint32_t header_len = calculate_msg_header_length(flow);
+    // one extra byte per client allows for a two byte varint length
+    const uint32_t content_len = calculate_update_msg_content_length(flow) + s_handle_counter;
 
-    SCMessage* sc_msg = sc->alloc_transmit_message((uint32_t)(header_len+content_len));
-    assert(sc_msg);
-    HAMessage ha_msg(sc_msg);
+    SCMessage record_sc_msg = { };
+    record_sc_msg.content = reserve(header_len + content_len);
+    record_sc_msg.content_length = header_len + content_len;
+    HAMessage ha_msg(&record_sc_msg);
 
-    write_msg_header(flow, HA_UPDATE_EVENT, content_len, &ha_msg);
-    write_update_msg_content(flow, &ha_msg);
-    sc->transmit_message(sc_msg);
+    write_msg_header(flow, HA_UPDATE_EVENT, 0, &ha_msg);
+    uint8_t* content = ha_msg.cursor;
+    write_update_msg_content(flow, &ha_msg,
+        flow->ha_state->full_sync_due(batch_seq, last_dropped));
+    ((HAMessageHeader*)ha_msg.content())->total_length = (uint16_t)(ha_msg.cursor - content);
+    commit(ha_msg.cursor);
 
     flow->ha_state->clear(FlowHAState::NEW | FlowHAState::MODIFIED |
         FlowHAState::MAJOR | FlowHAState::CRITICAL);
     flow->ha_state->clear_pending(ALL_CLIENTS);
     flow->ha_state->set_next_update();
+
+    if ( critical )
+        flush();
 }
 
 void HighAvailability::process_deletion(Flow* flow)
@@ -534,13 +898,14 @@ void HighAvailability::process_deletion(Flow* flow)
         return;
 
     const uint32_t msg_len = calculate_msg_header_length(flow);
-    SCMessage* sc_msg = sc->alloc_transmit_message(msg_len);
-    HAMessage ha_msg(sc_msg);
+    SCMessage record_sc_msg = { };
+    record_sc_msg.content = reserve(msg_len);
+    record_sc_msg.content_length = msg_len;
+    HAMessage ha_msg(&record_sc_msg);
 
     // No content, only header+key
     write_msg_header(flow, HA_DELETE_EVENT, 0, &ha_msg);
-
-    sc->transmit_message(sc_msg);
+    commit(ha_msg.cursor);
 
     flow->ha_state->add(FlowHAState::DELETED);
 }
@@ -548,7 +913,12 @@ void HighAvailability::process_deletion(Flow* flow)
 void HighAvailability::process_receive()
 {
     if ( sc != nullptr )
+    {
+        if ( batch_expired() )
+            flush();
+
         sc->process(DISPATCH_ALL_RECEIVE);
+    }
 }
 
 // Called by the configuration parsing activity in the main thread.
@@ -621,6 +991,12 @@ void HighAvailabilityManager::process_receive()
         ha->process_receive();
 }
 
+void HighAvailabilityManager::flush()
+{
+    if ( ha != nullptr )
+        ha->flush();
+}
+
 // Called in the packet threads to determine whether or not HA is active
 bool HighAvailabilityManager::active()
 {
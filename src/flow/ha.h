@@ -20,7 +20,10 @@
 #ifndef HA_H
 #define HA_H
 
+#include <vector>
+
 #include "flow/flow_key.h"
+#include "framework/counts.h"
 #include "main/snort_types.h"
 #include "packet_io/sfdaq.h"
 #include "side_channel/side_channel.h"
@@ -76,6 +79,11 @@ public:
     void set_next_update();
     void reset();
 
+    // the last content synced for each client, used as the delta base
+    uint8_t* get_sync_image(uint8_t client, uint8_t& length);
+    void set_sync_image(uint8_t client, const uint8_t* data, uint8_t length);
+    bool full_sync_due(uint64_t batch, uint64_t dropped);
+
 private:
     static const uint8_t INITIAL_STATE = 0x00;
     static const uint16_t NONE_PENDING = 0x0000;
@@ -84,7 +92,10 @@ private:
     static struct timeval min_sync_interval;
     uint8_t state;
     uint16_t pending;
+    uint8_t syncs = 0;
+    uint64_t sync_batch = 0;  // the batch carrying the last update
     struct timeval next_update;
+    std::vector<uint8_t> sync_images;  // { client, length, content } ...
 };
 
 struct __attribute__((__packed__)) HAMessageHeader
@@ -142,6 +153,12 @@ protected:
 // HighAvailability is instantiated for each packet-thread.
 // FIXIT-M make the SideChannel the THREAD_LOCAL element and collapse
 //  into HighAvailabilityManager
+struct HAStats
+{
+    PegCount dropped_batches;
+    PegCount unknown_version;
+};
+
 class HighAvailability
 {
 public:
@@ -151,10 +168,19 @@ public:
     void process_update(Flow*, const DAQ_PktHdr_t*);
     void process_deletion(Flow*);
     void process_receive();
+    void flush();
 
 private:
     void receive_handler(SCMessage*);
+    uint8_t* reserve(uint32_t length);
+    void commit(const uint8_t* end);
+    bool batch_expired();
+
     SideChannel* sc = nullptr;
+    std::vector<uint8_t> batch;  // records queued for the next transmit
+    struct timeval batch_start;
+    uint64_t batch_seq = 1;      // the batch being filled
+    uint64_t last_dropped = 0;   // the last batch that wasn't transmitted
 };
 
 // Top level management of HighAvailability components.
@@ -181,6 +207,10 @@ public:
 
     // Look for and dispatch receive messages.
     static void process_receive();
+
+    // Transmit any batched update and deletion records now; the batch
+    // age is packet time so this is also called when the thread is idle
+    static void flush();
     static void set_modified(Flow*);
     static bool in_standby(Flow*);
 
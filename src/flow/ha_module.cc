@@ -29,10 +29,12 @@
 
 static const PegInfo ha_pegs[] =
 {
+    { "dropped batches", "update batches not transmitted; their flows are fully synced next" },
+    { "unknown version", "received messages discarded for an unsupported version" },
     { nullptr, nullptr }
 };
 
-extern THREAD_LOCAL SimpleStats ha_stats;
+extern THREAD_LOCAL HAStats ha_stats;
 extern THREAD_LOCAL ProfileStats ha_perf_stats;
 
 //-------------------------------------------------------------------------
@@ -36,7 +36,9 @@ struct HighAvailabilityConfig
     struct timeval min_sync_interval;
 };
 
-extern THREAD_LOCAL SimpleStats ha_stats;
+struct HAStats;
+
+extern THREAD_LOCAL HAStats ha_stats;
 extern THREAD_LOCAL ProfileStats ha_perf_stats;
 
 class HighAvailabilityModule : public Module
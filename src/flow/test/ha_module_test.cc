@@ -31,7 +31,7 @@
 
 void LogMessage(const char*,...) { }
 
-THREAD_LOCAL SimpleStats ha_stats;
+THREAD_LOCAL HAStats ha_stats;
 THREAD_LOCAL ProfileStats ha_perf_stats;
 
 void show_stats(PegCount*, const PegInfo*, unsigned, const char*) { }
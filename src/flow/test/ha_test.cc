@@ -23,12 +23,15 @@
 
 #include "flow/flow.h"
 #include "main/snort_debug.h"
+#include "main/thread.h"
 #include "stream/stream.h"
 
+#include <chrono>
+
 #include <CppUTest/CommandLineTestRunner.h>
 #include <CppUTest/TestHarness.h>
 
-#define MSG_SIZE 100
+#define MSG_SIZE 2048
 #define TEST_KEY 0,1,2,3,4,5,6,7,8,9,10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,26,27,28,29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47
 
 class StreamHAClient;
@@ -41,7 +44,7 @@ TEST_KEY
 static const uint8_t s_delete_message[] =
 {
     0x01,
-    0x03,
+    0x04,
     0x00,
     0x00,
     0x01,
@@ -51,8 +54,8 @@ TEST_KEY
 static const uint8_t s_update_stream_message[] =
 {
     0x02,
-    0x03,
-    0x00,
+    0x04,
+    0x0c,
     0x00,
     0x01,
 TEST_KEY,
@@ -62,6 +65,18 @@ TEST_KEY,
 };
 
 
+static const uint8_t s_unknown_version_message[] =
+{
+    0x01,
+    0x05,
+    0x00,
+    0x00,
+    0x01,
+TEST_KEY
+};
+
+extern THREAD_LOCAL HAStats ha_stats;
+
 static struct timeval s_packet_time = { 0, 0 };
 static uint8_t s_message[MSG_SIZE];
 static SideChannel s_side_channel;
@@ -72,10 +87,15 @@ static bool s_other_consume_called = false;
 static bool s_get_session_called = false;
 static bool s_delete_session_called = false;
 static bool s_transmit_message_called = false;
+static bool s_alloc_fails = false;
 static bool s_stream_update_required = false;
 static bool s_other_update_required = false;
 static uint8_t* s_message_content = nullptr;
-static uint8_t s_message_length = 0;
+static uint32_t s_message_length = 0;
+static unsigned s_transmit_count = 0;
+static uint64_t s_transmit_bytes = 0;
+static uint8_t s_produce_round = 0;
+static uint8_t s_consumed[10];
 static Flow s_flow;
 static FlowKey s_flowkey;
 static DAQ_PktHdr_t s_pkthdr;
@@ -89,15 +109,17 @@ class StreamHAClient : public FlowHAClient
 public:
     StreamHAClient() : FlowHAClient(10, true) { }
     ~StreamHAClient() { }
-    bool consume(Flow*&, FlowKey*, HAMessage*)
+    bool consume(Flow*&, FlowKey*, HAMessage* msg)
     {
         s_stream_consume_called = true;
+        memcpy(s_consumed, msg->cursor, sizeof(s_consumed));
         return true;
     }
     bool produce(Flow*, HAMessage* msg)
     {
-        for ( uint8_t i=0; i<10; i++ )
+        for ( uint8_t i=0; i<9; i++ )
             *(msg->cursor)++ = i;
+        *(msg->cursor)++ = 9 + s_produce_round;
         return true;
     }
     uint8_t get_message_size() { return 10; }
@@ -200,11 +222,15 @@ bool SideChannel::transmit_message(SCMessage* msg)
     s_transmit_message_called = true;
     s_message_content = msg->content;
     s_message_length = msg->content_length;
+    s_transmit_count++;
+    s_transmit_bytes += msg->content_length;
     return true; }
 
+bool SideChannel::flush() { return true; }
+
 SCMessage* SideChannel::alloc_transmit_message(uint32_t len)
 {
-    if ( len > MSG_SIZE )
+    if ( s_alloc_fails || len > MSG_SIZE )
         return nullptr;
 
     s_sc_message.content = s_message;
@@ -358,10 +384,22 @@ TEST(high_availability_test, receive_update_stream_only)
     CHECK(memcmp((const void*)&s_flowkey, (const void*)&s_test_key, sizeof(s_test_key)) == 0);
 }
 
+TEST(high_availability_test, receive_unknown_version)
+{
+    PegCount before = ha_stats.unknown_version;
+    s_delete_session_called = false;
+    s_message_content = (uint8_t*)s_unknown_version_message;
+    s_message_length = sizeof(s_unknown_version_message);
+    HighAvailabilityManager::process_receive();
+    CHECK(s_delete_session_called == false);
+    CHECK(ha_stats.unknown_version == before + 1);
+}
+
 TEST(high_availability_test, transmit_deletion)
 {
     s_transmit_message_called = false;
     HighAvailabilityManager::process_deletion(&s_flow);
+    HighAvailabilityManager::flush();
     CHECK(s_transmit_message_called == true);
 }
 
@@ -371,6 +409,7 @@ TEST(high_availability_test, transmit_update_no_update)
     s_stream_update_required = false;
     s_other_update_required = false;
     HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+    HighAvailabilityManager::flush();
     CHECK(s_transmit_message_called == false);
 }
 
@@ -380,9 +419,160 @@ TEST(high_availability_test, transmit_update_stream_only)
     s_stream_update_required = true;
     s_other_update_required = false;
     HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+    HighAvailabilityManager::flush();
     CHECK(s_transmit_message_called == true);
 }
 
+TEST(high_availability_test, transmit_update_delta)
+{
+    const uint8_t standby_image[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    const unsigned record_start = sizeof(HAMessageHeader) + sizeof(s_test_key);
+
+    s_stream_update_required = true;
+    s_other_update_required = false;
+    s_flow.ha_state->reset();
+
+    s_produce_round = 0;
+    HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+    HighAvailabilityManager::flush();
+    CHECK(s_message_length == record_start + 2 + 10);
+    CHECK(s_message_content[record_start] == 0x00);
+
+    // only the last byte changed: { skip 9, length 1, byte }
+    s_produce_round = 1;
+    HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+    HighAvailabilityManager::flush();
+    CHECK(s_message_length == record_start + 2 + 3);
+    CHECK(s_message_content[record_start] == 0x80);
+    CHECK(s_message_content[record_start + 2] == 9);
+    CHECK(s_message_content[record_start + 3] == 1);
+    CHECK(s_message_content[record_start + 4] == 10);
+
+    // loop the delta back as if received by a standby holding the first update
+    s_flow.ha_state->set_sync_image(SESSION_HA_CLIENT_INDEX, standby_image, sizeof(standby_image));
+    s_stream_consume_called = false;
+    HighAvailabilityManager::process_receive();
+    CHECK(s_stream_consume_called == true);
+    CHECK(memcmp(s_consumed, standby_image, 9) == 0);
+    CHECK(s_consumed[9] == 10);
+    s_produce_round = 0;
+}
+
+TEST(high_availability_test, transmit_update_dropped)
+{
+    const unsigned record_start = sizeof(HAMessageHeader) + sizeof(s_test_key);
+    PegCount before = ha_stats.dropped_batches;
+
+    s_stream_update_required = true;
+    s_other_update_required = false;
+    s_flow.ha_state->reset();
+
+    s_produce_round = 0;
+    HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+    HighAvailabilityManager::flush();
+    CHECK(s_message_content[record_start] == 0x00);
+
+    // the delta against the first update is lost
+    s_transmit_count = 0;
+    s_alloc_fails = true;
+    s_produce_round = 1;
+    HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+    HighAvailabilityManager::flush();
+    s_alloc_fails = false;
+    CHECK(s_transmit_count == 0);
+    CHECK(ha_stats.dropped_batches == before + 1);
+
+    // so the next update can't be a delta against it
+    s_produce_round = 2;
+    HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+    HighAvailabilityManager::flush();
+    CHECK(s_transmit_count == 1);
+    CHECK(s_message_length == record_start + 2 + 10);
+    CHECK(s_message_content[record_start] == 0x00);
+
+    // after which deltas resume
+    s_produce_round = 3;
+    HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+    HighAvailabilityManager::flush();
+    CHECK(s_message_content[record_start] == 0x80);
+    s_produce_round = 0;
+}
+
+TEST(high_availability_test, transmit_update_batched)
+{
+    s_stream_update_required = true;
+    s_other_update_required = false;
+    s_transmit_count = 0;
+
+    for ( int i = 0; i < 3; i++ )
+        HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+
+    HighAvailabilityManager::process_deletion(&s_flow);
+    CHECK(s_transmit_count == 0);
+
+    HighAvailabilityManager::flush();
+    CHECK(s_transmit_count == 1);
+
+    // the batch goes out on its own once it has aged
+    HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+    HighAvailabilityManager::process_receive();
+    CHECK(s_transmit_count == 1);
+
+    s_packet_time.tv_sec += 1;
+    HighAvailabilityManager::process_receive();
+    CHECK(s_transmit_count == 2);
+}
+
+TEST(high_availability_test, transmit_update_throughput)
+{
+    const unsigned num_flows = 1000;
+    const unsigned num_rounds = 100;
+    const unsigned record_size = sizeof(HAMessageHeader) + sizeof(s_test_key) + 2 + 10;
+
+    Flow* flows = new Flow[num_flows];
+
+    for ( unsigned i = 0; i < num_flows; i++ )
+    {
+        FlowKey* key = (FlowKey*)flows[i].key;
+        memset(key, 0, sizeof(*key));
+        memcpy(key, &i, sizeof(i));
+    }
+
+    s_stream_update_required = true;
+    s_other_update_required = false;
+    s_transmit_count = 0;
+    s_transmit_bytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for ( unsigned r = 0; r < num_rounds; r++ )
+    {
+        s_produce_round = (uint8_t)r;
+
+        for ( unsigned i = 0; i < num_flows; i++ )
+            HighAvailabilityManager::process_update(&flows[i], &s_pkthdr);
+    }
+    HighAvailabilityManager::flush();
+
+    auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    const uint64_t updates = (uint64_t)num_flows * num_rounds;
+
+    // one message per update and full content each time was the old cost
+    CHECK(s_transmit_bytes < updates * record_size);
+    CHECK(s_transmit_count < updates / 10);
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "%u updates in %u messages, %u bytes, %.1f updates/usec",
+        (unsigned)updates, s_transmit_count, (unsigned)s_transmit_bytes,
+        usecs ? (double)updates / usecs : 0.0);
+    UT_PRINT(buf);
+
+    delete[] flows;
+    s_produce_round = 0;
+}
+
 TEST(high_availability_test, transmit_update_both_update)
 {
     s_transmit_message_called = false;
@@ -391,6 +581,7 @@ TEST(high_availability_test, transmit_update_both_update)
     CHECK(s_other_ha_client->handle == 1);
     s_flow.ha_state->set_pending(s_other_ha_client->handle);
     HighAvailabilityManager::process_update(&s_flow, &s_pkthdr);
+    HighAvailabilityManager::flush();
     CHECK(s_transmit_message_called == true);
 }
 
@@ -30,7 +30,7 @@
 #include "framework/base_api.h"
 
 // this is the current version of the api
-#define CONNECTOR_API_VERSION ((BASE_API_VERSION << 16) | 0)
+#define CONNECTOR_API_VERSION ((BASE_API_VERSION << 16) | 1)
 
 //-------------------------------------------------------------------------
 // api for class
@@ -67,6 +67,9 @@ public:
     virtual ConnectorMsgHandle* alloc_message(const uint32_t, const uint8_t**) = 0;
     virtual void discard_message(ConnectorMsgHandle*) = 0;
     virtual bool transmit_message(ConnectorMsgHandle*) = 0;
+
+    // send anything held back by transmit_message()
+    virtual bool flush() { return true; }
     virtual ConnectorMsgHandle* receive_message(bool block) = 0;
     virtual ConnectorMsg* get_connector_msg(ConnectorMsgHandle*) = 0;
     virtual Direction get_connector_direction() = 0;
@@ -18,8 +18,19 @@
 // data_bus.cc author Russ Combs <rucombs@cisco.com>
 
 #include "framework/data_bus.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 #include "main/policy.h"
 #include "protocols/packet.h"
+#include "pub_sub/http_events.h"
+#include "pub_sub/sip_events.h"
+
+#ifdef UNIT_TEST
+#include "catch/catch.hpp"
+#endif
 
 DataBus& get_data_bus()
 { return get_inspection_policy()->dbus; }
@@ -51,43 +62,188 @@ private:
     const Packet* packet;
 };
 
+//-------------------------------------------------------------------------
+// event ids
+//-------------------------------------------------------------------------
+
+// must be in DataEventId order
+static const char* const fixed_keys[DE_MAX] =
+{
+    PACKET_EVENT,
+    HTTP_REQUEST_HEADER_EVENT_KEY,
+    HTTP_RESPONSE_HEADER_EVENT_KEY,
+    SIP_EVENT_TYPE_SIP_DIALOG_KEY,
+    FILE_EVENT,
+};
+
+const unsigned DataBus::DE_NONE;
+
+static std::mutex id_mutex;
+static std::unordered_map<std::string, unsigned> id_map;
+
+static void init_ids()
+{
+    for ( unsigned id = 0; id < DE_MAX; ++id )
+        id_map[fixed_keys[id]] = id;
+}
+
+unsigned DataBus::get_id(const char* key)
+{
+    std::lock_guard<std::mutex> lock(id_mutex);
+
+    if ( id_map.empty() )
+        init_ids();
+
+    auto it = id_map.find(key);
+
+    if ( it != id_map.end() )
+        return it->second;
+
+    unsigned id = id_map.size();
+    id_map[key] = id;
+    return id;
+}
+
+unsigned DataBus::find_id(const char* key)
+{
+    std::lock_guard<std::mutex> lock(id_mutex);
+
+    if ( id_map.empty() )
+        init_ids();
+
+    auto it = id_map.find(key);
+    return it == id_map.end() ? DE_NONE : it->second;
+}
+
+//-------------------------------------------------------------------------
+// bus
+//-------------------------------------------------------------------------
+
 DataBus::DataBus() { }
 
 DataBus::~DataBus()
 {
-    for ( auto& p : map )
-        for ( auto* h : p.second )
+    for ( auto& v : lists )
+        for ( auto* h : v )
             delete h;
 }
 
 // add handler to list of handlers to be notified upon
 // publication of given event
+void DataBus::subscribe(unsigned id, DataHandler* h)
+{
+    if ( id >= lists.size() )
+        lists.resize(id + 1);
+
+    lists[id].push_back(h);
+}
+
 void DataBus::subscribe(const char* key, DataHandler* h)
 {
-    DataList& v = map[key];
-    v.push_back(h);
+    subscribe(get_id(key), h);
 }
 
 // notify subscribers of event
-void DataBus::publish(const char* key, DataEvent& e, Flow* f)
+void DataBus::notify(DataList& v, DataEvent& e, Flow* f)
 {
-    DataList& v = map[key];
-
     for ( auto* h : v )
         h->handle(e, f);
 }
 
-void DataBus::publish(const char* key, const uint8_t* buf, unsigned len, Flow* f)
+// a key nobody subscribed to can't have handlers so don't add it here
+void DataBus::publish(const char* key, DataEvent& e, Flow* f)
+{
+    publish(find_id(key), e, f);
+}
+
+void DataBus::publish(unsigned id, const uint8_t* buf, unsigned len, Flow* f)
 {
+    if ( !has_subscribers(id) )
+        return;
+
     BufferEvent e(buf, len);
-    publish(key, e, f);
+    notify(lists[id], e, f);
 }
 
-void DataBus::publish(const char* key, Packet* p, Flow* f)
+void DataBus::publish(unsigned id, Packet* p, Flow* f)
 {
+    if ( !has_subscribers(id) )
+        return;
+
     PacketEvent e(p);
     if ( !f )
         f = p->flow;
-    publish(key, e, f);
+    notify(lists[id], e, f);
+}
+
+void DataBus::publish(const char* key, const uint8_t* buf, unsigned len, Flow* f)
+{
+    publish(find_id(key), buf, len, f);
+}
+
+void DataBus::publish(const char* key, Packet* p, Flow* f)
+{
+    publish(find_id(key), p, f);
+}
+
+#ifdef UNIT_TEST
+
+class CountHandler : public DataHandler
+{
+public:
+    CountHandler(unsigned& n) : count(n) { }
+
+    void handle(DataEvent& e, Flow*) override
+    {
+        unsigned len;
+        e.get_data(len);
+        count += len;
+    }
+
+private:
+    unsigned& count;
+};
+
+TEST_CASE("DataBus ids", "[data_bus]")
+{
+    CHECK(DataBus::find_id(PACKET_EVENT) == DE_PACKET);
+    CHECK(DataBus::find_id("file_event") == DE_FILE);
+    CHECK(DataBus::find_id("data_bus.test.none") == DataBus::DE_NONE);
+
+    unsigned id = DataBus::get_id("data_bus.test.one");
+    CHECK(id >= DE_MAX);
+    CHECK(DataBus::get_id("data_bus.test.one") == id);
+    CHECK(DataBus::find_id("data_bus.test.one") == id);
+    CHECK(DataBus::get_id("data_bus.test.two") == id + 1);
+}
+
+TEST_CASE("DataBus publish", "[data_bus]")
+{
+    DataBus bus;
+    unsigned file = 0, custom = 0;
+
+    bus.subscribe(DE_FILE, new CountHandler(file));
+    bus.subscribe("data_bus.test.custom", new CountHandler(custom));
+
+    CHECK(bus.has_subscribers(DE_FILE));
+    CHECK(!bus.has_subscribers(DE_PACKET));
+    CHECK(!bus.has_subscribers(DataBus::DE_NONE));
+
+    const uint8_t buf[] = "abcd";
+    bus.publish(DE_FILE, buf, 4);
+    bus.publish("file_event", buf, 2);
+    CHECK(file == 6);
+
+    bus.publish(DataBus::get_id("data_bus.test.custom"), buf, 3);
+    bus.publish("data_bus.test.custom", buf, 1);
+    CHECK(custom == 4);
+
+    // no subscribers
+    bus.publish(DE_HTTP_REQUEST_HEADER, buf, 4);
+    bus.publish("data_bus.test.nobody", buf, 4);
+    CHECK(DataBus::find_id("data_bus.test.nobody") == DataBus::DE_NONE);
+    CHECK(file == 6);
+    CHECK(custom == 4);
 }
 
+#endif
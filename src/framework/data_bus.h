@@ -26,17 +26,31 @@
 // a publish-subscribe mechanism, it is possible to add custom processing
 // at arbitrary points, eg when service is identified, or when a URI is
 // available, or when a flow clears.
+//
+// Event keys are interned into small integer ids shared by all policies.
+// Each DataBus keeps a flat vector of handler lists indexed by id so
+// publishing by id is an index and, when nobody subscribed, nothing more.
+// The events published by Snort itself have fixed ids; any other key gets
+// the next free id the first time it is seen.  The string based methods
+// remain for plugins but cost an id lookup on each call.
 
-#include <map>
-#include <string>
 #include <vector>
 
-// FIXIT-P evaluate perf; focus is on correctness
 typedef std::vector<class DataHandler*> DataList;
-typedef std::map<std::string, DataList> DataMap;
 
 #include "main/snort_types.h"
 
+// fixed ids; the corresponding keys are registered in data_bus.cc
+enum DataEventId
+{
+    DE_PACKET,               // PACKET_EVENT
+    DE_HTTP_REQUEST_HEADER,  // HTTP_REQUEST_HEADER_EVENT_KEY
+    DE_HTTP_RESPONSE_HEADER, // HTTP_RESPONSE_HEADER_EVENT_KEY
+    DE_SIP_DIALOG,           // SIP_EVENT_TYPE_SIP_DIALOG_KEY
+    DE_FILE,                 // FILE_EVENT
+    DE_MAX
+};
+
 class Flow;
 struct Packet;
 
@@ -75,15 +89,39 @@ public:
     DataBus();
     ~DataBus();
 
+    // get the id for key, adding it if new; ids are never reused
+    static unsigned get_id(const char* key);
+
+    // get the id for key or DE_NONE if it was never added
+    static unsigned find_id(const char* key);
+
+    static const unsigned DE_NONE = ~0u;
+
+    void subscribe(unsigned id, DataHandler*);
     void subscribe(const char* key, DataHandler*);
+
+    bool has_subscribers(unsigned id) const
+    { return id < lists.size() and !lists[id].empty(); }
+
+    void publish(unsigned id, DataEvent& e, Flow* f = nullptr)
+    {
+        if ( has_subscribers(id) )
+            notify(lists[id], e, f);
+    }
+
     void publish(const char* key, DataEvent&, Flow* = nullptr);
 
     // convenience methods
+    void publish(unsigned id, const uint8_t*, unsigned, Flow* = nullptr);
+    void publish(unsigned id, Packet*, Flow* = nullptr);
+
     void publish(const char* key, const uint8_t*, unsigned, Flow* = nullptr);
     void publish(const char* key, Packet*, Flow* = nullptr);
 
 private:
-    DataMap map;
+    static void notify(DataList&, DataEvent&, Flow*);
+
+    std::vector<DataList> lists;
 };
 
 // FIXIT-L this should be in snort_confg.h or similar but that
@@ -92,6 +130,7 @@ SO_PUBLIC DataBus& get_data_bus();
 
 // common data events
 #define PACKET_EVENT "detection.packet"
+#define FILE_EVENT "file_event"
 
 #endif
 
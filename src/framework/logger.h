@@ -31,7 +31,7 @@
 struct Packet;
 
 // this is the current version of the api
-#define LOGAPI_VERSION ((BASE_API_VERSION << 16) | 0)
+#define LOGAPI_VERSION ((BASE_API_VERSION << 16) | 1)
 
 #define OUTPUT_TYPE_FLAG__NONE  0x0
 #define OUTPUT_TYPE_FLAG__ALERT 0x1
@@ -57,6 +57,10 @@ public:
     virtual void alert(Packet*, const char*, Event*) { }
     virtual void log(Packet*, const char*, Event*) { }
 
+    // called on packet threads about once a second, with or without
+    // traffic, so buffered output can be written
+    virtual void tick() { }
+
     void set_api(const LogApi* p)
     { api = p; }
 
@@ -36,7 +36,7 @@
 #include "search_engines/search_common.h"
 
 // this is the current version of the api
-#define SEAPI_VERSION ((BASE_API_VERSION << 16) | 0)
+#define SEAPI_VERSION ((BASE_API_VERSION << 16) | 1)
 
 struct SnortConfig;
 struct MpseApi;
@@ -112,6 +112,7 @@ struct MpseApi
 {
     BaseApi base;
     bool trim; // set true for NFAs to trim leading \0
+    bool all_hits; // set true if every occurrence of each pattern is reported
 
     MpseOptFunc activate;
     MpseOptFunc setup;
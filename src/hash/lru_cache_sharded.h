@@ -0,0 +1,189 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// lru_cache_sharded.h
+
+#ifndef LRU_CACHE_SHARDED_H
+#define LRU_CACHE_SHARDED_H
+
+// LruCacheSharded -- Spreads keys over a fixed number of LruCacheShared
+// instances so that threads working on different keys rarely contend for
+// the same mutex.  LRU order is maintained per shard.
+//
+// Each shard also carries a generation number that changes whenever an
+// entry in that shard is added, replaced, or removed.  Readers that keep
+// their own copies of cache data can compare generations to tell whether
+// their copy may be stale without taking any lock.
+
+#include <atomic>
+#include <memory>
+
+#include "hash/lru_cache_shared.h"
+
+template<typename Key, typename Data, typename Hash, unsigned NumShards = 16>
+class LruCacheSharded
+{
+public:
+    LruCacheSharded() = delete;
+    LruCacheSharded(const LruCacheSharded& arg) = delete;
+    LruCacheSharded& operator=(const LruCacheSharded& arg) = delete;
+
+    LruCacheSharded(const size_t initial_size) :
+        max_size(initial_size)
+    {
+        for ( unsigned i = 0; i < NumShards; i++ )
+        {
+            shards[i].reset(new Shard(shard_size(initial_size)));
+            generations[i] = 0;
+        }
+    }
+
+    size_t size()
+    {
+        size_t n = 0;
+
+        for ( auto& s : shards )
+            n += s->size();
+
+        return n;
+    }
+
+    size_t get_max_size()
+    { return max_size; }
+
+    //  The maximum is divided evenly among the shards.
+    bool set_max_size(size_t newsize)
+    {
+        if (newsize <= 0)
+            return false;
+
+        for ( unsigned i = 0; i < NumShards; i++ )
+        {
+            shards[i]->set_max_size(shard_size(newsize));
+            generations[i]++;
+        }
+
+        max_size = newsize;
+        return true;
+    }
+
+    void insert(const Key& key, const Data& data)
+    {
+        unsigned i = get_shard(key);
+        shards[i]->insert(key, data);
+        generations[i]++;
+    }
+
+    bool find(const Key& key, Data& data, bool update=true)
+    { return shards[get_shard(key)]->find(key, data, update); }
+
+    bool remove(const Key& key)
+    {
+        unsigned i = get_shard(key);
+
+        if ( !shards[i]->remove(key) )
+            return false;
+
+        generations[i]++;
+        return true;
+    }
+
+    bool remove(const Key& key, Data& data)
+    {
+        unsigned i = get_shard(key);
+
+        if ( !shards[i]->remove(key, data) )
+            return false;
+
+        generations[i]++;
+        return true;
+    }
+
+    void clear()
+    {
+        for ( unsigned i = 0; i < NumShards; i++ )
+        {
+            shards[i]->clear();
+            generations[i]++;
+        }
+    }
+
+    //  Data is returned shard by shard, most recently used first within
+    //  each shard.
+    std::vector<std::pair<Key, Data> > get_all_data()
+    {
+        std::vector<std::pair<Key, Data> > vec;
+
+        for ( auto& s : shards )
+        {
+            auto part = s->get_all_data();
+            vec.insert(vec.end(), part.begin(), part.end());
+        }
+        return vec;
+    }
+
+    unsigned get_shard(const Key& key) const
+    {
+        // the low bits of the hash pick the shard's hash bucket so use the
+        // high bits here to keep each shard's table evenly loaded
+        size_t h = Hash()(key);
+        return (unsigned)((h ^ (h >> 29) ^ (h >> 47)) * 0x9E3779B1u >> 16) % NumShards;
+    }
+
+    uint64_t get_generation(unsigned shard) const
+    { return generations[shard].load(std::memory_order_acquire); }
+
+    const PegInfo* get_pegs() const
+    {
+        return lru_cache_shared_peg_names;
+    }
+
+    //  The counts are summed over all shards on each call.
+    PegCount* get_counts() const
+    {
+        const unsigned num_pegs = sizeof(stats) / sizeof(PegCount);
+        PegCount* sum = (PegCount*)&stats;
+
+        for ( unsigned p = 0; p < num_pegs; p++ )
+            sum[p] = 0;
+
+        for ( auto& s : shards )
+        {
+            const PegCount* counts = s->get_counts();
+
+            for ( unsigned p = 0; p < num_pegs; p++ )
+                sum[p] += counts[p];
+        }
+        return sum;
+    }
+
+private:
+    using Shard = LruCacheShared<Key, Data, Hash>;
+
+    static size_t shard_size(size_t total)
+    { return (total + NumShards - 1) / NumShards; }
+
+    std::unique_ptr<Shard> shards[NumShards];
+    std::atomic<uint64_t> generations[NumShards];
+    std::atomic<size_t> max_size;
+
+    mutable struct LruCacheSharedStats stats;
+};
+
+#endif
+
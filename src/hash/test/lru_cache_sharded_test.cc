@@ -0,0 +1,131 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// lru_cache_sharded_test.cc
+// unit tests for LruCacheSharded class
+
+#include "hash/lru_cache_sharded.h"
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+#include <functional>
+#include <string>
+
+typedef LruCacheSharded<int, std::string, std::hash<int>, 4> TestCache;
+
+TEST_GROUP(lru_cache_sharded)
+{
+};
+
+//  Test LruCacheSharded constructor and member access.
+TEST(lru_cache_sharded, constructor_test)
+{
+    TestCache lru_cache(10);
+
+    CHECK(lru_cache.get_max_size() == 10);
+    CHECK(lru_cache.size() == 0);
+}
+
+//  Test insert, find, remove and clear across shards.
+TEST(lru_cache_sharded, insert_find_remove_test)
+{
+    std::string data;
+    TestCache lru_cache(100);
+
+    for ( int i = 0; i < 20; i++ )
+        lru_cache.insert(i, std::to_string(i));
+
+    CHECK(lru_cache.size() == 20);
+    CHECK(lru_cache.get_all_data().size() == 20);
+
+    for ( int i = 0; i < 20; i++ )
+    {
+        CHECK(true == lru_cache.find(i, data));
+        CHECK(std::to_string(i) == data);
+    }
+    CHECK(false == lru_cache.find(20, data));
+
+    CHECK(true == lru_cache.remove(3));
+    CHECK(false == lru_cache.remove(3));
+    CHECK(true == lru_cache.remove(4, data));
+    CHECK("4" == data);
+    CHECK(lru_cache.size() == 18);
+
+    const PegCount* stats = lru_cache.get_counts();
+    CHECK(stats[0] == 20);  //  adds
+    CHECK(stats[3] == 20);  //  find hits
+    CHECK(stats[4] == 1);   //  find misses
+    CHECK(stats[5] == 2);   //  removes
+
+    lru_cache.clear();
+    CHECK(lru_cache.size() == 0);
+}
+
+//  Test that the shard generation changes only when the shard changes.
+TEST(lru_cache_sharded, generation_test)
+{
+    std::string data;
+    TestCache lru_cache(100);
+
+    unsigned shard = lru_cache.get_shard(7);
+    uint64_t gen = lru_cache.get_generation(shard);
+
+    lru_cache.find(7, data);
+    CHECK(gen == lru_cache.get_generation(shard));
+
+    lru_cache.insert(7, "seven");
+    CHECK(gen != lru_cache.get_generation(shard));
+
+    gen = lru_cache.get_generation(shard);
+    lru_cache.find(7, data);
+    CHECK(gen == lru_cache.get_generation(shard));
+
+    lru_cache.remove(7);
+    CHECK(gen != lru_cache.get_generation(shard));
+
+    gen = lru_cache.get_generation(shard);
+    lru_cache.clear();
+    CHECK(gen != lru_cache.get_generation(shard));
+}
+
+//  Test that the size limit is divided among the shards.
+TEST(lru_cache_sharded, max_size_test)
+{
+    TestCache lru_cache(8);
+
+    for ( int i = 0; i < 100; i++ )
+        lru_cache.insert(i, "x");
+
+    CHECK(lru_cache.size() <= 8);
+
+    CHECK(true == lru_cache.set_max_size(400));
+    CHECK(lru_cache.get_max_size() == 400);
+
+    for ( int i = 0; i < 100; i++ )
+        lru_cache.insert(i, "x");
+
+    CHECK(lru_cache.size() == 100);
+
+    CHECK(false == lru_cache.set_max_size(0));
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
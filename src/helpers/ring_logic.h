@@ -20,7 +20,12 @@
 #ifndef RING_LOGIC_H
 #define RING_LOGIC_H
 
-// Logic for simple ring implementation
+// Logic for simple lock-free ring implementation.  Safe for exactly one
+// producer thread (write / push) and one consumer thread (read / pop).
+// Each index is only written by its own side and is kept on a separate
+// cache line so the two threads don't false share.
+
+#include <atomic>
 
 class RingLogic
 {
@@ -44,9 +49,13 @@ private:
     { return ( ++ix < sz ) ? ix : 0; }
 
 private:
+    static const unsigned CACHE_LINE_SIZE = 64;
+
     int sz;
-    volatile int rx;
-    volatile int wx;
+    std::atomic<int> rx;
+    char rx_pad[CACHE_LINE_SIZE - sizeof(std::atomic<int>)];
+    std::atomic<int> wx;
+    char wx_pad[CACHE_LINE_SIZE - sizeof(std::atomic<int>)];
 };
 
 inline RingLogic::RingLogic(int size)
@@ -58,37 +67,38 @@ inline RingLogic::RingLogic(int size)
 
 inline int RingLogic::read()
 {
-    int nx = next(rx);
-    return ( nx == wx ) ? -1 : nx;
+    int nx = next(rx.load(std::memory_order_relaxed));
+    return ( nx == wx.load(std::memory_order_acquire) ) ? -1 : nx;
 }
 
 inline int RingLogic::write()
 {
-    int nx = next(wx);
-    return ( nx == rx ) ? -1 : wx;
+    int ix = wx.load(std::memory_order_relaxed);
+    int nx = next(ix);
+    return ( nx == rx.load(std::memory_order_acquire) ) ? -1 : ix;
 }
 
 inline bool RingLogic::push()
 {
-    int nx = next(wx);
-    if ( nx == rx )
+    int nx = next(wx.load(std::memory_order_relaxed));
+    if ( nx == rx.load(std::memory_order_acquire) )
         return false;
-    wx = nx;
+    wx.store(nx, std::memory_order_release);
     return true;
 }
 
 inline bool RingLogic::pop()
 {
-    int nx = next(rx);
-    if ( nx == wx )
+    int nx = next(rx.load(std::memory_order_relaxed));
+    if ( nx == wx.load(std::memory_order_acquire) )
         return false;
-    rx = nx;
+    rx.store(nx, std::memory_order_release);
     return true;
 }
 
 inline int RingLogic::count()
 {
-    int c = wx - rx - 1;
+    int c = wx.load(std::memory_order_acquire) - rx.load(std::memory_order_acquire) - 1;
     if ( c < 0 )
         c += sz;
     return c;
@@ -96,7 +106,7 @@ inline int RingLogic::count()
 
 inline bool RingLogic::full()
 {
-    return ( count() == sz );
+    return ( next(wx.load(std::memory_order_acquire)) == rx.load(std::memory_order_acquire) );
 }
 
 inline bool RingLogic::empty()
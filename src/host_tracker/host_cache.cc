@@ -26,8 +26,24 @@
 
 #define LRU_CACHE_INITIAL_SIZE 65535
 
-LruCacheShared<HostIpKey, std::shared_ptr<HostTracker>, HashHostIpKey>
-    host_cache(LRU_CACHE_INITIAL_SIZE);
+// must be a power of 2
+#define SNAPSHOT_CACHE_SIZE 256
+
+HostCache host_cache(LRU_CACHE_INITIAL_SIZE);
+
+// A direct mapped cache of the hosts recently looked up by this thread.
+// Entries for hosts that are not in the host cache are kept too since
+// most lookups are for unknown hosts.
+struct SnapshotCacheEntry
+{
+    HostIpKey key;
+    uint64_t generation = 0;
+    bool valid = false;
+    std::shared_ptr<HostTracker> host;
+    std::shared_ptr<const HostSnapshot> snapshot;
+};
+
+static THREAD_LOCAL SnapshotCacheEntry* snapshot_cache = nullptr;
 
 void host_cache_add_host_tracker(HostTracker* ht)
 {
@@ -35,8 +51,57 @@ void host_cache_add_host_tracker(HostTracker* ht)
     host_cache.insert(ht->get_ip_addr().ip8, sptr);
 }
 
+const HostSnapshot* host_cache_find_snapshot(const sfip_t& ipaddr)
+{
+    if ( !snapshot_cache )
+        snapshot_cache = new SnapshotCacheEntry[SNAPSHOT_CACHE_SIZE];
+
+    HostIpKey ipkey(ipaddr.ip8);
+    unsigned shard = host_cache.get_shard(ipkey);
+    uint64_t generation = host_cache.get_generation(shard);
+    SnapshotCacheEntry& entry = snapshot_cache[HashHostIpKey()(ipkey) & (SNAPSHOT_CACHE_SIZE - 1)];
+
+    if ( entry.valid and entry.generation == generation and entry.key == ipkey )
+    {
+        if ( !entry.host )
+            return nullptr;
+
+        if ( entry.host->get_version() != entry.snapshot->version )
+            entry.snapshot = entry.host->get_snapshot();
+
+        return entry.snapshot.get();
+    }
+
+    //  The generation is read before the lookup so a concurrent change to
+    //  the shard is seen as stale on the next call.
+    entry.key = ipkey;
+    entry.generation = generation;
+    entry.valid = true;
+
+    if ( host_cache.find(ipkey, entry.host) )
+        entry.snapshot = entry.host->get_snapshot();
+    else
+    {
+        entry.host.reset();
+        entry.snapshot.reset();
+    }
+    return entry.snapshot.get();
+}
+
+void host_cache_thread_term()
+{
+    delete[] snapshot_cache;
+    snapshot_cache = nullptr;
+}
+
 bool host_cache_add_service(sfip_t ipaddr, Protocol ipproto, Port port, const char* /*service*/)
 {
+    //  Most calls are for services already known so check without locking.
+    const HostSnapshot* hs = host_cache_find_snapshot(ipaddr);
+
+    if ( hs and hs->find_service(ipproto, port) )
+        return false;
+
     HostIpKey ipkey(ipaddr.ip8);
     uint16_t proto = 0; // FIXIT-M not safe with multithreads snort_conf->proto_ref->add(service));
     HostApplicationEntry app_entry(ipproto, port, proto);
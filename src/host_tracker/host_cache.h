@@ -22,11 +22,12 @@
 #define HOST_CACHE_H
 
 // The host cache is used to cache information about hosts so that it can
-// be shared among threads.
+// be shared among threads.  Packet threads read through a small per-thread
+// cache of HostSnapshots which only takes a lock when a host has changed.
 
 #include <functional>
 #include "host_tracker/host_tracker.h"
-#include "hash/lru_cache_shared.h"
+#include "hash/lru_cache_sharded.h"
 #include "main/snort_types.h"
 
 
@@ -64,12 +65,22 @@ struct HashHostIpKey
     }
 };
 
-extern LruCacheShared<HostIpKey, std::shared_ptr<HostTracker>, HashHostIpKey> host_cache;
+typedef LruCacheSharded<HostIpKey, std::shared_ptr<HostTracker>, HashHostIpKey> HostCache;
+
+extern HostCache host_cache;
 
 void host_cache_add_host_tracker(HostTracker*);
 
 //  Insert a new service into host cache if it doesn't already exist.
 SO_PUBLIC bool host_cache_add_service(sfip_t, Protocol, Port, const char* service);
 
+//  Return the current snapshot of the host or nullptr if the host is not in
+//  the cache.  The snapshot remains valid until the next call on the same
+//  thread.
+SO_PUBLIC const HostSnapshot* host_cache_find_snapshot(const sfip_t&);
+
+//  Release the calling thread's snapshot cache.
+void host_cache_thread_term();
+
 #endif
 
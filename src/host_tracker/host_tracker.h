@@ -23,12 +23,15 @@
 
 // The HostTracker class holds information known about a host (may be from
 // configuration or dynamic discovery).  It provides a thread-safe API to
-// set/get the host data.
+// set/get the host data and publishes immutable HostSnapshots for lock-free
+// reads.
 
 #include <mutex>
 #include <memory>
 #include <cstring>
 #include <list>
+#include <vector>
+#include <atomic>
 #include <algorithm>
 
 #include "sfip/sfip_t.h"
@@ -76,6 +79,31 @@ struct HostApplicationEntry
     }
 };
 
+// An immutable copy of a HostTracker for use by the packet threads.  A new
+// snapshot is built the first time one is requested after any change.
+// Services and clients are held in flat arrays.
+struct HostSnapshot
+{
+    sfip_t ip_addr;
+    Policy stream_policy = 0;
+    Policy frag_policy = 0;
+    uint32_t version = 0;
+
+    std::vector<HostApplicationEntry> services;
+    std::vector<HostApplicationEntry> clients;
+
+    const HostApplicationEntry* find_service(Protocol ipproto, Port port) const
+    {
+        host_tracker_stats.service_finds++;
+
+        for ( auto& app : services )
+            if ( app.ipproto == ipproto and app.port == port )
+                return &app;
+
+        return nullptr;
+    }
+};
+
 class HostTracker
 {
 private:
@@ -92,12 +120,46 @@ private:
     std::list<HostApplicationEntry> services;
     std::list<HostApplicationEntry> clients;
 
+    //  Bumped with the lock held on every change.  Readers holding a
+    //  snapshot compare versions to detect that it is stale.
+    std::atomic<uint32_t> version;
+    std::shared_ptr<const HostSnapshot> snapshot;
+
+    void publish()
+    { version.store(version.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
 public:
-    HostTracker()
+    HostTracker() : version(0)
     {
         memset(&ip_addr, 0, sizeof(ip_addr));
     }
 
+    uint32_t get_version() const
+    {
+        return version.load(std::memory_order_acquire);
+    }
+
+    //  Returns a snapshot of the current host data, building a new one
+    //  only if the host has changed since the last call.
+    std::shared_ptr<const HostSnapshot> get_snapshot()
+    {
+        std::lock_guard<std::mutex> lck(host_tracker_lock);
+        uint32_t current = version.load(std::memory_order_relaxed);
+
+        if ( !snapshot or snapshot->version != current )
+        {
+            HostSnapshot* hs = new HostSnapshot;
+            hs->ip_addr = ip_addr;
+            hs->stream_policy = stream_policy;
+            hs->frag_policy = frag_policy;
+            hs->version = current;
+            hs->services.assign(services.begin(), services.end());
+            hs->clients.assign(clients.begin(), clients.end());
+            snapshot.reset(hs);
+        }
+        return snapshot;
+    }
+
     sfip_t get_ip_addr()
     {
         std::lock_guard<std::mutex> lck(host_tracker_lock);
@@ -108,6 +170,7 @@ public:
     {
         std::lock_guard<std::mutex> lck(host_tracker_lock);
         std::memcpy(&ip_addr, &new_ip_addr, sizeof(ip_addr));
+        publish();
     }
 
     Policy get_stream_policy()
@@ -120,6 +183,7 @@ public:
     {
         std::lock_guard<std::mutex> lck(host_tracker_lock);
         stream_policy = policy;
+        publish();
     }
 
     Policy get_frag_policy()
@@ -132,6 +196,7 @@ public:
     {
         std::lock_guard<std::mutex> lck(host_tracker_lock);
         frag_policy = policy;
+        publish();
     }
 
     //  Add host service data only if it doesn't already exist.  Returns
@@ -147,6 +212,7 @@ public:
             return false;   //  Already exists.
 
         services.push_front(app_entry);
+        publish();
         return true;
     }
 
@@ -163,6 +229,7 @@ public:
             services.erase(iter);
 
         services.push_front(app_entry);
+        publish();
     }
 
     //  Returns true and fills in copy of HostApplicationEntry when found.
@@ -197,6 +264,7 @@ public:
         if (iter != services.end())
         {
             services.erase(iter);
+            publish();
             return true;   //  Assumes only one matching entry.
         }
 
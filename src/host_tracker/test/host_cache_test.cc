@@ -149,6 +149,46 @@ TEST(host_cache, host_cache_add_service_test)
     CHECK(actual_app_entry == app_entry2);
 
     host_cache.clear();     //  Free HostTracker objects
+    host_cache_thread_term();
+}
+
+//  Test host_cache_find_snapshot
+TEST(host_cache, host_cache_find_snapshot_test)
+{
+    sfip_t ip_addr = { 0x00de,0x10ad,{{0xbe,0xef,0xde,0xad,0xbe,0xef,0xab,0xcd,0xef,0x01,0x23,0x34,0x56,0x78,0x90,0xab}} };
+    std::shared_ptr<HostTracker> ht;
+    const HostSnapshot* hs;
+
+    //  Unknown hosts are cached as unknown until the cache changes.
+    hs = host_cache_find_snapshot(ip_addr);
+    CHECK(nullptr == hs);
+
+    CHECK(true == host_cache_add_service(ip_addr, 6, 80, "tcp"));
+    CHECK(true == host_cache.find(ip_addr.ip8, ht));
+
+    hs = host_cache_find_snapshot(ip_addr);
+    CHECK(nullptr != hs);
+    CHECK(ht->get_version() == hs->version);
+    CHECK(nullptr != hs->find_service(6, 80));
+    CHECK(nullptr == hs->find_service(6, 443));
+
+    //  Changes to the host are picked up by the next lookup.
+    ht->set_stream_policy(3);
+    ht->add_service(HostApplicationEntry(6, 443, 0));
+    hs = host_cache_find_snapshot(ip_addr);
+    CHECK(3 == hs->stream_policy);
+    CHECK(nullptr != hs->find_service(6, 443));
+
+    //  An unchanged host returns the same snapshot.
+    CHECK(hs == host_cache_find_snapshot(ip_addr));
+
+    //  Removing the host from the cache is seen as well.
+    CHECK(true == host_cache.remove(ip_addr.ip8));
+    CHECK(nullptr == host_cache_find_snapshot(ip_addr));
+
+    ht.reset();
+    host_cache.clear();
+    host_cache_thread_term();
 }
 
 int main(int argc, char** argv)
@@ -169,7 +209,15 @@ int main(int argc, char** argv)
     host_cache_add_host_tracker(ht);
     host_cache_add_service(ip_addr1, proto1, port1, "udp");
 
+    //  The cache is sharded so touch every shard's map.
+    for ( int i = 0; i < 256; i++ )
+    {
+        ip_addr1.ip8[15] = (uint8_t)i;
+        host_cache_add_service(ip_addr1, proto1, port1, "udp");
+    }
+
     host_cache.clear();
+    host_cache_thread_term();
 
     //  Use this if you want to turn off memory checks entirely:
     // MemoryLeakWarningPlugin::turnOffNewDeleteOverloads();
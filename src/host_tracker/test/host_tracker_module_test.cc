@@ -180,9 +180,17 @@ int main(int argc, char** argv)
     //  must have some data allocated when it is first created
     //  that doesn't go away until the global map object is
     //  deallocated. This pre-allocates the map so that initial
-    //  allocation is done prior to starting the tests.
-    HostTracker* ht = new HostTracker;
-    host_cache_add_host_tracker(ht);
+    //  allocation is done prior to starting the tests.  The cache is
+    //  sharded so touch every shard's map.
+    for ( int i = 0; i < 256; i++ )
+    {
+        HostTracker* ht = new HostTracker;
+        sfip_t addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.ip8[15] = (uint8_t)i;
+        ht->set_ip_addr(addr);
+        host_cache_add_host_tracker(ht);
+    }
     host_cache.clear();
 
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -129,6 +129,38 @@ TEST(host_tracker, add_find_service_test)
     CHECK(true == ret);
 }
 
+//  Test HostTracker snapshots.
+TEST(host_tracker, snapshot_test)
+{
+    HostTracker ht;
+    HostApplicationEntry app_entry1(6, 2112, 3);
+    HostApplicationEntry app_entry2(17, 7777, 10);
+
+    ht.set_stream_policy(4);
+    ht.add_service(app_entry1);
+
+    std::shared_ptr<const HostSnapshot> hs1 = ht.get_snapshot();
+    CHECK(hs1->version == ht.get_version());
+    CHECK(hs1->stream_policy == 4);
+    CHECK(hs1->services.size() == 1);
+    CHECK(hs1->find_service(6, 2112) != nullptr);
+    CHECK(hs1->find_service(6, 2112)->protocol == 3);
+
+    //  No change, same snapshot.
+    CHECK(ht.get_snapshot() == hs1);
+
+    //  A change publishes a new version and leaves the old snapshot intact.
+    ht.add_service(app_entry2);
+    CHECK(hs1->version != ht.get_version());
+
+    std::shared_ptr<const HostSnapshot> hs2 = ht.get_snapshot();
+    CHECK(hs2 != hs1);
+    CHECK(hs2->services.size() == 2);
+    CHECK(hs2->find_service(17, 7777) != nullptr);
+    CHECK(hs1->services.size() == 1);
+    CHECK(hs1->find_service(17, 7777) == nullptr);
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
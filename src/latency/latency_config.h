@@ -22,12 +22,14 @@
 #define LATENCY_CONFIG_H
 
 #include "packet_latency_config.h"
+#include "rule_budget_config.h"
 #include "rule_latency_config.h"
 
 struct LatencyConfig
 {
     PacketLatencyConfig packet_latency;
     RuleLatencyConfig rule_latency;
+    RuleBudgetConfig rule_budget;
 };
 
 #endif
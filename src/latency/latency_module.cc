@@ -21,11 +21,13 @@
 #include "latency_module.h"
 
 #include <chrono>
+#include <lua.hpp>
 
 #include "main/snort_config.h"
 #include "latency_config.h"
 #include "latency_stats.h"
 #include "latency_rules.h"
+#include "rule_budget.h"
 
 // -----------------------------------------------------------------------------
 // latency attributes
@@ -71,6 +73,29 @@ static const Parameter s_rule_params[] =
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
+static const Parameter s_budget_params[] =
+{
+    { "share", Parameter::PT_INT, "0:100", "0",
+        "max percent of detection time a rule tree may use per window (0 disables)" },
+
+    { "window", Parameter::PT_INT, "1:", "10",
+        "set accounting window for rule tree cost (sec)" },
+
+    { "min_time", Parameter::PT_INT, "0:", "100000",
+        "set detection time needed in a window before demoting rules (usec)" },
+
+    { "max_demote_time", Parameter::PT_INT, "0:", "300000",
+        "set max time for demoting a rule (ms, 0 means until restored by command)" },
+
+    { "critical_priority", Parameter::PT_INT, "0:", "0",
+        "never demote rules with priority 1 to this (0 means none)" },
+
+    { "action", Parameter::PT_ENUM, "none | alert | log | alert_and_log", "none",
+        "event action for rule budget demote and restore events" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 static const Parameter s_params[] =
 {
     { "packet", Parameter::PT_TABLE, s_packet_params, nullptr,
@@ -79,6 +104,9 @@ static const Parameter s_params[] =
     { "rule", Parameter::PT_TABLE, s_rule_params, nullptr,
       "rule latency" },
 
+    { "budget", Parameter::PT_TABLE, s_budget_params, nullptr,
+      "rule cpu budget" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -87,6 +115,8 @@ static const RuleMap latency_rules[] =
     { LATENCY_EVENT_RULE_TREE_SUSPENDED, "rule tree suspended due to latency" },
     { LATENCY_EVENT_RULE_TREE_ENABLED, "rule tree re-enabled after suspend timeout" },
     { LATENCY_EVENT_PACKET_FASTPATHED, "packet fastpathed due to latency" },
+    { LATENCY_EVENT_RULE_TREE_DEMOTED, "rule tree demoted for exceeding cpu budget" },
+    { LATENCY_EVENT_RULE_TREE_RESTORED, "rule tree restored after demote timeout (not raised by latency.restore())" },
 
     { 0, nullptr }
 };
@@ -102,6 +132,8 @@ static const PegInfo latency_pegs[] =
     { "total rule evals", "total rule evals monitored" },
     { "rule eval timeouts", "rule evals that timed out" },
     { "rule tree enables", "rule tree re-enables" },
+    { "rule tree demotes", "rule trees demoted for exceeding cpu budget" },
+    { "rule tree restores", "demoted rule trees restored after timeout (excludes latency.restore())" },
     { nullptr, nullptr }
 };
 
@@ -165,6 +197,67 @@ static inline bool latency_set(Value& v, RuleLatencyConfig& config)
     return true;
 }
 
+static inline bool latency_set(Value& v, RuleBudgetConfig& config)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    using std::chrono::milliseconds;
+    using std::chrono::seconds;
+
+    if ( v.is("share") )
+        config.share = v.get_long();
+
+    else if ( v.is("window") )
+    {
+        long t = clock_ticks(v.get_long());
+        config.window = duration_cast<decltype(config.window)>(seconds(t));
+    }
+    else if ( v.is("min_time") )
+    {
+        long t = clock_ticks(v.get_long());
+        config.min_time = duration_cast<decltype(config.min_time)>(microseconds(t));
+    }
+    else if ( v.is("max_demote_time") )
+    {
+        long t = clock_ticks(v.get_long());
+        config.max_demote_time = duration_cast<decltype(config.max_demote_time)>(milliseconds(t));
+    }
+    else if ( v.is("critical_priority") )
+        config.critical_priority = v.get_long();
+
+    else if ( v.is("action") )
+        config.action =
+            static_cast<decltype(config.action)>(v.get_long());
+
+    else
+        return false;
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// latency commands
+// -----------------------------------------------------------------------------
+
+static int show_demoted(lua_State*)
+{
+    RuleBudget::show_demoted();
+    return 0;
+}
+
+static int restore_demoted(lua_State*)
+{
+    RuleBudget::restore_demoted();
+    return 0;
+}
+
+static const Command latency_cmds[] =
+{
+    { "demoted", show_demoted, nullptr, "list rule trees demoted for exceeding cpu budget" },
+    { "restore", restore_demoted, nullptr, "restore all demoted rule trees" },
+    { nullptr, nullptr, nullptr, nullptr }
+};
+
 LatencyModule::LatencyModule() :
     Module(s_name, s_help, s_params)
 { }
@@ -173,6 +266,7 @@ bool LatencyModule::set(const char* fqn, Value& v, SnortConfig* sc)
 {
     const char* slp = "latency.packet";
     const char* slr = "latency.rule";
+    const char* slb = "latency.budget";
 
     if ( !strncmp(fqn, slp, strlen(slp)) )
         return latency_set(v, sc->latency->packet_latency);
@@ -180,9 +274,15 @@ bool LatencyModule::set(const char* fqn, Value& v, SnortConfig* sc)
     else if ( !strncmp(fqn, slr, strlen(slr)) )
         return latency_set(v, sc->latency->rule_latency);
 
+    else if ( !strncmp(fqn, slb, strlen(slb)) )
+        return latency_set(v, sc->latency->rule_budget);
+
     return false;
 }
 
+const Command* LatencyModule::get_commands() const
+{ return latency_cmds; }
+
 const RuleMap* LatencyModule::get_rules() const
 { return latency_rules; }
 
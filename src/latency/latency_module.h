@@ -30,6 +30,7 @@ public:
 
     bool set(const char*, Value&, SnortConfig*) override;
 
+    const Command* get_commands() const override;
     const RuleMap* get_rules() const override;
     unsigned get_gid() const override;
 
@@ -27,6 +27,8 @@
 #define LATENCY_EVENT_RULE_TREE_SUSPENDED   1
 #define LATENCY_EVENT_RULE_TREE_ENABLED     2
 #define LATENCY_EVENT_PACKET_FASTPATHED     3
+#define LATENCY_EVENT_RULE_TREE_DEMOTED     4
+#define LATENCY_EVENT_RULE_TREE_RESTORED    5
 
 #endif
 
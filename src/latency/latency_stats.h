@@ -33,6 +33,8 @@ struct LatencyStats
     PegCount total_rule_evals;
     PegCount rule_eval_timeouts;
     PegCount rule_tree_enables;
+    PegCount rule_tree_demotes;
+    PegCount rule_tree_restores;
 };
 
 extern THREAD_LOCAL LatencyStats latency_stats;
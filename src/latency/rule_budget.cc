@@ -0,0 +1,670 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// rule_budget.cc
+
+#include "rule_budget.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "detection/detection_options.h"
+#include "detection/treenodes.h"
+#include "events/event_queue.h"
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "sfip/sf_ip.h"
+#include "utils/stats.h"
+
+#include "latency_config.h"
+#include "latency_rules.h"
+#include "latency_stats.h"
+#include "latency_util.h"
+
+#ifdef UNIT_TEST
+#include "catch/catch.hpp"
+#include "main/thread_config.h"
+#endif
+
+namespace rule_budget
+{
+// -----------------------------------------------------------------------------
+// helpers
+// -----------------------------------------------------------------------------
+
+struct Event
+{
+    enum Type
+    {
+        EVENT_DEMOTED,
+        EVENT_RESTORED
+    };
+
+    Type type;
+    unsigned share;
+    detection_option_tree_root_t* root;
+    Packet* packet;
+};
+
+using ConfigWrapper = ReferenceWrapper<RuleBudgetConfig>;
+using EventHandler = EventingWrapper<Event>;
+
+static inline std::ostream& operator<<(std::ostream& os, const Event& e)
+{
+    os << "latency: " << pc.total_from_daq << " rule tree ";
+
+    switch ( e.type )
+    {
+    case Event::EVENT_DEMOTED:
+        os << "demoted: " << e.share << "% of detection time, ";
+        break;
+
+    case Event::EVENT_RESTORED:
+        os << "restored: ";
+        break;
+    }
+
+    os << e.root->otn->sigInfo.generator << ":" << e.root->otn->sigInfo.id << ":"
+        << e.root->otn->sigInfo.rev;
+
+    if ( e.root->num_children > 1 )
+        os << " (of " << e.root->num_children << ")";
+
+    os << ", " << e.packet->ptrs.ip_api.get_src() << ":" << e.packet->ptrs.sp;
+    os << " -> " << e.packet->ptrs.ip_api.get_dst() << ":" << e.packet->ptrs.dp;
+
+    return os;
+}
+
+// the accounting window is shared by all packet threads; whichever thread
+// first sees the window expire starts the next one
+struct Window
+{
+    std::atomic<uint64_t> id { 0 };
+    std::atomic<hr_duration::rep> end { 0 };
+    std::atomic<hr_duration::rep> total { 0 };
+    std::atomic<hr_duration::rep> last_total { 0 };
+};
+
+// demotion is rare so a locked list is fine here
+class DemotedList
+{
+public:
+    void add(detection_option_tree_root_t* root)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        roots.push_back(root);
+    }
+
+    void remove(detection_option_tree_root_t* root)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = std::find(roots.begin(), roots.end(), root);
+
+        if ( it != roots.end() )
+            roots.erase(it);
+    }
+
+    std::vector<detection_option_tree_root_t*> get()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return roots;
+    }
+
+    unsigned restore()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for ( auto* root : roots )
+        {
+            root->budget_state->cost = 0;
+            root->budget_state->demoted = false;
+        }
+
+        unsigned n = roots.size();
+        roots.clear();
+        return n;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<detection_option_tree_root_t*> roots;
+};
+
+// -----------------------------------------------------------------------------
+// implementation
+// -----------------------------------------------------------------------------
+
+template<typename Clock = SnortClock>
+class Impl
+{
+public:
+    Impl(const ConfigWrapper&, Window&, DemotedList&, EventHandler&, EventHandler&);
+
+    bool push(detection_option_tree_root_t*, Packet*);
+    bool pop();
+    bool demoted() const;
+
+private:
+    struct Entry
+    {
+        detection_option_tree_root_t* root;
+        Packet* packet;
+        typename Clock::time_point start;
+    };
+
+    void roll(hr_duration::rep now);
+    bool charge(const Entry&, hr_duration::rep now, hr_duration::rep elapsed);
+    void handle(const Event&);
+
+    std::vector<Entry> stack;
+    hr_duration::rep pending = 0;  // detection time not yet added to window
+
+    const ConfigWrapper& config;
+    Window& window;
+    DemotedList& demoted_list;
+    EventHandler& event_handler;
+    EventHandler& log_handler;
+};
+
+template<typename Clock>
+inline Impl<Clock>::Impl(
+    const ConfigWrapper& cfg, Window& w, DemotedList& dl, EventHandler& eh, EventHandler& lh) :
+    config(cfg), window(w), demoted_list(dl), event_handler(eh), log_handler(lh)
+{ }
+
+template<typename Clock>
+inline bool Impl<Clock>::push(detection_option_tree_root_t* root, Packet* p)
+{
+    assert(root and p);
+
+    auto now = Clock::now();
+    stack.push_back({ root, p, now });
+
+    auto& state = *root->budget_state;
+
+    if ( !state.demoted.load(std::memory_order_relaxed) or !config->allow_restore() )
+        return false;
+
+    if ( now.time_since_epoch().count() - state.demote_time <= config->max_demote_time.count() )
+        return false;
+
+    bool expected = true;
+
+    if ( !state.demoted.compare_exchange_strong(expected, false) )
+        return false;
+
+    state.cost = 0;
+    demoted_list.remove(root);
+
+    Event e { Event::EVENT_RESTORED, 0, root, p };
+    handle(e);
+    return true;
+}
+
+template<typename Clock>
+inline bool Impl<Clock>::pop()
+{
+    assert(!stack.empty());
+
+    Entry entry = stack.back();
+    stack.pop_back();
+
+    auto now = Clock::now().time_since_epoch().count();
+    auto elapsed = now - entry.start.time_since_epoch().count();
+
+    roll(now);
+
+    // nested evaluations are already included in the outermost one
+    if ( stack.empty() )
+    {
+        pending += elapsed;
+
+        if ( pending >= config->quantum().count() )
+        {
+            window.total += pending;
+            pending = 0;
+        }
+    }
+
+    if ( entry.root->budget_state->demoted.load(std::memory_order_relaxed) )
+        return false;
+
+    return charge(entry, now, elapsed);
+}
+
+template<typename Clock>
+inline bool Impl<Clock>::demoted() const
+{
+    assert(!stack.empty());
+    return stack.back().root->budget_state->demoted.load(std::memory_order_relaxed);
+}
+
+template<typename Clock>
+inline void Impl<Clock>::roll(hr_duration::rep now)
+{
+    auto end = window.end.load(std::memory_order_relaxed);
+
+    if ( now < end )
+        return;
+
+    if ( window.end.compare_exchange_strong(end, now + config->window.count()) )
+    {
+        window.last_total = window.total.exchange(0);
+        ++window.id;
+    }
+}
+
+// costs are approximate; a charge racing with a window reset may be lost
+template<typename Clock>
+inline bool Impl<Clock>::charge(
+    const Entry& entry, hr_duration::rep now, hr_duration::rep elapsed)
+{
+    auto* root = entry.root;
+    auto& local = root->latency_state[get_instance_id()];
+    uint64_t id = window.id.load(std::memory_order_relaxed);
+
+    if ( local.budget_window != id )
+    {
+        local.budget_window = id;
+        local.budget_cost = 0_ticks;
+    }
+
+    local.budget_cost += hr_duration(elapsed);
+
+    if ( local.budget_cost < config->quantum() )
+        return false;
+
+    auto& state = *root->budget_state;
+    uint64_t last = state.window.load(std::memory_order_relaxed);
+
+    if ( last != id and state.window.compare_exchange_strong(last, id) )
+        state.cost = 0;
+
+    auto cost = (state.cost += local.budget_cost.count());
+    local.budget_cost = 0_ticks;
+
+    // the last full window is the reference until this one is busier
+    auto total = std::max(window.last_total.load(), window.total.load() + pending);
+
+    if ( total < config->min_time.count() or total <= 0 )
+        return false;
+
+    if ( cost * 100 <= total * (hr_duration::rep)config->share )
+        return false;
+
+    // priority 0 means the rule has no classtype or priority, not critical
+    if ( config->critical_priority and root->otn and root->otn->sigInfo.priority > 0 and
+        root->otn->sigInfo.priority <= config->critical_priority )
+        return false;
+
+    bool expected = false;
+
+    if ( !state.demoted.compare_exchange_strong(expected, true) )
+        return false;
+
+    state.demote_time = now;
+    state.share = (unsigned)(cost * 100 / total);
+    demoted_list.add(root);
+
+    Event e { Event::EVENT_DEMOTED, state.share, root, entry.packet };
+    handle(e);
+    return true;
+}
+
+template<typename Clock>
+inline void Impl<Clock>::handle(const Event& e)
+{
+    if ( config->action & RuleLatencyConfig::LOG )
+        log_handler.handle(e);
+
+    if ( config->action & RuleLatencyConfig::ALERT )
+        event_handler.handle(e);
+}
+
+// -----------------------------------------------------------------------------
+// static variables
+// -----------------------------------------------------------------------------
+
+static struct SnortConfigWrapper : public ConfigWrapper
+{
+    const RuleBudgetConfig* operator->() const override
+    { return &snort_conf->latency->rule_budget; }
+
+} config;
+
+static struct SnortEventHandler : public EventHandler
+{
+    void handle(const Event& e) override
+    {
+        switch ( e.type )
+        {
+            case Event::EVENT_DEMOTED:
+                SnortEventqAdd(GID_LATENCY, LATENCY_EVENT_RULE_TREE_DEMOTED);
+                break;
+
+            case Event::EVENT_RESTORED:
+                SnortEventqAdd(GID_LATENCY, LATENCY_EVENT_RULE_TREE_RESTORED);
+                break;
+        }
+    }
+} event_handler;
+
+static struct SnortLogHandler : public EventHandler
+{
+    void handle(const Event& e) override
+    {
+        std::ostringstream ss;
+        ss << e;
+        LogMessage("%s\n", ss.str().c_str());
+    }
+} log_handler;
+
+static Window window;
+static DemotedList demoted_list;
+
+static THREAD_LOCAL Impl<>* impl = nullptr;
+
+static inline Impl<>& get_impl()
+{
+    if ( !impl )
+        impl = new Impl<>(config, window, demoted_list, event_handler, log_handler);
+
+    return *impl;
+}
+
+} // namespace rule_budget
+
+// -----------------------------------------------------------------------------
+// rule budget interface
+// -----------------------------------------------------------------------------
+
+void RuleBudget::push(detection_option_tree_root_t* root, Packet* p)
+{
+    if ( rule_budget::config->enabled() )
+    {
+        if ( rule_budget::get_impl().push(root, p) )
+            ++latency_stats.rule_tree_restores;
+    }
+}
+
+void RuleBudget::pop()
+{
+    if ( rule_budget::config->enabled() )
+    {
+        if ( rule_budget::get_impl().pop() )
+            ++latency_stats.rule_tree_demotes;
+    }
+}
+
+bool RuleBudget::demoted()
+{
+    if ( rule_budget::config->enabled() )
+        return rule_budget::get_impl().demoted();
+
+    return false;
+}
+
+void RuleBudget::tterm()
+{
+    using rule_budget::impl;
+
+    if ( impl )
+    {
+        delete impl;
+        impl = nullptr;
+    }
+}
+
+void RuleBudget::show_demoted()
+{
+    auto roots = rule_budget::demoted_list.get();
+
+    LogMessage("latency: %u rule trees demoted\n", (unsigned)roots.size());
+
+    for ( auto* root : roots )
+    {
+        const SigInfo& si = root->otn->sigInfo;
+
+        LogMessage("    %u:%u:%u (of %d) %u%% of detection time\n",
+            si.generator, si.id, si.rev, root->num_children, root->budget_state->share.load());
+    }
+}
+
+unsigned RuleBudget::restore_demoted()
+{
+    unsigned n = rule_budget::demoted_list.restore();
+    LogMessage("latency: %u rule trees restored\n", n);
+    return n;
+}
+
+void RuleBudget::release(detection_option_tree_root_t* root)
+{
+    if ( root->budget_state->demoted )
+        rule_budget::demoted_list.remove(root);
+}
+
+// -----------------------------------------------------------------------------
+// unit tests
+// -----------------------------------------------------------------------------
+
+#ifdef UNIT_TEST
+
+namespace t_rule_budget
+{
+
+struct MockConfigWrapper : public rule_budget::ConfigWrapper
+{
+    RuleBudgetConfig config;
+
+    const RuleBudgetConfig* operator->() const override
+    { return &config; }
+};
+
+struct EventHandlerSpy : public rule_budget::EventHandler
+{
+    unsigned demotes = 0;
+    unsigned restores = 0;
+
+    void handle(const rule_budget::Event& e) override
+    {
+        if ( e.type == rule_budget::Event::EVENT_DEMOTED )
+            ++demotes;
+        else
+            ++restores;
+    }
+};
+
+struct MockClock : public ClockTraits<hr_clock>
+{
+    static hr_time t;
+
+    static void reset()
+    { t = hr_time(0_ticks); }
+
+    static void inc(hr_duration d = 1_ticks)
+    { t += d; }
+
+    static hr_time now()
+    { return t; }
+};
+
+hr_time MockClock::t = hr_time(0_ticks);
+
+struct MockTree
+{
+    MockTree(unsigned priority)
+    {
+        auto instances = ThreadConfig::get_instance_max();
+        if ( !instances )
+            instances = 1;
+
+        latency_state.reset(new RuleLatencyState[instances]());
+        otn.sigInfo.priority = priority;
+
+        root.num_children = 0;
+        root.children = nullptr;
+        root.latency_state = latency_state.get();
+        root.budget_state = &budget_state;
+        root.otn = &otn;
+    }
+
+    std::unique_ptr<RuleLatencyState[]> latency_state;
+    RuleBudgetState budget_state;
+    OptTreeNode otn { };
+    detection_option_tree_root_t root;
+};
+
+} // namespace t_rule_budget
+
+TEST_CASE ( "rule budget impl", "[latency]" )
+{
+    using namespace t_rule_budget;
+
+    MockConfigWrapper config;
+    EventHandlerSpy event_handler;
+    EventHandlerSpy log_handler;
+
+    config.config.share = 60;
+    config.config.window = 4096_ticks;
+    config.config.min_time = 100_ticks;
+    config.config.action = RuleLatencyConfig::ALERT_AND_LOG;
+
+    MockClock::reset();
+    MockClock::inc(1000_ticks);
+
+    rule_budget::Window window;
+    rule_budget::DemotedList demoted_list;
+    rule_budget::Impl<MockClock> impl(config, window, demoted_list, event_handler, log_handler);
+
+    MockTree cheap(3), costly(3);
+    Packet pkt(false);
+
+    auto eval = [&](MockTree& t, hr_duration d)
+    {
+        impl.push(&t.root, &pkt);
+        bool skip = impl.demoted();
+        MockClock::inc(d);
+        bool demoted = impl.pop();
+        return skip ? -1 : (int)demoted;
+    };
+
+    // first window establishes the reference total
+    for ( int i = 0; i < 10; ++i )
+    {
+        CHECK( eval(cheap, 10_ticks) == 0 );
+        CHECK( eval(costly, 10_ticks) == 0 );
+    }
+    MockClock::inc(4096_ticks);
+
+    SECTION( "within budget" )
+    {
+        for ( int i = 0; i < 10; ++i )
+        {
+            CHECK( eval(cheap, 10_ticks) == 0 );
+            CHECK( eval(costly, 10_ticks) == 0 );
+        }
+        CHECK( event_handler.demotes == 0 );
+        CHECK( demoted_list.get().empty() );
+    }
+
+    SECTION( "over budget" )
+    {
+        CHECK( eval(cheap, 10_ticks) == 0 );
+        CHECK( eval(costly, 150_ticks) == 1 );
+        CHECK( event_handler.demotes == 1 );
+        CHECK( log_handler.demotes == 1 );
+        CHECK( costly.budget_state.share == 75 );
+
+        // demoted trees are skipped and no longer charged
+        CHECK( eval(costly, 10_ticks) == -1 );
+        CHECK( eval(cheap, 10_ticks) == 0 );
+
+        REQUIRE( demoted_list.get().size() == 1 );
+        CHECK( demoted_list.get()[0] == &costly.root );
+
+        SECTION( "restored by command" )
+        {
+            CHECK( demoted_list.restore() == 1 );
+            CHECK( eval(costly, 10_ticks) == 0 );
+            CHECK( event_handler.restores == 0 );
+        }
+
+        SECTION( "not restored without timeout" )
+        {
+            MockClock::inc(100000_ticks);
+            CHECK( eval(costly, 10_ticks) == -1 );
+        }
+
+        SECTION( "restored by timeout" )
+        {
+            config.config.max_demote_time = 500_ticks;
+
+            CHECK( eval(costly, 10_ticks) == -1 );
+            MockClock::inc(600_ticks);
+            CHECK( eval(costly, 10_ticks) == 0 );
+            CHECK( event_handler.restores == 1 );
+            CHECK( demoted_list.get().empty() );
+        }
+    }
+
+    SECTION( "critical rules are not demoted" )
+    {
+        config.config.critical_priority = 3;
+
+        CHECK( eval(costly, 150_ticks) == 0 );
+        CHECK( event_handler.demotes == 0 );
+    }
+
+    SECTION( "unprioritized rules are not critical" )
+    {
+        config.config.critical_priority = 3;
+        costly.otn.sigInfo.priority = 0;
+
+        CHECK( eval(costly, 150_ticks) == 1 );
+        CHECK( event_handler.demotes == 1 );
+    }
+
+    SECTION( "not enough detection time" )
+    {
+        config.config.min_time = 100000_ticks;
+
+        CHECK( eval(costly, 150_ticks) == 0 );
+        CHECK( event_handler.demotes == 0 );
+    }
+
+    SECTION( "cost resets each window" )
+    {
+        for ( int i = 0; i < 3; ++i )
+        {
+            CHECK( eval(costly, 50_ticks) == 0 );
+            CHECK( eval(cheap, 70_ticks) == 0 );
+            MockClock::inc(4096_ticks);
+        }
+        CHECK( event_handler.demotes == 0 );
+    }
+}
+
+#endif
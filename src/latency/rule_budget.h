@@ -0,0 +1,57 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// rule_budget.h
+
+#ifndef RULE_BUDGET_H
+#define RULE_BUDGET_H
+
+// RuleBudget charges rule tree evaluation time to the tree across all
+// packet threads and demotes trees that use more than the configured share
+// of detection time in a window.  Demoted trees are skipped until they are
+// restored by timeout or by command.
+
+struct detection_option_tree_root_t;
+struct Packet;
+
+class RuleBudget
+{
+public:
+    static void push(detection_option_tree_root_t*, Packet*);
+    static void pop();
+    static bool demoted();
+
+    static void tterm();
+
+    // main thread only
+    static void show_demoted();
+    static unsigned restore_demoted();
+    static void release(detection_option_tree_root_t*);
+
+    class Context
+    {
+    public:
+        Context(detection_option_tree_root_t* root, Packet* p)
+        { RuleBudget::push(root, p); }
+
+        ~Context()
+        { RuleBudget::pop(); }
+    };
+};
+
+#endif
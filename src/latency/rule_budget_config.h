@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// rule_budget_config.h
+
+#ifndef RULE_BUDGET_CONFIG_H
+#define RULE_BUDGET_CONFIG_H
+
+#include "rule_latency_config.h"
+
+struct RuleBudgetConfig
+{
+    unsigned share = 0;                   // percent of detection time
+    hr_duration window = 0_ticks;
+    hr_duration min_time = 0_ticks;       // detection time needed to decide
+    hr_duration max_demote_time = 0_ticks;
+    unsigned critical_priority = 0;
+    RuleLatencyConfig::Action action = RuleLatencyConfig::NONE;
+
+    bool enabled() const { return share > 0 and window > 0_ticks; }
+    bool allow_restore() const { return max_demote_time > 0_ticks; }
+
+    // rule trees are charged to the shared total in pieces of this size
+    hr_duration quantum() const
+    { return window / 4096 > 0_ticks ? window / 4096 : 1_ticks; }
+};
+
+#endif
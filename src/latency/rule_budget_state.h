@@ -0,0 +1,41 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// rule_budget_state.h
+
+#ifndef RULE_BUDGET_STATE_H
+#define RULE_BUDGET_STATE_H
+
+#include <atomic>
+#include <cstdint>
+
+#include "time/clock_defs.h"
+
+// shared by all packet threads; per thread costs are batched in
+// RuleLatencyState and charged here in quanta so hot rule trees don't
+// bounce this cache line on every evaluation
+struct RuleBudgetState
+{
+    std::atomic<uint64_t> window { 0 };         // window cost belongs to
+    std::atomic<hr_duration::rep> cost { 0 };   // ticks charged in window
+    std::atomic<hr_duration::rep> demote_time { 0 };
+    std::atomic<unsigned> share { 0 };          // percent when demoted
+    std::atomic<bool> demoted { false };
+};
+
+#endif
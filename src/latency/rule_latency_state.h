@@ -21,6 +21,8 @@
 #ifndef RULE_LATENCY_STATE_H
 #define RULE_LATENCY_STATE_H
 
+#include <cstdint>
+
 #include "time/clock_defs.h"
 
 struct RuleLatencyState
@@ -29,6 +31,10 @@ struct RuleLatencyState
     unsigned timeouts = 0;
     bool suspended = false;
 
+    // rule budget cost not yet charged to the shared RuleBudgetState
+    hr_duration budget_cost { };
+    uint64_t budget_window = 0;
+
     void enable()
     {
         timeouts = 0;
@@ -0,0 +1,336 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// async_writer.cc
+
+#include "async_writer.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "log/messages.h"
+#include "utils/util.h"
+
+const PegInfo async_pegs[] =
+{
+    { "async records", "log records queued for the output thread" },
+    { "async bytes", "log bytes queued for the output thread" },
+    { "async waits", "records that waited for space in a full ring" },
+    { nullptr, nullptr }
+};
+
+THREAD_LOCAL AsyncCounts async_counts;
+
+// the mutex guards the writer list only; the output thread does its I/O
+// on a copy, so a writer is deleted only after the output thread has
+// released it (or has exited)
+static std::mutex s_mutex;
+static std::condition_variable s_cv;
+static std::vector<AsyncWriter*> s_writers;
+
+static std::thread* s_thread = nullptr;
+static std::atomic<bool> s_running(false);
+static bool s_alive = false;   // output thread may touch writers; guarded by s_mutex
+
+static unsigned s_ring_size = 0;
+static unsigned s_sync_interval = 0;
+
+//-------------------------------------------------------------------------
+// main thread
+//-------------------------------------------------------------------------
+
+void AsyncWriter::start(unsigned ring_size, unsigned sync_interval)
+{
+    if ( s_thread )
+        return;
+
+    unsigned size = 4096;
+
+    while ( size < ring_size )
+        size <<= 1;
+
+    s_ring_size = size;
+    s_sync_interval = sync_interval;
+    s_running = true;
+    s_alive = true;
+
+    s_thread = new std::thread(run);
+}
+
+void AsyncWriter::stop()
+{
+    if ( !s_thread )
+        return;
+
+    s_running = false;
+    s_cv.notify_one();
+
+    s_thread->join();
+    delete s_thread;
+    s_thread = nullptr;
+
+    // writers still open are flushed by their owners from here on
+    s_ring_size = 0;
+}
+
+//-------------------------------------------------------------------------
+// writer's thread
+//-------------------------------------------------------------------------
+
+AsyncWriter::AsyncWriter(int f, unsigned size) :
+    closing(false), released(false), head(0), tail(0)
+{
+    ring = (uint8_t*)snort_alloc(size);
+    mask = size - 1;
+    fd = f;
+    failed = false;
+    synced = 0;
+}
+
+AsyncWriter::~AsyncWriter()
+{
+    snort_free(ring);
+}
+
+AsyncWriter* AsyncWriter::open(int fd)
+{
+    if ( !s_ring_size or fd < 0 )
+        return nullptr;
+
+    AsyncWriter* w = new AsyncWriter(fd, s_ring_size);
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    s_writers.push_back(w);
+
+    return w;
+}
+
+void AsyncWriter::close(AsyncWriter* w)
+{
+    if ( !w )
+        return;
+
+    w->drain();
+
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+
+        if ( s_alive )
+            w->closing = true;
+        else
+        {
+            s_writers.erase(std::remove(s_writers.begin(), s_writers.end(), w), s_writers.end());
+            w->released = true;
+        }
+    }
+    s_cv.notify_one();
+
+    // the output thread may still be in a pass that includes w
+    while ( !w->released.load(std::memory_order_acquire) )
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+
+    if ( s_sync_interval )
+        fsync(w->fd);
+
+    delete w;
+}
+
+// records larger than the ring are copied in pieces as space frees up
+void AsyncWriter::write(const void* data, unsigned len)
+{
+    const uint8_t* buf = (const uint8_t*)data;
+    uint64_t h = head.load(std::memory_order_relaxed);
+    bool waited = false;
+
+    async_counts.records++;
+    async_counts.bytes += len;
+
+    while ( len )
+    {
+        unsigned avail = mask + 1 - (unsigned)(h - tail.load(std::memory_order_acquire));
+
+        if ( !avail )
+        {
+            if ( !waited )
+            {
+                async_counts.waits++;
+                waited = true;
+            }
+            wait();
+            continue;
+        }
+
+        unsigned off = h & mask;
+        unsigned n = std::min(len, std::min(avail, mask + 1 - off));
+
+        memcpy(ring + off, buf, n);
+        buf += n;
+        len -= n;
+        h += n;
+
+        head.store(h, std::memory_order_release);
+    }
+}
+
+void AsyncWriter::drain()
+{
+    while ( tail.load(std::memory_order_acquire) != head.load(std::memory_order_relaxed) )
+        wait();
+}
+
+// once the output thread has exited the owner writes its own data
+void AsyncWriter::wait()
+{
+    bool alive;
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        alive = s_alive;
+    }
+    if ( alive )
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    else
+        flush();
+}
+
+//-------------------------------------------------------------------------
+// output thread
+//-------------------------------------------------------------------------
+
+// call with s_mutex held; the output thread holds no writer from an
+// earlier pass at this point
+void AsyncWriter::release_closed()
+{
+    auto it = s_writers.begin();
+
+    while ( it != s_writers.end() )
+    {
+        AsyncWriter* w = *it;
+
+        if ( !w->closing )
+        {
+            ++it;
+            continue;
+        }
+        it = s_writers.erase(it);
+        w->released.store(true, std::memory_order_release);
+    }
+}
+
+void AsyncWriter::run()
+{
+    auto last_sync = std::chrono::steady_clock::now();
+    std::vector<AsyncWriter*> writers;
+
+    while ( s_running )
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_mutex);
+            release_closed();
+            writers = s_writers;
+        }
+
+        bool busy = false;
+
+        for ( auto w : writers )
+            busy = w->flush() or busy;
+
+        if ( s_sync_interval )
+        {
+            auto now = std::chrono::steady_clock::now();
+
+            if ( now - last_sync >= std::chrono::seconds(s_sync_interval) )
+            {
+                for ( auto w : writers )
+                    w->sync();
+
+                last_sync = now;
+            }
+        }
+
+        // records queued while idle wait at most this long
+        if ( !busy )
+        {
+            std::unique_lock<std::mutex> lock(s_mutex);
+            s_cv.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    release_closed();
+    s_alive = false;
+}
+
+// returns true if anything was queued
+bool AsyncWriter::flush()
+{
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    uint64_t h = head.load(std::memory_order_acquire);
+
+    if ( h == t )
+        return false;
+
+    unsigned n = h - t;
+    unsigned off = t & mask;
+    unsigned first = std::min(n, mask + 1 - off);
+
+    struct iovec iov[2];
+    iov[0].iov_base = ring + off;
+    iov[0].iov_len = first;
+    iov[1].iov_base = ring;
+    iov[1].iov_len = n - first;
+
+    ssize_t ret = writev(fd, iov, iov[1].iov_len ? 2 : 1);
+
+    if ( ret < 0 )
+    {
+        if ( errno == EINTR )
+            return true;
+
+        // discard rather than stall the packet thread
+        if ( !failed )
+        {
+            ErrorMessage("async output: can't write fd %d: %s; discarding\n",
+                fd, get_error(errno));
+            failed = true;
+        }
+        ret = n;
+    }
+    tail.store(t + ret, std::memory_order_release);
+    return true;
+}
+
+void AsyncWriter::sync()
+{
+    uint64_t t = tail.load(std::memory_order_relaxed);
+
+    if ( synced == t )
+        return;
+
+    fsync(fd);
+    synced = t;
+}
+
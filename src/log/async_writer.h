@@ -0,0 +1,100 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// async_writer.h
+
+#ifndef ASYNC_WRITER_H
+#define ASYNC_WRITER_H
+
+// AsyncWriter moves log file writes off the packet threads.  Each log file
+// a packet thread opens gets a single producer, single consumer byte ring.
+// The packet thread copies formatted records in and the output thread
+// writes whatever has accumulated with one writev() per file, fsyncing
+// each file periodically.  A packet thread waits only if its ring fills.
+//
+// open() returns nullptr unless output.async is enabled, so callers keep
+// their synchronous path and use the writer when they have one.  A writer
+// is opened and closed on the thread that writes to it; close() drains the
+// ring so the owner can roll or close the file afterwards.
+//
+// The output thread does its I/O on a copy of the writer list without
+// holding the list lock, so open() and close() never wait for writes to
+// other files.  close() marks the writer and waits at most for the output
+// thread to finish its current pass and release it.
+
+#include <atomic>
+#include <stdint.h>
+
+#include "framework/counts.h"
+#include "main/snort_types.h"
+#include "main/thread.h"
+
+struct AsyncCounts
+{
+    PegCount records;
+    PegCount bytes;
+    PegCount waits;
+};
+
+extern const PegInfo async_pegs[];
+extern THREAD_LOCAL AsyncCounts async_counts;
+
+class SO_PUBLIC AsyncWriter
+{
+public:
+    // main thread; ring size is rounded up to a power of 2
+    static void start(unsigned ring_size, unsigned sync_interval);
+    static void stop();
+
+    // writer's thread; the fd remains owned by the caller
+    static AsyncWriter* open(int fd);
+    static void close(AsyncWriter*);
+
+    void write(const void*, unsigned len);
+    void drain();
+
+private:
+    AsyncWriter(int fd, unsigned size);
+    ~AsyncWriter();
+
+    void wait();
+
+    // output thread
+    static void run();
+    static void release_closed();
+    bool flush();
+    void sync();
+
+private:
+    uint8_t* ring;
+    unsigned mask;
+    int fd;
+    bool failed;
+
+    // set by the owner after draining, acknowledged by the output thread
+    std::atomic<bool> closing;
+    std::atomic<bool> released;
+
+    // total bytes ever queued and written
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    uint64_t synced;
+};
+
+#endif
+
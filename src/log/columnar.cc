@@ -0,0 +1,190 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// columnar.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "columnar.h"
+
+#include <string.h>
+
+#ifdef HAVE_ZLIB_NG
+#include <zlib-ng.h>
+#define COMPRESS2 zng_compress2
+#define COMPRESS_BOUND zng_compressBound
+#define UNCOMPRESS zng_uncompress
+typedef size_t CompressLen;
+#else
+#include <zlib.h>
+#define COMPRESS2 compress2
+#define COMPRESS_BOUND compressBound
+#define UNCOMPRESS uncompress
+typedef uLongf CompressLen;
+#endif
+
+using namespace std;
+
+//-------------------------------------------------------------------------
+// writer
+//-------------------------------------------------------------------------
+
+bool ColumnarBlock::get_schema(
+    uint32_t type, const unsigned*& width, unsigned& num, unsigned& len_col)
+{
+    switch ( type )
+    {
+    case COLUMNAR_EVENTS:
+        width = columnar_event_width;
+        num = COLUMNAR_EVENT_MAX;
+        len_col = COLUMNAR_EVENT_PKT_LEN;
+        return true;
+
+    case COLUMNAR_EXTRA:
+        width = columnar_extra_width;
+        num = COLUMNAR_EXTRA_MAX;
+        len_col = COLUMNAR_EXTRA_LEN;
+        return true;
+    }
+    return false;
+}
+
+ColumnarBlock::ColumnarBlock(uint32_t t)
+{
+    unsigned num = 0, len_col;
+    get_schema(t, width, num, len_col);
+
+    cols.resize(num);
+    type = t;
+    rows = 0;
+    bytes = 0;
+}
+
+void ColumnarBlock::put(unsigned col, const void* data, unsigned len)
+{
+    const uint8_t* b = (const uint8_t*)data;
+    cols[col].insert(cols[col].end(), b, b + len);
+    bytes += len;
+}
+
+void ColumnarBlock::encode(vector<uint8_t>& out, bool deflate)
+{
+    raw.clear();
+
+    for ( auto& c : cols )
+    {
+        raw.insert(raw.end(), c.begin(), c.end());
+        c.clear();
+    }
+
+    uint32_t flags = 0;
+    CompressLen len = raw.size();
+
+    out.resize(COLUMNAR_HEADER_LEN + (deflate ? COMPRESS_BOUND(len) : len));
+    uint8_t* body = &out[COLUMNAR_HEADER_LEN];
+
+    // keep the raw body if deflate doesn't help
+    if ( deflate and COMPRESS2(body, &len, raw.data(), raw.size(), Z_BEST_SPEED) == Z_OK
+        and len < raw.size() )
+        flags |= COLUMNAR_FLAG_DEFLATE;
+    else
+    {
+        len = raw.size();
+        memcpy(body, raw.data(), len);
+    }
+
+    uint8_t* hdr = &out[0];
+    columnar_store(hdr, type, 4);
+    columnar_store(hdr + 4, flags, 4);
+    columnar_store(hdr + 8, rows, 4);
+    columnar_store(hdr + 12, len, 4);
+    columnar_store(hdr + 16, raw.size(), 4);
+
+    out.resize(COLUMNAR_HEADER_LEN + len);
+    rows = 0;
+    bytes = 0;
+}
+
+//-------------------------------------------------------------------------
+// reader
+//-------------------------------------------------------------------------
+
+void columnar_get_header(const uint8_t* hdr, ColumnarHeader& h)
+{
+    h.type = columnar_load(hdr, 4);
+    h.flags = columnar_load(hdr + 4, 4);
+    h.rows = columnar_load(hdr + 8, 4);
+    h.length = columnar_load(hdr + 12, 4);
+    h.raw_length = columnar_load(hdr + 16, 4);
+}
+
+const uint8_t* columnar_get_body(
+    const ColumnarHeader& h, const uint8_t* body, vector<uint8_t>& raw)
+{
+    if ( !(h.flags & COLUMNAR_FLAG_DEFLATE) )
+        return h.length == h.raw_length ? body : nullptr;
+
+    raw.resize(h.raw_length);
+    CompressLen out = h.raw_length;
+
+    if ( UNCOMPRESS(raw.data(), &out, body, h.length) != Z_OK or out != h.raw_length )
+        return nullptr;
+
+    return raw.data();
+}
+
+bool columnar_get_columns(
+    const ColumnarHeader& h, const uint8_t* raw, vector<const uint8_t*>& cols)
+{
+    const unsigned* width;
+    unsigned num, len_col;
+
+    if ( !ColumnarBlock::get_schema(h.type, width, num, len_col) )
+        return false;
+
+    const uint8_t* body = raw;
+    const uint8_t* end = raw + h.raw_length;
+    cols.clear();
+
+    for ( unsigned c = 0; c < num; ++c )
+    {
+        uint64_t bytes;
+
+        if ( width[c] )
+            bytes = (uint64_t)width[c] * h.rows;
+
+        else
+        {
+            // variable width data is the sum of the preceding length column
+            bytes = 0;
+            const uint8_t* p = cols[len_col];
+
+            for ( unsigned r = 0; r < h.rows; ++r )
+                bytes += columnar_load(p + r * width[len_col], width[len_col]);
+        }
+        if ( bytes > (uint64_t)(end - body) )
+            return false;
+
+        cols.push_back(body);
+        body += bytes;
+    }
+    return body == end;
+}
+
@@ -0,0 +1,192 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// columnar.h
+
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+// The alert_columnar file format, shared by the logger and tools/colspew.
+//
+// A file is COLUMNAR_MAGIC followed by blocks.  Each block holds up to a
+// configured number of rows of one record type stored column by column,
+// so like values are adjacent.  That keeps blocks small, and they compress
+// well when deflated.  There are no per-record headers.  Extra data rows
+// refer to their event by event id and second, just as in unified2.
+//
+// A block is a 20 byte header (type, flags, rows, length, raw length)
+// followed by length bytes of body.  If the deflate flag is set, the body
+// inflates to raw length bytes.  The raw body is each column in the order
+// of the enums below.  Fixed width columns take width * rows bytes.  A
+// variable width column is preceded by its length column and is the
+// concatenation of the rows' data.
+//
+// All integers are little endian.  Addresses are 16 bytes, with IPv4
+// stored as IPv4-mapped IPv6 (::ffff:a.b.c.d).
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "main/snort_types.h"
+
+#define COLUMNAR_MAGIC "SNCOLv1\n"
+#define COLUMNAR_MAGIC_LEN 8
+#define COLUMNAR_HEADER_LEN 20
+
+#define COLUMNAR_FLAG_DEFLATE 0x1
+
+enum ColumnarBlockType
+{
+    COLUMNAR_EVENTS = 1,
+    COLUMNAR_EXTRA = 2
+};
+
+enum ColumnarEventColumn
+{
+    COLUMNAR_EVENT_ID,
+    COLUMNAR_EVENT_SECOND,
+    COLUMNAR_EVENT_MICROSECOND,
+    COLUMNAR_EVENT_GID,
+    COLUMNAR_EVENT_SID,
+    COLUMNAR_EVENT_REV,
+    COLUMNAR_EVENT_CLASS,
+    COLUMNAR_EVENT_PRIORITY,
+    COLUMNAR_EVENT_SRC_ADDR,
+    COLUMNAR_EVENT_DST_ADDR,
+    COLUMNAR_EVENT_SRC_PORT,     // or icmp type
+    COLUMNAR_EVENT_DST_PORT,     // or icmp code
+    COLUMNAR_EVENT_PROTO,
+    COLUMNAR_EVENT_BLOCKED,      // as unified2: allow, can't, would, block
+    COLUMNAR_EVENT_VLAN,
+    COLUMNAR_EVENT_MPLS,
+    COLUMNAR_EVENT_LINKTYPE,
+    COLUMNAR_EVENT_PKT_LEN,
+    COLUMNAR_EVENT_PKT,          // 0 length unless the logger packet option is set
+    COLUMNAR_EVENT_MAX
+};
+
+enum ColumnarExtraColumn
+{
+    COLUMNAR_EXTRA_EVENT_ID,
+    COLUMNAR_EXTRA_EVENT_SECOND,
+    COLUMNAR_EXTRA_TYPE,         // EVENT_INFO_* from log/unified2.h
+    COLUMNAR_EXTRA_LEN,
+    COLUMNAR_EXTRA_DATA,
+    COLUMNAR_EXTRA_MAX
+};
+
+// bytes per row; 0 is variable width
+static const unsigned columnar_event_width[COLUMNAR_EVENT_MAX] =
+{ 4, 4, 4, 4, 4, 4, 4, 4, 16, 16, 2, 2, 1, 1, 2, 4, 4, 4, 0 };
+
+static const unsigned columnar_extra_width[COLUMNAR_EXTRA_MAX] =
+{ 4, 4, 4, 4, 0 };
+
+inline void columnar_store(uint8_t* p, uint64_t v, unsigned width)
+{
+    for ( unsigned i = 0; i < width; ++i )
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+inline uint64_t columnar_load(const uint8_t* p, unsigned width)
+{
+    uint64_t v = 0;
+
+    for ( unsigned i = 0; i < width; ++i )
+        v |= (uint64_t)p[i] << (8 * i);
+
+    return v;
+}
+
+// rows are appended column by column; encode() writes the block and clears it
+class SO_PUBLIC ColumnarBlock
+{
+public:
+    // false for unknown types
+    static bool get_schema(uint32_t type, const unsigned*& width, unsigned& num, unsigned& len_col);
+
+    ColumnarBlock(uint32_t type);
+
+    void put(unsigned col, uint64_t v)
+    {
+        std::vector<uint8_t>& c = cols[col];
+        size_t n = c.size();
+        c.resize(n + width[col]);
+        columnar_store(&c[n], v, width[col]);
+        bytes += width[col];
+    }
+
+    // returns a pointer to len bytes appended to col
+    uint8_t* extend(unsigned col, unsigned len)
+    {
+        std::vector<uint8_t>& c = cols[col];
+        size_t n = c.size();
+        c.resize(n + len);
+        bytes += len;
+        return &c[n];
+    }
+
+    void put(unsigned col, const void* data, unsigned len);
+
+    // call after the last column of each row
+    void end_row()
+    { ++rows; }
+
+    unsigned get_rows() const
+    { return rows; }
+
+    size_t get_bytes() const
+    { return bytes; }
+
+    // replaces out with header and body; the body is deflated only if
+    // requested and smaller
+    void encode(std::vector<uint8_t>& out, bool deflate);
+
+private:
+    std::vector<std::vector<uint8_t>> cols;
+    std::vector<uint8_t> raw;
+    const unsigned* width;
+    uint32_t type;
+    unsigned rows;
+    size_t bytes;
+};
+
+struct ColumnarHeader
+{
+    uint32_t type;
+    uint32_t flags;
+    uint32_t rows;
+    uint32_t length;
+    uint32_t raw_length;
+};
+
+// for readers; hdr is COLUMNAR_HEADER_LEN bytes
+SO_PUBLIC void columnar_get_header(const uint8_t* hdr, ColumnarHeader&);
+
+// returns the raw body, inflated into raw if needed, or nullptr if invalid
+SO_PUBLIC const uint8_t* columnar_get_body(
+    const ColumnarHeader&, const uint8_t* body, std::vector<uint8_t>& raw);
+
+// points cols at the start of each column of a raw body; false unless the
+// block type is known and its columns exactly fill raw_length bytes
+SO_PUBLIC bool columnar_get_columns(
+    const ColumnarHeader&, const uint8_t* raw, std::vector<const uint8_t*>& cols);
+
+#endif
+
@@ -0,0 +1,331 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// async_writer_test.cc
+
+#include "../async_writer.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+// Stubs whose sole purpose is to make the test code link
+void ErrorMessage(const char*, ...) { }
+const char* get_error(int) { return ""; }
+
+static std::string read_file(FILE* f)
+{
+    std::string s;
+    char buf[4096];
+    size_t n;
+
+    rewind(f);
+
+    while ( (n = fread(buf, 1, sizeof(buf), f)) > 0 )
+        s.append(buf, n);
+
+    return s;
+}
+
+// deterministic records of varying length, some longer than the ring
+static std::string make_records(unsigned count)
+{
+    std::string all;
+
+    for ( unsigned i = 0; i < count; i++ )
+    {
+        std::string rec(1 + (i * 7919) % 9000, 'a' + i % 26);
+        rec += '\n';
+        all += rec;
+    }
+    return all;
+}
+
+// fill the pipe and return the bytes written
+static size_t fill_pipe(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+    char buf[4096];
+    memset(buf, 'p', sizeof(buf));
+
+    size_t total = 0;
+    ssize_t n;
+
+    while ( (n = ::write(fd, buf, sizeof(buf))) > 0 )
+        total += n;
+
+    fcntl(fd, F_SETFL, flags);
+    return total;
+}
+
+static void read_pipe(int fd, size_t len)
+{
+    char buf[4096];
+
+    while ( len )
+    {
+        ssize_t n = read(fd, buf, std::min(len, sizeof(buf)));
+
+        if ( n <= 0 )
+            break;
+
+        len -= n;
+    }
+}
+
+static bool writable(int fd)
+{
+    struct pollfd pfd = { fd, POLLOUT, 0 };
+    return poll(&pfd, 1, 0) > 0 and (pfd.revents & POLLOUT);
+}
+
+// a regression hangs rather than fails, so the tests wait this long for
+// a step that must not depend on the output thread before giving up; it
+// is a watchdog, not a measure of how long the step took
+static const auto s_watchdog = std::chrono::seconds(10);
+
+TEST_GROUP(async_writer)
+{
+    void teardown() override
+    {
+        AsyncWriter::stop();
+    }
+};
+
+TEST(async_writer, not_started)
+{
+    FILE* f = tmpfile();
+    CHECK(AsyncWriter::open(fileno(f)) == nullptr);
+    fclose(f);
+}
+
+TEST(async_writer, in_order)
+{
+    const unsigned ring_size = 4096;
+    AsyncWriter::start(ring_size, 0);
+
+    FILE* f = tmpfile();
+    AsyncWriter* w = AsyncWriter::open(fileno(f));
+    CHECK(w != nullptr);
+
+    const AsyncCounts before = async_counts;
+    const std::string expected = make_records(200);
+
+    size_t pos = 0;
+    unsigned oversize = 0;
+
+    for ( unsigned i = 0; i < 200; i++ )
+    {
+        size_t end = expected.find('\n', pos) + 1;
+
+        // a record longer than the ring can't be queued without waiting
+        if ( end - pos > ring_size )
+            oversize++;
+
+        w->write(expected.data() + pos, end - pos);
+        pos = end;
+    }
+    AsyncWriter::close(w);
+
+    CHECK(oversize > 0);
+    CHECK(read_file(f) == expected);
+    CHECK(async_counts.records == before.records + 200);
+    CHECK(async_counts.bytes == before.bytes + expected.size());
+    CHECK(async_counts.waits >= before.waits + oversize);
+
+    fclose(f);
+}
+
+TEST(async_writer, after_stop)
+{
+    AsyncWriter::start(4096, 1);
+
+    FILE* f = tmpfile();
+    AsyncWriter* w = AsyncWriter::open(fileno(f));
+    CHECK(w != nullptr);
+
+    AsyncWriter::stop();
+    CHECK(AsyncWriter::open(fileno(f)) == nullptr);
+
+    // the owner writes its own data once the output thread is gone
+    std::string data(10000, 'x');
+    w->write(data.data(), data.size());
+    AsyncWriter::close(w);
+
+    CHECK(read_file(f) == data);
+    fclose(f);
+}
+
+// busy writers keep the output thread from going idle until they are
+// told to stop; opening and closing another writer must not wait for that
+TEST(async_writer, close_while_busy)
+{
+    AsyncWriter::start(65536, 1);
+
+    // the busy writers share a pipe drained slower than they fill their
+    // rings, so the output thread always finds something to write
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    std::thread reader([&fds]()
+    {
+        char buf[512];
+
+        while ( read(fds[0], buf, sizeof(buf)) > 0 )
+            ;
+    });
+
+    const unsigned num_busy = 4;
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> queued(0);
+    std::vector<std::thread> producers;
+
+    for ( unsigned i = 0; i < num_busy; i++ )
+    {
+        producers.emplace_back([&fds, &done, &queued]()
+        {
+            AsyncWriter* w = AsyncWriter::open(fds[1]);
+            std::string data(512, 'x');
+
+            while ( !done )
+            {
+                w->write(data.data(), data.size());
+                queued += data.size();
+            }
+            AsyncWriter::close(w);
+        });
+    }
+
+    // more than the rings hold, so the output thread has been writing
+    while ( queued < 2 * num_busy * 65536 )
+        std::this_thread::yield();
+
+    // checks are made on this thread; the roller just counts good rolls
+    auto rolled = std::async(std::launch::async, []()
+    {
+        unsigned good = 0;
+
+        for ( unsigned i = 0; i < 20; i++ )
+        {
+            FILE* f = tmpfile();
+            AsyncWriter* w = AsyncWriter::open(fileno(f));
+
+            if ( w )
+            {
+                w->write("roll\n", 5);
+                AsyncWriter::close(w);
+            }
+            if ( read_file(f) == "roll\n" )
+                good++;
+
+            fclose(f);
+        }
+        return good;
+    });
+
+    // the producers run until told to stop, so a close that waited for
+    // the output thread to go idle isn't ready
+    bool ready = rolled.wait_for(s_watchdog) == std::future_status::ready;
+
+    done = true;
+
+    for ( auto& t : producers )
+        t.join();
+
+    ::close(fds[1]);
+    reader.join();
+    ::close(fds[0]);
+
+    CHECK(ready);
+    CHECK(rolled.get() == 20);
+}
+
+// the output thread is stuck writing to a full pipe; that must not hold
+// up opening another file
+TEST(async_writer, open_while_blocked)
+{
+    AsyncWriter::start(65536, 0);
+
+    int fds[2];
+    CHECK(pipe(fds) == 0);
+
+    // leave room for one write so the output thread's write shows up
+    size_t pending = fill_pipe(fds[1]);
+    read_pipe(fds[0], 4096);
+    pending -= 4096;
+    CHECK(writable(fds[1]));
+
+    AsyncWriter* blocked = AsyncWriter::open(fds[1]);
+    CHECK(blocked != nullptr);
+
+    // more than the room left, so the write can't complete until read
+    const std::string data(4 * 4096, 'x');
+    blocked->write(data.data(), data.size());
+    pending += data.size();
+
+    // the pipe fills only from the output thread's write of this data
+    while ( writable(fds[1]) )
+        std::this_thread::yield();
+
+    FILE* f = tmpfile();
+
+    auto opened = std::async(std::launch::async, [f]()
+    { return AsyncWriter::open(fileno(f)); });
+
+    bool ready = opened.wait_for(s_watchdog) == std::future_status::ready;
+
+    // unblock the output thread either way so a regression fails
+    read_pipe(fds[0], pending);
+    AsyncWriter::close(blocked);
+
+    CHECK(ready);
+
+    // handed over by the future; the writer is used by one thread at a time
+    AsyncWriter* w = opened.get();
+    CHECK(w != nullptr);
+
+    w->write("roll\n", 5);
+    AsyncWriter::close(w);
+    CHECK(read_file(f) == "roll\n");
+
+    fclose(f);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
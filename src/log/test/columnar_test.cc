@@ -0,0 +1,229 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// columnar_test.cc
+
+#include "../columnar.h"
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace std;
+
+// rows of increasing id with packets of the given lengths
+static void add_events(ColumnarBlock& b, const vector<unsigned>& lens)
+{
+    for ( unsigned i = 0; i < lens.size(); ++i )
+    {
+        for ( unsigned c = 0; c < COLUMNAR_EVENT_MAX; ++c )
+        {
+            if ( c == COLUMNAR_EVENT_PKT_LEN )
+                b.put(c, lens[i]);
+
+            else if ( c == COLUMNAR_EVENT_PKT )
+                memset(b.extend(c, lens[i]), 'a' + i, lens[i]);
+
+            else if ( columnar_event_width[c] == 16 )
+                memset(b.extend(c, 16), i, 16);
+
+            else
+                b.put(c, 100 * i + c);
+        }
+        b.end_row();
+    }
+}
+
+// decode a block written by encode() and check every row
+static void check_events(const vector<uint8_t>& out, const vector<unsigned>& lens, bool deflated)
+{
+    ColumnarHeader hdr;
+    columnar_get_header(out.data(), hdr);
+
+    CHECK(hdr.type == COLUMNAR_EVENTS);
+    CHECK(hdr.rows == lens.size());
+    CHECK(hdr.length == out.size() - COLUMNAR_HEADER_LEN);
+    CHECK(((hdr.flags & COLUMNAR_FLAG_DEFLATE) != 0) == deflated);
+
+    if ( deflated )
+        CHECK(hdr.length < hdr.raw_length);
+    else
+        CHECK(hdr.length == hdr.raw_length);
+
+    vector<uint8_t> raw;
+    const uint8_t* body = columnar_get_body(hdr, out.data() + COLUMNAR_HEADER_LEN, raw);
+    CHECK(body != nullptr);
+
+    vector<const uint8_t*> cols;
+    CHECK(columnar_get_columns(hdr, body, cols));
+    CHECK(cols.size() == COLUMNAR_EVENT_MAX);
+
+    for ( unsigned i = 0; i < lens.size(); ++i )
+    {
+        for ( unsigned c = 0; c < COLUMNAR_EVENT_MAX; ++c )
+        {
+            unsigned w = columnar_event_width[c];
+
+            if ( c == COLUMNAR_EVENT_PKT )
+            {
+                CHECK(string((const char*)cols[c], lens[i]) == string(lens[i], 'a' + i));
+                cols[c] += lens[i];
+                continue;
+            }
+            if ( w == 16 )
+                CHECK(cols[c][0] == i and cols[c][15] == i);
+
+            else if ( c == COLUMNAR_EVENT_PKT_LEN )
+                CHECK(columnar_load(cols[c], w) == lens[i]);
+
+            else
+            {
+                uint64_t mask = w < 8 ? (1ull << (8 * w)) - 1 : ~0ull;
+                CHECK(columnar_load(cols[c], w) == ((100 * i + c) & mask));
+            }
+            cols[c] += w;
+        }
+    }
+}
+
+TEST_GROUP(columnar) { };
+
+TEST(columnar, store_load)
+{
+    uint8_t buf[4];
+    columnar_store(buf, 0x01020304, 4);
+    CHECK(buf[0] == 4 and buf[3] == 1);
+    CHECK(columnar_load(buf, 4) == 0x01020304);
+    CHECK(columnar_load(buf, 2) == 0x0304);
+}
+
+TEST(columnar, raw_round_trip)
+{
+    const vector<unsigned> lens = { 0, 5, 300, 0, 1 };
+    ColumnarBlock b(COLUMNAR_EVENTS);
+    add_events(b, lens);
+    CHECK(b.get_rows() == lens.size());
+
+    vector<uint8_t> out;
+    b.encode(out, false);
+    CHECK(b.get_rows() == 0);
+    CHECK(b.get_bytes() == 0);
+
+    check_events(out, lens, false);
+
+    // the cleared block encodes only what is added next
+    add_events(b, { 7 });
+    b.encode(out, false);
+    check_events(out, { 7 }, false);
+}
+
+TEST(columnar, deflate_round_trip)
+{
+    const vector<unsigned> lens = { 1000, 0, 2000, 3 };
+    ColumnarBlock b(COLUMNAR_EVENTS);
+    add_events(b, lens);
+
+    vector<uint8_t> out;
+    b.encode(out, true);
+    check_events(out, lens, true);
+}
+
+TEST(columnar, deflate_not_smaller)
+{
+    ColumnarBlock b(COLUMNAR_EXTRA);
+    b.put(COLUMNAR_EXTRA_EVENT_ID, 1);
+    b.put(COLUMNAR_EXTRA_EVENT_SECOND, 2);
+    b.put(COLUMNAR_EXTRA_TYPE, 3);
+    b.put(COLUMNAR_EXTRA_LEN, 1);
+    b.put(COLUMNAR_EXTRA_DATA, "x", 1);
+    b.end_row();
+
+    vector<uint8_t> out;
+    b.encode(out, true);
+
+    ColumnarHeader hdr;
+    columnar_get_header(out.data(), hdr);
+    CHECK(hdr.type == COLUMNAR_EXTRA);
+    CHECK(!(hdr.flags & COLUMNAR_FLAG_DEFLATE));
+    CHECK(hdr.raw_length == 4 * 4 + 1);
+
+    vector<uint8_t> raw;
+    const uint8_t* body = columnar_get_body(hdr, out.data() + COLUMNAR_HEADER_LEN, raw);
+    vector<const uint8_t*> cols;
+    CHECK(body and columnar_get_columns(hdr, body, cols));
+    CHECK(columnar_load(cols[COLUMNAR_EXTRA_TYPE], 4) == 3);
+    CHECK(cols[COLUMNAR_EXTRA_DATA][0] == 'x');
+}
+
+TEST(columnar, invalid)
+{
+    ColumnarBlock b(COLUMNAR_EVENTS);
+    add_events(b, { 2000, 10 });
+
+    vector<uint8_t> out, raw;
+    vector<const uint8_t*> cols;
+    b.encode(out, true);
+
+    ColumnarHeader hdr;
+    columnar_get_header(out.data(), hdr);
+    const uint8_t* body = out.data() + COLUMNAR_HEADER_LEN;
+
+    // corrupt deflate data
+    vector<uint8_t> bad(out.begin() + COLUMNAR_HEADER_LEN, out.end());
+    bad[bad.size() / 2] ^= 0xff;
+    bad[bad.size() - 1] ^= 0xff;
+    CHECK(columnar_get_body(hdr, bad.data(), raw) == nullptr);
+
+    // wrong raw length
+    ColumnarHeader h = hdr;
+    h.raw_length++;
+    CHECK(columnar_get_body(h, body, raw) == nullptr);
+
+    h = hdr;
+    h.flags = 0;
+    CHECK(columnar_get_body(h, body, raw) == nullptr);
+
+    const uint8_t* data = columnar_get_body(hdr, body, raw);
+    CHECK(data != nullptr);
+
+    // row count doesn't match the columns
+    h = hdr;
+    h.rows++;
+    CHECK(!columnar_get_columns(h, data, cols));
+
+    h = hdr;
+    h.rows--;
+    CHECK(!columnar_get_columns(h, data, cols));
+
+    // unknown block type
+    h = hdr;
+    h.type = 99;
+    CHECK(!columnar_get_columns(h, data, cols));
+
+    CHECK(columnar_get_columns(hdr, data, cols));
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
@@ -33,6 +33,7 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#include "async_writer.h"
 #include "log.h"
 #include "main/snort_types.h"
 #include "utils/util.h"
@@ -46,6 +47,7 @@ struct TextLog
 /* private:
    file attributes: */
     FILE* file;
+    AsyncWriter* async;
     char* name;
     size_t size;
     size_t maxFile;
@@ -69,6 +71,14 @@ static FILE* TextLog_Open(const char* name)
     return OpenAlertFile(name);
 }
 
+static AsyncWriter* TextLog_Async(FILE* file)
+{
+    if ( !file or file == stdout )
+        return nullptr;
+
+    return AsyncWriter::open(fileno(file));
+}
+
 static void TextLog_Close(FILE* file)
 {
     if ( !file )
@@ -122,6 +132,7 @@ TextLog* TextLog_Init(
 
     txt->name = name ? snort_strdup(name) : NULL;
     txt->file = TextLog_Open(txt->name);
+    txt->async = TextLog_Async(txt->file);
     txt->size = TextLog_Size(txt->file);
     txt->last = time(NULL);
     txt->maxFile = maxFile;
@@ -142,6 +153,7 @@ void TextLog_Term(TextLog* const txt)
         return;
 
     TextLog_Flush(txt);
+    AsyncWriter::close(txt->async);
     TextLog_Close(txt->file);
 
     if ( txt->name )
@@ -162,9 +174,11 @@ static void TextLog_Roll(TextLog* const txt)
     if ( txt->last >= time(NULL) )
         return;
 
+    AsyncWriter::close(txt->async);
     TextLog_Close(txt->file);
     RollAlertFile(txt->name);
     txt->file = TextLog_Open(txt->name);
+    txt->async = TextLog_Async(txt->file);
 
     txt->last = time(NULL);
     txt->size = 0;
@@ -183,7 +197,13 @@ bool TextLog_Flush(TextLog* const txt)
     if ( txt->size + txt->pos > txt->maxFile )
         TextLog_Roll(txt);
 
-    ok = fwrite(txt->buf, txt->pos, 1, txt->file);
+    if ( txt->async )
+    {
+        txt->async->write(txt->buf, txt->pos);
+        ok = 1;
+    }
+    else
+        ok = fwrite(txt->buf, txt->pos, 1, txt->file);
 
     if ( ok == 1 )
     {
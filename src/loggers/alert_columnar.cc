@@ -0,0 +1,525 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// alert_columnar.cc
+
+// alert_columnar writes events and extra data in the block format of
+// log/columnar.h.  Rows are buffered per packet thread and written a block
+// at a time, optionally deflated, through the async output thread when
+// output.async is enabled.  A partial block is written by the next alert
+// or tick after max_delay.  Use colspew to read the files.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "detection/signature.h"
+#include "events/event.h"
+#include "framework/logger.h"
+#include "framework/module.h"
+#include "log/async_writer.h"
+#include "log/columnar.h"
+#include "log/messages.h"
+#include "log/obfuscator.h"
+#include "main/snort_config.h"
+#include "main/thread.h"
+#include "packet_io/active.h"
+#include "packet_io/sfdaq.h"
+#include "protocols/layer.h"
+#include "protocols/packet.h"
+#include "protocols/vlan.h"
+#include "protocols/icmp4.h"
+#include "stream/stream.h"
+#include "utils/util.h"
+
+using namespace std;
+
+#define S_NAME "alert_columnar"
+#define F_NAME S_NAME ".log"
+
+//-------------------------------------------------------------------------
+// module stuff
+//-------------------------------------------------------------------------
+
+static const Parameter s_params[] =
+{
+    { "rows", Parameter::PT_INT, "1:65535", "1024",
+      "maximum rows per block" },
+
+    { "max_delay", Parameter::PT_INT, "0:", "1",
+      "seconds before a partial block is written (0 means only when full)" },
+
+    { "compress", Parameter::PT_BOOL, nullptr, "false",
+      "deflate each block" },
+
+    { "packet", Parameter::PT_BOOL, nullptr, "false",
+      "include the packet with each event" },
+
+    { "limit", Parameter::PT_INT, "0:", "0",
+      "set limit (0 is unlimited)" },
+
+    { "units", Parameter::PT_ENUM, "B | K | M | G", "B",
+      "bytes | KB | MB | GB" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
+#define s_help \
+    "output events and extra data in compact binary blocks"
+
+class ColumnarModule : public Module
+{
+public:
+    ColumnarModule() : Module(S_NAME, s_help, s_params) { }
+
+    bool set(const char*, Value&, SnortConfig*) override;
+    bool begin(const char*, int, SnortConfig*) override;
+    bool end(const char*, int, SnortConfig*) override;
+
+public:
+    unsigned rows;
+    unsigned max_delay;
+    bool compress;
+    bool packet;
+    unsigned long limit;
+    unsigned units;
+};
+
+bool ColumnarModule::set(const char*, Value& v, SnortConfig*)
+{
+    if ( v.is("rows") )
+        rows = v.get_long();
+
+    else if ( v.is("max_delay") )
+        max_delay = v.get_long();
+
+    else if ( v.is("compress") )
+        compress = v.get_bool();
+
+    else if ( v.is("packet") )
+        packet = v.get_bool();
+
+    else if ( v.is("limit") )
+        limit = v.get_long();
+
+    else if ( v.is("units") )
+        units = v.get_long();
+
+    else
+        return false;
+
+    return true;
+}
+
+bool ColumnarModule::begin(const char*, int, SnortConfig*)
+{
+    rows = 1024;
+    max_delay = 1;
+    compress = false;
+    packet = false;
+    limit = 0;
+    units = 0;
+    return true;
+}
+
+bool ColumnarModule::end(const char*, int, SnortConfig*)
+{
+    while ( units-- )
+        limit *= 1024;
+
+    return true;
+}
+
+//-------------------------------------------------------------------------
+// block stuff
+//-------------------------------------------------------------------------
+
+// large blocks are written early so packet columns can't grow unbounded
+#define MAX_BLOCK (4 * 1024 * 1024)
+
+struct ColumnarLog
+{
+    ColumnarLog() :
+        events(COLUMNAR_EVENTS), extra(COLUMNAR_EXTRA)
+    { file = nullptr; async = nullptr; size = 0; oldest = 0; }
+
+    string name;
+    FILE* file;
+    AsyncWriter* async;
+    uint64_t size;
+    time_t oldest;   // when the first buffered row was added
+
+    ColumnarBlock events;
+    ColumnarBlock extra;
+
+    vector<uint8_t> out;
+};
+
+static THREAD_LOCAL ColumnarLog* s_log = nullptr;
+
+static void write_out(ColumnarLog* log, const uint8_t* data, size_t len)
+{
+    if ( log->async )
+        log->async->write(data, len);
+
+    else if ( fwrite(data, len, 1, log->file) != 1 or fflush(log->file) )
+        ErrorMessage("%s: can't write %s: %s\n", S_NAME, log->name.c_str(), get_error(errno));
+
+    log->size += len;
+}
+
+static void open_file(ColumnarLog* log)
+{
+    log->file = fopen(log->name.c_str(), "ab");
+
+    if ( !log->file )
+        FatalError("%s: can't open %s: %s\n", S_NAME, log->name.c_str(), get_error(errno));
+
+    struct stat sb;
+    log->size = fstat(fileno(log->file), &sb) ? 0 : sb.st_size;
+    log->async = AsyncWriter::open(fileno(log->file));
+
+    if ( !log->size )
+        write_out(log, (const uint8_t*)COLUMNAR_MAGIC, COLUMNAR_MAGIC_LEN);
+}
+
+static void close_file(ColumnarLog* log)
+{
+    AsyncWriter::close(log->async);
+    log->async = nullptr;
+
+    fclose(log->file);
+    log->file = nullptr;
+}
+
+// start a new file, keeping the old one with a timestamp suffix
+static void roll_file(ColumnarLog* log)
+{
+    close_file(log);
+
+    string old = log->name + "." + to_string((unsigned long)time(nullptr));
+
+    if ( rename(log->name.c_str(), old.c_str()) )
+        ErrorMessage("%s: can't rename %s: %s\n", S_NAME, log->name.c_str(), get_error(errno));
+
+    open_file(log);
+}
+
+static void flush_block(ColumnarLog* log, ColumnarBlock& block, bool compress, uint64_t limit)
+{
+    if ( !block.get_rows() )
+        return;
+
+    block.encode(log->out, compress);
+
+    if ( limit and log->size > COLUMNAR_MAGIC_LEN and log->size + log->out.size() > limit )
+        roll_file(log);
+
+    write_out(log, log->out.data(), log->out.size());
+}
+
+static void put_addr(ColumnarBlock& block, unsigned col, const sfip_t* ip)
+{
+    uint8_t* a = block.extend(col, 16);
+    memset(a, 0, 16);
+
+    if ( !ip )
+        return;
+
+    if ( ip->is_ip6() )
+        memcpy(a, ip->ip8, 16);
+
+    else if ( ip->is_ip4() )
+    {
+        a[10] = a[11] = 0xff;
+        memcpy(a + 12, ip->ip8, 4);
+    }
+}
+
+static const uint8_t s_blocked[] =
+{
+    0,  // allow
+    3,  // can't
+    2,  // would
+    1,  // block
+};
+
+//-------------------------------------------------------------------------
+// logger stuff
+//-------------------------------------------------------------------------
+
+class ColumnarLogger : public Logger
+{
+public:
+    ColumnarLogger(ColumnarModule*);
+
+    void open() override;
+    void close() override;
+
+    void alert(Packet*, const char* msg, Event*) override;
+    void tick() override;
+
+private:
+    void add_event(Packet*, Event*);
+    void add_extra(Packet*, Event*);
+    void flush();
+
+private:
+    unsigned rows;
+    unsigned max_delay;
+    bool compress;
+    bool packet;
+    uint64_t limit;
+};
+
+ColumnarLogger::ColumnarLogger(ColumnarModule* m)
+{
+    rows = m->rows;
+    max_delay = m->max_delay;
+    compress = m->compress;
+    packet = m->packet;
+    limit = m->limit;
+}
+
+void ColumnarLogger::open()
+{
+    s_log = new ColumnarLog;
+    get_instance_file(s_log->name, F_NAME);
+    open_file(s_log);
+}
+
+void ColumnarLogger::close()
+{
+    if ( !s_log )
+        return;
+
+    flush();
+    close_file(s_log);
+
+    delete s_log;
+    s_log = nullptr;
+}
+
+void ColumnarLogger::flush()
+{
+    flush_block(s_log, s_log->events, compress, limit);
+    flush_block(s_log, s_log->extra, compress, limit);
+}
+
+void ColumnarLogger::add_event(Packet* p, Event* event)
+{
+    ColumnarBlock& b = s_log->events;
+
+    b.put(COLUMNAR_EVENT_ID, event->event_id);
+    b.put(COLUMNAR_EVENT_SECOND, event->ref_time.tv_sec);
+    b.put(COLUMNAR_EVENT_MICROSECOND, event->ref_time.tv_usec);
+    b.put(COLUMNAR_EVENT_GID, event->sig_info->generator);
+    b.put(COLUMNAR_EVENT_SID, event->sig_info->id);
+    b.put(COLUMNAR_EVENT_REV, event->sig_info->rev);
+    b.put(COLUMNAR_EVENT_CLASS, event->sig_info->class_id);
+    b.put(COLUMNAR_EVENT_PRIORITY, event->sig_info->priority);
+
+    uint16_t sport = 0, dport = 0;
+    uint8_t proto = 0;
+    uint16_t vlan = 0;
+    uint32_t mpls = 0;
+
+    if ( p->has_ip() )
+    {
+        put_addr(b, COLUMNAR_EVENT_SRC_ADDR, p->ptrs.ip_api.get_src());
+        put_addr(b, COLUMNAR_EVENT_DST_ADDR, p->ptrs.ip_api.get_dst());
+
+        if ( p->is_portscan() )
+            proto = (uint8_t)p->ps_proto;
+
+        else
+        {
+            proto = (uint8_t)p->get_ip_proto_next();
+
+            if ( p->type() == PktType::ICMP )
+            {
+                sport = p->ptrs.icmph->type;
+                dport = p->ptrs.icmph->code;
+            }
+            else
+            {
+                sport = p->ptrs.sp;
+                dport = p->ptrs.dp;
+            }
+        }
+        if ( p->proto_bits & PROTO_BIT__MPLS )
+            mpls = p->ptrs.mplsHdr.label;
+
+        if ( p->proto_bits & PROTO_BIT__VLAN )
+            vlan = layer::get_vlan_layer(p)->vid();
+    }
+    else
+    {
+        put_addr(b, COLUMNAR_EVENT_SRC_ADDR, nullptr);
+        put_addr(b, COLUMNAR_EVENT_DST_ADDR, nullptr);
+    }
+
+    b.put(COLUMNAR_EVENT_SRC_PORT, sport);
+    b.put(COLUMNAR_EVENT_DST_PORT, dport);
+    b.put(COLUMNAR_EVENT_PROTO, proto);
+    b.put(COLUMNAR_EVENT_BLOCKED, s_blocked[Active::get_status()]);
+    b.put(COLUMNAR_EVENT_VLAN, vlan);
+    b.put(COLUMNAR_EVENT_MPLS, mpls);
+    b.put(COLUMNAR_EVENT_LINKTYPE, SFDAQ::get_base_protocol());
+
+    // rebuilt packets are not logged, as with unified2
+    unsigned len = 0;
+
+    if ( packet and p->pkth and !(p->packet_flags & PKT_REBUILT_STREAM) )
+        len = p->pkth->caplen;
+
+    b.put(COLUMNAR_EVENT_PKT_LEN, len);
+
+    if ( len )
+    {
+        uint8_t* start = b.extend(COLUMNAR_EVENT_PKT, len);
+        memcpy(start, p->is_data() ? p->data : p->pkt, len);
+
+        if ( p->obfuscator )
+        {
+            off_t off = p->is_data() ? 0 : p->data - p->pkt;
+
+            for ( const auto& ob : *p->obfuscator )
+                memset(&start[off + ob.offset], p->obfuscator->get_mask_char(), ob.length);
+        }
+    }
+    b.end_row();
+}
+
+// extra data logged later by stream is written by the logger registered
+// with Stream::reg_xtra_data_log(), ie unified2
+void ColumnarLogger::add_extra(Packet* p, Event* event)
+{
+    LogFunction* log_funcs;
+    uint32_t max_count = Stream::get_xtra_data_map(&log_funcs);
+    uint32_t mask = p->xtradata_mask;
+    uint32_t xid = ffs(mask);
+
+    ColumnarBlock& b = s_log->extra;
+
+    while ( xid && (xid <= max_count) )
+    {
+        uint32_t len = 0;
+        uint32_t type = 0;
+        uint8_t* buf;
+
+        if ( log_funcs[xid-1](p->flow, &buf, &len, &type) && (len > 0) )
+        {
+            b.put(COLUMNAR_EXTRA_EVENT_ID, event->event_id);
+            b.put(COLUMNAR_EXTRA_EVENT_SECOND, event->ref_time.tv_sec);
+            b.put(COLUMNAR_EXTRA_TYPE, type);
+            b.put(COLUMNAR_EXTRA_LEN, len);
+            b.put(COLUMNAR_EXTRA_DATA, buf, len);
+            b.end_row();
+        }
+        mask ^= BIT(xid);
+        xid = ffs(mask);
+    }
+}
+
+void ColumnarLogger::alert(Packet* p, const char*, Event* event)
+{
+    if ( !event or !event->sig_info )
+        return;
+
+    time_t now = time(nullptr);
+
+    if ( !s_log->events.get_rows() and !s_log->extra.get_rows() )
+        s_log->oldest = now;
+
+    add_event(p, event);
+
+    if ( p->xtradata_mask )
+        add_extra(p, event);
+
+    if ( s_log->events.get_rows() >= rows or s_log->extra.get_rows() >= rows or
+        s_log->events.get_bytes() + s_log->extra.get_bytes() >= MAX_BLOCK or
+        (max_delay and now - s_log->oldest >= (time_t)max_delay) )
+        flush();
+}
+
+// partial blocks are written here when no further alerts arrive
+void ColumnarLogger::tick()
+{
+    if ( !s_log or !max_delay or (!s_log->events.get_rows() and !s_log->extra.get_rows()) )
+        return;
+
+    if ( time(nullptr) - s_log->oldest >= (time_t)max_delay )
+        flush();
+}
+
+//-------------------------------------------------------------------------
+// api stuff
+//-------------------------------------------------------------------------
+
+static Module* mod_ctor()
+{ return new ColumnarModule; }
+
+static void mod_dtor(Module* m)
+{ delete m; }
+
+static Logger* col_ctor(SnortConfig*, Module* mod)
+{ return new ColumnarLogger((ColumnarModule*)mod); }
+
+static void col_dtor(Logger* p)
+{ delete p; }
+
+static LogApi col_api
+{
+    {
+        PT_LOGGER,
+        sizeof(LogApi),
+        LOGAPI_VERSION,
+        0,
+        API_RESERVED,
+        API_OPTIONS,
+        S_NAME,
+        s_help,
+        mod_ctor,
+        mod_dtor
+    },
+    OUTPUT_TYPE_FLAG__ALERT,
+    col_ctor,
+    col_dtor
+};
+
+#ifdef BUILDING_SO
+SO_PUBLIC const BaseApi* snort_plugins[] =
+{
+    &col_api.base,
+    nullptr
+};
+#else
+const BaseApi* alert_columnar = &col_api.base;
+#endif
+
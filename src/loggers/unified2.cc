@@ -52,6 +52,7 @@
 #include "detection/detect.h"
 #include "parser/parser.h"
 #include "events/event.h"
+#include "log/async_writer.h"
 #include "log/messages.h"
 #include "log/obfuscator.h"
 #include "packet_io/active.h"
@@ -91,6 +92,7 @@ struct U2
     uint32_t timestamp;
     char filepath[STD_BUF];
     FILE* stream;
+    AsyncWriter* writer;
     unsigned int current;
 };
 
@@ -225,10 +227,14 @@ static void Unified2InitFile(Unified2Config* config)
                 __FILE__, __LINE__, fname_ptr, get_error(errno));
         }
     }
+    else
+        u2.writer = AsyncWriter::open(fileno(u2.stream));
 }
 
 static inline void Unified2RotateFile(Unified2Config* config)
 {
+    AsyncWriter::close(u2.writer);
+    u2.writer = nullptr;
     fclose(u2.stream);
     u2.current = 0;
     Unified2InitFile(config);
@@ -582,6 +588,9 @@ static void _Unified2LogPacketAlert(
  * added to the current amount of total data written thus far to the
  * unified2 file.
  *
+ * With output.async, the record is instead queued for the output thread,
+ * which reports write errors and discards what it can't write.
+ *
  * Arguments
  *  uint8_t *
  *      The buffer containing the data to write
@@ -602,6 +611,13 @@ static void Unified2Write(uint8_t* buf, uint32_t buf_len, Unified2Config* config
     if ((buf == NULL) || (config == NULL) || (u2.stream == NULL))
         return;
 
+    if ( u2.writer )
+    {
+        u2.writer->write(buf, buf_len);
+        u2.current += buf_len;
+        return;
+    }
+
     /* Don't use fsync().  It is a total performance killer */
     if (((fwcount = fwrite(buf, (size_t)buf_len, 1, u2.stream)) != 1) ||
         ((ffstatus = fflush(u2.stream)) != 0))
@@ -884,6 +900,9 @@ void U2Logger::open()
 
 void U2Logger::close()
 {
+    AsyncWriter::close(u2.writer);
+    u2.writer = nullptr;
+
     if ( u2.stream )
         fclose(u2.stream);
 }
@@ -60,6 +60,7 @@
 #include "packet_io/trough.h"
 #include "packet_io/intf.h"
 #include "packet_io/sfdaq.h"
+#include "profiler/profiler.h"
 #include "control/idle_processing.h"
 #include "target_based/sftarget_reader.h"
 #include "flow/flow_control.h"
@@ -378,6 +379,88 @@ int main_rotate_stats(lua_State*)
     return 0;
 }
 
+//-------------------------------------------------------------------------
+// profiler snapshots
+//-------------------------------------------------------------------------
+
+static bool profile_pending = false;
+static time_t profile_next = 0;
+
+static bool profiling(const Pig& pig)
+{
+    if ( !pig.analyzer )
+        return false;
+
+    Analyzer::State s = pig.analyzer->get_state();
+    return s == Analyzer::State::RUNNING or s == Analyzer::State::PAUSED;
+}
+
+// ask the running pigs to copy their stats; the copies are merged and
+// written by profile_check() once they are all done
+static bool profile_request()
+{
+    if ( profile_pending or swapper )
+        return false;
+
+    for ( unsigned idx = 0; idx < max_pigs; ++idx )
+    {
+        if ( profiling(pigs[idx]) and !pigs[idx].attentive() )
+            return false;
+    }
+
+    Profiler::prepare_snapshot();
+
+    for ( unsigned idx = 0; idx < max_pigs; ++idx )
+    {
+        if ( profiling(pigs[idx]) )
+            pigs[idx].execute(AC_PROFILE);
+    }
+
+    profile_pending = true;
+    return true;
+}
+
+static bool profile_check()
+{
+    if ( profile_pending )
+    {
+        for ( unsigned idx = 0; idx < max_pigs; ++idx )
+        {
+            if ( pigs[idx].analyzer and pigs[idx].analyzer->get_current_command() == AC_PROFILE )
+                return false;
+        }
+        Profiler::write_snapshot();
+        profile_pending = false;
+        return true;
+    }
+
+    unsigned interval = SnortConfig::get_profiler()->snapshot.interval;
+
+    if ( !interval )
+        return false;
+
+    time_t now = time(nullptr);
+
+    if ( !profile_next )
+        profile_next = now + interval;
+
+    // a busy drove just means we try again next time around
+    else if ( now >= profile_next and profile_request() )
+        profile_next = now + interval;
+
+    return false;
+}
+
+int main_snapshot_profile(lua_State*)
+{
+    if ( profile_request() )
+        request.respond("== writing profile snapshot\n");
+    else
+        request.respond("== busy, try again later\n");
+
+    return 0;
+}
+
 static void main_load(Swapper* ps)
 {
     std::lock_guard<std::mutex> lock(Swapper::mutex);
@@ -768,6 +851,9 @@ static void service_check()
     if ( check_response() )
         return;
 
+    if ( profile_check() )
+        return;
+
     if ( house_keeping() )
         return;
 
@@ -946,11 +1032,23 @@ static void main_loop()
 
             continue;
         }
-        if ( !exit_requested and !paused and (swine < max_pigs) and (src = Trough::get_next()) )
+        if ( !exit_requested and !paused and (swine < max_pigs) and
+            (!Trough::sharding() or !swine) and (src = Trough::get_next()) )
         {
-            Pig* pig = get_lazy_pig(max_pigs);
-            pig->prep(src);
-            ++swine;
+            if ( Trough::sharding() )
+            {
+                // every pig reads the same pcap and takes its share of the flows
+                for ( unsigned i = 0; i < max_pigs; ++i )
+                    pigs[i].prep(src);
+
+                swine = max_pigs;
+            }
+            else
+            {
+                Pig* pig = get_lazy_pig(max_pigs);
+                pig->prep(src);
+                ++swine;
+            }
             continue;
         }
         service_check();
@@ -32,6 +32,7 @@ const char* get_prompt();
 // commands provided by the snort module
 int main_dump_stats(lua_State* = nullptr);
 int main_rotate_stats(lua_State* = nullptr);
+int main_snapshot_profile(lua_State* = nullptr);
 int main_reload_config(lua_State* = nullptr);
 int main_reload_hosts(lua_State* = nullptr);
 int main_process(lua_State* = nullptr);
@@ -31,6 +31,9 @@
 #include "log/messages.h"
 #include "memory/memory_cap.h"
 #include "packet_io/sfdaq.h"
+#include "packet_io/trough.h"
+#include "profiler/profiler.h"
+#include "utils/stats.h"
 
 using namespace std;
 
@@ -78,6 +81,7 @@ const char* Analyzer::get_command_string(AnalyzerCommand ac)
     case AC_PAUSE:  return "PAUSE";
     case AC_RESUME: return "RESUME";
     case AC_ROTATE: return "ROTATE";
+    case AC_PROFILE: return "PROFILE";
     case AC_SWAP:   return "SWAP";
     }
 
@@ -111,6 +115,12 @@ void Analyzer::operator()(Swapper* ps)
 
         analyze();
 
+        if ( Trough::sharding() )
+        {
+            chrono::duration<double> secs = chrono::steady_clock::now() - run_start;
+            Trough::shard_done(id, secs.count(), pc.total_alert_pkts);
+        }
+
         Snort::thread_term();
     }
 
@@ -154,6 +164,7 @@ bool Analyzer::handle_command()
     case AC_RUN:
         assert(state == State::STARTED);
         Snort::thread_init_unprivileged();
+        run_start = chrono::steady_clock::now();
         command = AC_NONE;
         set_state(State::RUNNING);
         DebugMessage(DEBUG_ANALYZER, "Handled RUN command\n");
@@ -187,9 +198,17 @@ bool Analyzer::handle_command()
         command = AC_NONE;
         break;
 
+    case AC_PROFILE:
+        Profiler::snapshot();
+        command = AC_NONE;
+        break;
+
     case AC_SWAP:
         if (swap)
+        {
             swap->apply();
+            Snort::thread_reinit();
+        }
 
         // clear cmd only; swap ptr cleared by main thread
         command = AC_NONE;
@@ -25,6 +25,7 @@
 // to control the thread and swap configuration.
 
 #include <atomic>
+#include <chrono>
 #include "main/snort_types.h"
 
 enum AnalyzerCommand
@@ -36,6 +37,7 @@ enum AnalyzerCommand
     AC_PAUSE,
     AC_RESUME,
     AC_ROTATE,
+    AC_PROFILE,
     AC_SWAP,
     AC_MAX = AC_SWAP
 };
@@ -85,6 +87,7 @@ private:
     unsigned id;
 
     const char* source;
+    std::chrono::steady_clock::time_point run_start;
     Swapper* swap;
     SFDAQInstance* daq_instance;
 };
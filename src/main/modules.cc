@@ -29,6 +29,7 @@
 #include "thread_config.h"
 
 #include "codecs/codec_module.h"
+#include "decompress/decompress_module.h"
 #include "detection/fp_config.h"
 #include "file_api/file_module.h"
 #include "filters/detection_filter.h"
@@ -38,9 +39,11 @@
 #include "flow/ha_module.h"
 #include "filters/sfthreshold.h"
 #include "framework/module.h"
+#include "framework/mpse.h"
 #include "host_tracker/host_tracker_module.h"
 #include "host_tracker/host_cache_module.h"
 #include "latency/latency_module.h"
+#include "log/async_writer.h"
 #include "log/messages.h"
 #include "managers/module_manager.h"
 #include "managers/plugin_manager.h"
@@ -199,6 +202,9 @@ static const Parameter search_engine_params[] =
     { "enable_single_rule_group", Parameter::PT_BOOL, nullptr, "false",
       "put all rules into one group" },
 
+    { "fast_pattern_corpus", Parameter::PT_STRING, nullptr, nullptr,
+      "pcap used at startup to choose fast patterns by hit rate and report the noisiest" },
+
     { "debug", Parameter::PT_BOOL, nullptr, "false",
       "print verbose fast pattern info" },
 
@@ -214,6 +220,10 @@ static const Parameter search_engine_params[] =
     { "debug_print_rule_groups_compiled", Parameter::PT_BOOL, nullptr, "false",
       "prints compiled rule group information" },
 
+    { "merge_buffers", Parameter::PT_BOOL, nullptr, "false",
+      "search packet, key, header, and body patterns with one engine per group; "
+      "requires a search_method that reports every hit, such as ac_full" },
+
     { "max_pattern_len", Parameter::PT_INT, "0:", "0",
       "truncate patterns when compiling into state machine (0 means no maximum)" },
 
@@ -259,6 +269,7 @@ class SearchEngineModule : public Module
 public:
     SearchEngineModule() : Module("search_engine", search_engine_help, search_engine_params) { }
     bool set(const char*, Value&, SnortConfig*) override;
+    bool end(const char*, int, SnortConfig*) override;
 
     const PegInfo* get_pegs() const override
     { return mpse_pegs; }
@@ -284,6 +295,9 @@ bool SearchEngineModule::set(const char*, Value& v, SnortConfig* sc)
         if ( v.get_bool() )
             fp->set_single_rule_group();
     }
+    else if ( v.is("fast_pattern_corpus") )
+        fp->set_corpus(v.get_string());
+
     else if ( v.is("debug") )
     {
         if ( v.get_bool() )
@@ -309,6 +323,9 @@ bool SearchEngineModule::set(const char*, Value& v, SnortConfig* sc)
         if ( v.get_bool() )
             fp->set_debug_print_rule_groups_compiled();
     }
+    else if ( v.is("merge_buffers") )
+        fp->set_merge_buffers(v.get_bool());
+
     else if ( v.is("max_pattern_len") )
         fp->set_max_pattern_len(v.get_long());
 
@@ -338,6 +355,21 @@ bool SearchEngineModule::set(const char*, Value& v, SnortConfig* sc)
     return true;
 }
 
+bool SearchEngineModule::end(const char*, int, SnortConfig* sc)
+{
+    FastPatternConfig* fp = sc->fast_pattern_config;
+
+    // merged spans only work if a hit outside the pattern's buffer doesn't
+    // hide a later hit inside it
+    if ( fp->get_merge_buffers() and !fp->get_all_hits() )
+    {
+        ParseError("search_engine.merge_buffers requires a search_method "
+            "that reports every hit, not %s", fp->get_search_api()->base.name);
+        return false;
+    }
+    return true;
+}
+
 // -----------------------------------------------------------------------------
 // profiler module
 // -----------------------------------------------------------------------------
@@ -357,6 +389,12 @@ static const Parameter profiler_time_params[] =
     { "max_depth", Parameter::PT_INT, "-1:", "-1",
       "limit depth to max_depth (-1 = no limit)" },
 
+    { "sample", Parameter::PT_INT, "1:", "1",
+      "time 1 in sample packets and scale the results (1 = all)" },
+
+    { "sample_random", Parameter::PT_BOOL, nullptr, "false",
+      "pick sampled packets at random instead of every sample-th packet" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -394,6 +432,17 @@ static const Parameter profiler_rule_params[] =
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
+static const Parameter profiler_snapshot_params[] =
+{
+    { "interval", Parameter::PT_INT, "0:", "0",
+      "seconds between snapshots (0 = only with snapshot_profile command)" },
+
+    { "format", Parameter::PT_ENUM, "json | csv", "json",
+      "write JSON lines or CSV to profile_snapshot.json or .csv" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 static const Parameter profiler_params[] =  // FIXIT-L add help
 {
     { "modules", Parameter::PT_TABLE, profiler_time_params, nullptr,
@@ -405,6 +454,9 @@ static const Parameter profiler_params[] =  // FIXIT-L add help
     { "rules", Parameter::PT_TABLE, profiler_rule_params, nullptr,
       "rule time profiling" },
 
+    { "snapshot", Parameter::PT_TABLE, profiler_snapshot_params, nullptr,
+      "live deltas of module and rule time profiles" },
+
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
@@ -439,6 +491,20 @@ static bool s_profiler_module_set(T& config, Value& v)
     return true;
 }
 
+static bool s_profiler_module_set(TimeProfilerConfig& config, Value& v)
+{
+    if ( v.is("sample") )
+        config.sample = v.get_long();
+
+    else if ( v.is("sample_random") )
+        config.sample_random = v.get_bool();
+
+    else
+        return s_profiler_module_set<TimeProfilerConfig>(config, v);
+
+    return true;
+}
+
 class ProfilerModule : public Module
 {
 public:
@@ -451,6 +517,7 @@ bool ProfilerModule::set(const char* fqn, Value& v, SnortConfig* sc)
     const char* spt = "profiler.modules";
     const char* spm = "profiler.memory";
     const char* spr = "profiler.rules";
+    const char* sps = "profiler.snapshot";
 
     if ( !strncmp(fqn, spt, strlen(spt)) )
         return s_profiler_module_set(sc->profiler->time, v);
@@ -461,6 +528,21 @@ bool ProfilerModule::set(const char* fqn, Value& v, SnortConfig* sc)
     else if ( !strncmp(fqn, spr, strlen(spr)) )
         return s_profiler_module_set(sc->profiler->rule, v);
 
+    else if ( !strncmp(fqn, sps, strlen(sps)) )
+    {
+        if ( v.is("interval") )
+            sc->profiler->snapshot.interval = v.get_long();
+
+        else if ( v.is("format") )
+            sc->profiler->snapshot.format =
+                static_cast<ProfilerSnapshotConfig::Format>(v.get_long());
+
+        else
+            return false;
+
+        return true;
+    }
+
     return false;
 }
 
@@ -613,13 +695,20 @@ static const Parameter alerts_params[] =
       "set available memory for filters" },
 
     { "event_filter_memcap", Parameter::PT_INT, "0:", "1048576",
-      "set available memory for filters" },
+      "set available memory for event filters, shared by all packet threads when "
+      "filter_sync is 1, otherwise per packet thread plus one shared table" },
+
+    { "filter_sync", Parameter::PT_INT, "0:", "1",
+      "events each packet thread counts before merging event and rate filter counts "
+      "with other threads (1 tracks all threads in one locked table, larger values "
+      "merge approximate counts, 0 tracks each thread separately)" },
 
     { "order", Parameter::PT_STRING, nullptr, "pass drop alert log",
       "change the order of rule action application" },
 
     { "rate_filter_memcap", Parameter::PT_INT, "0:", "1048576",
-      "set available memory for filters" },
+      "set available memory for rate filters, shared by all packet threads when "
+      "filter_sync is 1, otherwise per packet thread plus one shared table" },
 
     { "reference_net", Parameter::PT_STRING, nullptr, nullptr,
       "set the CIDR for homenet "
@@ -658,6 +747,12 @@ bool AlertsModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("event_filter_memcap") )
         sc->threshold_config->memcap = v.get_long();
 
+    else if ( v.is("filter_sync") )
+    {
+        sc->threshold_config->sync = v.get_long();
+        sc->rate_filter_config->sync = v.get_long();
+    }
+
     else if ( v.is("order") )
         OrderRuleLists(sc, v.get_string());
 
@@ -691,8 +786,25 @@ static const Parameter output_event_trace_params[] =
     { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
 };
 
+static const Parameter output_async_params[] =
+{
+    { "enable", Parameter::PT_BOOL, nullptr, "false",
+      "write text and unified2 logs from a dedicated output thread" },
+
+    { "ring_size", Parameter::PT_INT, "4096:", "1048576",
+      "bytes queued per log file per packet thread before the packet thread waits" },
+
+    { "sync_interval", Parameter::PT_INT, "0:", "1",
+      "seconds between fsyncs of each log file (0 means never)" },
+
+    { nullptr, Parameter::PT_MAX, nullptr, nullptr, nullptr }
+};
+
 static const Parameter output_params[] =
 {
+    { "async", Parameter::PT_TABLE, output_async_params, nullptr,
+      "offload log file writes from the packet threads" },
+
     { "dump_chars_only", Parameter::PT_BOOL, nullptr, "false",
       "turns on character dumps (same as -C)" },
 
@@ -740,11 +852,26 @@ class OutputModule : public Module
 public:
     OutputModule() : Module("output", output_help, output_params) { }
     bool set(const char*, Value&, SnortConfig*) override;
+
+    const PegInfo* get_pegs() const override
+    { return async_pegs; }
+
+    PegCount* get_counts() const override
+    { return (PegCount*)&async_counts; }
 };
 
 bool OutputModule::set(const char*, Value& v, SnortConfig* sc)
 {
-    if ( v.is("dump_chars_only") )
+    if ( v.is("enable") )
+        sc->async_output = v.get_bool();
+
+    else if ( v.is("ring_size") )
+        sc->async_ring_size = v.get_long();
+
+    else if ( v.is("sync_interval") )
+        sc->async_sync_interval = v.get_long();
+
+    else if ( v.is("dump_chars_only") )
         v.update_mask(sc->output_flags, OUTPUT_FLAG__CHAR_DATA);
 
     else if ( v.is("dump_payload") )
@@ -1746,6 +1873,7 @@ void module_init()
     // these modules are not policy specific
     ModuleManager::add_module(new ClassificationsModule);
     ModuleManager::add_module(new CodecModule);
+    ModuleManager::add_module(new DecompressModule);
     ModuleManager::add_module(new DetectionModule);
     ModuleManager::add_module(new MemoryModule);
     ModuleManager::add_module(new PacketsModule);
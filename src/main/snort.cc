@@ -51,7 +51,9 @@
 #include "host_tracker/host_cache.h"
 #include "ips_options/ips_flowbits.h"
 #include "latency/packet_latency.h"
+#include "latency/rule_budget.h"
 #include "latency/rule_latency.h"
+#include "log/async_writer.h"
 #include "log/messages.h"
 #include "managers/action_manager.h"
 #include "managers/codec_manager.h"
@@ -69,6 +71,7 @@
 #include "parser/parser.h"
 #include "perf_monitor/perf_monitor.h"
 #include "profiler/profiler.h"
+#include "profiler/time_profiler.h"
 #include "protocols/packet.h"
 #include "protocols/packet_manager.h"
 #include "side_channel/side_channel.h"
@@ -103,6 +106,7 @@ static pid_t snort_main_thread_pid = 0;
 static THREAD_LOCAL DAQ_PktHdr_t s_pkth;
 static THREAD_LOCAL uint8_t s_data[65536];
 static THREAD_LOCAL Packet* s_packet = nullptr;
+static THREAD_LOCAL time_t s_tick = 0;
 
 //-------------------------------------------------------------------------
 // perf stats
@@ -269,6 +273,9 @@ void Snort::init(int argc, char** argv)
 
     snort_conf->setup();
 
+    if ( snort_conf->async_output )
+        AsyncWriter::start(snort_conf->async_ring_size, snort_conf->async_sync_interval);
+
     FileService::post_init();
 
     // Must be after CodecManager::instantiate()
@@ -388,6 +395,7 @@ void Snort::term()
     //MpseManager::print_search_engine_stats();
 
     FileService::close();
+    AsyncWriter::stop();
 
     sfthreshold_free();  // FIXDAQ etc.
     RateFilter_Cleanup();
@@ -597,11 +605,25 @@ void Snort::capture_packet()
     }
 }
 
+// let loggers write buffered output about once a second
+static void tick_outputs(time_t now)
+{
+    if ( now == s_tick )
+        return;
+
+    s_tick = now;
+    EventManager::tick_outputs();
+}
+
 void Snort::thread_idle()
 {
     Stream::timeout_flows(time(nullptr));
+    tick_outputs(time(nullptr));
     perf_monitor_idle_process();
     aux_counts.idle++;
+
+    // packet time doesn't advance while idle so the batch won't age out
+    HighAvailabilityManager::flush();
     HighAvailabilityManager::process_receive();
 }
 
@@ -610,6 +632,16 @@ void Snort::thread_rotate()
     SetRotatePerfFileFlag();
 }
 
+// called after a swap so the packet thread picks up the new settings
+void Snort::thread_reinit()
+{
+    time_profiler_thread_init(snort_conf->profiler->time);
+
+    // the filter tables are rebuilt from the new config's shares
+    sfthreshold_tterm();
+    RateFilter_ThreadTerm();
+}
+
 /*
  * Perform all packet thread initialization actions that need to be taken with escalated privileges
  * prior to starting the DAQ module.
@@ -636,6 +668,7 @@ bool Snort::thread_init_privileged(const char* intf)
 void Snort::thread_init_unprivileged()
 {
     s_packet = new Packet(false);
+    time_profiler_thread_init(snort_conf->profiler->time);
     CodecManager::thread_init(snort_conf);
 
     // this depends on instantiated daq capabilities
@@ -672,6 +705,7 @@ void Snort::thread_term()
 
     InspectorManager::thread_stop(snort_conf);
     ModuleManager::accumulate(snort_conf);
+    time_profiler_thread_term();
     InspectorManager::thread_term(snort_conf);
     ActionManager::thread_term(snort_conf);
 
@@ -680,6 +714,7 @@ void Snort::thread_term()
     CodecManager::thread_term();
     HighAvailabilityManager::thread_term();
     SideChannelManager::thread_term();
+    host_cache_thread_term();
 
     if ( s_packet )
     {
@@ -695,11 +730,14 @@ void Snort::thread_term()
 
     PacketLatency::tterm();
     RuleLatency::tterm();
+    RuleBudget::tterm();
 
     Profiler::consolidate_stats();
 
     otnx_match_data_term();
     detection_filter_term();
+    sfthreshold_tterm();
+    RateFilter_ThreadTerm();
     EventTrace_Term();
     CleanupTag();
     FileService::thread_term();
@@ -822,7 +860,19 @@ static DAQ_Verdict update_verdict(DAQ_Verdict verdict, int& inject)
 DAQ_Verdict Snort::packet_callback(
     void*, const DAQ_PktHdr_t* pkthdr, const uint8_t* pkt)
 {
+    if ( Trough::sharding() )
+    {
+        bool owned = Trough::owns(SFDAQ::get_base_protocol(), pkt, pkthdr->caplen,
+            get_instance_id(), ThreadConfig::get_instance_max());
+
+        Trough::count(pkthdr->caplen, owned);
+
+        if ( !owned )
+            return DAQ_VERDICT_PASS;
+    }
+
     set_default_policy();
+    time_profiler_sample();
     Profile profile(totalPerfStats);
 
     pc.total_from_daq++;
@@ -853,6 +903,7 @@ DAQ_Verdict Snort::packet_callback(
     Active::reset();
     PacketManager::encode_reset();
     Stream::timeout_flows(pkthdr->ts.tv_sec);
+    tick_outputs(pkthdr->ts.tv_sec);
     HighAvailabilityManager::process_receive();
 
     s_packet->pkth = nullptr;  // no longer avail upon sig segv
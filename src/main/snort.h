@@ -55,6 +55,7 @@ public:
 
     static void thread_idle();
     static void thread_rotate();
+    static void thread_reinit();
 
     static void capture_packet();
     static void detect_rebuilt_packet(Packet*);
@@ -491,22 +491,6 @@ bool SnortConfig::verify()
         return false;
     }
 
-    if (snort_conf->threshold_config->memcap !=
-        threshold_config->memcap)
-    {
-        ErrorMessage("Snort Reload: Changing the threshold memcap "
-            "configuration requires a restart.\n");
-        return false;
-    }
-
-    if (snort_conf->rate_filter_config->memcap !=
-        rate_filter_config->memcap)
-    {
-        ErrorMessage("Snort Reload: Changing the rate filter memcap "
-            "configuration requires a restart.\n");
-        return false;
-    }
-
     if (snort_conf->detection_filter_config->memcap !=
         detection_filter_config->memcap)
     {
@@ -178,6 +178,10 @@ public:
 
     std::string log_dir;
 
+    bool async_output = false;
+    uint32_t async_ring_size = 1048576;
+    uint32_t async_sync_interval = 1;
+
     //------------------------------------------------------
     // daq stuff
     SFDAQConfig* daq_config;
@@ -73,6 +73,8 @@ static const Command snort_cmds[] =
     { "show_plugins", main_dump_plugins, nullptr, "show available plugins" },
     { "dump_stats", main_dump_stats, nullptr, "show summary statistics" },
     { "rotate_stats", main_rotate_stats, nullptr, "roll perfmonitor log files" },
+    { "snapshot_profile", main_snapshot_profile, nullptr,
+      "append profiler deltas to profile_snapshot.json or .csv" },
     { "reload_config", main_reload_config, s_reload, "load new configuration" },
     { "reload_hosts", main_reload_hosts, s_reload, "load a new hosts table" },
 
@@ -384,6 +386,9 @@ static const Parameter s_params[] =
     { "--pcap-reload", Parameter::PT_IMPLIED, nullptr, nullptr,
       "if reading multiple pcaps, reload snort config between pcaps" },
 
+    { "--pcap-shard", Parameter::PT_IMPLIED, nullptr, nullptr,
+      "read each pcap with all packet threads, splitting flows across threads" },
+
     { "--pcap-show", Parameter::PT_IMPLIED, nullptr, nullptr,
       "print a line saying what pcap is currently being read" },
 
@@ -797,6 +802,9 @@ bool SnortModule::set(const char*, Value& v, SnortConfig* sc)
     else if ( v.is("--pcap-reload") )
         sc->run_flags |= RUN_FLAG__PCAP_RELOAD;
 
+    else if ( v.is("--pcap-shard") )
+        Trough::set_shard(true);
+
     else if ( v.is("--pcap-show") )
         sc->run_flags |= RUN_FLAG__PCAP_SHOW;
 
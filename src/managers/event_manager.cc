@@ -242,6 +242,12 @@ void EventManager::close_outputs()
         p->close();
 }
 
+void EventManager::tick_outputs()
+{
+    for ( auto p : s_loggers.outputs )
+        p->tick();
+}
+
 void EventManager::call_alerters(
     OutputSet* idx, Packet* pkt, const char* message, Event* event)
 {
@@ -22,6 +22,8 @@
 #include <assert.h>
 #include <algorithm>
 #include <list>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "module_manager.h"
@@ -162,6 +164,49 @@ struct PHVector
     { vec[num++] = p; }
 };
 
+// PktType is NONE or a single bit so there are 8 possible packet types.
+// packet dispatch uses the subset of each list that applies to the type
+// so eval() is called without checking proto_bits per inspector.
+#define PT_DISPATCH_MAX 8
+
+static inline unsigned get_dispatch_index(PktType t)
+{
+    unsigned u = to_utype(t);
+    return u ? __builtin_ctz(u) + 1 : 0;
+}
+
+struct PHDispatch
+{
+    PHVector packet;
+    PHVector network;
+    PHVector session;
+    PHVector probe;
+
+    void alloc(unsigned max)
+    {
+        packet.alloc(max);
+        network.alloc(max);
+        session.alloc(max);
+        probe.alloc(max);
+    }
+};
+
+// lists for each packet type that apply to flows with a given service.
+// network inspectors only run until a flow's service is known, unless
+// they name that service in their api, and other inspectors that name a
+// service only run on flows with that service.
+struct PHServiceDispatch
+{
+    PHDispatch type[PT_DISPATCH_MAX];
+};
+
+// service indices; named services follow
+#define PT_NO_SERVICE 0     // no flow or no service yet
+#define PT_ANY_SERVICE 1    // a service no inspector names
+
+// flows cache their service index per policy generation
+static unsigned s_policy_gen = 0;
+
 struct FrameworkPolicy
 {
     PHInstanceList ilist;
@@ -173,12 +218,36 @@ struct FrameworkPolicy
     PHVector service;
     PHVector probe;
 
+    vector<PHServiceDispatch*> dispatch;
+    unordered_map<string, unsigned> service_index;
+    unsigned gen;
+
     Inspector* binder;
     Inspector* wizard;
 
+    ~FrameworkPolicy();
+
     void vectorize();
+    void specialize();
+
+    unsigned get_service_index(const char*) const;
 };
 
+FrameworkPolicy::~FrameworkPolicy()
+{
+    for ( auto* d : dispatch )
+        delete d;
+}
+
+unsigned FrameworkPolicy::get_service_index(const char* s) const
+{
+    if ( !s )
+        return PT_NO_SERVICE;
+
+    auto it = service_index.find(s);
+    return it == service_index.end() ? PT_ANY_SERVICE : it->second;
+}
+
 void FrameworkPolicy::vectorize()
 {
     passive.alloc(ilist.size());
@@ -229,6 +298,84 @@ void FrameworkPolicy::vectorize()
             break;
         }
     }
+    specialize();
+}
+
+// is p in the lists for the service at idx?
+static bool applies(const PHInstance* p, unsigned idx, const char* svc, bool network)
+{
+    const char* ps = p->pp_class.api.service;
+
+    if ( ps )
+        return svc and !strcmp(ps, svc);
+
+    return !network or idx == PT_NO_SERVICE;
+}
+
+static void specialize(
+    PHVector& all, unsigned idx, const char* svc, bool network, PHVector* vecs[PT_DISPATCH_MAX])
+{
+    for ( unsigned i = 0; i < all.num; ++i )
+    {
+        PHInstance* p = all.vec[i];
+
+        if ( !applies(p, idx, svc, network) )
+            continue;
+
+        for ( unsigned t = 1; t < PT_DISPATCH_MAX; ++t )
+        {
+            if ( p->pp_class.api.proto_bits & (1 << (t - 1)) )
+                vecs[t]->add(p);
+        }
+    }
+}
+
+void FrameworkPolicy::specialize()
+{
+    // service inspectors are reached through the flow's gadget so only
+    // services named by other inspectors need their own lists
+    vector<const char*> names = { nullptr, nullptr };
+
+    for ( auto* p : ilist )
+    {
+        const char* svc = p->pp_class.api.service;
+
+        if ( svc and p->pp_class.api.type != IT_SERVICE and
+            service_index.find(svc) == service_index.end() )
+        {
+            service_index[svc] = names.size();
+            names.push_back(svc);
+        }
+    }
+
+    gen = ++s_policy_gen;
+
+    for ( unsigned idx = 0; idx < names.size(); ++idx )
+    {
+        PHServiceDispatch* sd = new PHServiceDispatch;
+        PHVector* vecs[PT_DISPATCH_MAX];
+
+        for ( unsigned t = 0; t < PT_DISPATCH_MAX; ++t )
+            sd->type[t].alloc(ilist.size());
+
+        for ( unsigned t = 0; t < PT_DISPATCH_MAX; ++t )
+            vecs[t] = &sd->type[t].packet;
+        ::specialize(packet, idx, names[idx], false, vecs);
+
+        for ( unsigned t = 0; t < PT_DISPATCH_MAX; ++t )
+            vecs[t] = &sd->type[t].network;
+        ::specialize(network, idx, names[idx], true, vecs);
+
+        for ( unsigned t = 0; t < PT_DISPATCH_MAX; ++t )
+            vecs[t] = &sd->type[t].session;
+        ::specialize(session, idx, names[idx], false, vecs);
+
+        for ( unsigned t = 0; t < PT_DISPATCH_MAX; ++t )
+            vecs[t] = &sd->type[t].probe;
+        ::specialize(probe, idx, names[idx], false, vecs);
+
+        dispatch.push_back(sd);
+    }
 }
 
 //-------------------------------------------------------------------------
@@ -726,24 +873,37 @@ void InspectorManager::print_config(SnortConfig* sc)
 // packet handling
 //-------------------------------------------------------------------------
 
-static inline void execute(
-    Packet* p, PHInstance** prep, unsigned num)
+// the flow's service index is looked up only when its service or policy
+// changes; the service may change while a packet is being inspected
+static inline const PHDispatch& get_dispatch(FrameworkPolicy* fp, Packet* p)
 {
-    for ( unsigned i = 0; i < num; ++i, ++prep )
+    unsigned t = get_dispatch_index(p->type());
+    Flow* flow = p->flow;
+
+    if ( !flow )
+        return fp->dispatch[PT_NO_SERVICE]->type[t];
+
+    if ( flow->inspection_gen != fp->gen or flow->inspection_service != flow->service )
     {
-        if ( p->packet_flags & PKT_PASS_RULE )
-            break;
+        flow->inspection_gen = fp->gen;
+        flow->inspection_service = flow->service;
+        flow->inspection_index = fp->get_service_index(flow->service);
+    }
+    return fp->dispatch[flow->inspection_index]->type[t];
+}
 
-        PHClass& ppc = (*prep)->pp_class;
+// the vector has already been specialized for the packet type and service
+// and holds no service inspectors so everything in it gets the packet
+static inline void execute(Packet* p, const PHVector& v)
+{
+    PHInstance** prep = v.vec;
 
-        // FIXIT-P these checks can eventually be optimized
-        // but they are required to ensure that session and app
-        // handlers aren't called w/o a session pointer
-        if ( !p->flow && (ppc.api.type == IT_SERVICE) )
+    for ( unsigned i = 0; i < v.num; ++i, ++prep )
+    {
+        if ( p->packet_flags & PKT_PASS_RULE )
             break;
 
-        if ( (unsigned)p->type() & ppc.api.proto_bits )
-            (*prep)->handler->eval(p);
+        (*prep)->handler->eval(p);
     }
 }
 
@@ -769,10 +929,9 @@ bool InspectorManager::full_inspection(FrameworkPolicy* fp, Packet* p)
 {
     Flow* flow = p->flow;
 
-    if ( !flow->service )
-        ::execute(p, fp->network.vec, fp->network.num);
+    ::execute(p, get_dispatch(fp, p).network);
 
-    else if ( flow->clouseau and !p->is_cooked() )
+    if ( flow->service and flow->clouseau and !p->is_cooked() )
         bumble(p);
 
     if ( p->disable_inspect )
@@ -797,10 +956,10 @@ void InspectorManager::execute(Packet* p)
 
     // FIXIT-M blocked flows should not be normalized
     if ( !p->is_cooked() )
-        ::execute(p, fp->packet.vec, fp->packet.num);
+        ::execute(p, get_dispatch(fp, p).packet);
 
     if ( !p->has_paf_payload() )
-        ::execute(p, fp->session.vec, fp->session.num);
+        ::execute(p, get_dispatch(fp, p).session);
 
     if( p->disable_inspect )
         return;
@@ -808,7 +967,7 @@ void InspectorManager::execute(Packet* p)
     Flow* flow = p->flow;
 
     if ( !flow )
-        ::execute(p, fp->network.vec, fp->network.num);
+        ::execute(p, get_dispatch(fp, p).network);
 
     else if ( flow->full_inspection() )
     {
@@ -816,7 +975,7 @@ void InspectorManager::execute(Packet* p)
             return;
     }
 
-    ::execute(p, fp->probe.vec, fp->probe.num);
+    ::execute(p, get_dispatch(fp, p).probe);
 }
 
 void InspectorManager::clear(Packet* p)
@@ -150,6 +150,11 @@ bool MpseManager::search_engine_trim(const MpseApi* api)
     return api->trim;
 }
 
+bool MpseManager::search_engine_all_hits(const MpseApi* api)
+{
+    return api->all_hits;
+}
+
 // was called during drop stats but actually commented out
 // FIXIT-M this one has to accumulate across threads
 #if 0
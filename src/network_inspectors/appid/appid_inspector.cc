@@ -84,9 +84,9 @@ bool AppIdInspector::configure(SnortConfig*)
 {
     active_config = new AppIdConfig( ( AppIdModuleConfig* )config);
 
-    get_data_bus().subscribe(HTTP_REQUEST_HEADER_EVENT_KEY, new HttpEventHandler(HttpEventHandler::REQUEST_EVENT));
-    get_data_bus().subscribe(HTTP_RESPONSE_HEADER_EVENT_KEY, new HttpEventHandler(HttpEventHandler::RESPONSE_EVENT));
-    get_data_bus().subscribe(SIP_EVENT_TYPE_SIP_DIALOG_KEY, new SipEventHandler());
+    get_data_bus().subscribe(DE_HTTP_REQUEST_HEADER, new HttpEventHandler(HttpEventHandler::REQUEST_EVENT));
+    get_data_bus().subscribe(DE_HTTP_RESPONSE_HEADER, new HttpEventHandler(HttpEventHandler::RESPONSE_EVENT));
+    get_data_bus().subscribe(DE_SIP_DIALOG, new SipEventHandler());
 
     return active_config->init_appid();
 
@@ -48,6 +48,8 @@ static const PegInfo bind_pegs[] =
     { "blocks", "block bindings" },
     { "allows", "allow bindings" },
     { "inspects", "inspect bindings" },
+    { "cache hits", "flows matched to cached binding candidates" },
+    { "cache misses", "flows that required a search for binding candidates" },
     { nullptr, nullptr }
 };
 
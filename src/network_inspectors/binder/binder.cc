@@ -19,6 +19,9 @@
 
 #include "binder.h"
 
+#include <atomic>
+#include <string.h>
+#include <string>
 #include <vector>
 
 #include "binding.h"
@@ -206,6 +209,41 @@ bool Binding::check_all(const Flow* flow) const
     return true;
 }
 
+// the server port is part of the cache key but the client port is not
+bool Binding::check_static(const Flow* flow) const
+{
+    if ( !check_policy(flow) )
+        return false;
+
+    if ( !check_iface(flow) )
+        return false;
+
+    if ( !check_vlan(flow) )
+        return false;
+
+    if ( !check_proto(flow) )
+        return false;
+
+    if ( when.role == BindWhen::BR_SERVER and !check_port(flow) )
+        return false;
+
+    if ( !check_service(flow) )
+        return false;
+
+    return true;
+}
+
+bool Binding::check_dynamic(const Flow* flow) const
+{
+    if ( !check_addr(flow) )
+        return false;
+
+    if ( when.role != BindWhen::BR_SERVER and !check_port(flow) )
+        return false;
+
+    return true;
+}
+
 //-------------------------------------------------------------------------
 // helpers
 //-------------------------------------------------------------------------
@@ -402,6 +440,68 @@ void Stuff::apply_service(Flow* flow, const HostAttributeEntry* host)
         flow->set_clouseau(wizard);
 }
 
+//-------------------------------------------------------------------------
+// cache stuff
+//-------------------------------------------------------------------------
+
+// get_bindings() runs for every new flow.  the bindings that pass
+// check_static() are a function of the fields below so the indexes of
+// those candidates are kept in a direct mapped cache per packet thread.
+// a hit leaves only check_dynamic() to run on each candidate.  binder
+// ids are never reused so entries for a binder from a previous config
+// just age out.
+
+struct BindKey
+{
+    unsigned binder;
+    unsigned policy_id;
+    int32_t iface_in;
+    int32_t iface_out;
+    uint16_t vlan;
+    uint16_t server_port;
+    uint8_t pkt_type;
+    uint8_t pad[3];
+};
+
+struct BindEntry
+{
+    BindKey key;
+    bool valid = false;
+    bool has_service = false;
+    std::string service;
+    vector<unsigned> candidates;
+};
+
+#define BIND_CACHE_SIZE 1024  // must be a power of 2
+
+static THREAD_LOCAL BindEntry* bind_cache = nullptr;
+static std::atomic<unsigned> bind_ids(0);
+
+static unsigned bind_hash(const BindKey& key, const char* svc)
+{
+    const uint32_t* w = (const uint32_t*)&key;
+    uint32_t h = 0;
+
+    for ( unsigned i = 0; i < sizeof(key) / sizeof(*w); i++ )
+        h = (h ^ w[i]) * 0x9E3779B1u;
+
+    while ( svc and *svc )
+        h = (h ^ (uint8_t)*svc++) * 0x01000193u;
+
+    return (h ^ (h >> 16)) & (BIND_CACHE_SIZE - 1);
+}
+
+static bool bind_match(const BindEntry& e, const BindKey& key, const char* svc)
+{
+    if ( !e.valid or memcmp(&e.key, &key, sizeof(key)) )
+        return false;
+
+    if ( !svc )
+        return !e.has_service;
+
+    return e.has_service and e.service == svc;
+}
+
 //-------------------------------------------------------------------------
 // class stuff
 //-------------------------------------------------------------------------
@@ -428,6 +528,8 @@ private:
 
     void set_binding(SnortConfig*, Binding*);
     void get_bindings(Flow*, Stuff&);
+    void scan_bindings(Flow*, Stuff&, unsigned start);
+    const vector<unsigned>& get_candidates(const Flow*);
     void apply(Flow*, Stuff&);
     Inspector* find_gadget(Flow*);
     int exec_handle_gadget(void*);
@@ -435,11 +537,16 @@ private:
 
 private:
     vector<Binding*> bindings;
+
+    // bindings indexed by the bit of each PktType they accept
+    vector<unsigned> protos[8];
+    unsigned id;
 };
 
 Binder::Binder(vector<Binding*>& v)
 {
     bindings = std::move(v);
+    id = ++bind_ids;
 }
 
 Binder::~Binder()
@@ -459,6 +566,12 @@ bool Binder::configure(SnortConfig* sc)
 
         if ( !pb->use.index )
             set_binding(sc, pb);
+
+        for ( unsigned b = 0; b < 8; b++ )
+        {
+            if ( pb->when.protos & (1 << b) )
+                protos[b].push_back(i);
+        }
     }
     return true;
 }
@@ -568,14 +681,104 @@ void Binder::set_binding(SnortConfig*, Binding* pb)
         ParseError("can't bind %s", key);
 }
 
-// FIXIT-P this is a simple linear search until functionality is nailed
-// down.  performance should be the focus of the next iteration.
+// a flow has a single packet type so a miss only considers the bindings
+// for that type
+const vector<unsigned>& Binder::get_candidates(const Flow* flow)
+{
+    if ( !bind_cache )
+        bind_cache = new BindEntry[BIND_CACHE_SIZE];
+
+    BindKey key;
+    memset(&key, 0, sizeof(key));
+
+    key.binder = id;
+    key.policy_id = flow->policy_id;
+    key.iface_in = flow->iface_in;
+    key.iface_out = flow->iface_out;
+    key.vlan = flow->key->vlan_tag;
+    key.server_port = flow->server_port;
+    key.pkt_type = (uint8_t)flow->pkt_type;
+
+    BindEntry& e = bind_cache[bind_hash(key, flow->service)];
+
+    if ( bind_match(e, key, flow->service) )
+    {
+        ++bstats.cache_hits;
+        return e.candidates;
+    }
+    ++bstats.cache_misses;
+
+    e.key = key;
+    e.valid = true;
+    e.has_service = (flow->service != nullptr);
+    e.service = flow->service ? flow->service : "";
+    e.candidates.clear();
+
+    unsigned t = key.pkt_type;
+
+    if ( t and !(t & (t - 1)) )
+    {
+        for ( auto i : protos[__builtin_ctz(t)] )
+        {
+            if ( bindings[i]->check_static(flow) )
+                e.candidates.push_back(i);
+        }
+    }
+    else
+    {
+        for ( unsigned i = 0; i < bindings.size(); i++ )
+        {
+            if ( bindings[i]->check_static(flow) )
+                e.candidates.push_back(i);
+        }
+    }
+    return e.candidates;
+}
+
+// the candidates are in binding order so the first match still wins.
+// the cache entry may be replaced by the sub-binder so it isn't used
+// after the recursion.
 void Binder::get_bindings(Flow* flow, Stuff& stuff)
+{
+    const vector<unsigned>& candidates = get_candidates(flow);
+
+    for ( auto i : candidates )
+    {
+        Binding* pb = bindings[i];
+
+        if ( !pb->check_dynamic(flow) )
+            continue;
+
+        if ( !pb->use.index )
+        {
+            if ( stuff.update(pb) )
+                return;
+            else
+                continue;
+        }
+
+        set_policies(snort_conf, pb->use.index - 1);
+        flow->policy_id = pb->use.index - 1;
+
+        Binder* sub = (Binder*)InspectorManager::get_binder();
+
+        // without a sub-binder the search continues under the new policy
+        // id which is part of the key so it can't use these candidates
+        if ( sub )
+            sub->get_bindings(flow, stuff);
+        else
+            scan_bindings(flow, stuff, i + 1);
+
+        return;
+    }
+}
+
+void Binder::scan_bindings(Flow* flow, Stuff& stuff, unsigned start)
 {
     Binding* pb;
     unsigned i, sz = bindings.size();
 
-    for ( i = 0; i < sz; i++ )
+    for ( i = start; i < sz; i++ )
     {
         pb = bindings[i];
 
@@ -647,6 +850,12 @@ static void bind_dtor(Inspector* p)
     delete p;
 }
 
+static void bind_tterm()
+{
+    delete[] bind_cache;
+    bind_cache = nullptr;
+}
+
 static const InspectApi bind_api =
 {
     {
@@ -668,7 +877,7 @@ static const InspectApi bind_api =
     nullptr, // pinit
     nullptr, // pterm
     nullptr, // tinit
-    nullptr, // tterm
+    bind_tterm,
     bind_ctor,
     bind_dtor,
     nullptr, // ssn
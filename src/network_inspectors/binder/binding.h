@@ -76,6 +76,11 @@ struct Binding
     bool check_port(const Flow*) const;
     bool check_policy(const Flow*) const;
     bool check_service(const Flow*) const;
+
+    // check_all() split for the binder cache; the static checks depend
+    // only on the cache key and the dynamic checks cover the rest
+    bool check_static(const Flow*) const;
+    bool check_dynamic(const Flow*) const;
 };
 
 #endif
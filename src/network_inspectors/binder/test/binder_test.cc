@@ -151,6 +151,83 @@ TEST(binder, exec)
     CHECK(flow->ssn_server != nullptr);
     api->dtor(b);
     api->base.mod_dtor(m);
+    api->tterm();
+    delete flow->key;
+    delete flow;
+    delete s_inspector;
+    delete[] conf;
+}
+
+static Binding* add_action(BindUse::Action action, unsigned protos)
+{
+    Binding* binding = new Binding;
+    binding->when.protos = protos;
+    binding->use.action = action;
+    s_bindings.push_back(binding);
+    return binding;
+}
+
+static Flow::FlowState eval_flow(Binder* b, Flow* flow, PktType type, uint16_t cp, uint16_t sp)
+{
+    flow->pkt_type = type;
+    flow->client_port = cp;
+    flow->server_port = sp;
+    flow->flow_state = Flow::FlowState::SETUP;
+    b->exec(BinderSpace::ExecOperation::EVAL_STANDBY_FLOW, flow);
+    return flow->flow_state;
+}
+
+TEST(binder, cache)
+{
+    uint8_t* conf = new uint8_t[sizeof(SnortConfig)];
+    memset(conf,0,sizeof(SnortConfig));
+    snort_conf = (SnortConfig*)conf;
+    Flow* flow = new Flow;
+    constexpr size_t offset = offsetof(Flow, flow_data);
+    memset((uint8_t*)flow+offset, 0, sizeof(Flow)-offset);
+
+    s_inspector = new MyInspector();
+
+    flow->key = new FlowKey;
+    ((FlowKey*)flow->key)->init(PktType::TCP, IpProtocol::TCP, &s_src_ip, (uint16_t)1234, &s_dst_ip, (uint16_t)80, 0, 0, 0);
+
+    InspectApi* api = (InspectApi*)nin_binder;
+    BinderModule* m = (BinderModule*)(api->base.mod_ctor());
+
+    Binding* binding = add_action(BindUse::BA_BLOCK, (unsigned)PktType::TCP);
+    binding->when.role = BindWhen::BR_SERVER;
+    binding->when.ports.reset();
+    binding->when.ports.set(80);
+
+    binding = add_action(BindUse::BA_ALLOW, (unsigned)PktType::ANY);
+    binding->when.role = BindWhen::BR_CLIENT;
+    binding->when.ports.reset();
+    binding->when.ports.set(1234);
+
+    add_action(BindUse::BA_RESET, (unsigned)PktType::UDP);
+
+    Binder* b = (Binder*)api->ctor(m);
+    b->configure(snort_conf);
+
+    PegCount misses = bstats.cache_misses;
+    PegCount hits = bstats.cache_hits;
+
+    // each flow twice; the second answer comes from the cache
+    for ( int n = 0; n < 2; n++ )
+    {
+        CHECK(eval_flow(b, flow, PktType::TCP, 1234, 80) == Flow::FlowState::BLOCK);
+        CHECK(eval_flow(b, flow, PktType::TCP, 1234, 81) == Flow::FlowState::ALLOW);
+        CHECK(eval_flow(b, flow, PktType::UDP, 1234, 80) == Flow::FlowState::ALLOW);
+        CHECK(eval_flow(b, flow, PktType::UDP, 5, 80) == Flow::FlowState::RESET);
+        CHECK(eval_flow(b, flow, PktType::ICMP, 5, 80) == Flow::FlowState::INSPECT);
+    }
+    // the client port is not part of the key
+    CHECK(bstats.cache_misses - misses == 4);
+    CHECK(bstats.cache_hits - hits == 6);
+
+    api->dtor(b);
+    api->base.mod_dtor(m);
+    api->tterm();
     delete flow->key;
     delete flow;
     delete s_inspector;
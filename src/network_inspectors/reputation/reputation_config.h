@@ -43,6 +43,12 @@ enum WhiteAction
     TRUST
 };
 
+enum IPTable
+{
+    TABLE_DIR,
+    TABLE_POPTRIE
+};
+
 enum IPdecision
 {
     DECISION_NULL,
@@ -68,11 +74,16 @@ struct ReputationConfig
     IPdecision priority = WHITELISTED_TRUST;
     NestedIP nestedIP = INNER;
     WhiteAction whiteAction = UNBLACK;
+    IPTable table = TABLE_DIR;
     MEM_OFFSET local_black_ptr = 0;
     MEM_OFFSET local_white_ptr = 0;
     uint8_t* reputation_segment = nullptr;
+    uint32_t segment_size = 0;
     char* blacklist_path = nullptr;
     char* whitelist_path = nullptr;
+    char* list_image = nullptr;
+    void* image_map = nullptr;   // when set, reputation_segment points into this mapping
+    size_t image_size = 0;
     bool memCapReached = false;
     table_flat_t* iplist = nullptr;
     ListInfo* listInfo = nullptr;
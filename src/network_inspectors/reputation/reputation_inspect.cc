@@ -35,6 +35,7 @@
 
 #include "protocols/packet.h"
 #include "sfip/sf_ip.h"
+#include "sfrt/sfrt_poptrie.h"
 #include "events/event_queue.h"
 #include "log/messages.h"
 #include "main/snort_types.h"
@@ -77,6 +78,13 @@ const char* WhiteActionOption[] =
     nullptr 
 };
 
+const char* IPTableOption[] =
+{
+    "dir",
+    "poptrie",
+    nullptr
+};
+
 /*
  * Function prototype(s)
  */
@@ -157,12 +165,18 @@ static void PrintReputationConf(ReputationConfig* config)
     LogMessage("    White action: %s %s \n",
         WhiteActionOption[config->whiteAction],
         config->whiteAction ==  UNBLACK ? "(Default)" : "");
+    bool poptrie = config->iplist and config->iplist->table_flat_type == POPTRIE;
+    LogMessage("    Lookup: %s %s \n",
+        IPTableOption[poptrie ? TABLE_POPTRIE : TABLE_DIR], poptrie ? "" : "(Default)");
     if (config->blacklist_path)
         LogMessage("    Blacklist File Path: %s\n", config->blacklist_path);
 
     if (config->whitelist_path)
         LogMessage("    Whitelist File Path: %s\n", config->whitelist_path);
 
+    if (config->list_image)
+        LogMessage("    List Image File Path: %s\n", config->list_image);
+
     LogMessage("\n");
 }
 
@@ -180,7 +194,10 @@ static inline IPrepInfo* ReputationLookup(ReputationConfig* config, const sfip_t
         }
     }
 
-    result = (IPrepInfo*)sfrt_flat_dir8x_lookup((void*)ip, config->iplist);
+    if ( config->iplist->table_flat_type == POPTRIE )
+        result = (IPrepInfo*)sfrt_flat_poptrie_lookup(ip, config->iplist);
+    else
+        result = (IPrepInfo*)sfrt_flat_dir8x_lookup((void*)ip, config->iplist);
 
     return (result);
 }
@@ -42,6 +42,12 @@ static const Parameter s_params[] =
     { "blacklist", Parameter::PT_STRING, nullptr, nullptr,
       "blacklist file name with ip lists" },
 
+    { "list_image", Parameter::PT_STRING, nullptr, nullptr,
+      "list image file compiled by rep_compiler; used instead of blacklist and whitelist" },
+
+    { "lookup", Parameter::PT_ENUM, "dir|poptrie", "dir",
+      "ip table; poptrie is compressed and much smaller for large or IPv6 lists" },
+
     { "memcap", Parameter::PT_INT, "1:4095", "500",
       "maximum total memory allocated" },
 
@@ -106,6 +112,12 @@ bool ReputationModule::set(const char*, Value& v, SnortConfig*)
     if ( v.is("blacklist") )
         conf->blacklist_path = snort_strdup(v.get_string());
 
+    else if ( v.is("list_image") )
+        conf->list_image = snort_strdup(v.get_string());
+
+    else if ( v.is("lookup") )
+        conf->table = (IPTable)v.get_long();
+
     else if ( v.is("memcap") )
         conf->memcap = v.get_long();
 
@@ -146,15 +158,32 @@ bool ReputationModule::begin(const char*, int, SnortConfig*)
 
 bool ReputationModule::end(const char*, int, SnortConfig*)
 {
-    EstimateNumEntries(conf);
-    if (conf->numEntries <= 0)
+    if ( conf->list_image )
     {
-        ParseWarning(WARN_CONF, "Can't find any whitelist/blacklist entries. "
-            "Reputation Preprocessor disabled.\n");
-        return true;
+        if ( conf->blacklist_path or conf->whitelist_path )
+            ParseWarning(WARN_CONF, "Keywords \"blacklist\" and \"whitelist\" are "
+                "ignored when \"list_image\" is set.\n");
+
+        LoadListImage(conf->list_image, conf);
     }
+    else
+    {
+        EstimateNumEntries(conf);
+        if (conf->numEntries <= 0)
+        {
+            ParseWarning(WARN_CONF, "Can't find any whitelist/blacklist entries. "
+                "Reputation Preprocessor disabled.\n");
+            return true;
+        }
+
+        IpListInit(conf->numEntries + 1, conf);
 
-    IpListInit(conf->numEntries + 1, conf);
+        LoadListFile(conf->blacklist_path, conf->local_black_ptr, conf);
+        LoadListFile(conf->whitelist_path, conf->local_white_ptr, conf);
+
+        if ( sfrt_flat_compile(conf->iplist) != RT_SUCCESS )
+            FatalError("Failed to compile IP list.\n");
+    }
 
     if ( (conf->priority == WHITELISTED_TRUST) && (conf->whiteAction == UNBLACK) )
     {
@@ -162,9 +191,6 @@ bool ReputationModule::end(const char*, int, SnortConfig*)
             "not applied when white action is unblack.\n");
             conf->priority = WHITELISTED_UNBLACK;
     }
-
-    LoadListFile(conf->blacklist_path, conf->local_black_ptr, conf);
-    LoadListFile(conf->whitelist_path, conf->local_white_ptr, conf);
     return true;
 }
 
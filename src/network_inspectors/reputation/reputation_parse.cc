@@ -21,7 +21,12 @@
 #include "reputation_parse.h"
 
 #include <assert.h>
+#include <fcntl.h>
 #include <limits>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "log/messages.h"
 #include "main/snort_debug.h"
@@ -54,9 +59,15 @@ int totalNumEntries = 0;
 
 ReputationConfig::~ReputationConfig()
 {
-    if (reputation_segment != nullptr)
+    if (image_map != nullptr)
+        munmap(image_map, image_size);
+
+    else if (reputation_segment != nullptr)
         snort_free(reputation_segment);
 
+    if (list_image)
+        snort_free(list_image);
+
     if (blacklist_path)
         snort_free(blacklist_path);
 
@@ -102,6 +113,7 @@ void IpListInit(uint32_t maxEntries, ReputationConfig* config)
         uint32_t mem_size;
         mem_size = estimateSizeFromEntries(maxEntries, config->memcap);
         config->reputation_segment = (uint8_t*)snort_alloc(mem_size);
+        config->segment_size = mem_size;
 
         segment_meminit(config->reputation_segment, mem_size);
         base = config->reputation_segment;
@@ -109,8 +121,11 @@ void IpListInit(uint32_t maxEntries, ReputationConfig* config)
         /*DIR_16x7_4x4 for performance, but memory usage is high
          *Use  DIR_8x16 worst case IPV4 5K, IPV6 15K (bytes)
          *Use  DIR_16x7_4x4 worst case IPV4 500, IPV6 2.5M
+         *Use  POPTRIE for large lists, lookups are about as fast as DIR_8x16
+         *and it is compiled to a small fraction of the size
          */
-        config->iplist = sfrt_flat_new(DIR_8x16, IPv6, maxEntries, config->memcap);
+        config->iplist = sfrt_flat_new(
+            config->table == TABLE_POPTRIE ? POPTRIE : DIR_8x16, IPv6, maxEntries, config->memcap);
 
         if ( !config->iplist )
             FatalError("Failed to create IP list.\n");
@@ -553,11 +568,11 @@ static int ProcessLine(char* line, INFO info, ReputationConfig* config)
     return AddIPtoList(&address, info, config);
 }
 
-static int UpdatePathToFile(char* full_path_filename, unsigned int max_size, char* filename)
+static int UpdatePathToFile(char* full_path_filename, unsigned int max_size, const char* filename)
 {
     const char* snort_conf_dir = get_snort_conf_dir();
 
-    if (!snort_conf_dir || !(*snort_conf_dir) || !full_path_filename || !filename)
+    if (!full_path_filename || !filename)
         FatalError("can't create path.\n");
 
     /*filename is too long*/
@@ -580,6 +595,9 @@ static int UpdatePathToFile(char* full_path_filename, unsigned int max_size, cha
         /*
          * Set up the file name directory.
          */
+        if (!snort_conf_dir || !(*snort_conf_dir))
+            FatalError("can't create path.\n");
+
         if (snort_conf_dir[strlen(snort_conf_dir) - 1] == '/')
         {
             snprintf(full_path_filename,max_size,
@@ -601,6 +619,9 @@ static int UpdatePathToFile(char* full_path_filename, unsigned int max_size, cha
         /*
          **  Set up the file name directory
          */
+        if (!snort_conf_dir || !(*snort_conf_dir))
+            FatalError("can't create path.\n");
+
         if (snort_conf_dir[strlen(snort_conf_dir) - 1] == '\\' ||
             snort_conf_dir[strlen(snort_conf_dir) - 1] == '/' )
         {
@@ -819,6 +840,200 @@ void EstimateNumEntries(ReputationConfig* config)
     config->numEntries = totalLines;
 }
 
+//-------------------------------------------------------------------------
+// list images
+//
+// The segment is position independent: the table is the first allocation
+// so every offset is relative to config->iplist.  An image is a header
+// followed by the used part of the segment.  It is only valid on the
+// architecture and build that wrote it, which the header checks.
+//-------------------------------------------------------------------------
+
+static const char* const white_action_name[] = { "unblack", "trust" };
+
+bool SaveListImage(const char* filename, ReputationConfig* config)
+{
+    if ( !config->iplist )
+        return false;
+
+    // the segment is allocated front to back and only this list has been
+    // loaded into it so the tail beyond the last allocation is never used
+    uint32_t used = config->segment_size - segment_unusedmem();
+
+    ListImageHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, LIST_IMAGE_MAGIC, sizeof(hdr.magic));
+    hdr.version = LIST_IMAGE_VERSION;
+    hdr.byte_order = LIST_IMAGE_BYTE_ORDER;
+    hdr.header_size = sizeof(hdr);
+    hdr.info_size = sizeof(ListInfo) + sizeof(IPrepInfo);
+    hdr.segment_size = used;
+    hdr.num_entries = sfrt_flat_num_entries(config->iplist);
+    hdr.white_action = (uint8_t)config->whiteAction;
+
+    // write a new file and rename it over the old one so that processes
+    // which still map the old image keep a consistent copy
+    std::string tmp = filename;
+    tmp += ".tmp";
+
+    FILE* fp = fopen(tmp.c_str(), "wb");
+
+    if ( !fp )
+    {
+        ErrorMessage("Unable to create list image %s, Error: %s\n", tmp.c_str(),
+            get_error(errno));
+        return false;
+    }
+
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1 and
+        fwrite(config->reputation_segment, used, 1, fp) == 1;
+
+    if ( fclose(fp) )
+        ok = false;
+
+    if ( ok and rename(tmp.c_str(), filename) )
+        ok = false;
+
+    if ( !ok )
+    {
+        ErrorMessage("Unable to write list image %s, Error: %s\n", filename, get_error(errno));
+        unlink(tmp.c_str());
+        return false;
+    }
+
+    LogMessage("    Reputation list image %s: %u entries, %u bytes\n",
+        filename, hdr.num_entries, used);
+
+    return true;
+}
+
+// every data entry is a chain of IPrepInfo, check that the chains stay in
+// the segment and only index the list info table
+static bool ListImageInfoValid(const table_flat_t* table, MEM_OFFSET size)
+{
+    const uint8_t* base = (const uint8_t*)table;
+    const INFO* data = (const INFO*)&base[table->data];
+
+    // each IPrepInfo is on one chain so all of them together are no longer
+    // than the segment has room for
+    MEM_OFFSET budget = size / sizeof(IPrepInfo);
+
+    for ( uint32_t i = 0; i < table->max_size; i++ )
+    {
+        for ( MEM_OFFSET info = data[i]; info; )
+        {
+            if ( !budget-- or info > size or size - info < sizeof(IPrepInfo) )
+                return false;
+
+            const IPrepInfo* rep_info = (const IPrepInfo*)&base[info];
+
+            for ( int j = 0; j < NUM_INDEX_PER_ENTRY; j++ )
+            {
+                if ( (unsigned char)rep_info->listIndexes[j] > DECISION_MAX )
+                    return false;
+            }
+            info = rep_info->next;
+        }
+    }
+    return true;
+}
+
+static bool ListImageValid(const ListImageHeader* hdr, size_t file_size, const char* filename)
+{
+    const char* problem = nullptr;
+
+    if ( file_size < sizeof(*hdr) or memcmp(hdr->magic, LIST_IMAGE_MAGIC, sizeof(hdr->magic)) )
+        problem = "not a list image";
+
+    else if ( hdr->version != LIST_IMAGE_VERSION or hdr->byte_order != LIST_IMAGE_BYTE_ORDER or
+        hdr->header_size != sizeof(*hdr) or
+        hdr->info_size != sizeof(ListInfo) + sizeof(IPrepInfo) )
+        problem = "list image was compiled for a different version or architecture";
+
+    else if ( hdr->segment_size < sizeof(table_flat_t) or
+        hdr->segment_size > file_size - sizeof(*hdr) )
+        problem = "list image is truncated";
+
+    else
+    {
+        const table_flat_t* table = (const table_flat_t*)(hdr + 1);
+
+        if ( !sfrt_flat_valid(table, hdr->segment_size) or
+            table->list_info > hdr->segment_size or
+            (hdr->segment_size - table->list_info) / sizeof(ListInfo) < DECISION_MAX or
+            !ListImageInfoValid(table, hdr->segment_size) )
+            problem = "list image is corrupt";
+    }
+
+    if ( problem )
+    {
+        ParseError("%s: %s\n", filename, problem);
+        return false;
+    }
+    return true;
+}
+
+bool LoadListImage(const char* filename, ReputationConfig* config)
+{
+    char full_path_filename[PATH_MAX+1];
+    UpdatePathToFile(full_path_filename, PATH_MAX, filename);
+
+    int fd = open(full_path_filename, O_RDONLY);
+
+    if ( fd < 0 )
+    {
+        ParseError("Unable to open list image %s, Error: %s\n", full_path_filename,
+            get_error(errno));
+        return false;
+    }
+
+    struct stat sb;
+    void* map = MAP_FAILED;
+
+    if ( !fstat(fd, &sb) and sb.st_size > 0 )
+        map = mmap(nullptr, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // the mapping keeps its own reference to the file
+    close(fd);
+
+    if ( map == MAP_FAILED )
+    {
+        ParseError("Unable to map list image %s, Error: %s\n", full_path_filename,
+            get_error(errno));
+        return false;
+    }
+
+    const ListImageHeader* hdr = (const ListImageHeader*)map;
+
+    if ( !ListImageValid(hdr, sb.st_size, full_path_filename) )
+    {
+        munmap(map, sb.st_size);
+        return false;
+    }
+
+    if ( hdr->white_action != config->whiteAction )
+        ParseWarning(WARN_CONF, "%s was compiled with white = %s which overrides the "
+            "configured white action.\n", full_path_filename, white_action_name[hdr->white_action & 1]);
+
+    // the lists are needed right away so fault the pages in now
+    madvise(map, sb.st_size, MADV_WILLNEED);
+
+    config->image_map = map;
+    config->image_size = sb.st_size;
+    config->reputation_segment = (uint8_t*)(hdr + 1);
+    config->segment_size = hdr->segment_size;
+    config->iplist = (table_flat_t*)config->reputation_segment;
+    config->whiteAction = (WhiteAction)(hdr->white_action & 1);
+
+    // nothing is allocated from an image but the sfrt helpers that report
+    // usage find the segment through the base pointer
+    segment_meminit(config->reputation_segment, 0);
+
+    LogMessage("    Mapped list image %s: %u entries\n", full_path_filename, hdr->num_entries);
+
+    return true;
+}
+
 #ifdef DEBUG_MSGS
 static void ReputationRepInfo(IPrepInfo* repInfo, uint8_t* base, char* repInfoBuff,
     int bufLen)
@@ -878,4 +1093,3 @@ void ReputationPrintRepInfo(IPrepInfo* repInfo, uint8_t* base)
 }
 
 #endif
-
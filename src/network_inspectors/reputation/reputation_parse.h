@@ -26,4 +26,29 @@ void IpListInit(uint32_t,ReputationConfig *config);
 void EstimateNumEntries(ReputationConfig* config);
 void LoadListFile(char* filename, INFO info, ReputationConfig* config);
 
+// a list image is the finished segment written by rep_compiler; it is
+// mapped read-only in place of IpListInit() and LoadListFile()
+bool SaveListImage(const char* filename, ReputationConfig* config);
+bool LoadListImage(const char* filename, ReputationConfig* config);
+
+// the image is a header followed by the used part of the segment
+#define LIST_IMAGE_MAGIC "SNREPIMG"
+#define LIST_IMAGE_VERSION 2
+#define LIST_IMAGE_BYTE_ORDER 0x01020304
+
+struct ListImageHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t header_size;
+    uint32_t info_size;      // sizeof(ListInfo) + sizeof(IPrepInfo) of the writer
+    uint32_t segment_size;
+    uint32_t num_entries;
+    uint8_t white_action;
+    uint8_t reserved[31];
+};
+
+static_assert(sizeof(ListImageHeader) == 64, "list image header must stay 64 bytes");
+
 #endif
@@ -0,0 +1,381 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// reputation_parse_test.cc
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "catch/catch.hpp"
+#include "catch/unit_test.h"
+#include "sfip/sf_ip.h"
+#include "sfrt/sfrt_poptrie.h"
+
+#include "reputation_parse.h"
+
+//---------------------------------------------------------------
+
+SNORT_CATCH_FORCED_INCLUSION_DEFINITION(reputation_parse_test);
+
+static std::string write_temp(const void* data, size_t len)
+{
+    char path[] = "/tmp/reputation_testXXXXXX";
+    int fd = mkstemp(path);
+    REQUIRE(fd >= 0);
+    REQUIRE(write(fd, data, len) == (ssize_t)len);
+    close(fd);
+    return path;
+}
+
+static void build_test_list(ReputationConfig& config)
+{
+    const char* list = "10.1.2.0/24\n192.0.2.7\n2001:db8::/32\n";
+    std::string path = write_temp(list, strlen(list));
+
+    config.memcap = 10;
+    IpListInit(16, &config);
+    LoadListFile((char*)path.c_str(), config.local_black_ptr, &config);
+    unlink(path.c_str());
+
+    REQUIRE(sfrt_flat_compile(config.iplist) == RT_SUCCESS);
+}
+
+static bool test_blacklisted(ReputationConfig& config, const char* addr)
+{
+    sfip_t ip;
+    REQUIRE(sfip_pton(addr, &ip) == SFIP_SUCCESS);
+
+    IPrepInfo* info = (IPrepInfo*)((config.iplist->table_flat_type == POPTRIE) ?
+        sfrt_flat_poptrie_lookup(&ip, config.iplist) :
+        sfrt_flat_dir8x_lookup(&ip, config.iplist));
+
+    return info and info->listIndexes[0] == BLACKLISTED + 1;
+}
+
+static std::vector<uint8_t> read_image(const std::string& path)
+{
+    std::vector<uint8_t> buf;
+    FILE* fp = fopen(path.c_str(), "rb");
+    REQUIRE(fp);
+
+    int c;
+    while ( (c = fgetc(fp)) != EOF )
+        buf.push_back((uint8_t)c);
+
+    fclose(fp);
+    return buf;
+}
+
+static std::vector<uint8_t> save_image(IPTable table)
+{
+    ReputationConfig saved;
+    saved.table = table;
+    build_test_list(saved);
+
+    std::string path = write_temp("", 0);
+    REQUIRE(SaveListImage(path.c_str(), &saved));
+
+    std::vector<uint8_t> image = read_image(path);
+    unlink(path.c_str());
+    return image;
+}
+
+static bool load_image(const std::vector<uint8_t>& image)
+{
+    std::string path = write_temp(image.data(), image.size());
+    ReputationConfig config;
+    bool ok = LoadListImage(path.c_str(), &config);
+    unlink(path.c_str());
+    return ok;
+}
+
+TEST_CASE("list image round trip", "[reputation]")
+{
+    for ( auto table : { TABLE_DIR, TABLE_POPTRIE } )
+    {
+        ReputationConfig saved;
+        saved.table = table;
+        build_test_list(saved);
+
+        std::string path = write_temp("", 0);
+        REQUIRE(SaveListImage(path.c_str(), &saved));
+
+        ReputationConfig loaded;
+        REQUIRE(LoadListImage(path.c_str(), &loaded));
+        unlink(path.c_str());
+
+        CHECK(loaded.image_map != nullptr);
+        CHECK(loaded.iplist->table_flat_type == saved.iplist->table_flat_type);
+        CHECK(sfrt_flat_num_entries(loaded.iplist) == sfrt_flat_num_entries(saved.iplist));
+
+        for ( auto config : { &saved, &loaded } )
+        {
+            CHECK(test_blacklisted(*config, "10.1.2.3"));
+            CHECK(test_blacklisted(*config, "192.0.2.7"));
+            CHECK(test_blacklisted(*config, "2001:db8::1"));
+            CHECK(!test_blacklisted(*config, "10.1.3.1"));
+            CHECK(!test_blacklisted(*config, "192.0.2.8"));
+            CHECK(!test_blacklisted(*config, "2001:db9::1"));
+        }
+    }
+}
+
+TEST_CASE("list image rejected", "[reputation]")
+{
+    ReputationConfig saved;
+    build_test_list(saved);
+
+    std::string path = write_temp("", 0);
+    REQUIRE(SaveListImage(path.c_str(), &saved));
+
+    std::vector<uint8_t> image = read_image(path);
+    unlink(path.c_str());
+
+    const ListImageHeader* hdr = (const ListImageHeader*)image.data();
+    REQUIRE(image.size() == sizeof(*hdr) + hdr->segment_size);
+    REQUIRE(load_image(image));
+
+    SECTION("truncated")
+    {
+        image.resize(image.size() - 1);
+        CHECK(!load_image(image));
+
+        image.resize(sizeof(*hdr) - 1);
+        CHECK(!load_image(image));
+    }
+    SECTION("bad magic")
+    {
+        image[0] ^= 0xff;
+        CHECK(!load_image(image));
+    }
+    SECTION("different version")
+    {
+        ((ListImageHeader*)image.data())->version++;
+        CHECK(!load_image(image));
+    }
+    SECTION("out of range offsets")
+    {
+        table_flat_t* table = (table_flat_t*)(image.data() + sizeof(*hdr));
+        MEM_OFFSET end = hdr->segment_size;
+
+        table->rt = end;
+        CHECK(!load_image(image));
+
+        table->rt = 0;
+        CHECK(!load_image(image));
+
+        table->rt = saved.iplist->rt;
+        table->rt6 = end;
+        CHECK(!load_image(image));
+
+        table->rt6 = 0;
+        CHECK(!load_image(image));
+
+        table->rt6 = saved.iplist->rt6;
+        table->data = end;
+        CHECK(!load_image(image));
+
+        table->data = saved.iplist->data;
+        table->list_info = end - sizeof(ListInfo);
+        CHECK(!load_image(image));
+    }
+}
+
+TEST_CASE("list image rejects corrupt entries", "[reputation]")
+{
+    std::vector<uint8_t> image = save_image(TABLE_DIR);
+    const ListImageHeader* hdr = (const ListImageHeader*)image.data();
+    uint8_t* base = image.data() + sizeof(*hdr);
+    table_flat_t* table = (table_flat_t*)base;
+    MEM_OFFSET end = hdr->segment_size;
+
+    INFO* data = (INFO*)&base[table->data];
+    uint32_t i = 0;
+
+    while ( i < table->max_size and !data[i] )
+        i++;
+
+    REQUIRE(i < table->max_size);
+    REQUIRE(load_image(image));
+
+    IPrepInfo* info = (IPrepInfo*)&base[data[i]];
+
+    SECTION("chain")
+    {
+        info->next = end;
+        CHECK(!load_image(image));
+    }
+    SECTION("list index")
+    {
+        info->listIndexes[0] = DECISION_MAX + 1;
+        CHECK(!load_image(image));
+
+        info->listIndexes[0] = -1;
+        CHECK(!load_image(image));
+    }
+}
+
+TEST_CASE("list image rejects corrupt dir tables", "[reputation]")
+{
+    std::vector<uint8_t> image = save_image(TABLE_DIR);
+    const ListImageHeader* hdr = (const ListImageHeader*)image.data();
+    uint8_t* base = image.data() + sizeof(*hdr);
+    table_flat_t* table = (table_flat_t*)base;
+    MEM_OFFSET end = hdr->segment_size;
+
+    REQUIRE(table->table_flat_type == DIR_8x16);
+    REQUIRE(load_image(image));
+
+    dir_table_flat_t* root = (dir_table_flat_t*)&base[table->rt6];
+    dir_sub_table_flat_t* sub = (dir_sub_table_flat_t*)&base[root->sub_table];
+    DIR_Entry* entries = (DIR_Entry*)&base[sub->entries];
+
+    // 2001:db8::/32 takes a subtable for the 0x20 in the first byte
+    REQUIRE(entries[0x20].value);
+    REQUIRE(!entries[0x20].length);
+
+    SECTION("dimensions")
+    {
+        root->dimensions[0] = 16;
+        CHECK(!load_image(image));
+    }
+    SECTION("width")
+    {
+        sub->width = 16;
+        CHECK(!load_image(image));
+    }
+    SECTION("entries")
+    {
+        sub->entries = end - sizeof(DIR_Entry);
+        CHECK(!load_image(image));
+    }
+    SECTION("subtable")
+    {
+        entries[0x20].value = end;
+        CHECK(!load_image(image));
+    }
+    SECTION("data index")
+    {
+        entries[0].value = table->max_size;
+        entries[0].length = 8;
+        CHECK(!load_image(image));
+    }
+}
+
+TEST_CASE("list image rejects corrupt poptrie tables", "[reputation]")
+{
+    std::vector<uint8_t> image = save_image(TABLE_POPTRIE);
+    const ListImageHeader* hdr = (const ListImageHeader*)image.data();
+    uint8_t* base = image.data() + sizeof(*hdr);
+    table_flat_t* table = (table_flat_t*)base;
+    MEM_OFFSET end = hdr->segment_size;
+
+    REQUIRE(table->table_flat_type == POPTRIE);
+    REQUIRE(load_image(image));
+
+    poptrie_flat_t* flat = (poptrie_flat_t*)&base[table->rt6];
+    poptrie_flat_node_t* nodes = (poptrie_flat_node_t*)&base[flat->nodes];
+    FLAT_INDEX* leaves = (FLAT_INDEX*)&base[flat->leaves];
+
+    // 2001:db8::/32 is longer than the direct bits so it takes nodes
+    REQUIRE((flat->direct[0x2001] & POPTRIE_NODE));
+    uint32_t n = flat->direct[0x2001] & ~POPTRIE_NODE;
+    poptrie_flat_node_t* node = &nodes[n];
+    REQUIRE(node->vector);
+
+    SECTION("direct")
+    {
+        flat->direct[0] = table->max_size;
+        CHECK(!load_image(image));
+
+        flat->direct[0x2001] = POPTRIE_NODE | (end / sizeof(poptrie_flat_node_t));
+        CHECK(!load_image(image));
+    }
+    SECTION("nodes")
+    {
+        flat->nodes = end;
+        CHECK(!load_image(image));
+    }
+    SECTION("cycle")
+    {
+        node->base1 = n;
+        CHECK(!load_image(image));
+    }
+    SECTION("children")
+    {
+        node->base1 = end / sizeof(poptrie_flat_node_t);
+        CHECK(!load_image(image));
+    }
+    SECTION("missing leaf")
+    {
+        node->leafvec = 0;
+        CHECK(!load_image(image));
+    }
+    SECTION("leaves")
+    {
+        node->base0 = end / sizeof(FLAT_INDEX);
+        CHECK(!load_image(image));
+    }
+    SECTION("data index")
+    {
+        leaves[node->base0] = table->max_size;
+        CHECK(!load_image(image));
+    }
+    SECTION("depth")
+    {
+        // add room for a new node array at the end of the segment and
+        // chain nodes down slot 0 until the last one starts at the end of
+        // the key and then one more
+        unsigned max_depth = (128 - POPTRIE_DIRECT_BITS + POPTRIE_STRIDE - 1) / POPTRIE_STRIDE;
+        MEM_OFFSET nodes_ptr = (end + 7) & ~(MEM_OFFSET)7;
+        MEM_OFFSET size = nodes_ptr + (max_depth + 1) * sizeof(poptrie_flat_node_t);
+
+        image.resize(sizeof(*hdr) + size);
+        hdr = (const ListImageHeader*)image.data();
+        ((ListImageHeader*)hdr)->segment_size = size;
+
+        base = image.data() + sizeof(*hdr);
+        flat = (poptrie_flat_t*)&base[((table_flat_t*)base)->rt6];
+        flat->nodes = nodes_ptr;
+        flat->direct[0x2001] = POPTRIE_NODE;
+        nodes = (poptrie_flat_node_t*)&base[nodes_ptr];
+
+        for ( uint32_t i = 0; i <= max_depth; i++ )
+        {
+            nodes[i].vector = 1;
+            nodes[i].leafvec = 1;
+            nodes[i].base1 = i + 1;
+            nodes[i].base0 = 0;
+        }
+        nodes[max_depth].vector = 0;
+        nodes[max_depth - 1].vector = 0;
+        CHECK(load_image(image));
+
+        nodes[max_depth - 1].vector = 1;
+        CHECK(!load_image(image));
+    }
+}
@@ -21,6 +21,7 @@
 
 #include <dirent.h>
 #include <fnmatch.h>
+#include <sfbpf_dlt.h>
 
 #include <algorithm>
 #include <fstream>
@@ -28,6 +29,10 @@
 #include "helpers/directory.h"
 #include "log/messages.h"
 #include "main/snort_config.h"
+#include "main/snort_types.h"
+#include "main/thread.h"
+#include "main/thread_config.h"
+#include "utils/stats.h"
 
 std::vector<struct Trough::PcapReadObject> Trough::pcap_object_list;
 std::vector<std::string> Trough::pcap_queue;
@@ -36,6 +41,18 @@ std::vector<std::string>::const_iterator Trough::pcap_queue_iter;
 long Trough::pcap_loop_count = 0;
 unsigned Trough::file_count = 0;
 
+bool Trough::shard = false;
+std::vector<Trough::ShardFileStats> Trough::shard_stats;
+
+struct ShardCounts
+{
+    uint64_t packets;
+    uint64_t bytes;
+    uint64_t skipped;
+};
+
+static THREAD_LOCAL ShardCounts shard_counts;
+
 int Trough::get_pcaps(std::vector<struct PcapReadObject> &pol)
 {
     for (const PcapReadObject &pro : pol)
@@ -231,6 +248,7 @@ void Trough::cleanup()
 {
     /* clean up pcap queues */
     pcap_queue.clear();
+    shard_stats.clear();
 }
 
 const char* Trough::get_next()
@@ -251,6 +269,14 @@ const char* Trough::get_next()
     }
 
     file_count++;
+
+    if ( shard )
+    {
+        ShardFileStats sfs;
+        sfs.file = pcap;
+        sfs.threads.resize(ThreadConfig::get_instance_max());
+        shard_stats.push_back(sfs);
+    }
     return pcap;
 }
 
@@ -259,3 +285,209 @@ bool Trough::has_next()
     return (!pcap_queue.empty() && pcap_queue_iter != pcap_queue.cend());
 }
 
+
+//-------------------------------------------------------------------------
+// shard mode
+//-------------------------------------------------------------------------
+
+#define ETHERTYPE_IPV4 0x0800
+#define ETHERTYPE_IPV6 0x86dd
+#define ETHERTYPE_VLAN 0x8100
+#define ETHERTYPE_QINQ 0x88a8
+
+static inline uint32_t get_u32(const uint8_t* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline uint16_t get_u16(const uint8_t* p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+// the hash must be symmetric so both directions of a flow land on the same
+// thread and must ignore ports so that ip fragments stay with their flow
+static uint32_t hash_ip(const uint8_t* pkt, uint32_t len)
+{
+    if ( len < 1 )
+        return 0;
+
+    unsigned ver = pkt[0] >> 4;
+    uint32_t a = 0, b = 0;
+
+    if ( ver == 4 and len >= 20 )
+    {
+        a = get_u32(pkt + 12);
+        b = get_u32(pkt + 16);
+    }
+    else if ( ver == 6 and len >= 40 )
+    {
+        for ( unsigned i = 0; i < 16; i += 4 )
+        {
+            a = (a * 31) + get_u32(pkt + 8 + i);
+            b = (b * 31) + get_u32(pkt + 24 + i);
+        }
+    }
+    else
+        return 0;
+
+    uint32_t h = (a ^ b) + (a < b ? a : b);
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    return h;
+}
+
+bool Trough::owns(int dlt, const uint8_t* pkt, uint32_t len, unsigned id, unsigned max)
+{
+    if ( max < 2 )
+        return true;
+
+    if ( dlt == DLT_EN10MB )
+    {
+        if ( len < 14 )
+            return id == 0;
+
+        uint32_t off = 12;
+        uint16_t type = get_u16(pkt + off);
+
+        while ( (type == ETHERTYPE_VLAN or type == ETHERTYPE_QINQ) and len >= off + 6 )
+        {
+            off += 4;
+            type = get_u16(pkt + off);
+        }
+        off += 2;
+
+        if ( type != ETHERTYPE_IPV4 and type != ETHERTYPE_IPV6 )
+            return id == 0;
+
+        pkt += off;
+        len -= off;
+    }
+    else if ( dlt != DLT_RAW
+#ifdef DLT_IPV4
+        and dlt != DLT_IPV4
+#endif
+#ifdef DLT_IPV6
+        and dlt != DLT_IPV6
+#endif
+        )
+    {
+        // unsupported link layer; let the first thread have it all
+        return id == 0;
+    }
+
+    // non-ip traffic goes to the first thread
+    return (hash_ip(pkt, len) % max) == id;
+}
+
+void Trough::count(uint32_t len, bool owned)
+{
+    if ( owned )
+    {
+        shard_counts.packets++;
+        shard_counts.bytes += len;
+    }
+    else
+        shard_counts.skipped++;
+}
+
+// each thread writes only its own slot of the current file; the main thread
+// doesn't start the next file or read the stats until all threads are joined
+void Trough::shard_done(unsigned id, double secs, uint64_t alerts)
+{
+    if ( shard_stats.empty() or id >= shard_stats.back().threads.size() )
+        return;
+
+    ShardThreadStats& sts = shard_stats.back().threads[id];
+
+    sts.packets = shard_counts.packets;
+    sts.bytes = shard_counts.bytes;
+    sts.skipped = shard_counts.skipped;
+    sts.alerts = alerts;
+    sts.secs = secs;
+
+    // skipped is cleared when the daq counts are summed
+    shard_counts.packets = shard_counts.bytes = 0;
+}
+
+uint64_t Trough::take_skipped()
+{
+    uint64_t skipped = shard_counts.skipped;
+    shard_counts.skipped = 0;
+    return skipped;
+}
+
+static void show_shard_line(
+    const char* label, uint64_t pkts, uint64_t bytes, uint64_t alerts, double secs)
+{
+    if ( secs <= 0.0 )
+        secs = 1e-6;
+
+    LogMessage("%12.12s " FMTu64("12") " " FMTu64("14") " " FMTu64("8") " %10.3f %12.0f %10.2f\n",
+        label, pkts, bytes, alerts, secs, pkts / secs, (bytes * 8.0) / (secs * 1e6));
+}
+
+void Trough::show_shard_stats()
+{
+    if ( shard_stats.empty() )
+        return;
+
+    LogLabel("Shard Statistics");
+
+    std::vector<ShardThreadStats> totals(ThreadConfig::get_instance_max());
+    uint64_t skipped = 0;
+
+    for ( const auto& sfs : shard_stats )
+    {
+        uint64_t pkts = 0, bytes = 0, alerts = 0;
+        double secs = 0.0;
+
+        LogMessage("%s\n", sfs.file.c_str());
+        LogMessage("%12.12s %12.12s %14.14s %8.8s %10.10s %12.12s %10.10s\n",
+            "thread", "packets", "bytes", "alerts", "seconds", "pkts/sec", "Mbits/sec");
+
+        for ( unsigned i = 0; i < sfs.threads.size(); ++i )
+        {
+            const ShardThreadStats& sts = sfs.threads[i];
+            std::string id = std::to_string(i);
+
+            show_shard_line(id.c_str(), sts.packets, sts.bytes, sts.alerts, sts.secs);
+
+            pkts += sts.packets;
+            bytes += sts.bytes;
+            alerts += sts.alerts;
+            skipped += sts.skipped;
+
+            // threads run concurrently so the file took as long as the slowest
+            if ( sts.secs > secs )
+                secs = sts.secs;
+
+            if ( i < totals.size() )
+            {
+                totals[i].packets += sts.packets;
+                totals[i].bytes += sts.bytes;
+                totals[i].alerts += sts.alerts;
+                totals[i].secs += sts.secs;
+            }
+        }
+        show_shard_line("file", pkts, bytes, alerts, secs);
+    }
+
+    LogMessage("%s\n", "all files");
+    LogMessage("%12.12s %12.12s %14.14s %8.8s %10.10s %12.12s %10.10s\n",
+        "thread", "packets", "bytes", "alerts", "seconds", "pkts/sec", "Mbits/sec");
+
+    for ( unsigned i = 0; i < totals.size(); ++i )
+    {
+        std::string id = std::to_string(i);
+        show_shard_line(id.c_str(), totals[i].packets, totals[i].bytes,
+            totals[i].alerts, totals[i].secs);
+    }
+
+    // the daq module counts what each thread read, not what it processed
+    LogMessage("each thread read every packet; the " FMTu64("-") " packets skipped by threads\n"
+        "that don't own them are not included in the daq received, analyzed, and\n"
+        "pass counts, which reflect the packets above\n", skipped);
+}
+
@@ -20,10 +20,15 @@
 #ifndef TROUGH_H
 #define TROUGH_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 // Trough provides access to sources (interface, file, etc.).
+//
+// In shard mode each pcap is read by all packet threads at once; each
+// thread processes only the packets whose address pair hashes to its
+// instance so that a single large pcap is spread across all cores.
 
 class Trough
 {
@@ -57,6 +62,28 @@ public:
         return pcap_loop_count;
     }
     static void cleanup();
+
+    static void set_shard(bool s)
+    {
+        shard = s;
+    }
+    static bool sharding()
+    {
+        return shard;
+    }
+
+    // called by packet threads
+    static bool owns(int dlt, const uint8_t* pkt, uint32_t len, unsigned id, unsigned max);
+    static void count(uint32_t len, bool owned);
+    static void shard_done(unsigned id, double secs, uint64_t alerts);
+
+    // every thread reads the whole pcap so the packets it skips must be
+    // taken out of its daq counts; returns and clears this thread's count
+    static uint64_t take_skipped();
+
+    // called by main thread after all threads are done
+    static void show_shard_stats();
+
 private:
     struct PcapReadObject
     {
@@ -65,6 +92,21 @@ private:
         std::string filter;
     };
 
+    struct ShardThreadStats
+    {
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+        uint64_t skipped = 0;
+        uint64_t alerts = 0;
+        double secs = 0.0;
+    };
+
+    struct ShardFileStats
+    {
+        std::string file;
+        std::vector<ShardThreadStats> threads;
+    };
+
     static int get_pcaps(std::vector<struct PcapReadObject> &pol);
     static std::vector<struct PcapReadObject> pcap_object_list;
     static std::vector<std::string> pcap_queue;
@@ -72,6 +114,9 @@ private:
     static std::string pcap_filter;
     static long pcap_loop_count;
     static unsigned file_count;
+
+    static bool shard;
+    static std::vector<ShardFileStats> shard_stats;
 };
 
 #endif
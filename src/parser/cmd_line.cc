@@ -61,6 +61,12 @@ static void check_flags(SnortConfig* sc)
         FatalError("--pcap-reload can only be used in combination with pcaps "
             "on the command line.\n");
     }
+
+    if (Trough::sharding() && !(sc->run_flags & RUN_FLAG__READ))
+    {
+        FatalError("--pcap-shard can only be used in combination with pcaps "
+            "on the command line.\n");
+    }
 }
 
 //-------------------------------------------------------------------------
@@ -57,12 +57,19 @@ struct PortGroup
     // pattern matchers
     class Mpse* mpse[PM_TYPE_MAX];
 
+    // with search_engine.merge_buffers, all but file patterns are here
+    class Mpse* merged;
+    unsigned merged_types;  // 1 << PmType of each pattern in merged
+
     // detection option tree
     void* nfp_tree;
 
     unsigned rule_count;
     unsigned nfp_rule_count;
 
+    // some rule reads pdu, body, or file data (see inspects_body())
+    bool body_rules;
+
     void add_rule();
     bool add_nfp_rule(void*);
     void delete_nfp_rules();
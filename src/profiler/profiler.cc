@@ -31,6 +31,7 @@
 #include "main/snort_config.h"
 
 #include "profiler_nodes.h"
+#include "profiler_snapshot.h"
 #include "memory_context.h"
 #include "memory_profiler.h"
 #include "time_profiler.h"
@@ -92,6 +93,20 @@ void Profiler::show_stats()
     show_rule_profiler_stats(config->rule);
 }
 
+void Profiler::prepare_snapshot()
+{ prepare_profiler_snapshot(s_profiler_nodes); }
+
+void Profiler::snapshot()
+{ snapshot_profiler_stats(s_profiler_nodes); }
+
+void Profiler::write_snapshot()
+{
+    const auto* config = SnortConfig::get_profiler();
+    assert(config);
+
+    write_profiler_snapshot(s_profiler_nodes, *config);
+}
+
 #ifdef UNIT_TEST
 
 TEST_CASE( "profile stats", "[profiler]" )
@@ -37,6 +37,12 @@ public:
     static void consolidate_stats();
     static void reset_stats();
     static void show_stats();
+
+    // live snapshots; prepare and write are called on the main thread
+    // and snapshot is called by each packet thread in between
+    static void prepare_snapshot();
+    static void snapshot();
+    static void write_snapshot();
 };
 
 
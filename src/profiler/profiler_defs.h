@@ -29,11 +29,24 @@
 
 #define ROOT_NODE "total"
 
+// live snapshots of module and rule time stats written as deltas
+struct ProfilerSnapshotConfig
+{
+    enum Format
+    {
+        FMT_JSON = 0,
+        FMT_CSV
+    } format = FMT_JSON;
+
+    unsigned interval = 0;  // seconds; 0 = only on command
+};
+
 struct ProfilerConfig
 {
     TimeProfilerConfig time;
     RuleProfilerConfig rule;
     MemoryProfilerConfig memory;
+    ProfilerSnapshotConfig snapshot;
 };
 
 struct SO_PUBLIC ProfileStats
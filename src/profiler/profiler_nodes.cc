@@ -119,6 +119,33 @@ void ProfilerNode::accumulate()
     }
 }
 
+void ProfilerNode::snapshot(unsigned instance)
+{
+    if ( !is_set() or instance >= snaps.size() )
+        return;
+
+    const auto* local_stats = (*getter)();
+
+    if ( local_stats )
+        snaps[instance] = *local_stats;
+}
+
+void ProfilerNode::prepare_snapshot(unsigned instances)
+{
+    if ( snaps.size() != instances )
+        snaps.resize(instances);
+}
+
+ProfileStats ProfilerNode::get_snapshot() const
+{
+    ProfileStats sum;
+
+    for ( const auto& ps : snaps )
+        sum += ps;
+
+    return sum;
+}
+
 void ProfilerNodeMap::register_node(std::string n, const char* pn, Module* m)
 { setup_node(get_node(n), get_node(pn ? pn : ROOT_NODE), m); }
 
@@ -140,6 +167,19 @@ void ProfilerNodeMap::reset_nodes()
         it->second.reset();
 }
 
+void ProfilerNodeMap::prepare_snapshot(unsigned instances)
+{
+    for ( auto it = nodes.begin(); it != nodes.end(); ++it )
+        it->second.prepare_snapshot(instances);
+}
+
+// each thread writes only its own slot so no lock is needed
+void ProfilerNodeMap::snapshot_nodes(unsigned instance)
+{
+    for ( auto it = nodes.begin(); it != nodes.end(); ++it )
+        it->second.snapshot(instance);
+}
+
 const ProfilerNode& ProfilerNodeMap::get_root()
 { return get_node(ROOT_NODE); }
 
@@ -309,6 +349,29 @@ TEST_CASE( "profiler node", "[profiler]" )
         auto& r2 = node.get_stats();
         CHECK( r2 == ProfileStats() );
     }
+
+    SECTION( "snapshot" )
+    {
+        the_stats.time = { 3_ticks, 2 };
+
+        // not prepared
+        node.snapshot(0);
+        CHECK( node.get_snapshot() == ProfileStats() );
+
+        node.prepare_snapshot(2);
+        node.snapshot(0);
+        node.snapshot(1);
+        node.snapshot(2);
+
+        auto result = node.get_snapshot();
+        CHECK( result.time.elapsed == 6_ticks );
+        CHECK( result.time.checks == 4 );
+
+        // snapshots replace rather than accumulate and don't touch stats
+        node.snapshot(1);
+        CHECK( node.get_snapshot() == result );
+        CHECK( node.get_stats() == ProfileStats() );
+    }
 }
 
 TEST_CASE( "profiler node map", "[profiler]" )
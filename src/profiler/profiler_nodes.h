@@ -46,6 +46,15 @@ public:
     // thread local call
     void accumulate();
 
+    // thread local call; copy this thread's stats for a live snapshot
+    void snapshot(unsigned instance);
+
+    // main thread; resize before asking threads for snapshots
+    void prepare_snapshot(unsigned instances);
+
+    // main thread; sum of the last thread snapshots
+    ProfileStats get_snapshot() const;
+
     const ProfileStats& get_stats() const
     { return stats; }
 
@@ -67,6 +76,7 @@ private:
     std::vector<ProfilerNode*> children;
     std::shared_ptr<GetProfileFunctor> getter;
     ProfileStats stats;
+    std::vector<ProfileStats> snaps;
 };
 
 inline bool operator==(const ProfilerNode& lhs, const ProfilerNode& rhs)
@@ -92,6 +102,9 @@ public:
     void accumulate_nodes();
     void reset_nodes();
 
+    void prepare_snapshot(unsigned instances);
+    void snapshot_nodes(unsigned instance);
+
     const ProfilerNode& get_root();
 
 private:
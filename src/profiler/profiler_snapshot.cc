@@ -0,0 +1,161 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// profiler_snapshot.cc
+
+#include "profiler_snapshot.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+
+#include "log/messages.h"
+#include "main/snort_config.h"
+#include "main/thread.h"
+#include "main/thread_config.h"
+
+#include "profiler_defs.h"
+#include "profiler_nodes.h"
+#include "rule_profiler.h"
+#include "time_profiler.h"
+
+#define s_snapshot_file "profile_snapshot"
+
+// last merged module stats, main thread only
+static std::unordered_map<std::string, TimeProfilerStats> s_prev;
+
+static inline long get_usecs(hr_duration d)
+{
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+    return clock_usecs(duration_cast<microseconds>(d).count());
+}
+
+static FILE* open_snapshot_file(const ProfilerSnapshotConfig& config)
+{
+    std::string file = !snort_conf->log_dir.empty() ? snort_conf->log_dir : ".";
+
+    if ( file.back() != '/' )
+        file += '/';
+
+    file += snort_conf->run_prefix;
+    file += s_snapshot_file;
+    file += (config.format == ProfilerSnapshotConfig::FMT_CSV) ? ".csv" : ".json";
+
+    FILE* fh = fopen(file.c_str(), "a");
+
+    if ( !fh )
+        ErrorMessage("can't open %s\n", file.c_str());
+
+    return fh;
+}
+
+void prepare_profiler_snapshot(ProfilerNodeMap& nodes)
+{
+    nodes.prepare_snapshot(ThreadConfig::get_instance_max());
+    prepare_rule_profiler_snapshot();
+}
+
+void snapshot_profiler_stats(ProfilerNodeMap& nodes)
+{
+    nodes.snapshot_nodes(get_instance_id());
+    snapshot_rule_profiler_stats();
+}
+
+void write_profiler_snapshot(ProfilerNodeMap& nodes, const ProfilerConfig& config)
+{
+    const ProfilerSnapshotConfig& sc = config.snapshot;
+    FILE* fh = open_snapshot_file(sc);
+
+    if ( !fh )
+        return;
+
+    const bool csv = (sc.format == ProfilerSnapshotConfig::FMT_CSV);
+    const double scale = time_profiler_scale();
+    const long now = (long)time(nullptr);
+
+    if ( csv and !ftell(fh) )
+        fprintf(fh, "#timestamp,type,name,checks,time_us,matches,alerts,timeouts,suspends\n");
+
+    if ( !csv )
+        fprintf(fh, "{ \"timestamp\": %ld, \"modules\": [", now);
+
+    bool first = true;
+
+    for ( const auto& it : nodes )
+    {
+        const TimeProfilerStats cur = it.second.get_snapshot().time;
+        TimeProfilerStats& prev = s_prev[it.first];
+
+        uint64_t checks = cur.checks >= prev.checks ? cur.checks - prev.checks : cur.checks;
+        hr_duration elapsed = cur.elapsed >= prev.elapsed ? cur.elapsed - prev.elapsed : cur.elapsed;
+        prev = cur;
+
+        if ( !checks and elapsed <= 0_ticks )
+            continue;
+
+        // sampled stats are scaled up to estimate the totals
+        checks = (uint64_t)(checks * scale);
+        long usecs = (long)(get_usecs(elapsed) * scale);
+
+        if ( csv )
+            fprintf(fh, "%ld,module,%s," STDu64 ",%ld,,,,\n", now, it.first.c_str(), checks, usecs);
+        else
+        {
+            fprintf(fh, "%s{ \"name\": \"%s\", \"checks\": " STDu64 ", \"time_us\": %ld }",
+                first ? " " : ", ", it.first.c_str(), checks, usecs);
+            first = false;
+        }
+    }
+
+    if ( !csv )
+        fprintf(fh, " ], \"rules\": [");
+
+    first = true;
+
+    for ( const auto& d : get_rule_profiler_deltas() )
+    {
+        if ( csv )
+        {
+            fprintf(fh, "%ld,rule,%u:%u:%u," STDu64 ",%ld," STDu64 "," STDu64 "," STDu64 "," STDu64 "\n",
+                now, d.gid, d.sid, d.rev, d.checks, get_usecs(d.elapsed), d.matches, d.alerts,
+                d.timeouts, d.suspends);
+        }
+        else
+        {
+            fprintf(fh, "%s{ \"gid\": %u, \"sid\": %u, \"rev\": %u, \"checks\": " STDu64
+                ", \"time_us\": %ld, \"matches\": " STDu64 ", \"alerts\": " STDu64
+                ", \"timeouts\": " STDu64 ", \"suspends\": " STDu64 " }",
+                first ? " " : ", ", d.gid, d.sid, d.rev, d.checks, get_usecs(d.elapsed),
+                d.matches, d.alerts, d.timeouts, d.suspends);
+            first = false;
+        }
+    }
+
+    if ( !csv )
+        fprintf(fh, " ] }\n");
+
+    fclose(fh);
+}
+
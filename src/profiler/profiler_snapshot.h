@@ -0,0 +1,43 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// profiler_snapshot.h
+
+#ifndef PROFILER_SNAPSHOT_H
+#define PROFILER_SNAPSHOT_H
+
+// Live snapshots let a running sensor report profiler stats without waiting
+// for shutdown.  The main thread prepares the snapshot, each packet thread
+// copies its own stats into its own slot when told to, and then the main
+// thread merges the copies and appends the changes since the last snapshot
+// to a JSON lines or CSV file.  Nothing is reset.
+
+class ProfilerNodeMap;
+struct ProfilerConfig;
+
+// main thread
+void prepare_profiler_snapshot(ProfilerNodeMap&);
+
+// packet threads
+void snapshot_profiler_stats(ProfilerNodeMap&);
+
+// main thread, after all packet threads have taken their snapshots
+void write_profiler_snapshot(ProfilerNodeMap&, const ProfilerConfig&);
+
+#endif
+
@@ -28,6 +28,7 @@
 #include <functional>
 #include <iostream>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 
 // this include eventually leads to possible issues with std::chrono:
@@ -38,7 +39,9 @@
 
 #include "detection/treenodes.h"
 #include "hash/sfghash.h"
+#include "hash/sfxhash.h"
 #include "main/snort_config.h"
+#include "main/thread.h"
 #include "main/thread_config.h"
 #include "parser/parser.h"
 #include "target_based/snort_protocols.h"
@@ -330,6 +333,143 @@ void reset_rule_profiler_stats()
     }
 }
 
+//-------------------------------------------------------------------------
+// live snapshots
+//-------------------------------------------------------------------------
+
+namespace rule_snapshot
+{
+
+struct Entry
+{
+    OtnState state;
+    uint32_t rev = 0;
+};
+
+// keyed by gid and sid so that entries survive reloads
+using Map = std::unordered_map<uint64_t, Entry>;
+
+static std::vector<detection_option_tree_node_t*> nodes;
+static std::vector<Map> thread_maps;
+static Map prev;
+
+struct Arg
+{
+    Map* map;
+    unsigned instance;
+};
+
+static inline uint64_t get_key(const SigInfo& si)
+{ return ((uint64_t)si.generator << 32) | si.id; }
+
+static void add_leaf(OptTreeNode* otn, const OtnState& path, void* pv)
+{
+    Arg* arg = (Arg*)pv;
+    auto res = arg->map->emplace(get_key(otn->sigInfo), Entry());
+    Entry& e = res.first->second;
+
+    if ( res.second )
+    {
+        // these are kept on the otn by the packet thread
+        const OtnState& os = otn->state[arg->instance];
+        e.state.matches = os.matches;
+        e.state.alerts = os.alerts;
+        e.rev = otn->sigInfo.rev;
+    }
+    e.state.elapsed += path.elapsed;
+    e.state.elapsed_match += path.elapsed_match;
+    e.state.elapsed_no_match += path.elapsed_no_match;
+
+    if ( path.checks > e.state.checks )
+        e.state.checks = path.checks;
+
+    e.state.latency_timeouts += path.latency_timeouts;
+    e.state.latency_suspends += path.latency_suspends;
+}
+
+template<typename T>
+static inline T delta(T now, T then)
+{ return now >= then ? now - then : now; }
+
+}
+
+// the node list is built here because the hash iterator isn't thread safe
+void prepare_rule_profiler_snapshot()
+{
+    assert(snort_conf);
+    rule_snapshot::nodes.clear();
+
+    if ( SFXHASH* doth = snort_conf->detection_option_tree_hash_table )
+    {
+        for ( auto* h = sfxhash_findfirst(doth); h; h = sfxhash_findnext(doth) )
+            rule_snapshot::nodes.push_back((detection_option_tree_node_t*)h->data);
+    }
+
+    rule_snapshot::thread_maps.resize(ThreadConfig::get_instance_max());
+
+    for ( auto& m : rule_snapshot::thread_maps )
+        m.clear();
+}
+
+// each thread only reads its own states and writes its own map
+void snapshot_rule_profiler_stats()
+{
+    unsigned instance = get_instance_id();
+
+    if ( instance >= rule_snapshot::thread_maps.size() )
+        return;
+
+    rule_snapshot::Arg arg { &rule_snapshot::thread_maps[instance], instance };
+
+    for ( auto* node : rule_snapshot::nodes )
+        detection_option_node_get_otn_stats(node, instance, rule_snapshot::add_leaf, &arg);
+}
+
+std::vector<RuleProfilerDelta> get_rule_profiler_deltas()
+{
+    using namespace rule_snapshot;
+    Map total;
+
+    for ( auto& m : thread_maps )
+    {
+        for ( auto& it : m )
+        {
+            Entry& e = total[it.first];
+            e.state += it.second.state;
+            e.state.elapsed_no_match += it.second.state.elapsed_no_match;
+            e.state.latency_timeouts += it.second.state.latency_timeouts;
+            e.state.latency_suspends += it.second.state.latency_suspends;
+            e.rev = it.second.rev;
+        }
+    }
+
+    std::vector<RuleProfilerDelta> deltas;
+
+    for ( auto& it : total )
+    {
+        const OtnState& now = it.second.state;
+        const OtnState& then = prev[it.first].state;
+
+        RuleProfilerDelta d;
+        d.gid = it.first >> 32;
+        d.sid = (uint32_t)it.first;
+        d.rev = it.second.rev;
+
+        d.elapsed = now.elapsed >= then.elapsed ? now.elapsed - then.elapsed : now.elapsed;
+        d.checks = delta(now.checks, then.checks);
+        d.matches = delta(now.matches, then.matches);
+        d.alerts = delta(now.alerts, then.alerts);
+        d.timeouts = delta(now.latency_timeouts, then.latency_timeouts);
+        d.suspends = delta(now.latency_suspends, then.latency_suspends);
+
+        if ( d.checks or d.elapsed > 0_ticks )
+            deltas.push_back(d);
+    }
+
+    prev.swap(total);
+    return deltas;
+}
+
 void RuleContext::stop(bool match)
 {
     if ( finished )
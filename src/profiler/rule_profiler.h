@@ -21,9 +21,36 @@
 #ifndef RULE_PROFILER_H
 #define RULE_PROFILER_H
 
+#include <cstdint>
+#include <vector>
+
+#include "time/clock_defs.h"
+
 struct RuleProfilerConfig;
 
 void show_rule_profiler_stats(const RuleProfilerConfig&);
 void reset_rule_profiler_stats();
 
+// live snapshots; prepare and get are called from the main thread and
+// snapshot is called by each packet thread in between
+struct RuleProfilerDelta
+{
+    uint32_t gid;
+    uint32_t sid;
+    uint32_t rev;
+
+    hr_duration elapsed;
+    uint64_t checks;
+    uint64_t matches;
+    uint64_t alerts;
+    uint64_t timeouts;
+    uint64_t suspends;
+};
+
+void prepare_rule_profiler_snapshot();
+void snapshot_rule_profiler_stats();
+
+// merge the thread snapshots and return the changes since the last call
+std::vector<RuleProfilerDelta> get_rule_profiler_deltas();
+
 #endif
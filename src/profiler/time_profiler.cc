@@ -24,9 +24,14 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "profiler_nodes.h"
 #include "profiler_tree_builder.h"
@@ -35,14 +40,127 @@
 #include "time_profiler_defs.h"
 
 #ifdef UNIT_TEST
+#include <thread>
+
 #include "catch/catch.hpp"
 #endif
 
 #define s_time_table_title "module profile"
 
+THREAD_LOCAL bool time_profiler_skip = false;
+
+static THREAD_LOCAL unsigned s_sample = 1;
+static THREAD_LOCAL unsigned s_count = 0;
+static THREAD_LOCAL uint32_t s_rand = 0;  // 0 = every sample-th packet
+
+// the rate can change with a reload so the stats are scaled by the
+// packets actually sampled rather than the configured rate; each thread
+// registers its counts so the scale includes the running threads too
+struct SampleCounts
+{
+    std::atomic<uint64_t> packets { 0 };
+    std::atomic<uint64_t> skipped { 0 };
+};
+
+static THREAD_LOCAL SampleCounts* s_counts = nullptr;
+
+// the running list and the totals of terminated threads
+static std::mutex s_totals_mutex;
+static std::vector<SampleCounts*> s_running;
+static uint64_t s_total_packets = 0;
+static uint64_t s_total_skipped = 0;
+
+// only the owning thread writes its counts so no locked add is needed
+static inline void bump(std::atomic<uint64_t>& n)
+{ n.store(n.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+void time_profiler_thread_init(const TimeProfilerConfig& config)
+{
+    if ( !s_counts )
+    {
+        s_counts = new SampleCounts;
+        std::lock_guard<std::mutex> lock(s_totals_mutex);
+        s_running.push_back(s_counts);
+    }
+
+    s_sample = config.sample ? config.sample : 1;
+    s_count = 0;
+    time_profiler_skip = false;
+
+    // any nonzero seed will do but threads shouldn't sample in lockstep
+    s_rand = config.sample_random ?
+        (uint32_t)(uintptr_t)&s_rand ^ 0x9E3779B9 : 0;
+
+    if ( config.sample_random and !s_rand )
+        s_rand = 1;
+}
+
+void time_profiler_thread_term()
+{
+    if ( !s_counts )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(s_totals_mutex);
+        s_total_packets += s_counts->packets.load(std::memory_order_relaxed);
+        s_total_skipped += s_counts->skipped.load(std::memory_order_relaxed);
+        s_running.erase(std::remove(s_running.begin(), s_running.end(), s_counts), s_running.end());
+    }
+    delete s_counts;
+    s_counts = nullptr;
+}
+
+void time_profiler_sample()
+{
+    bump(s_counts->packets);
+
+    if ( s_sample == 1 )
+        return;
+
+    if ( s_rand )
+    {
+        // xorshift32
+        s_rand ^= s_rand << 13;
+        s_rand ^= s_rand >> 17;
+        s_rand ^= s_rand << 5;
+        time_profiler_skip = (s_rand % s_sample) != 0;
+    }
+    else
+    {
+        if ( ++s_count == s_sample )
+            s_count = 0;
+
+        time_profiler_skip = (s_count != 0);
+    }
+    if ( time_profiler_skip )
+        bump(s_counts->skipped);
+}
+
+double time_profiler_scale()
+{
+    std::lock_guard<std::mutex> lock(s_totals_mutex);
+    uint64_t packets = s_total_packets;
+    uint64_t skipped = s_total_skipped;
+
+    // a running thread's counts may be a packet apart; that's noise
+    for ( const auto* c : s_running )
+    {
+        packets += c->packets.load(std::memory_order_relaxed);
+        skipped += c->skipped.load(std::memory_order_relaxed);
+    }
+
+    if ( packets <= skipped )
+        return 1.0;
+
+    return (double)packets / (packets - skipped);
+}
+
 namespace time_stats
 {
 
+// sampled stats are scaled up to estimate the totals
+static double scale = 1.0;
+
 static const StatsTable::Field fields[] =
 {
     { "#", 5, ' ', 0, std::ios_base::left },
@@ -128,10 +246,10 @@ static void print_fn(StatsTable& t, const View& v)
     using std::chrono::microseconds;
 
     // checks
-    t << v.checks();
+    t << (uint64_t)(v.checks() * scale);
 
     // total time
-    t << clock_usecs(duration_cast<microseconds>(v.elapsed()).count());
+    t << clock_usecs((long)(duration_cast<microseconds>(v.elapsed()).count() * scale));
 
     // avg/check
     t << clock_usecs(duration_cast<microseconds>(v.avg_check()).count());
@@ -151,9 +269,21 @@ void show_time_profiler_stats(ProfilerNodeMap& nodes, const TimeProfilerConfig&
         return;
 
     const auto& sorter = time_stats::sorters[config.sort];
+    std::string title = s_time_table_title;
+
+    time_stats::scale = time_profiler_scale();
+
+    if ( time_stats::scale > 1.0 )
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.1f", time_stats::scale);
+        title += " (sampled 1 in ";
+        title += buf;
+        title += ", scaled)";
+    }
 
     ProfilerPrinter<time_stats::View> printer(time_stats::fields, time_stats::print_fn, sorter);
-    printer.print_table(s_time_table_title, root, config.count, config.max_depth);
+    printer.print_table(title, root, config.count, config.max_depth);
 }
 
 #ifdef UNIT_TEST
@@ -465,6 +595,7 @@ TEST_CASE( "time profiler sorting", "[profiler][time_profiler]" )
     }
 }
 
+#ifndef NO_TIME_PROFILER
 TEST_CASE( "time profiler time context", "[profiler][time_profiler]" )
 {
     TimeProfilerStats stats;
@@ -538,4 +669,113 @@ TEST_CASE( "time context exclude", "[profiler][time_profiler]" )
     CHECK( stats.elapsed < hr_duration::max() );
 }
 
+TEST_CASE( "time profiler sampling", "[profiler][time_profiler]" )
+{
+    TimeProfilerConfig config;
+    TimeProfilerStats stats;
+
+    SECTION( "every nth" )
+    {
+        config.sample = 4;
+        time_profiler_thread_init(config);
+
+        for ( int i = 0; i < 100; ++i )
+        {
+            time_profiler_sample();
+            TimeContext ctx(stats);
+            CHECK( ctx.active() == !time_profiler_skip );
+        }
+        CHECK( stats.checks == 25 );
+        CHECK( stats.ref_count == 0 );
+    }
+
+    SECTION( "random" )
+    {
+        config.sample = 8;
+        config.sample_random = true;
+        time_profiler_thread_init(config);
+
+        for ( int i = 0; i < 8000; ++i )
+        {
+            time_profiler_sample();
+            TimeContext ctx(stats);
+        }
+        CHECK( stats.checks > 800 );
+        CHECK( stats.checks < 1200 );
+    }
+
+    SECTION( "all" )
+    {
+        time_profiler_thread_init(config);
+
+        for ( int i = 0; i < 10; ++i )
+        {
+            time_profiler_sample();
+            TimeContext ctx(stats);
+        }
+        CHECK( stats.checks == 10 );
+    }
+
+    SECTION( "rate changed by reload" )
+    {
+        time_profiler_thread_term();
+        s_total_packets = s_total_skipped = 0;
+
+        config.sample = 4;
+        time_profiler_thread_init(config);
+
+        for ( int i = 0; i < 100; ++i )
+            time_profiler_sample();
+
+        // a running thread counts too
+        CHECK( time_profiler_scale() == Approx(4.0) );
+
+        // reload turns sampling off
+        time_profiler_thread_init(TimeProfilerConfig());
+
+        for ( int i = 0; i < 50; ++i )
+        {
+            time_profiler_sample();
+            CHECK_FALSE( time_profiler_skip );
+        }
+        // 150 packets, 25 + 50 sampled
+        CHECK( time_profiler_scale() == Approx(2.0) );
+
+        time_profiler_thread_term();
+        CHECK( time_profiler_scale() == Approx(2.0) );
+    }
+
+    SECTION( "running and terminated threads" )
+    {
+        time_profiler_thread_term();
+        s_total_packets = s_total_skipped = 0;
+
+        config.sample = 4;
+
+        std::thread t([&config]
+        {
+            time_profiler_thread_init(config);
+
+            for ( int i = 0; i < 100; ++i )
+                time_profiler_sample();
+
+            time_profiler_thread_term();
+        });
+        t.join();
+
+        time_profiler_thread_init(TimeProfilerConfig());
+
+        for ( int i = 0; i < 100; ++i )
+            time_profiler_sample();
+
+        // 200 packets, 25 + 100 sampled
+        CHECK( time_profiler_scale() == Approx(1.6) );
+    }
+
+    // leave sampling off for other tests
+    time_profiler_thread_init(TimeProfilerConfig());
+    CHECK_FALSE( time_profiler_skip );
+}
+#endif
+
 #endif
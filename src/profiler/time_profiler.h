@@ -26,4 +26,15 @@ struct TimeProfilerConfig;
 
 void show_time_profiler_stats(ProfilerNodeMap&, const TimeProfilerConfig&);
 
+// per packet thread sampling state; init again after a reload to pick up
+// the new rate and term to add the packets sampled to the totals
+void time_profiler_thread_init(const TimeProfilerConfig&);
+void time_profiler_thread_term();
+
+// call at the start of each packet before any scopes are entered
+void time_profiler_sample();
+
+// packets seen per packet sampled by all threads, running or terminated
+double time_profiler_scale();
+
 #endif
@@ -22,6 +22,7 @@
 #define TIME_PROFILER_DEFS_H
 
 #include "main/snort_types.h"
+#include "main/thread.h"
 #include "time/clock_defs.h"
 #include "time/stopwatch.h"
 
@@ -38,8 +39,16 @@ struct TimeProfilerConfig
     bool show = false;
     unsigned count = 0;
     int max_depth = -1;
+
+    // time 1 in sample packets, every sample-th or at random
+    unsigned sample = 1;
+    bool sample_random = false;
 };
 
+// set for packets that are not sampled so that their scopes only check
+// this flag instead of reading the clock; see time_profiler_sample()
+SO_PUBLIC extern THREAD_LOCAL bool time_profiler_skip;
+
 struct SO_PUBLIC TimeProfilerStats
 {
     hr_duration elapsed;
@@ -82,13 +91,39 @@ inline TimeProfilerStats& operator+=(TimeProfilerStats& lhs, const TimeProfilerS
     return lhs;
 }
 
+#ifdef NO_TIME_PROFILER
+// time profiling compiled out; scopes cost nothing
+class TimeContext
+{
+public:
+    TimeContext(TimeProfilerStats&) { }
+
+    void stop() { }
+
+    bool active() const
+    { return false; }
+};
+
+class TimeExclude
+{
+public:
+    TimeExclude(TimeProfilerStats&) { }
+
+    TimeExclude(const TimeExclude&) = delete;
+    TimeExclude& operator=(const TimeExclude&) = delete;
+};
+
+#else
 class TimeContext
 {
 public:
     TimeContext(TimeProfilerStats& stats) :
         stats(stats)
     {
-        if ( stats.enter() )
+        if ( time_profiler_skip )
+            stopped_once = true;  // packet not sampled
+
+        else if ( stats.enter() )
             sw.start();
     }
 
@@ -137,5 +172,6 @@ private:
     TimeProfilerStats tmp;
     TimeContext ctx;
 };
+#endif
 
 #endif
@@ -123,6 +123,7 @@ static const MpseApi acb_api =
         nullptr
     },
     false,
+    true,
     nullptr,
     nullptr,
     nullptr,
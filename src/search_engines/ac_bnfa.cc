@@ -140,6 +140,7 @@ static const MpseApi bnfa_api =
         nullptr
     },
     false,
+    false,
     nullptr,
     nullptr,
     nullptr,
@@ -130,6 +130,7 @@ static const MpseApi acf_api =
         nullptr
     },
     false,
+    true,
     nullptr,
     nullptr,
     nullptr,
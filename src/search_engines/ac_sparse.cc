@@ -117,6 +117,7 @@ static const MpseApi acs_api =
         nullptr
     },
     false,
+    true,
     nullptr,
     nullptr,
     nullptr,
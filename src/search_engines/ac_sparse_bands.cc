@@ -117,6 +117,7 @@ static const MpseApi acsb_api =
         nullptr
     },
     false,
+    true,
     nullptr,
     nullptr,
     nullptr,
@@ -112,6 +112,7 @@ static const MpseApi ac_api =
         nullptr
     },
     false,
+    true,
     nullptr,
     nullptr,
     nullptr,
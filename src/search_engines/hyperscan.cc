@@ -350,6 +350,7 @@ static const MpseApi hs_api =
         nullptr
     },
     false,
+    false,
     nullptr,  // activate
     nullptr,  // setup
     nullptr,  // start
@@ -137,6 +137,7 @@ static const MpseApi cpm_api =
         nullptr
     },
     false,
+    false,
     cpm_activate,
     cpm_setup,
     cpm_start,
@@ -26,6 +26,7 @@
 
 #include "http_module.h"
 #include "http_flow_data.h"
+#include "http_pool.h"
 
 class HttpApi
 {
@@ -44,7 +45,7 @@ private:
     static Inspector* http_ctor(Module* mod);
     static void http_dtor(Inspector* p) { delete p; }
     static void http_tinit() { }
-    static void http_tterm() { }
+    static void http_tterm() { HttpFlowData::purge_inflaters(); HttpPool::purge(); }
 };
 
 #endif
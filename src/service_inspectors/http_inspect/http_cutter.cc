@@ -19,8 +19,53 @@
 
 #include "http_cutter.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using namespace HttpEnums;
 
+// The cutters spend nearly all their time looking for the end of a line. Runs of ordinary
+// octets are skipped a vector at a time and the byte-wise state machines take over at each
+// candidate delimiter.
+uint32_t HttpCutter::find_crlf(const uint8_t* buffer, uint32_t start, uint32_t length)
+{
+    uint32_t k = start;
+
+#if defined(__AVX2__)
+    const __m256i cr32 = _mm256_set1_epi8('\r');
+    const __m256i lf32 = _mm256_set1_epi8('\n');
+    for (; k + 32 <= length; k += 32)
+    {
+        const __m256i block = _mm256_loadu_si256((const __m256i*)(buffer + k));
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, cr32), _mm256_cmpeq_epi8(block, lf32)));
+        if (mask != 0)
+            return k + __builtin_ctz(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i cr16 = _mm_set1_epi8('\r');
+    const __m128i lf16 = _mm_set1_epi8('\n');
+    for (; k + 16 <= length; k += 16)
+    {
+        const __m128i block = _mm_loadu_si128((const __m128i*)(buffer + k));
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(block, cr16), _mm_cmpeq_epi8(block, lf16)));
+        if (mask != 0)
+            return k + __builtin_ctz(mask);
+    }
+#endif
+    for (; k < length; k++)
+    {
+        if ((buffer[k] == '\r') || (buffer[k] == '\n'))
+            return k;
+    }
+    return length;
+}
+
 ScanResult HttpStartCutter::cut(const uint8_t* buffer, uint32_t length,
     HttpInfractions& infractions, HttpEventGen& events, uint32_t, uint32_t)
 {
@@ -94,6 +139,11 @@ ScanResult HttpStartCutter::cut(const uint8_t* buffer, uint32_t length,
         {
             num_crlf = 1;
         }
+        else if (validated)
+        {
+            // Only the end of the line matters now
+            k = find_crlf(buffer, k+1, length) - 1;
+        }
     }
     octets_seen += length;
     return SCAN_NOTFOUND;
@@ -177,6 +227,8 @@ ScanResult HttpHeaderCutter::cut(const uint8_t* buffer, uint32_t length,
         {
             num_crlf = 0;
             first_lf = 0;
+            // Nothing changes until the next CR or LF
+            k = find_crlf(buffer, k+1, length) - 1;
         }
     }
     octets_seen += length;
@@ -340,6 +392,11 @@ ScanResult HttpBodyChunkCutter::cut(const uint8_t* buffer, uint32_t length,
                 curr_state = CHUNK_BAD;
                 break;
             }
+            else
+            {
+                // Chunk options are ignored so go straight to the end of the line
+                k = find_crlf(buffer, k+1, length) - 1;
+            }
             break;
         case CHUNK_HCRLF:
             if (buffer[k] != '\n')
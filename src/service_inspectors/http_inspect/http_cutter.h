@@ -44,6 +44,9 @@ public:
     virtual bool get_is_broken_chunk() const { return false; }
     virtual uint32_t get_num_good_chunks() const { return 0; }
 
+    // Offset of the first CR or LF in buffer[start, length) or length if there is none
+    static uint32_t find_crlf(const uint8_t* buffer, uint32_t start, uint32_t length);
+
 protected:
     // number of octets processed by previous cut() calls that returned NOTFOUND
     uint32_t octets_seen = 0;
@@ -25,6 +25,7 @@
 #include <assert.h>
 
 #include "http_enum.h"
+#include "http_pool.h"
 
 // Individual pieces of the message found during parsing.
 // Length values <= 0 are StatusCode values and imply that the start pointer is meaningless.
@@ -44,10 +45,16 @@ public:
     void set(const Field& f);
     void set(HttpEnums::StatusCode stat_code);
     void set(int32_t length) { set(static_cast<HttpEnums::StatusCode>(length)); }
-    // Only call this method if the field owns the dynamically allocated buffer you are deleting.
-    // This method is a convenience but you still must know where the buffer came from. Many fields
-    // refer to static buffers or a subfield of someone else's buffer.
-    void delete_buffer() { if (length >= 0) delete[] start; }
+    // Only call this method if the field owns the HttpPool buffer you are deleting. This method is
+    // a convenience but you still must know where the buffer came from. Many fields refer to
+    // static buffers or a subfield of someone else's buffer.
+    void delete_buffer() { if (length >= 0) HttpPool::release(const_cast<uint8_t*>(start)); }
+
+    // Buffers for derived fields come from the per-thread pool
+    static uint8_t* new_buffer(size_t size) { return (uint8_t*)HttpPool::allocate(size); }
+
+    static void* operator new[](size_t size) { return HttpPool::allocate(size); }
+    static void operator delete[](void* p) { HttpPool::release(p); }
 
 #ifdef REG_TEST
     void print(FILE* output, const char* name) const;
@@ -17,6 +17,10 @@
 //--------------------------------------------------------------------------
 // http_flow_data.cc author Tom Peters <thopeter@cisco.com>
 
+#include <vector>
+
+#include "main/thread.h"
+
 #include "http_enum.h"
 #include "http_test_manager.h"
 #include "http_flow_data.h"
@@ -63,11 +67,7 @@ HttpFlowData::~HttpFlowData()
             delete[] section_buffer[k];
         HttpTransaction::delete_transaction(transaction[k]);
         delete cutter[k];
-        if (compress_stream[k] != nullptr)
-        {
-            inflateEnd(compress_stream[k]);
-            delete compress_stream[k];
-        }
+        release_inflater(compress_stream[k]);
         if (mime_state[k] != nullptr)
         {
             delete mime_state[k];
@@ -94,12 +94,7 @@ void HttpFlowData::half_reset(SourceId source_id)
     file_depth_remaining[source_id] = STAT_NOT_PRESENT;
     detect_depth_remaining[source_id] = STAT_NOT_PRESENT;
     compression[source_id] = CMP_NONE;
-    if (compress_stream[source_id] != nullptr)
-    {
-        inflateEnd(compress_stream[source_id]);
-        delete compress_stream[source_id];
-        compress_stream[source_id] = nullptr;
-    }
+    release_inflater(compress_stream[source_id]);
     if (mime_state[source_id] != nullptr)
     {
         delete mime_state[source_id];
@@ -135,16 +130,74 @@ void HttpFlowData::trailer_prep(SourceId source_id)
 {
     type_expected[source_id] = SEC_TRAILER;
     compression[source_id] = CMP_NONE;
-    if (compress_stream[source_id] != nullptr)
-    {
-        inflateEnd(compress_stream[source_id]);
-        delete compress_stream[source_id];
-        compress_stream[source_id] = nullptr;
-    }
+    release_inflater(compress_stream[source_id]);
     infractions[source_id].reset();
     events[source_id].reset();
 }
 
+// Idle inflaters for this packet thread. Resetting a recycled inflater readies it for the next
+// message while keeping the window and other memory it allocated at init.
+static THREAD_LOCAL std::vector<Inflater*>* idle_inflaters = nullptr;
+
+Inflater* HttpFlowData::get_inflater(CompressId compression)
+{
+    const int window_bits = (compression == CMP_GZIP) ? GZIP_WINDOW_BITS : DEFLATE_WINDOW_BITS;
+    const InflateCodec codec = (compression == CMP_GZIP) ? INFLATE_HTTP_GZIP :
+        INFLATE_HTTP_DEFLATE;
+    Inflater* compress_stream;
+
+    if (idle_inflaters == nullptr)
+        idle_inflaters = new std::vector<Inflater*>;
+
+    while (!idle_inflaters->empty())
+    {
+        compress_stream = idle_inflaters->back();
+        idle_inflaters->pop_back();
+        if (compress_stream->reset(codec, window_bits))
+            return compress_stream;
+        compress_stream->end();
+        delete compress_stream;
+    }
+
+    compress_stream = new Inflater();
+    if (!compress_stream->init(codec, window_bits))
+    {
+        delete compress_stream;
+        return nullptr;
+    }
+    return compress_stream;
+}
+
+void HttpFlowData::release_inflater(Inflater*& compress_stream)
+{
+    if (compress_stream == nullptr)
+        return;
+
+    // Flows may outlive the pool during thread termination
+    if ((idle_inflaters != nullptr) && (idle_inflaters->size() < MAX_IDLE_INFLATERS))
+        idle_inflaters->push_back(compress_stream);
+    else
+    {
+        compress_stream->end();
+        delete compress_stream;
+    }
+    compress_stream = nullptr;
+}
+
+void HttpFlowData::purge_inflaters()
+{
+    if (idle_inflaters == nullptr)
+        return;
+
+    for (Inflater* compress_stream : *idle_inflaters)
+    {
+        compress_stream->end();
+        delete compress_stream;
+    }
+    delete idle_inflaters;
+    idle_inflaters = nullptr;
+}
+
 bool HttpFlowData::add_to_pipeline(HttpTransaction* latest)
 {
     if (pipeline == nullptr)
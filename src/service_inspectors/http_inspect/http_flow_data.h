@@ -21,8 +21,8 @@
 #define HTTP_FLOW_DATA_H
 
 #include <stdio.h>
-#include <zlib.h>
 
+#include "decompress/inflate.h"
 #include "flow/flow.h"
 #include "mime/file_mime_process.h"
 #include "utils/util_utf.h"
@@ -40,6 +40,7 @@ public:
     ~HttpFlowData();
     static unsigned http_flow_id;
     static void init() { http_flow_id = FlowData::get_flow_id(); }
+    static void purge_inflaters();
 
     friend class HttpInspect;
     friend class HttpMsgSection;
@@ -64,6 +65,12 @@ private:
     void half_reset(HttpEnums::SourceId source_id);
     void trailer_prep(HttpEnums::SourceId source_id);
 
+    // Inflate states are recycled through a per-thread pool instead of being allocated for
+    // every compressed message
+    static Inflater* get_inflater(HttpEnums::CompressId compression);
+    static void release_inflater(Inflater*& compress_stream);
+    static const unsigned MAX_IDLE_INFLATERS = 32;
+
     // 0 element refers to client request, 1 element refers to server response
 
     // *** StreamSplitter internal data - scan()
@@ -95,7 +102,7 @@ private:
     uint32_t section_size_target[2] = { 0, 0 };
     uint32_t section_size_max[2] = { 0, 0 };
     HttpEnums::CompressId compression[2] = { HttpEnums::CMP_NONE, HttpEnums::CMP_NONE };
-    z_stream* compress_stream[2] = { nullptr, nullptr };
+    Inflater* compress_stream[2] = { nullptr, nullptr };
     uint64_t zero_nine_expected = 0;
 
     // *** Inspector's internal data about the current message
@@ -100,8 +100,8 @@ void HeaderNormalizer::normalize(const HeaderId head_id, const int count,
     // number of normalization functions is odd or even, the initial buffer is chosen so that the
     // final normalization leaves the normalized header value in norm_value.
 
-    uint8_t* const norm_value = new uint8_t[buffer_length];
-    uint8_t* const temp_space = new uint8_t[buffer_length];
+    uint8_t* const norm_value = Field::new_buffer(buffer_length);
+    uint8_t* const temp_space = Field::new_buffer(buffer_length);
     uint8_t* working = (num_normalizers%2 == 0) ? norm_value : temp_space;
     int32_t data_length = 0;
     for (int j=0; j < num_matches; j++)
@@ -129,7 +129,7 @@ void HeaderNormalizer::normalize(const HeaderId head_id, const int count,
             data_length = normalizer[i](norm_value, data_length, temp_space, infractions, events);
         }
     }
-    delete[] temp_space;
+    HttpPool::release(temp_space);
     result_field.set(data_length, norm_value);
     return;
 }
@@ -96,12 +96,12 @@ void HttpMsgBody::do_utf_decoding(const Field& input, Field& output, bool& decod
     {
         int bytes_copied;
         bool decoded;
-        uint8_t* buffer = new uint8_t[input.length];
+        uint8_t* buffer = Field::new_buffer(input.length);
         decoded = session_data->utf_state->decode_utf((const char*)input.start, input.length,
                             (char*)buffer, input.length, &bytes_copied);
         if (!decoded)
         {
-            delete[] buffer;
+            HttpPool::release(buffer);
             infractions += INF_UTF_NORM_FAIL;
             events.create_event(EVENT_UTF_NORM_FAIL);
         }
@@ -111,7 +111,7 @@ void HttpMsgBody::do_utf_decoding(const Field& input, Field& output, bool& decod
             decoded_alloc = true;
         }
         else
-            delete[] buffer;
+            HttpPool::release(buffer);
     }
 
 }
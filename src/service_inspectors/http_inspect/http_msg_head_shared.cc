@@ -32,7 +32,7 @@ HttpMsgHeadShared::~HttpMsgHeadShared()
 {
     delete[] header_line;
     delete[] header_name;
-    delete[] header_name_id;
+    HttpPool::release(header_name_id);
     delete[] header_value;
     NormalizedHeader* list_ptr = norm_heads;
     while (list_ptr != nullptr)
@@ -161,7 +161,7 @@ void HttpMsgHeadShared::parse_header_lines()
 {
     header_name = new Field[num_headers];
     header_value = new Field[num_headers];
-    header_name_id = new HeaderId[num_headers];
+    header_name_id = (HeaderId*)HttpPool::allocate(num_headers * sizeof(HeaderId));
 
     int colon;
     for (int k=0; k < num_headers; k++)
@@ -201,7 +201,7 @@ void HttpMsgHeadShared::derive_header_name_id(int index)
 
     // Normalize header field name to lower case and remove LWS for matching purposes
     int32_t lower_length = 0;
-    uint8_t* lower_name = new uint8_t[length];
+    uint8_t* lower_name = Field::new_buffer(length);
     for (int32_t k=0; k < length; k++)
     {
         if (!is_sp_tab[buffer[k]])
@@ -216,7 +216,7 @@ void HttpMsgHeadShared::derive_header_name_id(int index)
         }
     }
     header_name_id[index] = (HeaderId)str_to_code(lower_name, lower_length, header_list);
-    delete[] lower_name;
+    HttpPool::release(lower_name);
 }
 
 HttpMsgHeadShared::NormalizedHeader* HttpMsgHeadShared::get_header_node(HeaderId header_id) const
@@ -262,7 +262,7 @@ const Field& HttpMsgHeadShared::get_classic_raw_header()
     }
 
     // Step through headers again and do the copying this time
-    uint8_t* const buffer = new uint8_t[length];
+    uint8_t* const buffer = Field::new_buffer(length);
     int32_t current = 0;
     for (int k = 0; k < num_headers; k++)
     {
@@ -109,6 +109,8 @@ private:
     struct NormalizedHeader
     {
         NormalizedHeader(HttpEnums::HeaderId id_) : id(id_) {}
+        static void* operator new(size_t size) { return HttpPool::allocate(size); }
+        static void operator delete(void* p) { HttpPool::release(p); }
         const HttpEnums::HeaderId id;
         int count;
         Field norm;
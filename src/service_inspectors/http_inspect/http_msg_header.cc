@@ -23,12 +23,14 @@
 
 #include "utils/util.h"
 #include "detection/detection_util.h"
+#include "detection/fp_detect.h"
 #include "file_api/file_service.h"
 #include "file_api/file_flows.h"
 
 #include "http_module.h"
 #include "http_api.h"
 #include "http_normalizers.h"
+#include "http_test_manager.h"
 #include "http_msg_request.h"
 #include "http_msg_header.h"
 #include "pub_sub/http_events.h"
@@ -45,15 +47,15 @@ HttpMsgHeader::HttpMsgHeader(const uint8_t* buffer, const uint16_t buf_size,
 
 void HttpMsgHeader::publish()
 {
+    const unsigned id = (source_id == SRC_CLIENT) ? DE_HTTP_REQUEST_HEADER :
+        DE_HTTP_RESPONSE_HEADER;
+    DataBus& bus = get_data_bus();
+
+    if (!bus.has_subscribers(id))
+        return;
+
     HttpEvent http_event(this);
-    if(source_id == SRC_CLIENT)
-    {
-        get_data_bus().publish(HTTP_REQUEST_HEADER_EVENT_KEY, http_event, flow);
-    }
-    else
-    {
-        get_data_bus().publish(HTTP_RESPONSE_HEADER_EVENT_KEY, http_event, flow);
-    }
+    bus.publish(id, http_event, flow);
 }
 
 void HttpMsgHeader::update_flow()
@@ -351,18 +353,22 @@ void HttpMsgHeader::setup_decompression()
     if (compression == CMP_NONE)
         return;
 
-    session_data->compress_stream[source_id] = new z_stream;
-    session_data->compress_stream[source_id]->zalloc = Z_NULL;
-    session_data->compress_stream[source_id]->zfree = Z_NULL;
-    session_data->compress_stream[source_id]->next_in = Z_NULL;
-    session_data->compress_stream[source_id]->avail_in = 0;
-    const int window_bits = (compression == CMP_GZIP) ? GZIP_WINDOW_BITS : DEFLATE_WINDOW_BITS;
-    if (inflateInit2(session_data->compress_stream[source_id], window_bits) != Z_OK)
+    // Decompression is expensive and only worthwhile when something will look at the result. If
+    // file processing is off and no rule that could be applied to this flow reads the body, pass
+    // the body along as is. Otherwise the inflate state is obtained when body data arrives.
+#ifdef REG_TEST
+    if (!HttpTestManager::use_test_output())
+#endif
     {
-        session_data->compression[source_id] = CMP_NONE;
-        delete session_data->compress_stream[source_id];
-        session_data->compress_stream[source_id] = nullptr;
+        if ((session_data->file_depth_remaining[source_id] <= 0) &&
+            !fpInspectsBody(flow, source_id == SRC_CLIENT))
+        {
+            compression = CMP_NONE;
+            HttpModule::increment_peg_counts(PEG_DECOMPRESS_SKIP);
+            return;
+        }
     }
+    HttpModule::increment_peg_counts(PEG_DECOMPRESS);
 }
 
 void HttpMsgHeader::setup_utf_decoding()
@@ -93,7 +93,7 @@ const Field& HttpMsgSection::classic_normalize(const Field& raw, Field& norm, bo
         norm.set(raw);
         return norm;
     }
-    uint8_t* buffer = new uint8_t[raw.length + UriNormalizer::URI_NORM_EXPANSION];
+    uint8_t* buffer = Field::new_buffer(raw.length + UriNormalizer::URI_NORM_EXPANSION);
     UriNormalizer::classic_normalize(raw, norm, buffer, uri_param);
     norm_alloc = true;
     return norm;
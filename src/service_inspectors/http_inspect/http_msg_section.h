@@ -23,6 +23,7 @@
 #include "detection/detection_util.h"
 
 #include "http_field.h"
+#include "http_pool.h"
 #include "http_module.h"
 #include "http_flow_data.h"
 #include "http_transaction.h"
@@ -36,6 +37,10 @@ class HttpMsgSection
 {
 public:
     virtual ~HttpMsgSection() { if (delete_msg_on_destruct) delete[] msg_text.start; }
+
+    static void* operator new(size_t size) { return HttpPool::allocate(size); }
+    static void operator delete(void* p) { HttpPool::release(p); }
+
     virtual HttpEnums::InspectSection get_inspection_section() const
         { return HttpEnums::IS_NONE; }
     HttpEnums::SourceId get_source_id() { return source_id; }
@@ -0,0 +1,124 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// http_pool.cc
+
+#include <assert.h>
+#include <stdint.h>
+
+#include "main/thread.h"
+#include "utils/util.h"
+
+#include "http_pool.h"
+
+// Every block starts with a header recording its size class so that release() does not need
+// to be told the size. The header keeps the payload aligned for any object type.
+struct alignas(16) PoolHeader
+{
+    uint32_t size_class;
+};
+
+// While a block is idle its payload holds the free list link
+struct IdleBlock
+{
+    IdleBlock* next;
+};
+
+// Size classes are powers of two from 64 to 4096 octets including the header. Larger requests
+// are not pooled.
+static const unsigned MIN_CLASS_SHIFT = 6;
+static const unsigned NUM_CLASSES = 7;
+static const uint32_t LARGE_CLASS = NUM_CLASSES;
+
+// Bounds the idle memory a thread holds to about 256 KB after a burst of concurrent
+// transactions
+static const unsigned MAX_IDLE_PER_CLASS = 32;
+
+static THREAD_LOCAL IdleBlock* idle_blocks[NUM_CLASSES];
+static THREAD_LOCAL unsigned num_idle[NUM_CLASSES];
+
+static inline size_t class_size(unsigned size_class)
+{
+    return (size_t)1 << (size_class + MIN_CLASS_SHIFT);
+}
+
+static inline unsigned get_size_class(size_t size)
+{
+    const size_t total = size + sizeof(PoolHeader);
+    unsigned size_class = 0;
+    while ((size_class < NUM_CLASSES) && (class_size(size_class) < total))
+        size_class++;
+    return size_class;
+}
+
+void* HttpPool::allocate(size_t size)
+{
+    const unsigned size_class = get_size_class(size);
+    PoolHeader* header;
+
+    if ((size_class < NUM_CLASSES) && (idle_blocks[size_class] != nullptr))
+    {
+        IdleBlock* block = idle_blocks[size_class];
+        idle_blocks[size_class] = block->next;
+        num_idle[size_class]--;
+        header = (PoolHeader*)block - 1;
+    }
+    else
+    {
+        const size_t total = (size_class < NUM_CLASSES) ? class_size(size_class) :
+            size + sizeof(PoolHeader);
+        header = (PoolHeader*)snort_alloc(total);
+        header->size_class = size_class;
+    }
+    return header + 1;
+}
+
+void HttpPool::release(void* block)
+{
+    if (block == nullptr)
+        return;
+
+    PoolHeader* header = (PoolHeader*)block - 1;
+    const uint32_t size_class = header->size_class;
+    assert(size_class <= LARGE_CLASS);
+
+    if ((size_class == LARGE_CLASS) || (num_idle[size_class] >= MAX_IDLE_PER_CLASS))
+    {
+        snort_free(header);
+        return;
+    }
+
+    IdleBlock* idle = (IdleBlock*)block;
+    idle->next = idle_blocks[size_class];
+    idle_blocks[size_class] = idle;
+    num_idle[size_class]++;
+}
+
+void HttpPool::purge()
+{
+    for (unsigned k = 0; k < NUM_CLASSES; k++)
+    {
+        while (idle_blocks[k] != nullptr)
+        {
+            IdleBlock* block = idle_blocks[k];
+            idle_blocks[k] = block->next;
+            snort_free((PoolHeader*)block - 1);
+        }
+        num_idle[k] = 0;
+    }
+}
+
@@ -0,0 +1,50 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// http_pool.h
+
+#ifndef HTTP_POOL_H
+#define HTTP_POOL_H
+
+#include <stddef.h>
+
+//-------------------------------------------------------------------------
+// HttpPool class
+//
+// Per-thread recycling allocator for the short-lived objects of an HTTP transaction: message
+// sections, transactions, URIs, header tables, and JIT normalized field buffers. A keep-alive
+// connection creates and destroys the same handful of object sizes over and over. Freed blocks
+// go onto a per-thread free list for their size class and are handed out again by the next
+// transaction instead of returning to the heap. Blocks larger than the biggest class come from
+// the heap directly.
+//
+// Memory from allocate() must be returned with release() on the same packet thread.
+//-------------------------------------------------------------------------
+
+class HttpPool
+{
+public:
+    static void* allocate(size_t size);
+    static void release(void* block);
+
+    // Return all idle blocks to the heap. Called at thread termination after the flows have been
+    // purged.
+    static void purge();
+};
+
+#endif
+
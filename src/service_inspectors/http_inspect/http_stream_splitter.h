@@ -20,7 +20,6 @@
 #ifndef HTTP_STREAM_SPLITTER_H
 #define HTTP_STREAM_SPLITTER_H
 
-#include <zlib.h>
 
 #include "stream/stream_splitter.h"
 
@@ -52,7 +51,7 @@ private:
     void chunk_spray(HttpFlowData* session_data, uint8_t* buffer, const uint8_t* data,
         unsigned length) const;
     static void decompress_copy(uint8_t* buffer, uint32_t& offset, const uint8_t* data,
-        uint32_t length, HttpEnums::CompressId& compression, z_stream*& compress_stream,
+        uint32_t length, HttpEnums::CompressId& compression, Inflater*& compress_stream,
         bool at_start, HttpInfractions& infractions, HttpEventGen& events);
 
     const HttpEnums::SourceId source_id;
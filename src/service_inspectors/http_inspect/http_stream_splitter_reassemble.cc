@@ -60,6 +60,8 @@ void HttpStreamSplitter::chunk_spray(HttpFlowData* session_data, uint8_t* buffer
             // No practical difference between white space and options in reassemble()
             if (data[k] == '\r')
                 curr_state = CHUNK_HCRLF;
+            else
+                k = HttpCutter::find_crlf(data, k+1, length) - 1;
             break;
         case CHUNK_HCRLF:
             if (expected > 0)
@@ -116,29 +118,37 @@ void HttpStreamSplitter::chunk_spray(HttpFlowData* session_data, uint8_t* buffer
 }
 
 void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, const uint8_t* data,
-    uint32_t length, HttpEnums::CompressId& compression, z_stream*& compress_stream,
+    uint32_t length, HttpEnums::CompressId& compression, Inflater*& compress_stream,
     bool at_start, HttpInfractions& infractions, HttpEventGen& events)
 {
+    if (((compression == CMP_GZIP) || (compression == CMP_DEFLATE)) &&
+        (compress_stream == nullptr))
+    {
+        // Deferred until now so that messages without body data never need an inflate state
+        if ((compress_stream = HttpFlowData::get_inflater(compression)) == nullptr)
+            compression = CMP_NONE;
+    }
+
     if ((compression == CMP_GZIP) || (compression == CMP_DEFLATE))
     {
-        compress_stream->next_in = (Bytef*)data;
+        compress_stream->next_in = (uint8_t*)data;
         compress_stream->avail_in = length;
         compress_stream->next_out = buffer + offset;
         compress_stream->avail_out = MAX_OCTETS - offset;
-        int ret_val = inflate(compress_stream, Z_SYNC_FLUSH);
+        const InflateStatus ret_val = compress_stream->inflate();
 
-        if ((ret_val == Z_OK) || (ret_val == Z_STREAM_END))
+        if ((ret_val == INFLATE_OK) || (ret_val == INFLATE_STREAM_END))
         {
             offset = MAX_OCTETS - compress_stream->avail_out;
             if (compress_stream->avail_in > 0)
             {
                 // There are two ways not to consume all the input
-                if (ret_val == Z_STREAM_END)
+                if (ret_val == INFLATE_STREAM_END)
                 {
                     // The zipped data stream ended but there is more input data
                     infractions += INF_GZIP_EARLY_END;
                     events.create_event(EVENT_GZIP_FAILURE);
-                    const uInt num_copy =
+                    const uint32_t num_copy =
                         (compress_stream->avail_in <= compress_stream->avail_out) ?
                         compress_stream->avail_in : compress_stream->avail_out;
                     memcpy(buffer + offset, data, num_copy);
@@ -152,22 +162,20 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
                     events.create_event(EVENT_GZIP_OVERRUN);
                 }
                 compression = CMP_NONE;
-                inflateEnd(compress_stream);
-                delete compress_stream;
-                compress_stream = nullptr;
+                HttpFlowData::release_inflater(compress_stream);
             }
             return;
         }
-        else if ((compression == CMP_DEFLATE) && at_start && (ret_val == Z_DATA_ERROR))
+        else if ((compression == CMP_DEFLATE) && at_start && (ret_val == INFLATE_DATA_ERROR))
         {
             // Some incorrect implementations of deflate don't use the expected header. Feed a
-            // dummy header to zlib and retry the inflate.
-            static constexpr char zlib_header[2] = { 0x78, 0x01 };
+            // dummy header to the inflater and retry.
+            static constexpr uint8_t zlib_header[2] = { 0x78, 0x01 };
 
-            inflateReset(compress_stream);
-            compress_stream->next_in = (Bytef*)zlib_header;
+            compress_stream->reset();
+            compress_stream->next_in = (uint8_t*)zlib_header;
             compress_stream->avail_in = sizeof(zlib_header);
-            inflate(compress_stream, Z_SYNC_FLUSH);
+            compress_stream->inflate();
 
             // Start over at the beginning
             decompress_copy(buffer, offset, data, length, compression, compress_stream, false,
@@ -179,9 +187,7 @@ void HttpStreamSplitter::decompress_copy(uint8_t* buffer, uint32_t& offset, cons
             infractions += INF_GZIP_FAILURE;
             events.create_event(EVENT_GZIP_FAILURE);
             compression = CMP_NONE;
-            inflateEnd(compress_stream);
-            delete compress_stream;
-            compress_stream = nullptr;
+            HttpFlowData::release_inflater(compress_stream);
             // Since we failed to uncompress the data, fall through
         }
     }
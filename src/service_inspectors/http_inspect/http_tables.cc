@@ -388,6 +388,8 @@ const PegInfo HttpModule::peg_names[PEG_COUNT_MAX+1] =
     { "URI normalizations", "URIs needing to be normalization" },
     { "URI path", "URIs with path problems" },
     { "URI coding", "URIs with character coding problems" },
+    { "decompressions", "gzip and deflate message bodies decompressed" },
+    { "skipped decompressions", "compressed message bodies no rule or file processing needed" },
     { nullptr, nullptr }
 };
 
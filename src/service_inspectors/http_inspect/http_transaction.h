@@ -22,6 +22,7 @@
 
 #include "http_enum.h"
 #include "http_flow_data.h"
+#include "http_pool.h"
 
 class HttpMsgRequest;
 class HttpMsgStatus;
@@ -38,6 +39,9 @@ public:
         HttpEnums::SourceId source_id);
     static void delete_transaction(HttpTransaction* transaction);
 
+    static void* operator new(size_t size) { return HttpPool::allocate(size); }
+    static void operator delete(void* p) { HttpPool::release(p); }
+
     HttpMsgRequest* get_request() const { return request; }
     void set_request(HttpMsgRequest* request_) { request = request_; }
 
@@ -33,7 +33,7 @@ using namespace HttpEnums;
 HttpUri::~HttpUri()
 {
     if (classic_norm_allocated)
-        delete[] classic_norm.start;
+        classic_norm.delete_buffer();
 }
 
 void HttpUri::parse_uri()
@@ -228,7 +228,7 @@ void HttpUri::normalize()
 
     // Create a new buffer containing the normalized URI by normalizing each individual piece.
     const uint32_t total_length = uri.length + UriNormalizer::URI_NORM_EXPANSION;
-    uint8_t* const new_buf = new uint8_t[total_length];
+    uint8_t* const new_buf = Field::new_buffer(total_length);
     uint8_t* current = new_buf;
     if (scheme.length >= 0)
     {
@@ -26,6 +26,7 @@
 #include "http_field.h"
 #include "http_infractions.h"
 #include "http_event_gen.h"
+#include "http_pool.h"
 
 //-------------------------------------------------------------------------
 // HttpUri class
@@ -41,6 +42,10 @@ public:
         infractions(infractions_), events(events_)
         { normalize(); }
     ~HttpUri();
+
+    static void* operator new(size_t size) { return HttpPool::allocate(size); }
+    static void operator delete(void* p) { HttpPool::release(p); }
+
     const Field& get_uri() const { return uri; }
     HttpEnums::UriType get_uri_type() { return uri_type; }
     const Field& get_scheme() { return scheme; }
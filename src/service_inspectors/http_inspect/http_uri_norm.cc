@@ -28,8 +28,81 @@
 #include "http_enum.h"
 #include "http_uri_norm.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using namespace HttpEnums;
 
+// Most URIs are long runs of letters, digits, and separators with nothing to normalize. Octets
+// that uri_char can classify as anything other than CHAR_NORMAL are percent, backslash, plus,
+// slash, period, and 8-bit octets. Everything else is skipped a vector at a time and the
+// byte-wise code only runs at these candidates. Slash and period are candidates only when the
+// caller cares about path characters and 8-bit octets only when it cares about bare bytes.
+int32_t UriNormalizer::find_special(const uint8_t* buf, int32_t start, int32_t length,
+    bool path, bool eight_bit)
+{
+    int32_t k = start;
+
+#if defined(__SSE2__)
+    // When path characters are not wanted their comparisons just look for percent again
+    const char slash = path ? '/' : '%';
+    const char period = path ? '.' : '%';
+    const uint32_t high_mask = eight_bit ? 0xFFFFFFFF : 0;
+#endif
+
+#if defined(__AVX2__)
+    const __m256i percent32 = _mm256_set1_epi8('%');
+    const __m256i backslash32 = _mm256_set1_epi8('\\');
+    const __m256i plus32 = _mm256_set1_epi8('+');
+    const __m256i slash32 = _mm256_set1_epi8(slash);
+    const __m256i period32 = _mm256_set1_epi8(period);
+    for (; k + 32 <= length; k += 32)
+    {
+        const __m256i block = _mm256_loadu_si256((const __m256i*)(buf + k));
+        const __m256i match = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, percent32),
+                _mm256_cmpeq_epi8(block, backslash32)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, plus32),
+                _mm256_or_si256(_mm256_cmpeq_epi8(block, slash32),
+                    _mm256_cmpeq_epi8(block, period32))));
+        const uint32_t mask = (uint32_t)_mm256_movemask_epi8(match) |
+            ((uint32_t)_mm256_movemask_epi8(block) & high_mask);
+        if (mask != 0)
+            return k + __builtin_ctz(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i percent16 = _mm_set1_epi8('%');
+    const __m128i backslash16 = _mm_set1_epi8('\\');
+    const __m128i plus16 = _mm_set1_epi8('+');
+    const __m128i slash16 = _mm_set1_epi8(slash);
+    const __m128i period16 = _mm_set1_epi8(period);
+    for (; k + 16 <= length; k += 16)
+    {
+        const __m128i block = _mm_loadu_si128((const __m128i*)(buf + k));
+        const __m128i match = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(block, percent16), _mm_cmpeq_epi8(block, backslash16)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, plus16),
+                _mm_or_si128(_mm_cmpeq_epi8(block, slash16), _mm_cmpeq_epi8(block, period16))));
+        const uint32_t mask = (uint32_t)_mm_movemask_epi8(match) |
+            ((uint32_t)_mm_movemask_epi8(block) & high_mask);
+        if (mask != 0)
+            return k + __builtin_ctz(mask);
+    }
+#endif
+    for (; k < length; k++)
+    {
+        const uint8_t c = buf[k];
+        if ((c == '%') || (c == '\\') || (c == '+') || (path && ((c == '/') || (c == '.'))) ||
+            (eight_bit && (c >= 0x80)))
+            return k;
+    }
+    return length;
+}
+
 void UriNormalizer::normalize(const Field& input, Field& result, bool do_path, uint8_t* buffer,
     const HttpParaList::UriParam& uri_param, HttpInfractions& infractions, HttpEventGen& events)
 {
@@ -72,7 +145,8 @@ bool UriNormalizer::need_norm_no_path(const Field& uri_component,
 {
     const int32_t& length = uri_component.length;
     const uint8_t* const & buf = uri_component.start;
-    for (int32_t k = 0; k < length; k++)
+    for (int32_t k = find_special(buf, 0, length, false, false); k < length;
+        k = find_special(buf, k+1, length, false, false))
     {
         if ((uri_param.uri_char[buf[k]] == CHAR_PERCENT) ||
             (uri_param.uri_char[buf[k]] == CHAR_SUBSTIT))
@@ -86,7 +160,8 @@ bool UriNormalizer::need_norm_path(const Field& uri_component,
 {
     const int32_t& length = uri_component.length;
     const uint8_t* const & buf = uri_component.start;
-    for (int32_t k = 0; k < length; k++)
+    for (int32_t k = find_special(buf, 0, length, true, false); k < length;
+        k = find_special(buf, k+1, length, true, false))
     {
         switch (uri_param.uri_char[buf[k]])
         {
@@ -146,6 +221,14 @@ int32_t UriNormalizer::norm_percent_processing(const Field& input, uint8_t* out_
     int32_t length = 0;
     for (int32_t k = 0; k < input.length; k++)
     {
+        // Copy everything up to the next octet that might need attention
+        const int32_t next = find_special(input.start, k, input.length, false,
+            uri_param.utf8_bare_byte);
+        memcpy(out_buf + length, input.start + k, next - k);
+        length += next - k;
+        if ((k = next) >= input.length)
+            break;
+
         switch (uri_param.uri_char[input.start[k]])
         {
         case CHAR_EIGHTBIT:
@@ -289,31 +372,33 @@ int32_t UriNormalizer::norm_double_decode(const Field& input, uint8_t* out_buf,
     int32_t length = 0;
     for (int32_t k = 0; k < input.length; k++)
     {
-        if (input.start[k] != '%')
-            out_buf[length++] = input.start[k];
+        const uint8_t* percent = (const uint8_t*)memchr(input.start + k, '%', input.length - k);
+        const int32_t next = (percent != nullptr) ? percent - input.start : input.length;
+        memmove(out_buf + length, input.start + k, next - k);
+        length += next - k;
+        if ((k = next) >= input.length)
+            break;
+
+        if (is_percent_encoding(input, k))
+        {
+            infractions += INF_URI_DOUBLE_DECODE;
+            events.create_event(EVENT_DOUBLE_DECODE);
+            out_buf[length++] = extract_percent_encoding(input, k);
+            k += 2;
+        }
+        else if (uri_param.percent_u && is_u_encoding(input, k))
+        {
+            infractions += INF_URI_DOUBLE_DECODE;
+            events.create_event(EVENT_DOUBLE_DECODE);
+            infractions += INF_URI_U_ENCODE;
+            events.create_event(EVENT_U_ENCODE);
+            out_buf[length++] = reduce_to_eight_bits(extract_u_encoding(input, k), uri_param,
+                infractions, events);
+            k += 5;
+        }
         else
         {
-            if (is_percent_encoding(input, k))
-            {
-                infractions += INF_URI_DOUBLE_DECODE;
-                events.create_event(EVENT_DOUBLE_DECODE);
-                out_buf[length++] = extract_percent_encoding(input, k);
-                k += 2;
-            }
-            else if (uri_param.percent_u && is_u_encoding(input, k))
-            {
-                infractions += INF_URI_DOUBLE_DECODE;
-                events.create_event(EVENT_DOUBLE_DECODE);
-                infractions += INF_URI_U_ENCODE;
-                events.create_event(EVENT_U_ENCODE);
-                out_buf[length++] = reduce_to_eight_bits(extract_u_encoding(input, k), uri_param,
-                    infractions, events);
-                k += 5;
-            }
-            else
-            {
-                out_buf[length++] = '%';
-            }
+            out_buf[length++] = '%';
         }
     }
     return length;
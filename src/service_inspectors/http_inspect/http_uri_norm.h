@@ -48,6 +48,10 @@ public:
     static void load_unicode_map(uint8_t map[65536], const char* filename, int code_page);
 
 private:
+    friend class HttpUnitTestSetup;
+
+    static int32_t find_special(const uint8_t* buf, int32_t start, int32_t length, bool path,
+        bool eight_bit);
     static bool need_norm_path(const Field& uri_component,
         const HttpParaList::UriParam& uri_param);
     static bool need_norm_no_path(const Field& uri_component,
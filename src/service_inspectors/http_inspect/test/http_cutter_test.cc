@@ -0,0 +1,234 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// http_cutter_test.cc
+// unit test main
+
+#include "service_inspectors/http_inspect/http_cutter.h"
+
+#include <chrono>
+#include <string>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+using namespace HttpEnums;
+
+// Stubs whose sole purpose is to make the test code link
+const char* SnortStrnStr(const char*, int, const char*) { return nullptr; }
+int SnortEventqAdd(uint32_t, uint32_t, RuleType) { return 0; }
+
+static const uint32_t FLOW_TARGET = 16384;
+static const uint32_t FLOW_MAX = 65535;
+
+class TestEventGen : public HttpEventGen
+{
+public:
+    void create_event(EventSid sid) override { events |= (uint64_t)1 << (sid % 64); }
+    uint64_t events = 0;
+};
+
+struct CutOutcome
+{
+    ScanResult result;
+    uint32_t end;           // octets consumed through the end of the cut
+    uint32_t num_excess;
+    uint32_t num_head_lines;
+    uint64_t infractions;
+    uint64_t events;
+
+    bool operator==(const CutOutcome& rhs) const
+    {
+        return result == rhs.result && end == rhs.end && num_excess == rhs.num_excess &&
+            num_head_lines == rhs.num_head_lines && infractions == rhs.infractions &&
+            events == rhs.events;
+    }
+};
+
+// Flush position means nothing after an abort and num_excess is only defined after a flush
+static CutOutcome outcome(const HttpCutter& cutter, ScanResult result, uint32_t end,
+    const HttpInfractions& infractions, const TestEventGen& events)
+{
+    return { result, (result == SCAN_ABORT) ? 0 : end,
+        (result == SCAN_FOUND) ? cutter.get_num_excess() : 0, cutter.get_num_head_lines(),
+        infractions.get_raw(), events.events };
+}
+
+// Cut the whole buffer at once so the vector scanning is used
+template<class Cutter>
+static CutOutcome cut_whole(const std::string& data)
+{
+    Cutter cutter;
+    HttpInfractions infractions;
+    TestEventGen events;
+    const ScanResult result = cutter.cut((const uint8_t*)data.data(), data.size(), infractions,
+        events, FLOW_TARGET, FLOW_MAX);
+    const uint32_t end = (result == SCAN_NOTFOUND) ? data.size() : cutter.get_num_flush();
+    return outcome(cutter, result, end, infractions, events);
+}
+
+// Cut one octet at a time so only the byte-wise state machine runs
+template<class Cutter>
+static CutOutcome cut_bytewise(const std::string& data)
+{
+    Cutter cutter;
+    HttpInfractions infractions;
+    TestEventGen events;
+    ScanResult result = SCAN_NOTFOUND;
+    uint32_t end = data.size();
+
+    for (uint32_t k = 0; k < data.size(); k++)
+    {
+        result = cutter.cut((const uint8_t*)data.data() + k, 1, infractions, events,
+            FLOW_TARGET, FLOW_MAX);
+        if (result != SCAN_NOTFOUND)
+        {
+            end = k + cutter.get_num_flush();
+            break;
+        }
+    }
+    return outcome(cutter, result, end, infractions, events);
+}
+
+// Deterministic mix of ordinary text with sparse CR and LF
+static std::string random_text(uint32_t& seed, unsigned length, const char* alphabet,
+    unsigned alphabet_size)
+{
+    std::string s;
+    for (unsigned k = 0; k < length; k++)
+    {
+        seed = seed * 1103515245 + 12345;
+        const unsigned r = (seed >> 16) % 64;
+        if (r == 0)
+            s += '\r';
+        else if (r == 1)
+            s += '\n';
+        else if (r == 2)
+            s += "\r\n";
+        else
+            s += alphabet[r % alphabet_size];
+    }
+    return s;
+}
+
+TEST_GROUP(http_cutter_find_crlf) {};
+
+TEST(http_cutter_find_crlf, all_offsets)
+{
+    uint8_t buffer[100];
+    memset(buffer, 'x', sizeof(buffer));
+
+    CHECK(HttpCutter::find_crlf(buffer, 0, sizeof(buffer)) == sizeof(buffer));
+    CHECK(HttpCutter::find_crlf(buffer, 0, 0) == 0);
+    CHECK(HttpCutter::find_crlf(buffer, 50, 50) == 50);
+
+    for (uint32_t pos = 0; pos < sizeof(buffer); pos++)
+    {
+        buffer[pos] = (pos & 1) ? '\r' : '\n';
+        for (uint32_t start = 0; start <= pos; start++)
+            CHECK(HttpCutter::find_crlf(buffer, start, sizeof(buffer)) == pos);
+        CHECK(HttpCutter::find_crlf(buffer, pos+1, sizeof(buffer)) == sizeof(buffer));
+        // a delimiter past length must not be found
+        CHECK(HttpCutter::find_crlf(buffer, 0, pos) == pos);
+        buffer[pos] = 'x';
+    }
+}
+
+TEST_GROUP(http_cutter_differential) {};
+
+TEST(http_cutter_differential, header_cutter)
+{
+    static const char alphabet[] = "abcdefghij: \t-/0123456789";
+    uint32_t seed = 1;
+
+    for (int n = 0; n < 2000; n++)
+    {
+        std::string data = random_text(seed, 1 + n % 300, alphabet, sizeof(alphabet)-1);
+        if (n & 1)
+            data += "\r\n\r\nbody";
+        CHECK(cut_whole<HttpHeaderCutter>(data) == cut_bytewise<HttpHeaderCutter>(data));
+    }
+}
+
+TEST(http_cutter_differential, start_cutter)
+{
+    static const char alphabet[] = "abcdefghij /HTTP1.0";
+    uint32_t seed = 2;
+
+    for (int n = 0; n < 2000; n++)
+    {
+        const std::string line = random_text(seed, n % 200, alphabet, sizeof(alphabet)-1);
+        const std::string request = ((n & 3) == 0 ? "\r\n" : "") + std::string("GET ") + line;
+        CHECK(cut_whole<HttpRequestCutter>(request) == cut_bytewise<HttpRequestCutter>(request));
+        const std::string status = "HTTP/1.1 " + line;
+        CHECK(cut_whole<HttpStatusCutter>(status) == cut_bytewise<HttpStatusCutter>(status));
+    }
+}
+
+TEST(http_cutter_differential, chunk_cutter)
+{
+    static const char alphabet[] = "abc=;\t 01";
+    uint32_t seed = 3;
+
+    for (int n = 0; n < 2000; n++)
+    {
+        const std::string data = "1a" + random_text(seed, n % 100, alphabet, sizeof(alphabet)-1) +
+            "\r\nabcdefghijklmnopqrstuvwxyz\r\n0;ext=" + std::string(n % 70, 'e') + "\r\n";
+        CHECK(cut_whole<HttpBodyChunkCutter>(data) == cut_bytewise<HttpBodyChunkCutter>(data));
+    }
+}
+
+TEST_GROUP(http_cutter_benchmark) {};
+
+TEST(http_cutter_benchmark, header_cutter)
+{
+    std::string head;
+    for (int k = 0; k < 12; k++)
+        head += "X-Header-" + std::to_string(k) +
+            ": value value value value value value value value value\r\n";
+    head += "\r\n";
+
+    const unsigned iterations = 20000;
+    unsigned found = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (unsigned k = 0; k < iterations; k++)
+    {
+        HttpHeaderCutter cutter;
+        HttpInfractions infractions;
+        TestEventGen events;
+        if (cutter.cut((const uint8_t*)head.data(), head.size(), infractions, events, 0, 0) ==
+            SCAN_FOUND)
+            found++;
+    }
+
+    auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    CHECK(found == iterations);
+
+    char buf[128];
+    snprintf(buf, sizeof(buf), "header cutter: %.1f MB/s",
+        usecs ? (double)head.size() * iterations / usecs : 0.0);
+    UT_PRINT(buf);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
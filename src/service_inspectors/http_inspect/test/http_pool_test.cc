@@ -0,0 +1,83 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// http_pool_test.cc
+// unit test main
+
+#include "service_inspectors/http_inspect/http_pool.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness.h>
+
+TEST_GROUP(http_pool)
+{
+    void teardown()
+    {
+        HttpPool::purge();
+    }
+};
+
+TEST(http_pool, recycle_same_class)
+{
+    void* first = HttpPool::allocate(100);
+    CHECK(first != nullptr);
+    CHECK(((uintptr_t)first & 15) == 0);
+    memset(first, 0xA5, 100);
+    HttpPool::release(first);
+
+    // Any size in the same class gets the block back
+    void* second = HttpPool::allocate(90);
+    CHECK(second == first);
+    HttpPool::release(second);
+}
+
+TEST(http_pool, distinct_live_blocks)
+{
+    void* blocks[40];
+    for (unsigned k = 0; k < 40; k++)
+    {
+        blocks[k] = HttpPool::allocate(8 * k);
+        memset(blocks[k], k, 8 * k);
+        for (unsigned j = 0; j < k; j++)
+            CHECK(blocks[j] != blocks[k]);
+    }
+    for (unsigned k = 0; k < 40; k++)
+    {
+        for (unsigned i = 0; i < 8 * k; i++)
+            CHECK(((uint8_t*)blocks[k])[i] == k);
+        HttpPool::release(blocks[k]);
+    }
+}
+
+TEST(http_pool, large_blocks)
+{
+    uint8_t* big = (uint8_t*)HttpPool::allocate(100000);
+    CHECK(big != nullptr);
+    big[0] = 1;
+    big[99999] = 2;
+    HttpPool::release(big);
+    HttpPool::release(nullptr);
+}
+
+int main(int argc, char** argv)
+{
+    return CommandLineTestRunner::RunAllTests(argc, argv);
+}
+
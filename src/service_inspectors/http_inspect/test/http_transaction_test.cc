@@ -36,6 +36,9 @@ FlowData::FlowData(unsigned, Inspector*) {}
 FlowData::~FlowData() {}
 int SnortEventqAdd(unsigned int, unsigned int, RuleType) { return 0; }
 THREAD_LOCAL PegCount HttpModule::peg_counts[1];
+bool Inflater::init(InflateCodec, int) { return false; }
+bool Inflater::reset(InflateCodec, int) { return false; }
+void Inflater::end() { }
 
 class HttpUnitTestSetup
 {
@@ -55,6 +58,7 @@ TEST_GROUP(http_transaction_test)
     void teardown()
     {
         delete flow_data;
+        HttpPool::purge();
     }
 };
 
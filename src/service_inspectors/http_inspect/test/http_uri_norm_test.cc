@@ -26,6 +26,8 @@
 #include <CppUTest/TestHarness.h>
 #include <CppUTestExt/MockSupport.h>
 
+using namespace HttpEnums;
+
 // Stubs whose sole purpose is to make the test code link
 void ParseWarning(WarningGroup, const char*, ...) {}
 void ParseError(const char*, ...) {}
@@ -134,6 +136,296 @@ TEST(http_double_decode_test, u_encode_all)
     CHECK(memcmp(result.start, "/uri/to/normalize", 17) == 0);
 }
 
+// The byte-wise scanning loops as they were before the vector fast path was added. Everything
+// else reuses the UriNormalizer code so that only the changed loops are compared.
+class HttpUnitTestSetup
+{
+public:
+    static bool need_norm(const Field& uri_component, bool do_path,
+        const HttpParaList::UriParam& uri_param, HttpInfractions& infractions,
+        HttpEventGen& events)
+    {
+        const bool need_it = (do_path && uri_param.simplify_path) ?
+            need_norm_path(uri_component, uri_param) :
+            need_norm_no_path(uri_component, uri_param);
+        if (!need_it)
+            UriNormalizer::detect_bad_char(uri_component, uri_param, infractions, events);
+        return need_it;
+    }
+
+    static void normalize(const Field& input, Field& result, bool do_path, uint8_t* buffer,
+        const HttpParaList::UriParam& uri_param, HttpInfractions& infractions,
+        HttpEventGen& events)
+    {
+        bool utf8_needed = false;
+        bool double_decoding_needed = false;
+        std::vector<bool> percent_encoded(input.length, false);
+        int32_t data_length = norm_percent_processing(input, buffer, uri_param, utf8_needed,
+            percent_encoded, double_decoding_needed, infractions, events);
+        if (uri_param.utf8 && utf8_needed)
+        {
+            data_length = UriNormalizer::norm_utf8_processing(Field(data_length, buffer), buffer,
+                uri_param, percent_encoded, double_decoding_needed, infractions, events);
+        }
+        if (uri_param.iis_double_decode && double_decoding_needed)
+        {
+            data_length = norm_double_decode(Field(data_length, buffer), buffer, uri_param,
+                infractions, events);
+        }
+        UriNormalizer::detect_bad_char(Field(data_length, buffer), uri_param, infractions,
+            events);
+        UriNormalizer::norm_substitute(buffer, data_length, uri_param, infractions, events);
+        if (do_path && uri_param.simplify_path)
+            data_length = UriNormalizer::norm_path_clean(buffer, data_length, infractions, events);
+        result.set(data_length, buffer);
+    }
+
+private:
+    static bool need_norm_no_path(const Field& uri_component,
+        const HttpParaList::UriParam& uri_param)
+    {
+        for (int32_t k = 0; k < uri_component.length; k++)
+        {
+            if ((uri_param.uri_char[uri_component.start[k]] == CHAR_PERCENT) ||
+                (uri_param.uri_char[uri_component.start[k]] == CHAR_SUBSTIT))
+                return true;
+        }
+        return false;
+    }
+
+    static bool need_norm_path(const Field& uri_component,
+        const HttpParaList::UriParam& uri_param)
+    {
+        const int32_t& length = uri_component.length;
+        const uint8_t* const & buf = uri_component.start;
+        for (int32_t k = 0; k < length; k++)
+        {
+            switch (uri_param.uri_char[buf[k]])
+            {
+            case CHAR_NORMAL:
+            case CHAR_EIGHTBIT:
+                continue;
+            case CHAR_PERCENT:
+            case CHAR_SUBSTIT:
+                return true;
+            case CHAR_PATH:
+                if (buf[k] == '/')
+                {
+                    if ((k == 0) || (buf[k-1] != '/'))
+                        continue;
+                    return true;
+                }
+                else
+                {
+                    if (((k == 0) || (uri_param.uri_char[buf[k-1]] != CHAR_PATH)) &&
+                        ((k == length-1) || (uri_param.uri_char[buf[k+1]] != CHAR_PATH)))
+                        continue;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    static int32_t norm_percent_processing(const Field& input, uint8_t* out_buf,
+        const HttpParaList::UriParam& uri_param, bool& utf8_needed,
+        std::vector<bool>& percent_encoded, bool& double_decoding_needed,
+        HttpInfractions& infractions, HttpEventGen& events)
+    {
+        int32_t length = 0;
+        for (int32_t k = 0; k < input.length; k++)
+        {
+            switch (uri_param.uri_char[input.start[k]])
+            {
+            case CHAR_EIGHTBIT:
+                if (uri_param.utf8_bare_byte &&
+                   (((input.start[k] & 0xE0) == 0xC0) || ((input.start[k] & 0xF0) == 0xE0)))
+                    utf8_needed = true;
+                // Fall through
+            case CHAR_NORMAL:
+            case CHAR_PATH:
+            case CHAR_SUBSTIT:
+                out_buf[length++] = input.start[k];
+                break;
+            case CHAR_PERCENT:
+                if (UriNormalizer::is_percent_encoding(input, k))
+                {
+                    const uint8_t hex_val = UriNormalizer::extract_percent_encoding(input, k);
+                    percent_encoded[length] = true;
+                    if (((hex_val & 0xE0) == 0xC0) || ((hex_val & 0xF0) == 0xE0))
+                        utf8_needed = true;
+                    if (hex_val == '%')
+                        double_decoding_needed = true;
+                    out_buf[length++] = hex_val;
+                    k += 2;
+                }
+                else if ((k+1 < input.length) && (input.start[k+1] == '%'))
+                {
+                    double_decoding_needed = true;
+                    out_buf[length++] = '%';
+                    k += 1;
+                }
+                else if (uri_param.percent_u && UriNormalizer::is_u_encoding(input, k))
+                {
+                    infractions += INF_URI_U_ENCODE;
+                    events.create_event(EVENT_U_ENCODE);
+                    percent_encoded[length] = true;
+                    const uint8_t byte_val = UriNormalizer::reduce_to_eight_bits(
+                        UriNormalizer::extract_u_encoding(input, k), uri_param, infractions,
+                        events);
+                    if (((byte_val & 0xE0) == 0xC0) || ((byte_val & 0xF0) == 0xE0))
+                        utf8_needed = true;
+                    if (byte_val == '%')
+                        double_decoding_needed = true;
+                    out_buf[length++] = byte_val;
+                    k += 5;
+                }
+                else
+                {
+                    infractions += INF_URI_UNKNOWN_PERCENT;
+                    events.create_event(EVENT_UNKNOWN_PERCENT);
+                    double_decoding_needed = true;
+                    out_buf[length++] = '%';
+                }
+                if (uri_param.unreserved_char[out_buf[length-1]])
+                {
+                    infractions += INF_URI_PERCENT_UNRESERVED;
+                    events.create_event(EVENT_ASCII);
+                }
+                break;
+            }
+        }
+        return length;
+    }
+
+    static int32_t norm_double_decode(const Field& input, uint8_t* out_buf,
+        const HttpParaList::UriParam& uri_param, HttpInfractions& infractions,
+        HttpEventGen& events)
+    {
+        int32_t length = 0;
+        for (int32_t k = 0; k < input.length; k++)
+        {
+            if (input.start[k] != '%')
+                out_buf[length++] = input.start[k];
+            else if (UriNormalizer::is_percent_encoding(input, k))
+            {
+                infractions += INF_URI_DOUBLE_DECODE;
+                events.create_event(EVENT_DOUBLE_DECODE);
+                out_buf[length++] = UriNormalizer::extract_percent_encoding(input, k);
+                k += 2;
+            }
+            else if (uri_param.percent_u && UriNormalizer::is_u_encoding(input, k))
+            {
+                infractions += INF_URI_DOUBLE_DECODE;
+                events.create_event(EVENT_DOUBLE_DECODE);
+                infractions += INF_URI_U_ENCODE;
+                events.create_event(EVENT_U_ENCODE);
+                out_buf[length++] = UriNormalizer::reduce_to_eight_bits(
+                    UriNormalizer::extract_u_encoding(input, k), uri_param, infractions, events);
+                k += 5;
+            }
+            else
+                out_buf[length++] = '%';
+        }
+        return length;
+    }
+};
+
+class TestEventGen : public HttpEventGen
+{
+public:
+    void create_event(HttpEnums::EventSid sid) override { events[sid % 128] = true; }
+    std::bitset<128> events;
+};
+
+TEST_GROUP(http_uri_norm_differential)
+{
+    uint8_t fast_buffer[1000];
+    uint8_t ref_buffer[1000];
+    HttpParaList::UriParam uri_param;
+    uint32_t seed = 12345;
+
+    unsigned random(unsigned range)
+    {
+        seed = seed * 1103515245 + 12345;
+        return (seed >> 16) % range;
+    }
+
+    // Mostly clean text with occasional escapes, path characters, and UTF-8 octets
+    std::string random_uri(unsigned length)
+    {
+        static const char* const pieces[] = { "%2e", "%2F", "%25", "%%", "%u002e", "%U00C3",
+            "%c3%a9", "%e2%82%ac", "\xC3\xA9", "\xE2\x82\xAC", "\xFF", "%", "%4", "%zz", "/",
+            "//", "/./", "/../", ".", "..", "\\", "+", "%5c", "%2b", "%255c", "%u0025" };
+        std::string s;
+        while (s.length() < length)
+        {
+            if (random(8) == 0)
+                s += pieces[random(sizeof(pieces)/sizeof(pieces[0]))];
+            else
+                s += "abcdefghijklmnopqrstuvwxyz0123456789-_~=&?"[random(42)];
+        }
+        return s;
+    }
+
+    void randomize_params()
+    {
+        uri_param.percent_u = random(2);
+        uri_param.utf8 = random(4) != 0;
+        uri_param.utf8_bare_byte = random(2);
+        uri_param.iis_unicode = random(2);
+        uri_param.iis_double_decode = random(2);
+        uri_param.backslash_to_slash = random(2);
+        uri_param.plus_to_space = random(2);
+        uri_param.simplify_path = random(4) != 0;
+        uri_param.uri_char[(uint8_t)'\\'] = uri_param.backslash_to_slash ? CHAR_SUBSTIT :
+            CHAR_NORMAL;
+        uri_param.uri_char[(uint8_t)'+'] = uri_param.plus_to_space ? CHAR_SUBSTIT : CHAR_NORMAL;
+        uri_param.bad_characters.reset();
+        if (random(4) == 0)
+            uri_param.bad_characters[random(256)] = true;
+    }
+
+    void setup()
+    {
+        uri_param.unicode_map = new uint8_t[65536];
+        for (unsigned k = 0; k < 65536; k++)
+            uri_param.unicode_map[k] = (k % 7 == 0) ? 0xFF : (uint8_t)k;
+    }
+};
+
+TEST(http_uri_norm_differential, random_uris)
+{
+    for (int n = 0; n < 20000; n++)
+    {
+        randomize_params();
+        const bool do_path = random(2);
+        std::string uri = random_uri(random(300));
+        if (do_path)
+            uri = "/" + uri;
+        const Field input(uri.length(), (const uint8_t*)uri.data());
+
+        HttpInfractions fast_inf, ref_inf;
+        TestEventGen fast_ev, ref_ev;
+        const bool fast_need = UriNormalizer::need_norm(input, do_path, uri_param, fast_inf,
+            fast_ev);
+        const bool ref_need = HttpUnitTestSetup::need_norm(input, do_path, uri_param, ref_inf,
+            ref_ev);
+        CHECK(fast_need == ref_need);
+
+        Field fast_result, ref_result;
+        UriNormalizer::normalize(input, fast_result, do_path, fast_buffer, uri_param, fast_inf,
+            fast_ev);
+        HttpUnitTestSetup::normalize(input, ref_result, do_path, ref_buffer, uri_param, ref_inf,
+            ref_ev);
+        CHECK(fast_result.length == ref_result.length);
+        CHECK(memcmp(fast_result.start, ref_result.start, ref_result.length) == 0);
+        CHECK(fast_inf.get_raw() == ref_inf.get_raw());
+        CHECK(fast_inf.get_raw2() == ref_inf.get_raw2());
+        CHECK(fast_ev.events == ref_ev.events);
+    }
+}
+
 int main(int argc, char** argv)
 {
     return CommandLineTestRunner::RunAllTests(argc, argv);
@@ -653,8 +653,13 @@ static int SIP_deleteDialog(SIP_DialogData* currDialog, SIP_DialogList* dList)
 
 static void sip_publish_data_bus(const Packet* p, const SIPMsg* sip_msg, const SIP_DialogData* dialog)
 {
+    DataBus& bus = get_data_bus();
+
+    if ( !bus.has_subscribers(DE_SIP_DIALOG) )
+        return;
+
     SipEvent event(p, sip_msg, dialog);
-    get_data_bus().publish(SIP_EVENT_TYPE_SIP_DIALOG_KEY, event, p->flow);
+    bus.publish(DE_SIP_DIALOG, event, p->flow);
 }
 
 /********************************************************************
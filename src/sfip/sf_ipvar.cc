@@ -31,8 +31,13 @@
 #include <ctype.h>
 #include <stdio.h>
 
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
 #include "utils/util.h"
 #include "sfip/sf_vartable.h"
+#include "sfrt/sfrt.h"
 
 #define LIST_OPEN '['
 #define LIST_CLOSE ']'
@@ -40,6 +45,7 @@
 static SFIP_RET sfvar_list_compare(sfip_node_t*, sfip_node_t*);
 static inline void sfip_node_free(sfip_node_t*);
 static inline void sfip_node_freelist(sfip_node_t*);
+static void sfvar_table_release(sfip_var_table_t*);
 
 static inline sfip_var_t* _alloc_var()
 {
@@ -57,15 +63,11 @@ void sfvar_free(sfip_var_t* var)
     if (var->value)
         snort_free(var->value);
 
-    if (var->mode == SFIP_LIST)
-    {
-        sfip_node_freelist(var->head);
-        sfip_node_freelist(var->neg_head);
-    }
-    else if (var->mode == SFIP_TABLE)
-    {
-        // XXX
-    }
+    sfip_node_freelist(var->head);
+    sfip_node_freelist(var->neg_head);
+
+    if (var->mode == SFIP_TABLE)
+        sfvar_table_release(var->table);
 
     snort_free(var);
 }
@@ -219,7 +221,8 @@ static sfip_var_t* sfvar_deep_copy(const sfip_var_t* var)
 
     ret = (sfip_var_t*)snort_calloc(sizeof(sfip_var_t));
 
-    ret->mode = var->mode;
+    /* the copy is usually changed; compile it when done */
+    ret->mode = SFIP_LIST;
     ret->head = _sfvar_deep_copy_list(var->head);
     ret->neg_head = _sfvar_deep_copy_list(var->neg_head);
 
@@ -357,6 +360,8 @@ sfip_var_t* sfvar_create_alias(const sfip_var_t* alias_from, const char* alias_t
     ret->name = snort_strdup(alias_to);
     ret->id = alias_from->id;
 
+    sfvar_compile(ret);
+
     return ret;
 }
 
@@ -826,9 +831,173 @@ sfip_var_t* sfvar_alloc(vartable_t* table, const char* variable, SFIP_RET* statu
         return NULL;
     }
 
+    sfvar_compile(ret);
+
     return ret;
 }
 
+/* Variables with at least this many addresses are compiled into a routing
+ * table.  Shorter lists are as fast to walk. */
+#define SFIP_TABLE_MIN 16
+
+/* Megabytes; a table is mostly its two 16 bit direct arrays */
+#define SFIP_TABLE_MEMCAP 64
+
+/* A POPTRIE holding the positive addresses of a variable mapped to s_in and
+ * the negated ones mapped to s_out.  Positive addresses inside a negated
+ * network are left out, so the longest match gives the same answer as the
+ * lists.  Addresses that match nothing get the cached result in "miss". */
+struct sfip_var_table_t
+{
+    table_t* rt;
+    bool miss;
+    unsigned refs;
+    std::string key;
+};
+
+static int s_in = 1;
+static int s_out = 0;
+
+/* Rule headers get their own copy of each variable they use, so the same
+ * lists are compiled many times.  Those share one table. */
+static std::unordered_map<std::string, sfip_var_table_t*> s_tables;
+static std::mutex s_tables_mutex;
+
+static unsigned sfvar_key_append(std::string& key, const sfip_node_t* node)
+{
+    unsigned num = 0;
+
+    for (; node; node = node->next, num++)
+    {
+        key += (char)sfip_family(node->ip);
+        key += (char)sfip_bits(node->ip);
+        key.append((const char*)node->ip->ip8, sizeof(node->ip->ip8));
+    }
+    return num;
+}
+
+static bool sfvar_table_insert(table_t* rt, const sfip_t* ip, int* value)
+{
+    sfip_t tmp = *ip;
+
+    return sfrt_insert(&tmp, (unsigned char)sfip_bits(ip), value, RT_FAVOR_SPECIFIC, rt) ==
+        RT_SUCCESS;
+}
+
+static bool sfvar_negated(const sfip_var_t* var, const sfip_t* ip)
+{
+    for (const sfip_node_t* neg = var->neg_head; neg; neg = neg->next)
+    {
+        if ((sfip_bits(neg->ip) <= sfip_bits(ip)) &&
+            (sfip_contains(neg->ip, ip) == SFIP_CONTAINS))
+            return true;
+    }
+    return false;
+}
+
+static sfip_var_table_t* sfvar_table_new(const sfip_var_t* var, unsigned num)
+{
+    sfip_node_t* node;
+    table_t* rt = sfrt_new(POPTRIE, IPv6, num + 1, SFIP_TABLE_MEMCAP);
+
+    if (!rt)
+        return NULL;
+
+    /* An "any" matches every address and makes the other positive
+     * addresses moot */
+    bool miss = !var->head;
+
+    for (node = var->head; node; node = node->next)
+    {
+        if (!sfip_is_set(node->ip))
+            miss = true;
+    }
+
+    for (node = var->head; node and !miss; node = node->next)
+    {
+        if (sfvar_negated(var, node->ip))
+            continue;
+
+        if (!sfvar_table_insert(rt, node->ip, &s_in))
+        {
+            sfrt_free(rt);
+            return NULL;
+        }
+    }
+
+    for (node = var->neg_head; node; node = node->next)
+    {
+        if (!sfvar_table_insert(rt, node->ip, &s_out))
+        {
+            sfrt_free(rt);
+            return NULL;
+        }
+    }
+
+    sfip_var_table_t* table = new sfip_var_table_t;
+    table->rt = rt;
+    table->miss = miss;
+    table->refs = 0;
+
+    return table;
+}
+
+static void sfvar_table_release(sfip_var_table_t* table)
+{
+    std::lock_guard<std::mutex> lock(s_tables_mutex);
+
+    if (--table->refs)
+        return;
+
+    s_tables.erase(table->key);
+    sfrt_free(table->rt);
+    delete table;
+}
+
+void sfvar_compile(sfip_var_t* var)
+{
+    if (!var)
+        return;
+
+    if (var->mode == SFIP_TABLE)
+    {
+        sfvar_table_release(var->table);
+        var->table = NULL;
+        var->mode = SFIP_LIST;
+    }
+
+    std::string key(sizeof(unsigned), '\0');
+    unsigned num_pos = sfvar_key_append(key, var->head);
+    unsigned num = num_pos + sfvar_key_append(key, var->neg_head);
+
+    if (num < SFIP_TABLE_MIN)
+        return;
+
+    /* so a list can't be mistaken for a longer positive list */
+    key.replace(0, sizeof(num_pos), (const char*)&num_pos, sizeof(num_pos));
+
+    std::lock_guard<std::mutex> lock(s_tables_mutex);
+    auto it = s_tables.find(key);
+    sfip_var_table_t* table;
+
+    if (it != s_tables.end())
+        table = it->second;
+
+    /* stay in list mode if the table can't be built */
+    else if (!(table = sfvar_table_new(var, num)))
+        return;
+
+    else
+    {
+        table->key = key;
+        s_tables[key] = table;
+    }
+
+    table->refs++;
+    var->table = table;
+    var->mode = SFIP_TABLE;
+}
+
 /* Support function for sfvar_ip_in  */
 static inline bool sfvar_ip_in4(sfip_var_t* var, const sfip_t* ip)
 {
@@ -963,11 +1132,25 @@ static inline bool sfvar_ip_in6(sfip_var_t* var, const sfip_t* ip)
     return false;
 }
 
+/* Support function for sfvar_ip_in  */
+static inline bool sfvar_ip_in_table(sfip_var_t* var, const sfip_t* ip)
+{
+    GENERIC result = sfrt_lookup((sfip_t*)ip, var->table->rt);
+
+    if (!result)
+        return var->table->miss;
+
+    return result == &s_in;
+}
+
 bool sfvar_ip_in(sfip_var_t* var, const sfip_t* ip)
 {
     if (!var || !ip)
         return false;
 
+    if (var->mode == SFIP_TABLE)
+        return sfvar_ip_in_table(var, ip);
+
     /* Since this is a performance-critical function it uses different
      * codepaths for IPv6 and IPv4 traffic, rather than the dual-stack
      * functions. */
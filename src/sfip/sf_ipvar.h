@@ -58,6 +58,9 @@ typedef struct _ip_node
                     /* Should merge them later */
 } sfip_node_t;
 
+/* Used by the "table" mode.  See sf_ipvar.cc. */
+struct sfip_var_table_t;
+
 /* An IP variable onkect */
 struct sfip_var_t
 {
@@ -70,8 +73,8 @@ struct sfip_var_t
     sfip_node_t* neg_head;
 
     /* The mode above will select whether to use the sfip_node_t linked list
-     * or the IP routing table */
-//    sfrt rt;
+     * or the IP routing table.  The lists are kept in either mode. */
+    sfip_var_table_t* table;
 
     /* Linked list of IP variables for the variable table */
     sfip_var_t* next;
@@ -110,6 +113,11 @@ SFIP_RET sfvar_compare(const sfip_var_t* one, const sfip_var_t* two);
 /* Free an allocated variable */
 void sfvar_free(sfip_var_t* var);
 
+/* Switches a variable with many addresses to table mode so sfvar_ip_in
+ * does not walk the lists.  Must be called again if the lists change;
+ * the parsing functions above do so. */
+void sfvar_compile(sfip_var_t* var);
+
 // returns true if both args are valid and ip is contained by var
 bool sfvar_ip_in(sfip_var_t* var, const sfip_t* ip);
 
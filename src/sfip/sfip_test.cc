@@ -24,11 +24,15 @@
 
 #include <string.h>
 
+#include <string>
+
 #include "catch/catch.hpp"
 #include "catch/unit_test.h"
 #include "main/snort_types.h"
 
 #include "sf_ip.h"
+#include "sf_ipvar.h"
+#include "sf_vartable.h"
 
 //---------------------------------------------------------------
 
@@ -483,3 +487,104 @@ TEST_CASE("sfip raw", "[sfip]")
         CHECK(RawCheck(i) == 1);
 }
 
+
+//---------------------------------------------------------------
+// large variables are looked up in a table; the answers must not change
+
+static std::string var_def(const char* name, unsigned num, const char* extra)
+{
+    std::string def = name;
+    def += " [";
+    def += extra;
+
+    for ( unsigned i = 0; i < num; ++i )
+    {
+        char buf[64];
+
+        if ( i & 1 )
+            snprintf(buf, sizeof(buf), ",2001:db8:%x::/48", i);
+        else
+            snprintf(buf, sizeof(buf), ",192.168.%u.0/24", i);
+
+        def += buf;
+    }
+    def += "]";
+    return def;
+}
+
+static void check_var(vartable_t* table, const char* name)
+{
+    sfip_var_t* var = sfvt_lookup_var(table, name);
+    REQUIRE(var);
+    CHECK(var->mode == SFIP_TABLE);
+
+    unsigned seed = 1;
+    unsigned in = 0;
+
+    for ( unsigned i = 0; i < 20000; ++i )
+    {
+        char buf[64];
+        seed = seed * 1103515245 + 12345;
+        unsigned r = seed >> 8;
+
+        switch ( i % 4 )
+        {
+        case 0:
+            snprintf(buf, sizeof(buf), "192.168.%u.%u", r % 80, (r >> 8) & 0xff);
+            break;
+        case 1:
+            snprintf(buf, sizeof(buf), "10.%u.%u.%u", r % 4, (r >> 8) & 0xff, (r >> 16) & 0xff);
+            break;
+        case 2:
+            snprintf(buf, sizeof(buf), "2001:db8:%x:%x::1", r % 80, (r >> 8) % 4);
+            break;
+        default:
+            snprintf(buf, sizeof(buf), "%u.%u.0.1", r & 0xff, (r >> 8) & 0xff);
+            break;
+        }
+
+        sfip_t ip;
+        REQUIRE(sfip_pton(buf, &ip) == SFIP_SUCCESS);
+
+        bool table_in = sfvar_ip_in(var, &ip);
+
+        var->mode = SFIP_LIST;
+        bool list_in = sfvar_ip_in(var, &ip);
+        var->mode = SFIP_TABLE;
+
+        CHECK(table_in == list_in);
+        in += table_in;
+    }
+    CHECK(in > 0);
+}
+
+TEST_CASE("sfip var table", "[sfip]")
+{
+    vartable_t* table = sfvt_alloc_table();
+    sfip_var_t* var;
+
+    std::string def = var_def("big", 64, "10.0.0.0/8,!10.1.0.0/16,!10.2.3.0/24,"
+        "!192.168.4.128/25,!2001:db8:5:1::/64");
+    REQUIRE(sfvt_add_str(table, def.c_str(), &var) == SFIP_SUCCESS);
+
+    def = var_def("negs", 40, "!10.1.0.0/16");
+    def.insert(def.find('['), "!");
+    REQUIRE(sfvt_add_str(table, def.c_str(), &var) == SFIP_SUCCESS);
+
+    def = var_def("small", 4, "");
+    REQUIRE(sfvt_add_str(table, def.c_str(), &var) == SFIP_SUCCESS);
+    CHECK(var->mode == SFIP_LIST);
+
+    check_var(table, "big");
+    check_var(table, "negs");
+
+    // an alias shares the compiled table
+    sfip_var_t* big = sfvt_lookup_var(table, "big");
+    sfip_var_t* alias = sfvar_create_alias(big, "alias");
+    REQUIRE(alias);
+    CHECK(alias->mode == SFIP_TABLE);
+    CHECK(alias->table == big->table);
+    sfvar_free(alias);
+
+    sfvt_free_table(table);
+}
@@ -84,6 +84,7 @@
 #endif
 
 #include "main/snort_types.h"
+#include "sfrt/sfrt_poptrie.h"
 #include "utils/util.h"
 
 const char* rt_error_messages[] =
@@ -196,6 +197,17 @@ table_t* sfrt_new(char table_type, char ip_type, long data_size, uint32_t mem_ca
 
         break;
 
+    /* Setup poptrie table */
+    case POPTRIE:
+        table->insert = sfrt_poptrie_insert;
+        table->lookup = sfrt_poptrie_lookup;
+        table->free = sfrt_poptrie_free;
+        table->usage = sfrt_poptrie_usage;
+        table->print = sfrt_poptrie_print;
+        table->remove = sfrt_poptrie_remove;
+
+        break;
+
     default:
         snort_free(table->data);
         snort_free(table);
@@ -248,6 +260,10 @@ table_t* sfrt_new(char table_type, char ip_type, long data_size, uint32_t mem_ca
         table->rt6 = sfrt_dir_new(mem_cap, 16,
             8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8);
         break;
+    case POPTRIE:
+        table->rt = sfrt_poptrie_new(mem_cap);
+        table->rt6 = sfrt_poptrie_new(mem_cap);
+        break;
     }
 
     if ((!table->rt) || (!table->rt6))
@@ -65,7 +65,8 @@ enum types
     DIR_16x8,
     DIR_8x16,
     IPv4,
-    IPv6
+    IPv6,
+    POPTRIE
 };
 
 enum return_codes
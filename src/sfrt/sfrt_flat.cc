@@ -24,6 +24,8 @@
 #include "config.h"
 #endif
 
+#include "sfrt_poptrie.h"
+
 #include "main/snort_types.h"
 #include "main/snort_debug.h"
 
@@ -99,6 +101,8 @@ table_flat_t* sfrt_flat_new(char table_flat_type, char ip_type,  long data_size,
     /* This will point to the actual table lookup algorithm */
     table->rt = 0;
     table->rt6 = 0;
+    table->rt_build = nullptr;
+    table->rt6_build = nullptr;
 
     /* index 0 will be used for failed lookups, so set this to 1 */
     table->num_ent = 1;
@@ -149,6 +153,20 @@ table_flat_t* sfrt_flat_new(char table_flat_type, char ip_type,  long data_size,
         table->rt6 = sfrt_dir_flat_new(mem_cap, 16,
             8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8);
         break;
+    /* Built on the heap and written to the segment by sfrt_flat_compile */
+    case POPTRIE:
+        table->rt_build = sfrt_poptrie_new(mem_cap);
+        table->rt6_build = sfrt_poptrie_new(mem_cap);
+
+        if ((!table->rt_build) || (!table->rt6_build))
+        {
+            sfrt_poptrie_free(table->rt_build);
+            sfrt_poptrie_free(table->rt6_build);
+            segment_free(table->data);
+            segment_free(table_ptr);
+            return NULL;
+        }
+        return table;
     }
 
     if ((!table->rt) || (!table->rt6))
@@ -189,7 +207,18 @@ void sfrt_flat_free(TABLE_PTR table_ptr)
         segment_free(table->data);
     }
 
-    if (!table->rt)
+    if (table->table_flat_type == POPTRIE)
+    {
+        sfrt_poptrie_free(table->rt_build);
+        sfrt_poptrie_free(table->rt6_build);
+        table->rt_build = table->rt6_build = nullptr;
+
+        if (table->rt)
+            segment_free(table->rt);
+        if (table->rt6)
+            segment_free(table->rt6);
+    }
+    else if (!table->rt)
     {
         /* This should not have happened either */
     }
@@ -198,7 +227,11 @@ void sfrt_flat_free(TABLE_PTR table_ptr)
         sfrt_dir_flat_free(table->rt);
     }
 
-    if (!table->rt6)
+    if (table->table_flat_type == POPTRIE)
+    {
+        /* freed above */
+    }
+    else if (!table->rt6)
     {
         /* This should not have happened either */
     }
@@ -239,12 +272,23 @@ GENERIC sfrt_flat_lookup(void* adr, table_flat_t* table)
         rt = table->rt6;
     }
 
-    if (!rt)
+    if (table->table_flat_type == POPTRIE)
+    {
+        void* rt_build = (ip->family == AF_INET) ? table->rt_build : table->rt6_build;
+
+        if (rt_build)
+            tuple = sfrt_poptrie_build_lookup(ip, (poptrie_table_t*)rt_build);
+        else if (rt)
+            tuple.index = sfrt_poptrie_flat_lookup(ip, rt);
+        else
+            return NULL;
+    }
+    else if (!rt)
     {
         return NULL;
     }
-
-    tuple = sfrt_dir_flat_lookup(ip, rt);
+    else
+        tuple = sfrt_dir_flat_lookup(ip, rt);
 
     if (tuple.index >= table->num_ent)
     {
@@ -258,6 +302,65 @@ GENERIC sfrt_flat_lookup(void* adr, table_flat_t* table)
         return NULL;
 }
 
+/* Same as the DIR-n-m part of sfrt_flat_insert but on the heap tables */
+static int poptrie_insert(sfip_t* ip, unsigned char len, INFO ptr,
+    int behavior, table_flat_t* table, updateEntryInfoFunc updateEntry)
+{
+    poptrie_table_t* rt;
+    tuple_flat_t tuple;
+    INFO* data;
+    uint8_t* base;
+    int64_t bytesAllocated;
+    int index;
+    int res;
+
+    if (ip->family == AF_INET)
+        rt = (poptrie_table_t*)table->rt_build;
+    else if (ip->family == AF_INET6)
+        rt = (poptrie_table_t*)table->rt6_build;
+    else
+        rt = nullptr;
+
+    /* compiled tables are read only */
+    if (!rt)
+        return RT_INSERT_FAILURE;
+
+    tuple = sfrt_poptrie_build_lookup(ip, rt);
+
+    base = (uint8_t*)segment_basePtr();
+    data = (INFO*)(&base[table->data]);
+
+    if (tuple.length != len)
+    {
+        if ( table->num_ent >= table->max_size)
+            return RT_POLICY_TABLE_EXCEEDED;
+
+        index = table->num_ent;
+        table->num_ent++;
+        data[index] = 0;
+    }
+    else
+        index = tuple.index;
+
+    bytesAllocated = updateEntry(&data[index], ptr, SAVE_TO_CURRENT, base);
+
+    if (bytesAllocated < 0)
+    {
+        if (tuple.length != len)
+            table->num_ent--;
+        return MEM_ALLOC_FAILURE;
+    }
+
+    table->allocated += (uint32_t)bytesAllocated;
+
+    res = sfrt_poptrie_build_insert(ip, len, index, behavior, rt, updateEntry, data);
+
+    if (res == MEM_ALLOC_FAILURE)
+        table->num_ent--;
+
+    return res;
+}
+
 /* Insert "ip", of length "len", into "table", and have it point to "ptr"
    Insert "ip", of length "len", into "table", and have it point to "ptr" */
 int sfrt_flat_insert(void* adr, unsigned char len, INFO ptr,
@@ -293,6 +396,9 @@ int sfrt_flat_insert(void* adr, unsigned char len, INFO ptr,
 
     ip = (sfip_t*)adr;
 
+    if (table->table_flat_type == POPTRIE)
+        return poptrie_insert(ip, len, ptr, behavior, table, updateEntry);
+
     if (ip->family == AF_INET)
     {
         rt = table->rt;
@@ -306,7 +412,7 @@ int sfrt_flat_insert(void* adr, unsigned char len, INFO ptr,
         return RT_INSERT_FAILURE;
     }
 
-    tuple = sfrt_dir_flat_lookup(ip, table->rt);
+    tuple = sfrt_dir_flat_lookup(ip, rt);
 
     base = (uint8_t*)segment_basePtr();
     data = (INFO*)(&base[table->data]);
@@ -365,7 +471,7 @@ uint32_t sfrt_flat_num_entries(table_flat_t* table)
         return 0;
     }
 
-    if ( !table->rt || !table->allocated)
+    if ( (!table->rt && !table->rt_build) || !table->allocated)
     {
         return 0;
     }
@@ -377,7 +483,19 @@ uint32_t sfrt_flat_num_entries(table_flat_t* table)
 uint32_t sfrt_flat_usage(table_flat_t* table)
 {
     uint32_t usage;
-    if (!table || !table->rt || !table->allocated )
+    if (!table || !table->allocated )
+    {
+        return 0;
+    }
+
+    if (table->table_flat_type == POPTRIE)
+    {
+        return table->allocated +
+            sfrt_poptrie_usage(table->rt_build) + sfrt_poptrie_usage(table->rt6_build) +
+            sfrt_poptrie_flat_usage(table->rt) + sfrt_poptrie_flat_usage(table->rt6);
+    }
+
+    if (!table->rt)
     {
         return 0;
     }
@@ -392,9 +510,61 @@ uint32_t sfrt_flat_usage(table_flat_t* table)
     return usage;
 }
 
+int sfrt_flat_compile(table_flat_t* table)
+{
+    if (!table || table->table_flat_type != POPTRIE)
+        return RT_SUCCESS;
+
+    /* already compiled */
+    if (!table->rt_build)
+        return RT_SUCCESS;
+
+    table->rt = sfrt_poptrie_flat_compile((poptrie_table_t*)table->rt_build);
+    table->rt6 = sfrt_poptrie_flat_compile((poptrie_table_t*)table->rt6_build);
+
+    if (!table->rt || !table->rt6)
+        return MEM_ALLOC_FAILURE;
+
+    sfrt_poptrie_free(table->rt_build);
+    sfrt_poptrie_free(table->rt6_build);
+    table->rt_build = table->rt6_build = nullptr;
+
+    return RT_SUCCESS;
+}
+
 /* Perform a lookup on value contained in "ip"
  * For performance reason, we use this simplified version instead of sfrt_lookup
  * Note: this only applied to table setting: DIR_8x16 (DIR_16_8_4x2 for IPV4), DIR_8x4*/
+/* Check a compiled table in an untrusted segment of size bytes that
+ * starts with the table, e.g. one mapped from a file.  Only the types
+ * with a flat lookup function are accepted.  Returns true if a lookup
+ * can't reach outside the segment.  The data entries are offsets the
+ * caller must check. */
+bool sfrt_flat_valid(const table_flat_t* table, MEM_OFFSET size)
+{
+    static const int dir_v4[] = { 16, 8, 4, 4 };
+    static const int dir_v6[] = { 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8, 8 };
+    const uint8_t* base = (const uint8_t*)table;
+
+    if (size < sizeof(*table) || table->rt_build || table->rt6_build || !table->max_size)
+        return false;
+
+    if (table->data > size || (size - table->data) / sizeof(INFO) < table->max_size)
+        return false;
+
+    switch (table->table_flat_type)
+    {
+    case DIR_8x16:
+        return sfrt_dir_flat_valid(base, size, table->rt, table->max_size, 4, dir_v4) &&
+            sfrt_dir_flat_valid(base, size, table->rt6, table->max_size, 16, dir_v6);
+
+    case POPTRIE:
+        return sfrt_poptrie_flat_valid(base, size, table->rt, table->max_size) &&
+            sfrt_poptrie_flat_valid(base, size, table->rt6, table->max_size);
+    }
+    return false;
+}
+
 GENERIC sfrt_flat_dir8x_lookup(void* adr, table_flat_t* table)
 {
     dir_sub_table_flat_t* subtable;
@@ -66,6 +66,8 @@ typedef struct
     TABLE_PTR rt; /* Actual "routing" table */
     TABLE_PTR rt6; /* Actual "routing" table */
     TABLE_PTR list_info; /* List file information table (entry information)*/
+    void* rt_build; /* POPTRIE only: heap tables used until sfrt_flat_compile */
+    void* rt6_build;
 } table_flat_t;
 /*******************************************************************/
 
@@ -82,5 +84,15 @@ int sfrt_flat_insert(void* adr, unsigned char len, INFO ptr, int behavior,
 uint32_t sfrt_flat_usage(table_flat_t* table);
 uint32_t sfrt_flat_num_entries(table_flat_t* table);
 
+/* Write any tables built on the heap to the segment.  This must be called
+ * after the last insert and before the first lookup of a POPTRIE table;
+ * it does nothing for the DIR-n-m types. */
+int sfrt_flat_compile(table_flat_t* table);
+
+/* Check the offsets of a compiled table in an untrusted segment of size
+ * bytes that starts with the table.  Only DIR_8x16 and POPTRIE, the types
+ * with a flat lookup function, are accepted. */
+bool sfrt_flat_valid(const table_flat_t* table, MEM_OFFSET size);
+
 #endif
 
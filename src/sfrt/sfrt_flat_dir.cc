@@ -608,3 +608,77 @@ uint32_t sfrt_dir_flat_usage(TABLE_PTR table_ptr)
     return ((dir_table_flat_t*)(table))->allocated;
 }
 
+
+static bool _sub_table_flat_valid(const uint8_t* base, MEM_OFFSET size,
+    const dir_table_flat_t* root, SUB_TABLE_PTR sub_ptr, int level, uint32_t num_data,
+    uint32_t* budget)
+{
+    dir_sub_table_flat_t* sub_table;
+    DIR_Entry* entries;
+    int i;
+
+    /* a subtable may be shared but a valid table can't visit more
+     * subtables than the segment holds */
+    if (!*budget)
+        return false;
+
+    (*budget)--;
+
+    if (!sub_ptr || sub_ptr > size || size - sub_ptr < sizeof(dir_sub_table_flat_t))
+        return false;
+
+    sub_table = (dir_sub_table_flat_t*)(&base[sub_ptr]);
+
+    if (sub_table->width != root->dimensions[level] ||
+        sub_table->num_entries != 1 << sub_table->width)
+        return false;
+
+    if (sub_table->entries > size ||
+        (size - sub_table->entries) / sizeof(DIR_Entry) < (MEM_OFFSET)sub_table->num_entries)
+        return false;
+
+    entries = (DIR_Entry*)(&base[sub_table->entries]);
+
+    for (i = 0; i < sub_table->num_entries; i++)
+    {
+        if (!entries[i].value || entries[i].length)
+        {
+            if (entries[i].value >= num_data)
+                return false;
+        }
+        else if (level + 1 >= root->dim_size ||
+            !_sub_table_flat_valid(base, size, root, entries[i].value, level + 1, num_data,
+            budget))
+            return false;
+    }
+    return true;
+}
+
+/* Check that a table in an untrusted segment of size bytes at base has
+ * the given dimensions and that every offset and data index it holds is
+ * in range. */
+bool sfrt_dir_flat_valid(const uint8_t* base, MEM_OFFSET size, TABLE_PTR table_ptr,
+    uint32_t num_data, int count, const int* dimensions)
+{
+    dir_table_flat_t* root;
+    uint32_t budget;
+    int i;
+
+    if (!table_ptr || table_ptr > size || size - table_ptr < sizeof(dir_table_flat_t))
+        return false;
+
+    root = (dir_table_flat_t*)(&base[table_ptr]);
+
+    if (root->dim_size != count)
+        return false;
+
+    for (i = 0; i < count; i++)
+    {
+        if (root->dimensions[i] != dimensions[i])
+            return false;
+    }
+
+    budget = size / sizeof(dir_sub_table_flat_t);
+
+    return _sub_table_flat_valid(base, size, root, root->sub_table, 0, num_data, &budget);
+}
@@ -74,6 +74,8 @@ tuple_flat_t sfrt_dir_flat_lookup(const sfip_t* ip, TABLE_PTR table);
 int sfrt_dir_flat_insert(const sfip_t *ip, int len, word data_index,
 int behavior, TABLE_PTR, updateEntryInfoFunc updateEntry, INFO *data);
 uint32_t sfrt_dir_flat_usage(TABLE_PTR);
+bool sfrt_dir_flat_valid(const uint8_t* base, MEM_OFFSET size, TABLE_PTR, uint32_t num_data,
+    int count, const int* dimensions);
 
 #endif /* SFRT_FLAT_DIR_H */
 
@@ -0,0 +1,1012 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sfrt_poptrie.cc
+
+#include "sfrt_poptrie.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "main/snort_types.h"
+#include "utils/util.h"
+
+#define POPTRIE_SLOTS (1 << POPTRIE_STRIDE)
+#define POPTRIE_DIRECT (1 << POPTRIE_DIRECT_BITS)
+
+struct PoptrieLeaf
+{
+    uint32_t index;
+    uint8_t length;
+
+    bool operator!=(const PoptrieLeaf& rhs) const
+    { return index != rhs.index or length != rhs.length; }
+};
+
+struct PoptrieNode
+{
+    uint64_t vector;        // slots that lead to a child
+    uint64_t leafvec;       // slots that start a run of leaves
+    PoptrieNode* children;  // one per bit in vector
+    PoptrieLeaf* leaves;    // one per bit in leafvec
+};
+
+struct poptrie_table_t
+{
+    uint32_t direct[POPTRIE_DIRECT];    // data index or POPTRIE_NODE | node
+    uint8_t lengths[POPTRIE_DIRECT];
+
+    std::vector<PoptrieNode> nodes;     // children of the direct entries
+    std::vector<uint32_t> free_nodes;
+
+    uint32_t mem_cap;
+    uint32_t allocated;
+};
+
+// a node with one entry per slot, for changing it
+struct PoptrieSlots
+{
+    uint64_t vector;
+    PoptrieLeaf leaf[POPTRIE_SLOTS];
+    PoptrieNode child[POPTRIE_SLOTS];
+};
+
+// what an insert or remove is doing
+struct PoptrieUpdate
+{
+    uint32_t key[5];        // host order with a zero word past the end
+    int length;
+    int behavior;
+    PoptrieLeaf leaf;
+
+    updateEntryInfoFunc update_entry;
+    INFO* data;
+    uint8_t* base;
+    int64_t bytes;
+    bool failed;
+
+    word removed;
+};
+
+static inline unsigned popcount(uint64_t bits)
+{ return __builtin_popcountll(bits); }
+
+// n bits starting pos bits into the key
+static inline unsigned key_bits(const uint32_t* key, unsigned pos, unsigned n)
+{
+    uint64_t w = ((uint64_t)key[pos >> 5] << 32) | key[(pos >> 5) + 1];
+    return (unsigned)((w << (pos & 31)) >> (64 - n));
+}
+
+static void set_key(uint32_t* key, const sfip_t* ip, bool net_order)
+{
+    unsigned n = (ip->family == AF_INET) ? 1 : 4;
+    unsigned i;
+
+    for ( i = 0; i < n; i++ )
+        key[i] = net_order ? ntohl(ip->ip32[i]) : ip->ip32[i];
+
+    for ( ; i < 5; i++ )
+        key[i] = 0;
+}
+
+//-------------------------------------------------------------------------
+// nodes
+//-------------------------------------------------------------------------
+
+static void node_init(poptrie_table_t* table, PoptrieNode* node, const PoptrieLeaf& leaf)
+{
+    node->vector = 0;
+    node->leafvec = 1;
+    node->children = nullptr;
+    node->leaves = (PoptrieLeaf*)snort_alloc(sizeof(PoptrieLeaf));
+    node->leaves[0] = leaf;
+    table->allocated += sizeof(PoptrieLeaf);
+}
+
+static void node_free(poptrie_table_t* table, PoptrieNode* node)
+{
+    unsigned num_children = popcount(node->vector);
+
+    for ( unsigned i = 0; i < num_children; i++ )
+        node_free(table, &node->children[i]);
+
+    if ( node->children )
+        snort_free(node->children);
+
+    snort_free(node->leaves);
+
+    table->allocated -= num_children * sizeof(PoptrieNode) +
+        popcount(node->leafvec) * sizeof(PoptrieLeaf);
+}
+
+// a node with no children and a single run is just a leaf
+static inline bool node_is_leaf(const PoptrieNode* node)
+{ return !node->vector and node->leafvec == 1; }
+
+static void node_expand(const PoptrieNode* node, PoptrieSlots& slots)
+{
+    unsigned c = 0;
+    int l = -1;
+
+    slots.vector = node->vector;
+
+    for ( unsigned i = 0; i < POPTRIE_SLOTS; i++ )
+    {
+        uint64_t bit = (uint64_t)1 << i;
+
+        if ( node->leafvec & bit )
+            l++;
+
+        slots.leaf[i] = node->leaves[l];
+
+        if ( node->vector & bit )
+            slots.child[i] = node->children[c++];
+    }
+}
+
+// repack the slots into node, replacing its arrays but not its children's
+static void node_pack(poptrie_table_t* table, PoptrieNode* node, const PoptrieSlots& slots)
+{
+    PoptrieLeaf leaves[POPTRIE_SLOTS];
+    PoptrieNode children[POPTRIE_SLOTS];
+    uint64_t leafvec = 1;
+    unsigned num_leaves = 1;
+    unsigned num_children = 0;
+
+    // slot 0 always starts a run; a child does not end the run it sits in
+    leaves[0] = slots.leaf[0];
+
+    for ( unsigned i = 0; i < POPTRIE_SLOTS; i++ )
+    {
+        uint64_t bit = (uint64_t)1 << i;
+
+        if ( slots.vector & bit )
+            children[num_children++] = slots.child[i];
+
+        else if ( i and slots.leaf[i] != leaves[num_leaves - 1] )
+        {
+            leafvec |= bit;
+            leaves[num_leaves++] = slots.leaf[i];
+        }
+    }
+
+    table->allocated -= popcount(node->vector) * sizeof(PoptrieNode) +
+        popcount(node->leafvec) * sizeof(PoptrieLeaf);
+
+    if ( node->children )
+        snort_free(node->children);
+
+    snort_free(node->leaves);
+
+    node->vector = slots.vector;
+    node->leafvec = leafvec;
+    node->children = nullptr;
+
+    if ( num_children )
+    {
+        node->children = (PoptrieNode*)snort_alloc(num_children * sizeof(PoptrieNode));
+        memcpy(node->children, children, num_children * sizeof(PoptrieNode));
+    }
+
+    node->leaves = (PoptrieLeaf*)snort_alloc(num_leaves * sizeof(PoptrieLeaf));
+    memcpy(node->leaves, leaves, num_leaves * sizeof(PoptrieLeaf));
+
+    table->allocated += num_children * sizeof(PoptrieNode) + num_leaves * sizeof(PoptrieLeaf);
+}
+
+static inline bool out_of_memory(const poptrie_table_t* table)
+{
+    return table->mem_cap <
+        table->allocated + POPTRIE_SLOTS * (sizeof(PoptrieNode) + sizeof(PoptrieLeaf));
+}
+
+//-------------------------------------------------------------------------
+// insert
+//-------------------------------------------------------------------------
+
+// Same as the DIR-n-m fill functions: favor time overwrites, favor specific
+// overwrites less specific entries, and favor all also merges the entry
+// info of the entries it covers.
+static void fill_leaf(PoptrieUpdate& u, PoptrieLeaf& leaf)
+{
+    switch ( u.behavior )
+    {
+    case RT_FAVOR_TIME:
+        leaf = u.leaf;
+        break;
+
+    case RT_FAVOR_SPECIFIC:
+        if ( u.leaf.length >= leaf.length )
+            leaf = u.leaf;
+        break;
+
+    case RT_FAVOR_ALL:
+    {
+        SaveDest dest = SAVE_TO_CURRENT;
+
+        if ( u.leaf.length > leaf.length )
+            dest = SAVE_TO_NEW;
+
+        if ( leaf.index )
+        {
+            int64_t bytes = u.update_entry(&u.data[leaf.index], u.data[u.leaf.index], dest, u.base);
+
+            if ( bytes < 0 )
+                u.failed = true;
+            else
+                u.bytes += bytes;
+        }
+        if ( dest == SAVE_TO_NEW )
+            leaf = u.leaf;
+        break;
+    }
+    }
+}
+
+static void fill_node(PoptrieUpdate&, poptrie_table_t*, PoptrieNode*);
+
+static void fill_slot(PoptrieUpdate& u, poptrie_table_t* table, PoptrieSlots& slots, unsigned i)
+{
+    uint64_t bit = (uint64_t)1 << i;
+
+    if ( !(slots.vector & bit) )
+        fill_leaf(u, slots.leaf[i]);
+
+    else if ( u.behavior == RT_FAVOR_TIME )
+    {
+        node_free(table, &slots.child[i]);
+        slots.vector &= ~bit;
+        slots.leaf[i] = u.leaf;
+    }
+    else
+        fill_node(u, table, &slots.child[i]);
+}
+
+// the prefix covers the whole node
+static void fill_node(PoptrieUpdate& u, poptrie_table_t* table, PoptrieNode* node)
+{
+    PoptrieSlots slots;
+    node_expand(node, slots);
+
+    for ( unsigned i = 0; i < POPTRIE_SLOTS; i++ )
+        fill_slot(u, table, slots, i);
+
+    node_pack(table, node, slots);
+}
+
+static int node_insert(PoptrieUpdate& u, poptrie_table_t* table, PoptrieNode* node,
+    unsigned pos)
+{
+    unsigned index = key_bits(u.key, pos, POPTRIE_STRIDE);
+    uint64_t bit = (uint64_t)1 << index;
+
+    /* Check if this is the last node to traverse to */
+    if ( u.length <= (int)(pos + POPTRIE_STRIDE) )
+    {
+        unsigned span = pos + POPTRIE_STRIDE - u.length;
+        unsigned first = (index >> span) << span;
+        unsigned fill = first + (1 << span);
+        PoptrieSlots slots;
+
+        node_expand(node, slots);
+
+        for ( unsigned i = first; i < fill; i++ )
+            fill_slot(u, table, slots, i);
+
+        node_pack(table, node, slots);
+        return u.failed ? MEM_ALLOC_FAILURE : RT_SUCCESS;
+    }
+
+    if ( node->vector & bit )
+    {
+        PoptrieNode* child = &node->children[popcount(node->vector & (bit - 1))];
+        return node_insert(u, table, child, pos + POPTRIE_STRIDE);
+    }
+
+    if ( out_of_memory(table) )
+        return MEM_ALLOC_FAILURE;
+
+    /* The slot was a leaf; push it down into a new child */
+    PoptrieSlots slots;
+    node_expand(node, slots);
+    node_init(table, &slots.child[index], slots.leaf[index]);
+    slots.vector |= bit;
+
+    int ret = node_insert(u, table, &slots.child[index], pos + POPTRIE_STRIDE);
+    node_pack(table, node, slots);
+    return ret;
+}
+
+static uint32_t direct_node_new(poptrie_table_t* table, const PoptrieLeaf& leaf)
+{
+    uint32_t n;
+
+    if ( !table->free_nodes.empty() )
+    {
+        n = table->free_nodes.back();
+        table->free_nodes.pop_back();
+    }
+    else
+    {
+        n = table->nodes.size();
+        table->nodes.push_back(PoptrieNode());
+        table->allocated += sizeof(PoptrieNode);
+    }
+    node_init(table, &table->nodes[n], leaf);
+    return n;
+}
+
+static void direct_node_free(poptrie_table_t* table, uint32_t i, PoptrieLeaf leaf)
+{
+    uint32_t n = table->direct[i] & ~POPTRIE_NODE;
+
+    node_free(table, &table->nodes[n]);
+    table->free_nodes.push_back(n);
+
+    table->direct[i] = leaf.index;
+    table->lengths[i] = leaf.length;
+}
+
+static int poptrie_insert(PoptrieUpdate& u, poptrie_table_t* table)
+{
+    unsigned index = u.key[0] >> (32 - POPTRIE_DIRECT_BITS);
+
+    if ( u.leaf.index & POPTRIE_NODE )
+        return RT_INSERT_FAILURE;
+
+    if ( u.length > POPTRIE_DIRECT_BITS )
+    {
+        if ( !(table->direct[index] & POPTRIE_NODE) )
+        {
+            if ( out_of_memory(table) )
+                return MEM_ALLOC_FAILURE;
+
+            PoptrieLeaf leaf = { table->direct[index], table->lengths[index] };
+            table->direct[index] = POPTRIE_NODE | direct_node_new(table, leaf);
+            table->lengths[index] = 0;
+        }
+        PoptrieNode* node = &table->nodes[table->direct[index] & ~POPTRIE_NODE];
+        return node_insert(u, table, node, POPTRIE_DIRECT_BITS);
+    }
+
+    unsigned span = POPTRIE_DIRECT_BITS - u.length;
+    unsigned first = (index >> span) << span;
+    unsigned fill = first + (1 << span);
+
+    for ( unsigned i = first; i < fill; i++ )
+    {
+        if ( !(table->direct[i] & POPTRIE_NODE) )
+        {
+            PoptrieLeaf leaf = { table->direct[i], table->lengths[i] };
+            fill_leaf(u, leaf);
+            table->direct[i] = leaf.index;
+            table->lengths[i] = leaf.length;
+        }
+        else if ( u.behavior == RT_FAVOR_TIME )
+            direct_node_free(table, i, u.leaf);
+
+        else
+            fill_node(u, table, &table->nodes[table->direct[i] & ~POPTRIE_NODE]);
+    }
+    return u.failed ? MEM_ALLOC_FAILURE : RT_SUCCESS;
+}
+
+//-------------------------------------------------------------------------
+// remove
+//-------------------------------------------------------------------------
+
+// Same as the DIR-n-m remove functions: favor time clears everything the
+// prefix covers, favor specific clears only entries of the same length.
+static void remove_leaf(PoptrieUpdate& u, PoptrieLeaf& leaf)
+{
+    if ( leaf.length == u.length )
+    {
+        if ( leaf.index )
+            u.removed = leaf.index;
+    }
+    else if ( u.behavior != RT_FAVOR_TIME )
+        return;
+
+    leaf.index = 0;
+    leaf.length = 0;
+}
+
+static void remove_node(PoptrieUpdate&, poptrie_table_t*, PoptrieNode*);
+
+static void remove_slot(PoptrieUpdate& u, poptrie_table_t* table, PoptrieSlots& slots,
+    unsigned i)
+{
+    static const PoptrieLeaf none = { 0, 0 };
+    uint64_t bit = (uint64_t)1 << i;
+
+    if ( !(slots.vector & bit) )
+    {
+        remove_leaf(u, slots.leaf[i]);
+        return;
+    }
+
+    if ( u.behavior == RT_FAVOR_TIME )
+    {
+        node_free(table, &slots.child[i]);
+        slots.leaf[i] = none;
+    }
+    else
+    {
+        remove_node(u, table, &slots.child[i]);
+
+        if ( !node_is_leaf(&slots.child[i]) )
+            return;
+
+        slots.leaf[i] = slots.child[i].leaves[0];
+        node_free(table, &slots.child[i]);
+    }
+    slots.vector &= ~bit;
+}
+
+// the prefix covers the whole node
+static void remove_node(PoptrieUpdate& u, poptrie_table_t* table, PoptrieNode* node)
+{
+    PoptrieSlots slots;
+    node_expand(node, slots);
+
+    for ( unsigned i = 0; i < POPTRIE_SLOTS; i++ )
+        remove_slot(u, table, slots, i);
+
+    node_pack(table, node, slots);
+}
+
+static void node_remove(PoptrieUpdate& u, poptrie_table_t* table, PoptrieNode* node,
+    unsigned pos)
+{
+    unsigned index = key_bits(u.key, pos, POPTRIE_STRIDE);
+    uint64_t bit = (uint64_t)1 << index;
+    PoptrieSlots slots;
+
+    if ( u.length <= (int)(pos + POPTRIE_STRIDE) )
+    {
+        unsigned span = pos + POPTRIE_STRIDE - u.length;
+        unsigned first = (index >> span) << span;
+        unsigned fill = first + (1 << span);
+
+        node_expand(node, slots);
+
+        for ( unsigned i = first; i < fill; i++ )
+            remove_slot(u, table, slots, i);
+
+        node_pack(table, node, slots);
+        return;
+    }
+
+    /* subtree was never added */
+    if ( !(node->vector & bit) )
+        return;
+
+    PoptrieNode* child = &node->children[popcount(node->vector & (bit - 1))];
+    node_remove(u, table, child, pos + POPTRIE_STRIDE);
+
+    if ( !node_is_leaf(child) )
+        return;
+
+    /* collapse the child back into a leaf */
+    node_expand(node, slots);
+    slots.leaf[index] = child->leaves[0];
+    node_free(table, &slots.child[index]);
+    slots.vector &= ~bit;
+    node_pack(table, node, slots);
+}
+
+static word poptrie_remove(PoptrieUpdate& u, poptrie_table_t* table)
+{
+    unsigned index = u.key[0] >> (32 - POPTRIE_DIRECT_BITS);
+
+    if ( u.length > POPTRIE_DIRECT_BITS )
+    {
+        if ( !(table->direct[index] & POPTRIE_NODE) )
+            return 0;
+
+        PoptrieNode* node = &table->nodes[table->direct[index] & ~POPTRIE_NODE];
+        node_remove(u, table, node, POPTRIE_DIRECT_BITS);
+
+        if ( node_is_leaf(node) )
+            direct_node_free(table, index, node->leaves[0]);
+
+        return u.removed;
+    }
+
+    unsigned span = POPTRIE_DIRECT_BITS - u.length;
+    unsigned first = (index >> span) << span;
+    unsigned fill = first + (1 << span);
+
+    for ( unsigned i = first; i < fill; i++ )
+    {
+        if ( !(table->direct[i] & POPTRIE_NODE) )
+        {
+            PoptrieLeaf leaf = { table->direct[i], table->lengths[i] };
+            remove_leaf(u, leaf);
+            table->direct[i] = leaf.index;
+            table->lengths[i] = leaf.length;
+            continue;
+        }
+
+        PoptrieNode* node = &table->nodes[table->direct[i] & ~POPTRIE_NODE];
+
+        if ( u.behavior == RT_FAVOR_TIME )
+        {
+            static const PoptrieLeaf none = { 0, 0 };
+            direct_node_free(table, i, none);
+            continue;
+        }
+        remove_node(u, table, node);
+
+        if ( node_is_leaf(node) )
+            direct_node_free(table, i, node->leaves[0]);
+    }
+    return u.removed;
+}
+
+//-------------------------------------------------------------------------
+// lookup
+//-------------------------------------------------------------------------
+
+static PoptrieLeaf poptrie_lookup(const poptrie_table_t* table, const uint32_t* key)
+{
+    unsigned index = key[0] >> (32 - POPTRIE_DIRECT_BITS);
+    uint32_t entry = table->direct[index];
+
+    if ( !(entry & POPTRIE_NODE) )
+    {
+        PoptrieLeaf leaf = { entry, table->lengths[index] };
+        return leaf;
+    }
+
+    const PoptrieNode* node = &table->nodes[entry & ~POPTRIE_NODE];
+    unsigned pos = POPTRIE_DIRECT_BITS;
+
+    while ( true )
+    {
+        uint64_t bit = (uint64_t)1 << key_bits(key, pos, POPTRIE_STRIDE);
+
+        if ( !(node->vector & bit) )
+            return node->leaves[popcount(node->leafvec & ((bit << 1) - 1)) - 1];
+
+        node = &node->children[popcount(node->vector & (bit - 1))];
+        pos += POPTRIE_STRIDE;
+    }
+}
+
+//-------------------------------------------------------------------------
+// heap poptrie api
+//-------------------------------------------------------------------------
+
+poptrie_table_t* sfrt_poptrie_new(uint32_t mem_cap)
+{
+    poptrie_table_t* table = new poptrie_table_t;
+
+    memset(table->direct, 0, sizeof(table->direct));
+    memset(table->lengths, 0, sizeof(table->lengths));
+
+    table->mem_cap = mem_cap;
+    table->allocated = sizeof(poptrie_table_t);
+
+    if ( table->mem_cap < table->allocated )
+    {
+        delete table;
+        return nullptr;
+    }
+    return table;
+}
+
+void sfrt_poptrie_free(void* tbl)
+{
+    poptrie_table_t* table = (poptrie_table_t*)tbl;
+
+    if ( !table )
+        return;
+
+    for ( unsigned i = 0; i < POPTRIE_DIRECT; i++ )
+    {
+        if ( table->direct[i] & POPTRIE_NODE )
+            node_free(table, &table->nodes[table->direct[i] & ~POPTRIE_NODE]);
+    }
+    delete table;
+}
+
+tuple_t sfrt_poptrie_lookup(IP ip, void* tbl)
+{
+    uint32_t key[5];
+    set_key(key, ip, true);
+
+    PoptrieLeaf leaf = poptrie_lookup((poptrie_table_t*)tbl, key);
+    tuple_t ret = { leaf.index, leaf.length };
+
+    return ret;
+}
+
+int sfrt_poptrie_insert(IP ip, int len, word data_index, int behavior, void* tbl)
+{
+    PoptrieUpdate u;
+
+    set_key(u.key, ip, true);
+    u.length = len;
+    u.behavior = behavior;
+    u.leaf.index = data_index;
+    u.leaf.length = len;
+    u.update_entry = nullptr;
+    u.data = nullptr;
+    u.base = nullptr;
+    u.bytes = 0;
+    u.failed = false;
+
+    /* like sfrt_dir_insert, there is no entry info to merge here */
+    if ( behavior == RT_FAVOR_ALL )
+        u.behavior = RT_FAVOR_SPECIFIC;
+
+    return poptrie_insert(u, (poptrie_table_t*)tbl);
+}
+
+word sfrt_poptrie_remove(IP ip, int len, int behavior, void* tbl)
+{
+    PoptrieUpdate u;
+
+    set_key(u.key, ip, true);
+    u.length = len;
+    u.behavior = behavior;
+    u.removed = 0;
+
+    return poptrie_remove(u, (poptrie_table_t*)tbl);
+}
+
+uint32_t sfrt_poptrie_usage(void* tbl)
+{
+    if ( !tbl )
+        return 0;
+
+    return ((poptrie_table_t*)tbl)->allocated;
+}
+
+static void node_print(const PoptrieNode* node, unsigned level)
+{
+    char label[100];
+
+    memset(label, ' ', sizeof(label));
+    label[level*5 < sizeof(label) ? level*5 : sizeof(label) - 1] = '\0';
+
+    printf("%sChildren: %u, Leaves: %u\n", label, popcount(node->vector),
+        popcount(node->leafvec));
+
+    PoptrieSlots slots;
+    node_expand(node, slots);
+
+    for ( unsigned i = 0; i < POPTRIE_SLOTS; i++ )
+    {
+        if ( slots.vector & ((uint64_t)1 << i) )
+            node_print(&slots.child[i], level + 1);
+
+        else if ( slots.leaf[i].index or slots.leaf[i].length )
+            printf("%sIndex: %u, Length: %u, dataIndex: %u\n", label, i,
+                slots.leaf[i].length, slots.leaf[i].index);
+    }
+}
+
+/* Print a table.
+ * This is used for debugging purpose only. */
+void sfrt_poptrie_print(void* tbl)
+{
+    poptrie_table_t* table = (poptrie_table_t*)tbl;
+
+    if ( !table )
+        return;
+
+    printf("Nodes in use: %zu\n", table->nodes.size() - table->free_nodes.size());
+
+    for ( unsigned i = 0; i < POPTRIE_DIRECT; i++ )
+    {
+        if ( table->direct[i] & POPTRIE_NODE )
+        {
+            printf("Index: %u\n", i);
+            node_print(&table->nodes[table->direct[i] & ~POPTRIE_NODE], 1);
+        }
+        else if ( table->direct[i] or table->lengths[i] )
+            printf("Index: %u, Length: %u, dataIndex: %u\n", i, table->lengths[i],
+                table->direct[i]);
+    }
+}
+
+//-------------------------------------------------------------------------
+// flat poptrie
+//-------------------------------------------------------------------------
+
+tuple_flat_t sfrt_poptrie_build_lookup(const sfip_t* ip, poptrie_table_t* table)
+{
+    uint32_t key[5];
+    set_key(key, ip, false);
+
+    PoptrieLeaf leaf = poptrie_lookup(table, key);
+    tuple_flat_t ret = { leaf.index, leaf.length };
+
+    return ret;
+}
+
+int sfrt_poptrie_build_insert(const sfip_t* ip, int len, word data_index, int behavior,
+    poptrie_table_t* table, updateEntryInfoFunc updateEntry, INFO* data)
+{
+    PoptrieUpdate u;
+
+    set_key(u.key, ip, false);
+    u.length = len;
+    u.behavior = behavior;
+    u.leaf.index = data_index;
+    u.leaf.length = len;
+    u.update_entry = updateEntry;
+    u.data = data;
+    u.base = (uint8_t*)segment_basePtr();
+    u.bytes = 0;
+    u.failed = false;
+
+    return poptrie_insert(u, table);
+}
+
+// segment memory is handed out byte by byte; keep the node bitmaps aligned
+static MEM_OFFSET segment_align_alloc(size_t size)
+{
+    MEM_OFFSET ptr = segment_snort_alloc(size + 7);
+
+    if ( !ptr )
+        return 0;
+
+    return (ptr + 7) & ~(MEM_OFFSET)7;
+}
+
+static void node_count(const PoptrieNode* node, uint32_t& num_nodes, uint32_t& num_leaves)
+{
+    unsigned num_children = popcount(node->vector);
+
+    num_nodes++;
+    num_leaves += popcount(node->leafvec);
+
+    for ( unsigned i = 0; i < num_children; i++ )
+        node_count(&node->children[i], num_nodes, num_leaves);
+}
+
+/* Write the table to segment memory.  Nodes are laid out breadth first
+ * so the children of each node are adjacent.
+ * Returns the offset of the poptrie_flat_t or 0 if out of memory. */
+TABLE_PTR sfrt_poptrie_flat_compile(poptrie_table_t* table)
+{
+    uint32_t num_nodes = 0, num_leaves = 0;
+
+    for ( unsigned i = 0; i < POPTRIE_DIRECT; i++ )
+    {
+        if ( table->direct[i] & POPTRIE_NODE )
+            node_count(&table->nodes[table->direct[i] & ~POPTRIE_NODE], num_nodes, num_leaves);
+    }
+
+    TABLE_PTR table_ptr = segment_align_alloc(sizeof(poptrie_flat_t));
+    MEM_OFFSET nodes_ptr = 0, leaves_ptr = 0;
+
+    if ( !table_ptr )
+        return 0;
+
+    if ( num_nodes )
+    {
+        nodes_ptr = segment_align_alloc(num_nodes * sizeof(poptrie_flat_node_t));
+        leaves_ptr = segment_snort_alloc(num_leaves * sizeof(FLAT_INDEX));
+
+        if ( !nodes_ptr or !leaves_ptr )
+            return 0;
+    }
+
+    uint8_t* base = (uint8_t*)segment_basePtr();
+    poptrie_flat_t* flat = (poptrie_flat_t*)&base[table_ptr];
+    poptrie_flat_node_t* nodes = (poptrie_flat_node_t*)&base[nodes_ptr];
+    FLAT_INDEX* leaves = (FLAT_INDEX*)&base[leaves_ptr];
+
+    flat->nodes = nodes_ptr;
+    flat->leaves = leaves_ptr;
+    flat->allocated = sizeof(poptrie_flat_t) + num_nodes * sizeof(poptrie_flat_node_t) +
+        num_leaves * sizeof(FLAT_INDEX);
+
+    std::vector<const PoptrieNode*> order;
+    order.reserve(num_nodes);
+
+    for ( unsigned i = 0; i < POPTRIE_DIRECT; i++ )
+    {
+        if ( table->direct[i] & POPTRIE_NODE )
+        {
+            flat->direct[i] = POPTRIE_NODE | order.size();
+            order.push_back(&table->nodes[table->direct[i] & ~POPTRIE_NODE]);
+        }
+        else
+            flat->direct[i] = table->direct[i];
+    }
+
+    uint32_t next_leaf = 0;
+
+    for ( uint32_t n = 0; n < order.size(); n++ )
+    {
+        const PoptrieNode* node = order[n];
+        unsigned num_children = popcount(node->vector);
+        unsigned node_leaves = popcount(node->leafvec);
+
+        nodes[n].vector = node->vector;
+        nodes[n].leafvec = node->leafvec;
+        nodes[n].base1 = order.size();
+        nodes[n].base0 = next_leaf;
+
+        for ( unsigned i = 0; i < num_children; i++ )
+            order.push_back(&node->children[i]);
+
+        for ( unsigned i = 0; i < node_leaves; i++ )
+            leaves[next_leaf++] = node->leaves[i].index;
+    }
+
+    return table_ptr;
+}
+
+static inline FLAT_INDEX flat_lookup(const uint8_t* base, TABLE_PTR table_ptr,
+    const uint32_t* key)
+{
+    const poptrie_flat_t* flat = (const poptrie_flat_t*)&base[table_ptr];
+    FLAT_INDEX entry = flat->direct[key[0] >> (32 - POPTRIE_DIRECT_BITS)];
+
+    if ( !(entry & POPTRIE_NODE) )
+        return entry;
+
+    const poptrie_flat_node_t* nodes = (const poptrie_flat_node_t*)&base[flat->nodes];
+    const poptrie_flat_node_t* node = &nodes[entry & ~POPTRIE_NODE];
+    unsigned pos = POPTRIE_DIRECT_BITS;
+
+    while ( true )
+    {
+        uint64_t bit = (uint64_t)1 << key_bits(key, pos, POPTRIE_STRIDE);
+
+        if ( !(node->vector & bit) )
+        {
+            const FLAT_INDEX* leaves = (const FLAT_INDEX*)&base[flat->leaves];
+            return leaves[node->base0 + popcount(node->leafvec & ((bit << 1) - 1)) - 1];
+        }
+        node = &nodes[node->base1 + popcount(node->vector & (bit - 1))];
+        pos += POPTRIE_STRIDE;
+    }
+}
+
+FLAT_INDEX sfrt_poptrie_flat_lookup(const sfip_t* ip, TABLE_PTR table_ptr)
+{
+    uint32_t key[5];
+    set_key(key, ip, false);
+
+    return flat_lookup((uint8_t*)segment_basePtr(), table_ptr, key);
+}
+
+uint32_t sfrt_poptrie_flat_usage(TABLE_PTR table_ptr)
+{
+    if ( !table_ptr )
+        return 0;
+
+    uint8_t* base = (uint8_t*)segment_basePtr();
+    return ((poptrie_flat_t*)&base[table_ptr])->allocated;
+}
+
+// a lookup reads the key a word at a time and the key is 5 words so the
+// deepest node must start in the 4th word
+#define POPTRIE_MAX_POS 128
+
+bool sfrt_poptrie_flat_valid(const uint8_t* base, MEM_OFFSET size, TABLE_PTR table_ptr,
+    uint32_t num_data)
+{
+    if ( !table_ptr or table_ptr > size or size - table_ptr < sizeof(poptrie_flat_t) )
+        return false;
+
+    const poptrie_flat_t* flat = (const poptrie_flat_t*)&base[table_ptr];
+    uint32_t max_nodes = 0, max_leaves = 0;
+
+    if ( flat->nodes and flat->nodes <= size )
+        max_nodes = (size - flat->nodes) / sizeof(poptrie_flat_node_t);
+
+    if ( flat->leaves and flat->leaves <= size )
+        max_leaves = (size - flat->leaves) / sizeof(FLAT_INDEX);
+
+    // the deepest position each node is reached at, 0 if it is not reached
+    std::vector<uint8_t> depth(max_nodes, 0);
+
+    for ( unsigned i = 0; i < POPTRIE_DIRECT; i++ )
+    {
+        FLAT_INDEX entry = flat->direct[i];
+
+        if ( !(entry & POPTRIE_NODE) )
+        {
+            if ( entry >= num_data )
+                return false;
+        }
+        else if ( (entry & ~POPTRIE_NODE) >= max_nodes )
+            return false;
+
+        else
+            depth[entry & ~POPTRIE_NODE] = 1;
+    }
+
+    const poptrie_flat_node_t* nodes = (const poptrie_flat_node_t*)&base[flat->nodes];
+    const FLAT_INDEX* leaves = (const FLAT_INDEX*)&base[flat->leaves];
+
+    // children always follow their parent so one pass in order sees every
+    // parent of a node before the node itself and cycles are impossible
+    for ( uint32_t n = 0; n < max_nodes; n++ )
+    {
+        if ( !depth[n] )
+            continue;
+
+        const poptrie_flat_node_t* node = &nodes[n];
+        unsigned pos = POPTRIE_DIRECT_BITS + (depth[n] - 1) * POPTRIE_STRIDE;
+        unsigned num_children = popcount(node->vector);
+        unsigned num_leaves = popcount(node->leafvec);
+
+        if ( pos >= POPTRIE_MAX_POS )
+            return false;
+
+        if ( num_children and (node->base1 <= n or node->base1 > max_nodes - num_children) )
+            return false;
+
+        if ( num_leaves > max_leaves or node->base0 > max_leaves - num_leaves )
+            return false;
+
+        // every slot without a child needs a leaf at or below it
+        uint64_t first = ~node->vector & -~node->vector;
+
+        if ( first and !(node->leafvec & ((first << 1) - 1)) )
+            return false;
+
+        for ( unsigned i = 0; i < num_leaves; i++ )
+        {
+            if ( leaves[node->base0 + i] >= num_data )
+                return false;
+        }
+
+        for ( unsigned i = 0; i < num_children; i++ )
+        {
+            if ( depth[node->base1 + i] < depth[n] + 1 )
+                depth[node->base1 + i] = depth[n] + 1;
+        }
+    }
+    return true;
+}
+
+GENERIC sfrt_flat_poptrie_lookup(const void* adr, table_flat_t* table)
+{
+    const sfip_t* ip = (const sfip_t*)adr;
+    uint8_t* base = (uint8_t*)table;
+    uint32_t key[5];
+    TABLE_PTR rt;
+
+    set_key(key, ip, true);
+    rt = (ip->family == AF_INET) ? table->rt : table->rt6;
+
+    INFO* data = (INFO*)&base[table->data];
+    FLAT_INDEX index = flat_lookup(base, rt, key);
+
+    if ( data[index] )
+        return (GENERIC)&base[data[index]];
+
+    return nullptr;
+}
+
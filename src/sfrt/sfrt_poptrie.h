@@ -0,0 +1,93 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// sfrt_poptrie.h
+
+#ifndef SFRT_POPTRIE_H
+#define SFRT_POPTRIE_H
+
+// A poptrie (Asai and Ohara, SIGCOMM 2015) is a multibit trie with 6 bit
+// strides.  Each node describes its 64 slots with two bitmaps: vector marks
+// the slots that lead to a child node and leafvec marks the slots where a
+// run of identical leaves starts.  Children and leaves are packed arrays
+// indexed by popcount, so empty and repeated slots take no space and a
+// lookup touches one node per stride.  The first 16 bits index a flat
+// array directly.
+//
+// The heap version supports insert and remove and backs the POPTRIE type
+// of sfrt_new().  sfrt_flat builds one on the heap while the table is
+// loaded and sfrt_flat_compile() writes it to segment memory in the layout
+// below, which is read only.
+
+#include "sfrt/sfrt_flat.h"
+
+#define POPTRIE_DIRECT_BITS 16
+#define POPTRIE_STRIDE 6
+
+// set in a direct entry that holds a node index rather than a data index
+#define POPTRIE_NODE 0x80000000
+
+struct poptrie_table_t;
+
+/******************************************************************
+   heap poptrie functions, these are not intended to be called directly */
+poptrie_table_t* sfrt_poptrie_new(uint32_t mem_cap);
+void sfrt_poptrie_free(void*);
+tuple_t sfrt_poptrie_lookup(IP ip, void* table);
+int sfrt_poptrie_insert(IP ip, int len, word data_index, int behavior, void* table);
+word sfrt_poptrie_remove(IP ip, int len, int behavior, void* table);
+uint32_t sfrt_poptrie_usage(void* table);
+void sfrt_poptrie_print(void* table);
+
+/******************************************************************
+   flat poptrie
+   these take addresses in host order like the other flat functions */
+typedef struct
+{
+    uint32_t direct[1 << POPTRIE_DIRECT_BITS];  // data index or POPTRIE_NODE | node
+    MEM_OFFSET nodes;       // poptrie_flat_node_t array
+    MEM_OFFSET leaves;      // data index array
+    uint32_t allocated;
+} poptrie_flat_t;
+
+typedef struct
+{
+    uint64_t vector;
+    uint64_t leafvec;
+    uint32_t base1;         // first child in the node array
+    uint32_t base0;         // first leaf in the leaf array
+} poptrie_flat_node_t;
+
+tuple_flat_t sfrt_poptrie_build_lookup(const sfip_t* ip, poptrie_table_t*);
+int sfrt_poptrie_build_insert(const sfip_t* ip, int len, word data_index, int behavior,
+    poptrie_table_t*, updateEntryInfoFunc updateEntry, INFO* data);
+TABLE_PTR sfrt_poptrie_flat_compile(poptrie_table_t*);
+FLAT_INDEX sfrt_poptrie_flat_lookup(const sfip_t* ip, TABLE_PTR);
+uint32_t sfrt_poptrie_flat_usage(TABLE_PTR);
+
+/* Check that a table in an untrusted segment of size bytes at base only
+ * holds offsets and data indexes in range and only nodes a lookup can
+ * reach without reading past the key. */
+bool sfrt_poptrie_flat_valid(const uint8_t* base, MEM_OFFSET size, TABLE_PTR,
+    uint32_t num_data);
+
+/* Perform a lookup on value contained in "ip" in network order
+ * This is the packet time lookup for a compiled POPTRIE table and the
+ * counterpart of sfrt_flat_dir8x_lookup() */
+GENERIC sfrt_flat_poptrie_lookup(const void* adr, table_flat_t* table);
+
+#endif
@@ -18,12 +18,17 @@
 //--------------------------------------------------------------------------
 // sfrt_test.cc author Hui Cao <hcao@sourcefire.com>
 
+#include <chrono>
+#include <vector>
+
 #include "catch/catch.hpp"
 #include "catch/unit_test.h"
 #include "sfip/sf_ip.h"
 #include "utils/util.h"
 
 #include "sfrt.h"
+#include "sfrt_flat.h"
+#include "sfrt_poptrie.h"
 
 #define NUM_IPS 32
 #define NUM_DATA 4
@@ -59,7 +64,7 @@ static IP_entry ip_lists[] =
 static int s_debug = 0;
 
 /* Add one ip, then delete that IP*/
-static void test_sfrt_remove_after_insert()
+static void test_sfrt_remove_after_insert(char table_type)
 {
     table_t* dir;
     unsigned num_entries;
@@ -69,7 +74,7 @@ static void test_sfrt_remove_after_insert()
     if ( s_debug )
         printf("Number of entries: %u \n",num_entries);
 
-    dir = sfrt_new(DIR_16_4x4_16x5_4x4, IPv6, num_entries + 1, 200);
+    dir = sfrt_new(table_type, IPv6, num_entries + 1, 200);
 
     CHECK(dir != NULL); // "sfrt_new()"
 
@@ -149,7 +154,7 @@ static void test_sfrt_remove_after_insert()
 }
 
 /*Add all IPs, then delete all of them*/
-static void test_sfrt_remove_after_insert_all()
+static void test_sfrt_remove_after_insert_all(char table_type)
 {
     table_t* dir;
     unsigned num_entries;
@@ -160,7 +165,7 @@ static void test_sfrt_remove_after_insert_all()
     if ( s_debug )
         printf("Number of entries: %u \n",num_entries);
 
-    dir = sfrt_new(DIR_16_4x4_16x5_4x4, IPv6, num_entries + 1, 200);
+    dir = sfrt_new(table_type, IPv6, num_entries + 1, 200);
 
     CHECK(dir != NULL); // "sfrt_new()"
 
@@ -249,15 +254,319 @@ static void test_sfrt_remove_after_insert_all()
     sfrt_free(dir);
 }
 
+//---------------------------------------------------------------
+// random prefixes for comparing table types
+
+static uint32_t s_seed = 1;
+
+static uint32_t rand32()
+{
+    s_seed = s_seed * 1103515245 + 12345;
+    uint32_t hi = s_seed >> 16;
+    s_seed = s_seed * 1103515245 + 12345;
+    return (hi << 16) | (s_seed >> 16);
+}
+
+// clustered so that prefixes overlap and share subtables
+static void random_ip(sfip_t* ip, bool v6)
+{
+    static const uint32_t nets[] = { 0x0a000000, 0xc0a80000, 0x20010db8, 0x7f000000 };
+
+    memset(ip, 0, sizeof(*ip));
+    ip->ip32[0] = htonl((nets[rand32() % 4] & 0xffff0000) | (rand32() & 0x0303ffff));
+
+    if ( v6 )
+    {
+        ip->family = AF_INET6;
+        ip->bits = 128;
+        ip->ip32[1] = htonl(rand32() & 0x000000ff);
+        ip->ip32[2] = htonl(rand32() & 0xff00ff00);
+        ip->ip32[3] = htonl(rand32());
+    }
+    else
+    {
+        ip->family = AF_INET;
+        ip->bits = 32;
+    }
+}
+
+static void random_prefix(sfip_t* ip, unsigned char& len, bool v6, unsigned min_len = 1)
+{
+    random_ip(ip, v6);
+
+    if ( v6 )
+        len = min_len + rand32() % (129 - min_len);
+    else
+        len = min_len + rand32() % (33 - min_len);
+}
+
+static void compare_lookups(table_t* a, table_t* b, const std::vector<sfip_t>& ips)
+{
+    unsigned mismatches = 0;
+
+    for ( auto& ip : ips )
+    {
+        sfip_t tmp = ip;
+
+        if ( sfrt_lookup(&tmp, a) != sfrt_lookup(&tmp, b) )
+            mismatches++;
+    }
+    CHECK(mismatches == 0);
+}
+
+/* POPTRIE must give the same answers as DIR-n-m for the same inserts and removes */
+static void test_sfrt_poptrie_matches_dir(int behavior)
+{
+    const unsigned num_prefixes = 3000;
+    static int values[num_prefixes];
+
+    table_t* dir = sfrt_new(DIR_8x16, IPv6, num_prefixes + 1, 200);
+    table_t* pop = sfrt_new(POPTRIE, IPv6, num_prefixes + 1, 200);
+
+    REQUIRE(dir != NULL);
+    REQUIRE(pop != NULL);
+
+    std::vector<sfip_t> prefixes;
+    std::vector<unsigned char> lengths;
+    std::vector<sfip_t> probes;
+
+    for ( unsigned i = 0; i < num_prefixes; i++ )
+    {
+        sfip_t ip;
+        unsigned char len;
+
+        random_prefix(&ip, len, i & 1);
+        values[i] = i;
+
+        int r1 = sfrt_insert(&ip, len, &values[i], behavior, dir);
+        int r2 = sfrt_insert(&ip, len, &values[i], behavior, pop);
+
+        CHECK(r1 == r2);
+
+        prefixes.push_back(ip);
+        lengths.push_back(len);
+        probes.push_back(ip);
+
+        random_ip(&ip, i & 1);
+        probes.push_back(ip);
+    }
+    compare_lookups(dir, pop, probes);
+    CHECK(sfrt_num_entries(dir) == sfrt_num_entries(pop));
+
+    for ( unsigned i = 0; i < num_prefixes; i += 3 )
+    {
+        GENERIC r1 = NULL, r2 = NULL;
+
+        sfrt_remove(&prefixes[i], lengths[i], &r1, behavior, dir);
+        sfrt_remove(&prefixes[i], lengths[i], &r2, behavior, pop);
+
+        CHECK(r1 == r2);
+    }
+    compare_lookups(dir, pop, probes);
+
+    if ( s_debug )
+        printf("Usage: dir %u bytes, poptrie %u bytes\n", sfrt_usage(dir), sfrt_usage(pop));
+
+    sfrt_free(dir);
+    sfrt_free(pop);
+}
+
 TEST_CASE("sfrt", "[sfrt]")
 {
     SECTION("remove after insert")
     {
-        test_sfrt_remove_after_insert();
+        test_sfrt_remove_after_insert(DIR_16_4x4_16x5_4x4);
+    }
+    SECTION("remove after insert all")
+    {
+        test_sfrt_remove_after_insert_all(DIR_16_4x4_16x5_4x4);
+    }
+}
+
+TEST_CASE("sfrt poptrie", "[sfrt]")
+{
+    SECTION("remove after insert")
+    {
+        test_sfrt_remove_after_insert(POPTRIE);
     }
     SECTION("remove after insert all")
     {
-        test_sfrt_remove_after_insert_all();
+        test_sfrt_remove_after_insert_all(POPTRIE);
+    }
+    SECTION("favor specific matches dir")
+    {
+        test_sfrt_poptrie_matches_dir(RT_FAVOR_SPECIFIC);
+    }
+    SECTION("favor time matches dir")
+    {
+        test_sfrt_poptrie_matches_dir(RT_FAVOR_TIME);
+    }
+}
+
+/* the first value for each index is kept so both tables see the same data */
+static int64_t flat_test_update(INFO* current, INFO new_entry, SaveDest, uint8_t*)
+{
+    if ( !*current )
+        *current = new_entry;
+    return 0;
+}
+
+/* the flat tables are built from host order addresses, as by reputation */
+static sfip_t flat_host_order(const sfip_t& ip)
+{
+    sfip_t tmp = ip;
+
+    for ( int i = 0; i < (ip.family == AF_INET ? 1 : 4); i++ )
+        tmp.ip32[i] = ntohl(ip.ip32[i]);
+
+    return tmp;
+}
+
+/* build a flat table in its own segment, as the fast lookups require the
+ * table at the segment base, and return the value found for each probe */
+static std::vector<int> flat_lookups(char table_type, int behavior, unsigned num_prefixes)
+{
+    const size_t seg_size = 64 * 1024 * 1024;
+
+    uint8_t* seg = (uint8_t*)snort_alloc(seg_size);
+    segment_meminit(seg, seg_size);
+
+    table_flat_t* table = sfrt_flat_new(table_type, IPv6, num_prefixes + 1, 30);
+    REQUIRE(table != NULL);
+    REQUIRE((uint8_t*)table == seg);
+
+    std::vector<sfip_t> probes;
+    s_seed = 3;
+
+    for ( unsigned i = 0; i < num_prefixes; i++ )
+    {
+        sfip_t ip;
+        unsigned char len;
+
+        random_prefix(&ip, len, i & 1);
+
+        MEM_OFFSET value = segment_snort_calloc(1, sizeof(int));
+        REQUIRE(value);
+        *(int*)(seg + value) = i;
+
+        sfip_t host = flat_host_order(ip);
+        CHECK(sfrt_flat_insert(&host, len, value, behavior, table, flat_test_update) == RT_SUCCESS);
+
+        probes.push_back(ip);
+        random_ip(&ip, i & 1);
+        probes.push_back(ip);
+    }
+    CHECK(sfrt_flat_compile(table) == RT_SUCCESS);
+
+    if ( s_debug )
+        printf("Usage: %u bytes\n", sfrt_flat_usage(table));
+
+    std::vector<int> values;
+
+    for ( auto& ip : probes )
+    {
+        GENERIC r = (table_type == POPTRIE) ?
+            sfrt_flat_poptrie_lookup(&ip, table) : sfrt_flat_dir8x_lookup(&ip, table);
+
+        sfip_t host = flat_host_order(ip);
+        CHECK(r == sfrt_flat_lookup(&host, table));
+
+        values.push_back(r ? *(int*)r : -1);
+    }
+    snort_free(seg);
+    return values;
+}
+
+/* a compiled flat POPTRIE must give the same answers as a flat DIR_8x16 */
+static void test_sfrt_flat_poptrie_matches_dir(int behavior)
+{
+    const unsigned num_prefixes = 1000;
+
+    std::vector<int> dir = flat_lookups(DIR_8x16, behavior, num_prefixes);
+    std::vector<int> pop = flat_lookups(POPTRIE, behavior, num_prefixes);
+
+    unsigned found = 0;
+
+    for ( auto v : pop )
+    {
+        if ( v >= 0 )
+            found++;
+    }
+    CHECK(found >= num_prefixes);
+    CHECK(dir == pop);
+}
+
+TEST_CASE("sfrt flat poptrie", "[sfrt]")
+{
+    SECTION("favor specific matches dir")
+    {
+        test_sfrt_flat_poptrie_matches_dir(RT_FAVOR_SPECIFIC);
+    }
+    SECTION("favor time matches dir")
+    {
+        test_sfrt_flat_poptrie_matches_dir(RT_FAVOR_TIME);
+    }
+    SECTION("favor all matches dir")
+    {
+        test_sfrt_flat_poptrie_matches_dir(RT_FAVOR_ALL);
+    }
+}
+
+//---------------------------------------------------------------
+// run with -t "[sfrt_perf]"
+
+static void bench_lookups(const char* name, char table_type, bool v6)
+{
+    const unsigned num_prefixes = 50000;
+    const unsigned num_lookups = 4000000;
+    static int value = 1;
+
+    table_t* table = sfrt_new(table_type, IPv6, num_prefixes + 1, 500);
+    REQUIRE(table != NULL);
+
+    s_seed = 7;
+
+    for ( unsigned i = 0; i < num_prefixes; i++ )
+    {
+        sfip_t ip;
+        unsigned char len;
+
+        // mostly hosts and small networks like a reputation list
+        random_prefix(&ip, len, v6, v6 ? 32 : 16);
+        sfrt_insert(&ip, len, &value, RT_FAVOR_SPECIFIC, table);
+    }
+
+    std::vector<sfip_t> probes(1024);
+
+    for ( auto& ip : probes )
+        random_ip(&ip, v6);
+
+    unsigned found = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for ( unsigned i = 0; i < num_lookups; i++ )
+    {
+        if ( sfrt_lookup(&probes[i & 1023], table) )
+            found++;
+    }
+
+    auto usecs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    printf("%-20s %s: %6.1f M lookups/sec, %u bytes, %u found\n", name, v6 ? "v6" : "v4",
+        usecs ? (double)num_lookups / usecs : 0.0, sfrt_usage(table), found);
+
+    sfrt_free(table);
+}
+
+TEST_CASE("sfrt lookup benchmark", "[.][sfrt_perf]")
+{
+    for ( bool v6 : { false, true } )
+    {
+        bench_lookups("DIR_16_4x4_16x5_4x4", DIR_16_4x4_16x5_4x4, v6);
+        bench_lookups("DIR_16x7_4x4", DIR_16x7_4x4, v6);
+        bench_lookups("DIR_8x16", DIR_8x16, v6);
+        bench_lookups("POPTRIE", POPTRIE, v6);
     }
 }
 
@@ -313,6 +313,15 @@ bool SideChannel::transmit_message(SCMessage* msg)
     return return_value;
 }
 
+// push out any messages the transmit connector is holding for batching
+bool SideChannel::flush()
+{
+    if ( connector_transmit )
+        return connector_transmit->flush();
+
+    return false;
+}
+
 Connector::Direction SideChannel::get_direction()
 {
     if ( connector_receive && connector_transmit )
@@ -269,6 +269,9 @@ TEST(side_channel, test_connector_alloc_transmit)
 
     bool success = sc->transmit_message(msg);
     CHECK(success == true);
+
+    success = sc->flush();
+    CHECK(success == true);
 }
 
 static void receive_handler(SCMessage* sc_msg)
@@ -199,6 +199,7 @@ const PegInfo pc_names[] =
     { "header searches", "fast pattern searches in header buffer" },
     { "body searches", "fast pattern searches in body buffer" },
     { "file searches", "fast pattern searches in file buffer" },
+    { "merged searches", "fast pattern searches of merged buffer spans" },
     { "alerts", "alerts not including IP reputation" },
     { "total alerts", "alerts including IP reputation" },
     { "logged", "logged packets" },
@@ -224,19 +225,30 @@ const PegInfo proc_names[] =
 
 //-------------------------------------------------------------------------
 
+static uint64_t uncount(uint64_t n, uint64_t skipped)
+{ return n > skipped ? n - skipped : 0; }
+
 void pc_sum()
 {
     // must sum explicitly; can't zero; daq stats are cuumulative ...
     const DAQ_Stats_t* daq_stats = SFDAQ::get_stats();
 
-    g_daq_stats.hw_packets_received += daq_stats->hw_packets_received;
+    // with --pcap-shard each thread passes the packets it doesn't own
+    uint64_t skipped = Trough::take_skipped();
+
+    g_daq_stats.hw_packets_received += uncount(daq_stats->hw_packets_received, skipped);
     g_daq_stats.hw_packets_dropped += daq_stats->hw_packets_dropped;
-    g_daq_stats.packets_received += daq_stats->packets_received;
+    g_daq_stats.packets_received += uncount(daq_stats->packets_received, skipped);
     g_daq_stats.packets_filtered += daq_stats->packets_filtered;
     g_daq_stats.packets_injected += daq_stats->packets_injected;
 
     for ( unsigned i = 0; i < MAX_SFDAQ_VERDICT; i++ )
-        g_daq_stats.verdicts[i] += daq_stats->verdicts[i];
+    {
+        if ( i == DAQ_VERDICT_PASS )
+            g_daq_stats.verdicts[i] += uncount(daq_stats->verdicts[i], skipped);
+        else
+            g_daq_stats.verdicts[i] += daq_stats->verdicts[i];
+    }
 
     sum_stats((PegCount*)&gaux, (PegCount*)&aux_counts, sizeof(aux_counts)/sizeof(PegCount));
 
@@ -305,6 +317,7 @@ void DropStats()
 void PrintStatistics()
 {
     DropStats();
+    Trough::show_shard_stats();
     timing_stats();
 
     // FIXIT-L below stats need to be made consistent with above
@@ -50,6 +50,7 @@ struct PacketCount
     PegCount header_searches;
     PegCount body_searches;
     PegCount file_searches;
+    PegCount merged_searches;
     PegCount alert_pkts;
     PegCount total_alert_pkts;
     PegCount log_pkts;
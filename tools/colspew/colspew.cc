@@ -0,0 +1,268 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+
+// colspew.cc
+
+// dump alert_columnar files as text or csv
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "log/columnar.h"
+
+using namespace std;
+
+static bool s_csv = false;
+static bool s_hex = false;
+
+struct Column
+{
+    const char* name;
+    const uint8_t* data;   // next row
+    unsigned width;
+};
+
+//-------------------------------------------------------------------------
+// output
+//-------------------------------------------------------------------------
+
+static const char* event_names[COLUMNAR_EVENT_MAX] =
+{
+    "event id", "second", "microsecond", "gid", "sid", "rev", "class",
+    "priority", "src addr", "dst addr", "src port", "dst port", "proto",
+    "blocked", "vlan", "mpls", "linktype", "pkt len", "pkt"
+};
+
+static const char* extra_names[COLUMNAR_EXTRA_MAX] =
+{
+    "event id", "event second", "type", "len", "data"
+};
+
+static void print_addr(const uint8_t* a)
+{
+    static const uint8_t mapped[12] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff };
+    char buf[INET6_ADDRSTRLEN];
+
+    if ( !memcmp(a, mapped, sizeof(mapped)) )
+        inet_ntop(AF_INET, a + 12, buf, sizeof(buf));
+    else
+        inet_ntop(AF_INET6, a, buf, sizeof(buf));
+
+    printf("%s", buf);
+}
+
+static void print_data(const uint8_t* data, unsigned len)
+{
+    if ( !s_hex )
+    {
+        printf("%u bytes", len);
+        return;
+    }
+    for ( unsigned i = 0; i < len; ++i )
+        printf("%02x", data[i]);
+}
+
+static void print_header(const char* const* names, unsigned n)
+{
+    for ( unsigned c = 0; c < n; ++c )
+        printf("%s%s", c ? "," : "", names[c]);
+
+    printf("\n");
+}
+
+static void print_row(const char* type, vector<Column>& cols, unsigned len_col)
+{
+    if ( !s_csv )
+        printf("\n(%s)\n", type);
+
+    uint64_t len = 0;
+
+    for ( unsigned c = 0; c < cols.size(); ++c )
+    {
+        Column& col = cols[c];
+
+        if ( s_csv )
+            printf("%s", c ? "," : "");
+        else
+            printf("\t%s: ", col.name);
+
+        if ( !col.width )
+        {
+            print_data(col.data, len);
+            col.data += len;
+        }
+        else
+        {
+            if ( col.width == 16 )
+                print_addr(col.data);
+            else
+            {
+                uint64_t v = columnar_load(col.data, col.width);
+                printf("%" PRIu64, v);
+
+                if ( c == len_col )
+                    len = v;
+            }
+            col.data += col.width;
+        }
+        if ( !s_csv )
+            printf("\n");
+    }
+    if ( s_csv )
+        printf("\n");
+}
+
+//-------------------------------------------------------------------------
+// input
+//-------------------------------------------------------------------------
+
+static bool read_file(FILE* file, const char* name)
+{
+    char magic[COLUMNAR_MAGIC_LEN];
+
+    if ( fread(magic, sizeof(magic), 1, file) != 1 or
+        memcmp(magic, COLUMNAR_MAGIC, sizeof(magic)) )
+    {
+        fprintf(stderr, "%s: not an alert_columnar file\n", name);
+        return false;
+    }
+
+    vector<uint8_t> body, raw;
+    vector<const uint8_t*> starts;
+    vector<Column> cols;
+    uint8_t buf[COLUMNAR_HEADER_LEN];
+    unsigned last_type = 0;
+
+    while ( fread(buf, sizeof(buf), 1, file) == 1 )
+    {
+        ColumnarHeader hdr;
+        columnar_get_header(buf, hdr);
+
+        body.resize(hdr.length);
+
+        if ( hdr.length and fread(body.data(), hdr.length, 1, file) != 1 )
+        {
+            fprintf(stderr, "%s: truncated block\n", name);
+            return false;
+        }
+
+        const char* tag;
+        const char* const* names;
+
+        if ( hdr.type == COLUMNAR_EVENTS )
+        {
+            tag = "Event";
+            names = event_names;
+        }
+        else if ( hdr.type == COLUMNAR_EXTRA )
+        {
+            tag = "Extra Data";
+            names = extra_names;
+        }
+        else
+        {
+            // skip block types added later
+            continue;
+        }
+
+        const uint8_t* data = columnar_get_body(hdr, body.data(), raw);
+
+        if ( !data or !columnar_get_columns(hdr, data, starts) )
+        {
+            fprintf(stderr, "%s: bad block\n", name);
+            return false;
+        }
+
+        const unsigned* width;
+        unsigned n, len_col;
+        ColumnarBlock::get_schema(hdr.type, width, n, len_col);
+
+        cols.clear();
+
+        for ( unsigned c = 0; c < n; ++c )
+            cols.push_back({ names[c], starts[c], width[c] });
+
+        if ( s_csv and hdr.type != last_type )
+            print_header(names, n);
+
+        last_type = hdr.type;
+
+        for ( unsigned r = 0; r < hdr.rows; ++r )
+            print_row(tag, cols, len_col);
+    }
+    return !ferror(file);
+}
+
+//-------------------------------------------------------------------------
+// main
+//-------------------------------------------------------------------------
+
+static void usage(const char* prog)
+{
+    fprintf(stderr, "usage: %s [-c] [-x] <file>...\n", prog);
+    fprintf(stderr, "    -c  print csv with a header line per block type change\n");
+    fprintf(stderr, "    -x  print packets and extra data in hex\n");
+}
+
+int main(int argc, char* argv[])
+{
+    int opt;
+
+    while ( (opt = getopt(argc, argv, "cx")) != -1 )
+    {
+        switch ( opt )
+        {
+        case 'c': s_csv = true; break;
+        case 'x': s_hex = true; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+
+    if ( optind >= argc )
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    int ret = 0;
+
+    for ( int i = optind; i < argc; ++i )
+    {
+        FILE* file = fopen(argv[i], "rb");
+
+        if ( !file )
+        {
+            fprintf(stderr, "%s: %s\n", argv[i], strerror(errno));
+            ret = 1;
+            continue;
+        }
+        if ( !read_file(file, argv[i]) )
+            ret = 1;
+
+        fclose(file);
+    }
+    return ret;
+}
+
@@ -0,0 +1,220 @@
+//--------------------------------------------------------------------------
+// Copyright (C) 2016-2016 Cisco and/or its affiliates. All rights reserved.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License Version 2 as published
+// by the Free Software Foundation.  You may not use, modify or distribute
+// this program under any other version of the GNU General Public License.
+//
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+//--------------------------------------------------------------------------
+// rep_compiler.cc
+
+// rep_compiler parses reputation blacklist and whitelist files exactly as
+// the reputation inspector does and writes the finished lookup table as a
+// list image.  Point reputation.list_image at the result and snort maps it
+// read-only instead of parsing the lists at startup and on every reload.
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "log/messages.h"
+#include "network_inspectors/reputation/reputation_parse.h"
+#include "parser/config_file.h"
+#include "utils/util.h"
+
+//-------------------------------------------------------------------------
+// the parts of snort the list parser calls
+//-------------------------------------------------------------------------
+
+static bool errors = false;
+
+void LogMessage(const char* format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stdout, format, ap);
+    va_end(ap);
+}
+
+void ErrorMessage(const char* format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+}
+
+void ParseWarning(WarningGroup, const char* format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+}
+
+void ParseError(const char* format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+    errors = true;
+}
+
+NORETURN void FatalError(const char* format, ...)
+{
+    va_list ap;
+    va_start(ap, format);
+    vfprintf(stderr, format, ap);
+    va_end(ap);
+    exit(1);
+}
+
+const char* get_error(int errnum)
+{ return strerror(errnum); }
+
+// relative list paths are taken from the current directory
+const char* get_snort_conf_dir()
+{ return "./"; }
+
+char* snort_strdup(const char* str)
+{
+    size_t n = strlen(str) + 1;
+    char* p = (char*)snort_alloc(n);
+    memcpy(p, str, n);
+    return p;
+}
+
+//-------------------------------------------------------------------------
+// main
+//-------------------------------------------------------------------------
+
+static void usage()
+{
+    fprintf(stderr,
+        "usage: rep_compiler [-b blacklist] [-w whitelist] [-t unblack|trust] "
+        "[-l dir|poptrie] [-m memcap] -o image\n"
+        "  -b  blacklist file name with ip lists\n"
+        "  -w  whitelist file name with ip lists\n"
+        "  -t  meaning of whitelist (default unblack); fixed in the image\n"
+        "  -l  ip table (default dir); poptrie images are much smaller\n"
+        "  -m  maximum memory for the table in megabytes (default 500)\n"
+        "  -o  list image to write; an existing image is replaced atomically\n");
+}
+
+int main(int argc, char* argv[])
+{
+    ReputationConfig config;
+    const char* output_filename = nullptr;
+    int c;
+
+    opterr = 0;
+
+    while ((c = getopt(argc, argv, "b:w:t:l:m:o:")) != -1)
+    {
+        switch (c)
+        {
+        case 'b':
+            config.blacklist_path = snort_strdup(optarg);
+            break;
+        case 'w':
+            config.whitelist_path = snort_strdup(optarg);
+            break;
+        case 't':
+            if ( !strcmp(optarg, "unblack") )
+                config.whiteAction = UNBLACK;
+            else if ( !strcmp(optarg, "trust") )
+                config.whiteAction = TRUST;
+            else
+            {
+                usage();
+                return 1;
+            }
+            break;
+        case 'l':
+            if ( !strcmp(optarg, "dir") )
+                config.table = TABLE_DIR;
+            else if ( !strcmp(optarg, "poptrie") )
+                config.table = TABLE_POPTRIE;
+            else
+            {
+                usage();
+                return 1;
+            }
+            break;
+        case 'm':
+            config.memcap = strtoul(optarg, nullptr, 10);
+            if ( config.memcap < 1 or config.memcap > 4095 )
+            {
+                fprintf(stderr, "memcap must be 1 to 4095 megabytes\n");
+                return 1;
+            }
+            break;
+        case 'o':
+            output_filename = optarg;
+            break;
+        case '?':
+            if (isprint(optopt))
+                fprintf(stderr, "Unknown option or missing argument -%c.\n", optopt);
+            usage();
+            return 1;
+        default:
+            usage();
+            return 1;
+        }
+    }
+
+    if ( !output_filename or (!config.blacklist_path and !config.whitelist_path) )
+    {
+        usage();
+        return 1;
+    }
+
+    EstimateNumEntries(&config);
+
+    if (config.numEntries <= 0)
+    {
+        fprintf(stderr, "Can't find any whitelist/blacklist entries.\n");
+        return 1;
+    }
+
+    IpListInit(config.numEntries + 1, &config);
+
+    LoadListFile(config.blacklist_path, config.local_black_ptr, &config);
+    LoadListFile(config.whitelist_path, config.local_white_ptr, &config);
+
+    if ( config.memCapReached )
+    {
+        fprintf(stderr, "Memcap %u Mbytes reached; image not written.\n", config.memcap);
+        return 1;
+    }
+
+    if ( sfrt_flat_compile(config.iplist) != RT_SUCCESS )
+    {
+        fprintf(stderr, "Failed to compile IP list.\n");
+        return 1;
+    }
+
+    if ( errors or !SaveListImage(output_filename, &config) )
+        return 1;
+
+    return 0;
+}
+